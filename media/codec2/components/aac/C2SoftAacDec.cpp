@@ -18,6 +18,7 @@
 #define LOG_TAG "C2SoftAacDec"
 #include <log/log.h>
 
+#include <algorithm>
 #include <inttypes.h>
 #include <math.h>
 #include <numeric>
@@ -72,6 +73,7 @@ public:
         noOutputReferences();
         noInputLatency();
         noTimeStretch();
+        multipleAccessUnits();
 
         addParameter(
                 DefineParam(mActualOutputDelay, C2_PARAMKEY_OUTPUT_DELAY)
@@ -490,6 +492,29 @@ int32_t C2SoftAacDec::outputDelayRingBufferSpaceLeft() {
     return mOutputDelayRingBufferSize - outputDelayRingBufferSamplesAvailable();
 }
 
+bool C2SoftAacDec::outputDelayRingBufferReserve(int32_t numSamples) {
+    if (outputDelayRingBufferSpaceLeft() >= numSamples) {
+        return true;
+    }
+    // grow geometrically, as a batch reserves room one access unit at a time
+    int32_t newSize = std::max(mOutputDelayRingBufferFilled + numSamples,
+                               2 * mOutputDelayRingBufferSize);
+    std::unique_ptr<short[]> newBuffer(new (std::nothrow) short[newSize]);
+    if (!newBuffer) {
+        return false;
+    }
+    for (int32_t i = 0; i < mOutputDelayRingBufferFilled; ++i) {
+        newBuffer[i] = mOutputDelayRingBuffer[
+                (mOutputDelayRingBufferReadPos + i) % mOutputDelayRingBufferSize];
+    }
+    ALOGV("ring buffer grown from %d to %d samples", mOutputDelayRingBufferSize, newSize);
+    mOutputDelayRingBuffer = std::move(newBuffer);
+    mOutputDelayRingBufferSize = newSize;
+    mOutputDelayRingBufferReadPos = 0;
+    mOutputDelayRingBufferWritePos = mOutputDelayRingBufferFilled;
+    return true;
+}
+
 void C2SoftAacDec::drainRingBuffer(
         const std::unique_ptr<C2Work> &work,
         const std::shared_ptr<C2BlockPool> &pool,
@@ -637,6 +662,10 @@ void C2SoftAacDec::process(
     inInfo.timestamp = work->input.ordinal.timestamp.peeku();
     inInfo.bufferSize = size;
     inInfo.decodedSizes.clear();
+
+    // Raw access units are filled one at a time; ADTS frames carry their own length.
+    const std::vector<uint32_t> auSizes = getInputAccessUnitSizes(work, size);
+    size_t auIndex = 0;
     while (size > 0u) {
         ALOGV("size = %zu", size);
         if (mIntf->isAdts()) {
@@ -690,7 +719,7 @@ void C2SoftAacDec::process(
         } else {
             // const_cast because of libAACdec method signature.
             inBuffer[0] = const_cast<UCHAR *>(view.data() + offset);
-            inBufferLength[0] = size;
+            inBufferLength[0] = (auIndex < auSizes.size()) ? auSizes[auIndex++] : size;
         }
 
         // Fill and decode
@@ -757,6 +786,16 @@ void C2SoftAacDec::process(
 
         AAC_DECODER_ERROR decoderErr;
         do {
+            if (!auSizes.empty() && !outputDelayRingBufferReserve(
+                    sizeof(tmpOutBuffer) / sizeof(tmpOutBuffer[0]))) {
+                // The output of all the access units stays in the ring buffer until
+                // drained below. A frame fills at most tmpOutBuffer, whatever its size,
+                // e.g. 4096 samples per channel with the 4:1 SBR of USAC.
+                ALOGE("cannot grow the ring buffer after %zu access units", auIndex);
+                mSignalledError = true;
+                work->result = C2_NO_MEMORY;
+                return;
+            }
             if (outputDelayRingBufferSpaceLeft() <
                     (mStreamInfo->frameSize * mStreamInfo->numChannels)) {
                 ALOGV("skipping decode: not enough space left in ringbuffer");
@@ -811,8 +850,11 @@ void C2SoftAacDec::process(
                     return;
                 }
 
-                // Discard input buffer.
-                size = 0;
+                // Discard input buffer. The remaining access units of a raw
+                // input are still decoded.
+                if (auSizes.empty() || mIntf->isAdts()) {
+                    size = 0;
+                }
 
                 aacDecoder_SetParam(mAACDecoder, AAC_TPDEC_CLEAR_BUFFER, 1);
 
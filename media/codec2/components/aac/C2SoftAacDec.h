@@ -102,6 +102,8 @@ private:
     int32_t outputDelayRingBufferGetSamples(INT_PCM *samples, int numSamples);
     int32_t outputDelayRingBufferSamplesAvailable();
     int32_t outputDelayRingBufferSpaceLeft();
+    // Grows the ring buffer, if needed, to hold |numSamples| more samples.
+    bool outputDelayRingBufferReserve(int32_t numSamples);
     uint32_t maskFromCount(uint32_t channelCount);
 
     C2_DO_NOT_COPY(C2SoftAacDec);
@@ -348,6 +348,8 @@ C2SoftAvcDec::C2SoftAvcDec(
       mHeight(240),
       mHeaderDecoded(false),
       mOutIndex(0u) {
+    // the listener callbacks overlap with decoding
+    setPipelineStages(STAGE_OUTPUT);
     GENERATE_FILE_NAMES();
     CREATE_DUMP_FILE(mInFile);
 }
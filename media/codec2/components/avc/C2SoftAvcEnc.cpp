@@ -143,6 +143,20 @@ public:
                 .calculatedAs(InputDelaySetter, mGop)
                 .build());
 
+        addParameter(
+                DefineParam(mComplexity, C2_PARAMKEY_COMPLEXITY)
+                .withDefault(new C2StreamComplexityTuning::output(0u, DEFAULT_COMPLEXITY))
+                .withFields({C2F(mComplexity, value).inRange(0, 10)})
+                .withSetter(Setter<decltype(*mComplexity)>::NonStrictValueWithNoDeps)
+                .build());
+
+        addParameter(
+                DefineParam(mThreadCount, C2_PARAMKEY_SOFT_THREAD_COUNT)
+                .withDefault(new C2SoftThreadCountTuning(0u))
+                .withFields({C2F(mThreadCount, value).any()})
+                .withSetter(Setter<decltype(*mThreadCount)>::StrictValueWithNoDeps)
+                .build());
+
         addParameter(
                 DefineParam(mFrameRate, C2_PARAMKEY_FRAME_RATE)
                 .withDefault(new C2StreamFrameRateInfo::output(0u, 1.))
@@ -558,6 +572,10 @@ public:
     std::shared_ptr<C2StreamColorAspectsInfo::output> getCodedColorAspects_l() const {
         return mCodedColorAspects;
     }
+    std::shared_ptr<C2StreamComplexityTuning::output> getComplexity_l() const {
+        return mComplexity;
+    }
+    std::shared_ptr<C2SoftThreadCountTuning> getThreadCount_l() const { return mThreadCount; }
 
 private:
     std::shared_ptr<C2StreamUsageTuning::input> mUsage;
@@ -573,6 +591,8 @@ private:
     std::shared_ptr<C2StreamPictureQuantizationTuning::output> mPictureQuantization;
     std::shared_ptr<C2StreamColorAspectsInfo::input> mColorAspects;
     std::shared_ptr<C2StreamColorAspectsInfo::output> mCodedColorAspects;
+    std::shared_ptr<C2StreamComplexityTuning::output> mComplexity;
+    std::shared_ptr<C2SoftThreadCountTuning> mThreadCount;
 };
 
 #define ive_api_function  ih264e_api_function
@@ -649,6 +669,7 @@ void C2SoftAvcEnc::onRelease() {
 
 c2_status_t C2SoftAvcEnc::onFlush_sm() {
     // TODO: use IVE_CMD_CTL_FLUSH?
+    mInputTimes.clear();
     return C2_OK;
 }
 
@@ -1166,6 +1187,8 @@ c2_status_t C2SoftAvcEnc::initEncoder() {
     c2_status_t errType = C2_OK;
 
     std::shared_ptr<C2StreamGopTuning::output> gop;
+    std::shared_ptr<C2StreamComplexityTuning::output> complexity;
+    std::shared_ptr<C2SoftThreadCountTuning> threadCount;
     {
         IntfImpl::Lock lock = mIntf->lock();
         mSize = mIntf->getSize_l();
@@ -1178,6 +1201,23 @@ c2_status_t C2SoftAvcEnc::initEncoder() {
         mIDRInterval = mIntf->getSyncFramePeriod_l();
         gop = mIntf->getGop_l();
         mColorAspects = mIntf->getCodedColorAspects_l();
+        complexity = mIntf->getComplexity_l();
+        threadCount = mIntf->getThreadCount_l();
+    }
+    mNumCores = GetCPUCoreCount();
+    if (threadCount->value > 0) {
+        mNumCores = std::min((size_t)threadCount->value, mNumCores);
+    }
+    if (complexity->value >= 8) {
+        mEncSpeed = IVE_SLOWEST;
+    } else if (complexity->value >= 5) {
+        mEncSpeed = IVE_NORMAL;
+    } else if (complexity->value >= 3) {
+        mEncSpeed = IVE_FAST;
+    } else if (complexity->value >= 1) {
+        mEncSpeed = IVE_HIGH_SPEED;
+    } else {
+        mEncSpeed = IVE_FASTEST;
     }
     if (gop && gop->flexCount() > 0) {
         uint32_t syncInterval = 1;
@@ -1469,6 +1509,7 @@ c2_status_t C2SoftAvcEnc::releaseEncoder() {
 
     // clear other pointers into the space being free()d
     mCodecCtx = nullptr;
+    mInputTimes.clear();
 
     mStarted = false;
 
@@ -1658,6 +1699,12 @@ void C2SoftAvcEnc::finishWork(uint64_t workIndex, const std::unique_ptr<C2Work>
         buffer->setInfo(std::make_shared<C2StreamPictureTypeMaskInfo::output>(
                 0u /* stream id */, C2Config::SYNC_FRAME));
     }
+    auto it = mInputTimes.find(workIndex);
+    if (it != mInputTimes.end()) {
+        buffer->setInfo(std::make_shared<C2SoftEncodeLatencyInfo::output>(
+                0u /* stream id */, ns2us(systemTime() - it->second)));
+        mInputTimes.erase(it);
+    }
     mOutBlock = nullptr;
 
     auto fillWork = [buffer](const std::unique_ptr<C2Work> &work) {
@@ -1880,6 +1927,7 @@ void C2SoftAvcEnc::process(
     // Hold input buffer reference
     if (inputBuffer) {
         mBuffers[ps_encode_ip->s_inp_buf.apv_bufs[0]] = inputBuffer;
+        mInputTimes[workIndex] = mTimeStart;
     }
 
     /* Compute time taken for decode() */
@@ -23,6 +23,7 @@
 #include <utils/Vector.h>
 
 #include <SimpleC2Component.h>
+#include <SimpleC2VendorParams.h>
 
 #include "ih264_typedefs.h"
 #include "ih264e.h"
@@ -47,6 +48,7 @@ namespace android {
 #define DEFAULT_NUM_CORES_PRE_ENC   0
 #define DEFAULT_FPS                 30
 #define DEFAULT_ENC_SPEED           IVE_NORMAL
+#define DEFAULT_COMPLEXITY          5   // maps to DEFAULT_ENC_SPEED
 
 #define DEFAULT_MEM_REC_CNT         0
 #define DEFAULT_RECON_ENABLE        0
@@ -208,6 +210,8 @@ private:
     std::map<const void *, std::shared_ptr<C2Buffer>> mBuffers;
     MemoryBlockPool mConversionBuffers;
     std::map<const void *, MemoryBlock> mConversionBuffersInUse;
+    // Time at which each work in flight was handed to the encoder, by work index.
+    std::map<uint64_t, nsecs_t> mInputTimes;
 
     void initEncParams();
     c2_status_t initEncoder();
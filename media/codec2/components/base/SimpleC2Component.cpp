@@ -25,6 +25,15 @@
 
 #include <inttypes.h>
 #include <libyuv.h>
+#include <pthread.h>
+#include <utils/AndroidThreads.h>
+#include <utils/SystemClock.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 #include <C2Config.h>
 #include <C2Debug.h>
@@ -787,6 +796,107 @@ private:
     std::shared_ptr<C2BlockPool> mBase;
 };
 
+/**
+ * Runs the jobs of a pipeline stage in order on its own thread.
+ */
+class SimpleC2Component::PipelineStageThread {
+public:
+    // post() waits while capacity jobs are pending.
+    PipelineStageThread(const std::string &name, size_t capacity)
+        : mState(std::make_shared<State>(capacity)),
+          mThread(&PipelineStageThread::run, mState, name) {}
+
+    ~PipelineStageThread() {
+        {
+            std::lock_guard<std::mutex> lock(mState->lock);
+            mState->exit = true;
+            mState->cond.notify_all();
+        }
+        // The last reference to the component may be released by a job: the thread then
+        // exits on its own, as it shares the state.
+        if (mThread.get_id() == std::this_thread::get_id()) {
+            mThread.detach();
+        } else {
+            mThread.join();
+        }
+    }
+
+    void post(std::function<void()> job) {
+        std::unique_lock<std::mutex> lock(mState->lock);
+        mState->cond.wait(lock, [this] {
+            return mState->jobs.size() < mState->capacity || mState->exit;
+        });
+        mState->jobs.push_back(std::move(job));
+        mState->cond.notify_all();
+    }
+
+    // Waits for the jobs posted so far.
+    void waitIdle() {
+        if (mThread.get_id() == std::this_thread::get_id()) return;
+        std::unique_lock<std::mutex> lock(mState->lock);
+        mState->cond.wait(lock, [this] {
+            return (mState->jobs.empty() && !mState->busy) || mState->exit;
+        });
+    }
+
+    StageTiming timing() const {
+        std::lock_guard<std::mutex> lock(mState->lock);
+        return mState->timing;
+    }
+
+private:
+    struct State {
+        explicit State(size_t capacity) : capacity(capacity) {}
+
+        const size_t capacity;
+        std::mutex lock;
+        std::condition_variable cond;
+        std::deque<std::function<void()>> jobs;
+        bool busy = false;
+        bool exit = false;
+        StageTiming timing;
+    };
+
+    static void run(std::shared_ptr<State> state, std::string name) {
+        // thread names are limited to 15 characters
+        pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+        androidSetThreadPriority(0, ANDROID_PRIORITY_VIDEO);
+        std::unique_lock<std::mutex> lock(state->lock);
+        while (true) {
+            state->cond.wait(lock, [&state] { return !state->jobs.empty() || state->exit; });
+            if (state->exit) break;
+            std::function<void()> job = std::move(state->jobs.front());
+            state->jobs.pop_front();
+            state->busy = true;
+            state->cond.notify_all();
+            lock.unlock();
+            const int64_t startNs = elapsedRealtimeNano();
+            job();
+            const int64_t durationNs = elapsedRealtimeNano() - startNs;
+            job = nullptr;
+            lock.lock();
+            state->timing.add(durationNs);
+            state->busy = false;
+            state->cond.notify_all();
+        }
+    }
+
+    const std::shared_ptr<State> mState;
+    std::thread mThread;
+};
+
+void SimpleC2Component::StageTiming::add(int64_t ns) {
+    ++count;
+    totalNs += ns;
+    maxNs = std::max(maxNs, ns);
+}
+
+std::string SimpleC2Component::StageTiming::toString() const {
+    return "count " + std::to_string(count)
+            + " avg " + std::to_string(count ? totalNs / (int64_t)count / 1000 : 0) + " us"
+            + " max " + std::to_string(maxNs / 1000) + " us";
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace {
@@ -795,6 +905,12 @@ struct DummyReadView : public C2ReadView {
     DummyReadView() : C2ReadView(C2_NO_INIT) {}
 };
 
+std::list<std::unique_ptr<C2Work>> vec(std::unique_ptr<C2Work> &work) {
+    std::list<std::unique_ptr<C2Work>> ret;
+    ret.push_back(std::move(work));
+    return ret;
+}
+
 }  // namespace
 
 SimpleC2Component::SimpleC2Component(
@@ -813,6 +929,67 @@ SimpleC2Component::~SimpleC2Component() {
     (void)mLooper->stop();
 }
 
+void SimpleC2Component::setPipelineStages(uint32_t stages) {
+    if (!property_get_bool("debug.stagefright.c2.pipeline_stages", true)) {
+        return;
+    }
+    const std::string name = mIntf->getName();
+    // keep the end of the name, which tells the codec apart
+    const std::string shortName = name.size() > 11 ? name.substr(name.size() - 11) : name;
+    if ((stages & STAGE_OUTPUT) && !mOutputStage) {
+        mOutputStage = std::make_unique<PipelineStageThread>(shortName + "/out", kMaxInFlightWork);
+    }
+}
+
+SimpleC2Component::StageTiming SimpleC2Component::getStageTiming(PipelineStage stage) const {
+    switch (stage) {
+        case STAGE_PROCESS:
+            return *mProcessTiming.lock();
+        case STAGE_OUTPUT:
+            return mOutputStage ? mOutputStage->timing() : StageTiming{};
+    }
+    return {};
+}
+
+void SimpleC2Component::sendWorkDone(std::unique_ptr<C2Work> work) {
+    std::shared_ptr<C2Component::Listener> listener = mExecState.lock()->mListener;
+    if (!mOutputStage) {
+        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        return;
+    }
+    // std::function must be copyable
+    auto holder = std::make_shared<std::unique_ptr<C2Work>>(std::move(work));
+    mOutputStage->post([weakThis = weak_from_this(), listener, holder] {
+        std::shared_ptr<SimpleC2Component> thiz = weakThis.lock();
+        if (thiz) {
+            listener->onWorkDone_nb(thiz, vec(*holder));
+        }
+    });
+}
+
+void SimpleC2Component::sendError(c2_status_t err) {
+    std::shared_ptr<C2Component::Listener> listener = mExecState.lock()->mListener;
+    if (!mOutputStage) {
+        listener->onError_nb(shared_from_this(), err);
+        return;
+    }
+    mOutputStage->post([weakThis = weak_from_this(), listener, err] {
+        std::shared_ptr<SimpleC2Component> thiz = weakThis.lock();
+        if (thiz) {
+            listener->onError_nb(thiz, err);
+        }
+    });
+}
+
+void SimpleC2Component::stopPipelineStages() {
+    if (mOutputStage) {
+        mOutputStage->waitIdle();
+        ALOGD("%s pipeline: process %s, output %s", mIntf->getName().c_str(),
+                getStageTiming(STAGE_PROCESS).toString().c_str(),
+                getStageTiming(STAGE_OUTPUT).toString().c_str());
+    }
+}
+
 c2_status_t SimpleC2Component::setListener_vb(
         const std::shared_ptr<C2Component::Listener> &listener, c2_blocking_t mayBlock) {
     mHandler->setComponent(shared_from_this());
@@ -867,6 +1044,10 @@ c2_status_t SimpleC2Component::flush_sm(
             return C2_BAD_STATE;
         }
     }
+    if (mOutputStage) {
+        // the work finished before the flush is returned before flush_sm()
+        mOutputStage->waitIdle();
+    }
     {
         Mutexed<WorkQueue>::Locked queue(mWorkQueue);
         queue->incGeneration();
@@ -948,6 +1129,7 @@ c2_status_t SimpleC2Component::stop() {
     }
     sp<AMessage> reply;
     (new AMessage(WorkHandler::kWhatStop, mHandler))->postAndAwaitResponse(&reply);
+    stopPipelineStages();
     int32_t err;
     CHECK(reply->findInt32("err", &err));
     if (err != C2_OK) {
@@ -969,6 +1151,7 @@ c2_status_t SimpleC2Component::reset() {
     }
     sp<AMessage> reply;
     (new AMessage(WorkHandler::kWhatReset, mHandler))->postAndAwaitResponse(&reply);
+    stopPipelineStages();
     return C2_OK;
 }
 
@@ -976,6 +1159,7 @@ c2_status_t SimpleC2Component::release() {
     ALOGV("release");
     sp<AMessage> reply;
     (new AMessage(WorkHandler::kWhatRelease, mHandler))->postAndAwaitResponse(&reply);
+    stopPipelineStages();
     return C2_OK;
 }
 
@@ -983,16 +1167,6 @@ std::shared_ptr<C2ComponentInterface> SimpleC2Component::intf() {
     return mIntf;
 }
 
-namespace {
-
-std::list<std::unique_ptr<C2Work>> vec(std::unique_ptr<C2Work> &work) {
-    std::list<std::unique_ptr<C2Work>> ret;
-    ret.push_back(std::move(work));
-    return ret;
-}
-
-}  // namespace
-
 void SimpleC2Component::finish(
         uint64_t frameIndex, std::function<void(const std::unique_ptr<C2Work> &)> fillWork) {
     std::unique_ptr<C2Work> work;
@@ -1007,8 +1181,7 @@ void SimpleC2Component::finish(
     }
     if (work) {
         fillWork(work);
-        std::shared_ptr<C2Component::Listener> listener = mExecState.lock()->mListener;
-        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        sendWorkDone(std::move(work));
         ALOGV("returning pending work");
     }
 }
@@ -1033,8 +1206,7 @@ void SimpleC2Component::cloneAndSend(
     work->worklets.emplace_back(new C2Worklet);
     if (work) {
         fillWork(work);
-        std::shared_ptr<C2Component::Listener> listener = mExecState.lock()->mListener;
-        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        sendWorkDone(std::move(work));
         ALOGV("cloned and sending work");
     }
 }
@@ -1105,21 +1277,17 @@ bool SimpleC2Component::processQueue() {
             return err;
         }();
         if (err != C2_OK) {
-            Mutexed<ExecState>::Locked state(mExecState);
-            std::shared_ptr<C2Component::Listener> listener = state->mListener;
-            state.unlock();
-            listener->onError_nb(shared_from_this(), err);
+            sendError(err);
             return hasQueuedWork;
         }
     }
 
     if (!work) {
+        const int64_t startNs = elapsedRealtimeNano();
         c2_status_t err = drain(drainMode, mOutputBlockPool);
+        mProcessTiming.lock()->add(elapsedRealtimeNano() - startNs);
         if (err != C2_OK) {
-            Mutexed<ExecState>::Locked state(mExecState);
-            std::shared_ptr<C2Component::Listener> listener = state->mListener;
-            state.unlock();
-            listener->onError_nb(shared_from_this(), err);
+            sendError(err);
         }
         return hasQueuedWork;
     }
@@ -1146,7 +1314,9 @@ bool SimpleC2Component::processQueue() {
         ALOGD("Encountered null input buffer. Clearing the input buffer");
         work->input.buffers.clear();
     }
+    const int64_t startNs = elapsedRealtimeNano();
     process(work, mOutputBlockPool);
+    mProcessTiming.lock()->add(elapsedRealtimeNano() - startNs);
     ALOGV("processed frame #%" PRIu64, work->input.ordinal.frameIndex.peeku());
     Mutexed<WorkQueue>::Locked queue(mWorkQueue);
     if (queue->generation() != generation) {
@@ -1155,19 +1325,13 @@ bool SimpleC2Component::processQueue() {
         work->result = C2_NOT_FOUND;
         queue.unlock();
 
-        Mutexed<ExecState>::Locked state(mExecState);
-        std::shared_ptr<C2Component::Listener> listener = state->mListener;
-        state.unlock();
-        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        sendWorkDone(std::move(work));
         return hasQueuedWork;
     }
     if (work->workletsProcessed != 0u) {
         queue.unlock();
-        Mutexed<ExecState>::Locked state(mExecState);
         ALOGV("returning this work");
-        std::shared_ptr<C2Component::Listener> listener = state->mListener;
-        state.unlock();
-        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        sendWorkDone(std::move(work));
     } else {
         ALOGV("queue pending work");
         work->input.buffers.clear();
@@ -1184,10 +1348,7 @@ bool SimpleC2Component::processQueue() {
         if (unexpected) {
             ALOGD("unexpected pending work");
             unexpected->result = C2_CORRUPTED;
-            Mutexed<ExecState>::Locked state(mExecState);
-            std::shared_ptr<C2Component::Listener> listener = state->mListener;
-            state.unlock();
-            listener->onWorkDone_nb(shared_from_this(), vec(unexpected));
+            sendWorkDone(std::move(unexpected));
         }
     }
     return hasQueuedWork;
@@ -1234,4 +1395,31 @@ std::shared_ptr<C2Buffer> SimpleC2Component::createGraphicBuffer(
     return C2Buffer::CreateGraphicBuffer(block->share(crop, ::C2Fence()));
 }
 
+std::vector<uint32_t> SimpleC2Component::getInputAccessUnitSizes(
+        const std::unique_ptr<C2Work> &work, size_t size) {
+    std::vector<uint32_t> sizes;
+    if (work->input.buffers.empty() || !work->input.buffers.front()) {
+        return sizes;
+    }
+    std::shared_ptr<const C2AccessUnitInfos::input> infos =
+            std::static_pointer_cast<const C2AccessUnitInfos::input>(
+                    work->input.buffers.front()->getInfo(C2AccessUnitInfos::input::PARAM_TYPE));
+    if (!infos || infos->flexCount() <= 1) {
+        return sizes;
+    }
+    size_t offset = 0;
+    for (size_t i = 0; i < infos->flexCount() && offset < size; ++i) {
+        uint32_t auSize = std::min<size_t>(infos->m.values[i].size, size - offset);
+        if (auSize > 0) {
+            sizes.push_back(auSize);
+            offset += auSize;
+        }
+    }
+    if (offset < size) {
+        ALOGW("%zu trailing bytes not covered by access unit infos", size - offset);
+        sizes.push_back(size - offset);
+    }
+    return sizes;
+}
+
 } // namespace android
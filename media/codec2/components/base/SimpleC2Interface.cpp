@@ -319,6 +319,13 @@ void SimpleInterface<void>::BaseParams::noTimeStretch() {
             .build());
 }
 
+void SimpleInterface<void>::BaseParams::multipleAccessUnits() {
+    addParameter(
+            DefineParam(mInputAccessUnitInfos, C2_PARAMKEY_INPUT_ACCESS_UNIT_INFOS)
+            .withConstValue(C2AccessUnitInfos::input::AllocShared(0u))
+            .build());
+}
+
 /*
     Clients need to handle the following base params due to custom dependency.
 
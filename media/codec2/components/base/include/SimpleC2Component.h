@@ -18,7 +18,10 @@
 #define SIMPLE_C2_COMPONENT_H_
 
 #include <list>
+#include <memory>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <C2Component.h>
 #include <C2Config.h>
@@ -122,6 +125,28 @@ public:
     // for handler
     bool processQueue();
 
+    /**
+     * Stages of the work pipeline. The process stage always runs on the component looper;
+     * the output stage can run on its own thread, see setPipelineStages().
+     */
+    enum PipelineStage : uint32_t {
+        STAGE_PROCESS = 1 << 0,  // process() and drain()
+        STAGE_OUTPUT  = 1 << 1,  // delivery of the finished work to the listener
+    };
+
+    /** Time spent in a pipeline stage. */
+    struct StageTiming {
+        uint64_t count = 0;
+        int64_t totalNs = 0;
+        int64_t maxNs = 0;
+
+        void add(int64_t ns);
+        std::string toString() const;
+    };
+
+    /** Returns the time spent in the given stage since the component was created. */
+    StageTiming getStageTiming(PipelineStage stage) const;
+
 protected:
     /**
      * Initialize internal states of the component according to the config set
@@ -176,6 +201,18 @@ protected:
             uint32_t drainMode,
             const std::shared_ptr<C2BlockPool> &pool) = 0;
 
+    /**
+     * Run the given stages (a combination of PipelineStage) on their own thread, so that they
+     * overlap with process() of other work. At most kMaxInFlightWork works wait for delivery;
+     * past that, process() waits for the output stage.
+     *
+     * Must be called from the derived class constructor. Software codecs spending time in the
+     * listener callbacks benefit from it on multi-core devices.
+     */
+    void setPipelineStages(uint32_t stages);
+
+    static constexpr size_t kMaxInFlightWork = 8;
+
     // for derived classes
     /**
      * Finish pending work.
@@ -215,6 +252,19 @@ protected:
             const std::shared_ptr<C2GraphicBlock> &block,
             const C2Rect &crop);
 
+    /**
+     * Returns the sizes of the access units in the input buffer of |work|, as described by the
+     * C2AccessUnitInfos::input attached to the buffer. Returns an empty vector if the buffer
+     * holds a single access unit.
+     *
+     * Used by components marked with SimpleInterface<void>::BaseParams::multipleAccessUnits().
+     *
+     * \param[in]   work    the work under processing
+     * \param[in]   size    the size of the input buffer; access units are clamped to it
+     */
+    static std::vector<uint32_t> getInputAccessUnitSizes(
+            const std::unique_ptr<C2Work> &work, size_t size);
+
     static constexpr uint32_t NO_DRAIN = ~0u;
 
     C2ReadView mDummyReadView;
@@ -276,6 +326,7 @@ private:
         std::unique_ptr<C2Work> pop_front();
         void push_back(std::unique_ptr<C2Work> work);
         bool empty() const;
+        size_t size() const { return mQueue.size(); }
         uint32_t drainMode() const;
         void markDrain(uint32_t drainMode);
         inline bool popPendingFlush() {
@@ -302,6 +353,16 @@ private:
     class BlockingBlockPool;
     std::shared_ptr<BlockingBlockPool> mOutputBlockPool;
 
+    // Returns the work to the listener, through the output stage if enabled.
+    void sendWorkDone(std::unique_ptr<C2Work> work);
+    void sendError(c2_status_t err);
+    // Waits for the output stage to deliver the finished work.
+    void stopPipelineStages();
+
+    class PipelineStageThread;
+    std::unique_ptr<PipelineStageThread> mOutputStage;
+    mutable Mutexed<StageTiming> mProcessTiming;
+
     std::vector<int> mBitDepth10HalPixelFormats;
     SimpleC2Component() = delete;
 };
@@ -123,6 +123,11 @@ public:
         /// must add support for C2ComponentTimeStretchTuning.
         void noTimeStretch();
 
+        /// Marks that this component consumes an input buffer carrying multiple access units,
+        /// described by C2AccessUnitInfos::input, in a single work. Otherwise, such buffers are
+        /// split into one work per access unit before being queued to the component.
+        void multipleAccessUnits();
+
         std::shared_ptr<C2ApiLevelSetting> mApiLevel;
         std::shared_ptr<C2ApiFeaturesSetting> mApiFeatures;
 
@@ -135,6 +140,7 @@ public:
         std::shared_ptr<C2ComponentDomainSetting> mDomain;
         std::shared_ptr<C2ComponentAttributesSetting> mAttrib;
         std::shared_ptr<C2ComponentTimeStretchTuning> mTimeStretch;
+        std::shared_ptr<C2AccessUnitInfos::input> mInputAccessUnitInfos;
 
         std::shared_ptr<C2PortMediaTypeSetting::input> mInputMediaType;
         std::shared_ptr<C2PortMediaTypeSetting::output> mOutputMediaType;
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SIMPLE_C2_VENDOR_PARAMS_H_
+#define ANDROID_SIMPLE_C2_VENDOR_PARAMS_H_
+
+#include <C2Config.h>
+
+namespace android {
+
+/**
+ * Vendor parameters of the software codecs.
+ *
+ * The tunings control how the codec libraries use the CPU. They are reflected to MediaCodec
+ * clients as "vendor.<key>.value", and are applied when the component is started.
+ */
+enum C2SoftParamIndexKind : C2Param::type_index_t {
+    kParamIndexSoftCodecStart = C2Param::TYPE_INDEX_VENDOR_START + 0x6000,
+
+    kParamIndexSoftThreadCount = kParamIndexSoftCodecStart,
+    kParamIndexSoftFrameThreading,
+    kParamIndexSoftTileThreading,
+    kParamIndexSoftLookahead,
+    kParamIndexSoftEncodeLatency,
+};
+
+/**
+ * Number of threads used by the codec library. 0 lets the component choose based on the
+ * number of CPU cores.
+ */
+typedef C2GlobalParam<C2Tuning, C2Uint32Value, kParamIndexSoftThreadCount>
+        C2SoftThreadCountTuning;
+constexpr char C2_PARAMKEY_SOFT_THREAD_COUNT[] = "soft-codec.thread-count";
+
+/**
+ * Whether the codec library may work on several frames concurrently. This raises the
+ * throughput on multi-core devices, at the cost of a larger output delay.
+ */
+typedef C2GlobalParam<C2Tuning, C2EasyBoolValue, kParamIndexSoftFrameThreading>
+        C2SoftFrameThreadingTuning;
+constexpr char C2_PARAMKEY_SOFT_FRAME_THREADING[] = "soft-codec.frame-threading";
+
+/**
+ * Whether the codec library may split a single frame across threads by tile and by row.
+ */
+typedef C2GlobalParam<C2Tuning, C2EasyBoolValue, kParamIndexSoftTileThreading>
+        C2SoftTileThreadingTuning;
+constexpr char C2_PARAMKEY_SOFT_TILE_THREADING[] = "soft-codec.tile-threading";
+
+/**
+ * Number of frames the encoder rate control looks ahead. Each frame of look-ahead adds one to
+ * the input delay of the encoder.
+ */
+typedef C2GlobalParam<C2Tuning, C2Uint32Value, kParamIndexSoftLookahead>
+        C2SoftLookaheadTuning;
+constexpr char C2_PARAMKEY_SOFT_LOOKAHEAD[] = "soft-codec.lookahead";
+
+/**
+ * Time in microseconds between the start of the processing of an input frame and the output
+ * of its encoded buffer. Set by the software encoders as info on their output buffers.
+ */
+typedef C2StreamParam<C2Info, C2Int64Value, kParamIndexSoftEncodeLatency>
+        C2SoftEncodeLatencyInfo;
+constexpr char C2_PARAMKEY_SOFT_ENCODE_LATENCY[] = "soft-codec.encode-latency";
+
+}  // namespace android
+
+#endif  // ANDROID_SIMPLE_C2_VENDOR_PARAMS_H_
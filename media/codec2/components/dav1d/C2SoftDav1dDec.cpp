@@ -249,11 +249,25 @@ class C2SoftDav1dDec::IntfImpl : public SimpleInterface<void>::BaseParams {
                 .withSetter(Setter<decltype(*mLowLatencyMode)>::StrictValueWithNoDeps)
                 .build());
 
+        addParameter(
+                DefineParam(mThreadCount, C2_PARAMKEY_SOFT_THREAD_COUNT)
+                .withDefault(new C2SoftThreadCountTuning(0u))
+                .withFields({C2F(mThreadCount, value).any()})
+                .withSetter(Setter<decltype(*mThreadCount)>::StrictValueWithNoDeps)
+                .build());
+
+        addParameter(
+                DefineParam(mFrameThreading, C2_PARAMKEY_SOFT_FRAME_THREADING)
+                .withDefault(new C2SoftFrameThreadingTuning(C2_TRUE))
+                .withFields({C2F(mFrameThreading, value).oneOf({0, 1})})
+                .withSetter(Setter<decltype(*mFrameThreading)>::StrictValueWithNoDeps)
+                .build());
+
         addParameter(
                 DefineParam(mActualOutputDelay, C2_PARAMKEY_OUTPUT_DELAY)
                 .withDefault(new C2PortActualDelayTuning::output(kOutputDelay))
                 .withFields({C2F(mActualOutputDelay, value).inRange(0, kOutputDelay)})
-                .withSetter(ActualOutputDelaySetter, mLowLatencyMode)
+                .withSetter(ActualOutputDelaySetter, mLowLatencyMode, mFrameThreading)
                 .build());
     }
 
@@ -376,6 +390,10 @@ class C2SoftDav1dDec::IntfImpl : public SimpleInterface<void>::BaseParams {
         return mActualOutputDelay;
     }
 
+    std::shared_ptr<C2SoftThreadCountTuning> getThreadCount_l() const {
+        return mThreadCount;
+    }
+
     static C2R HdrStaticInfoSetter(bool mayBlock, C2P<C2StreamHdrStaticInfo::output>& me) {
         (void)mayBlock;
         if (me.v.mastering.red.x > 1) {
@@ -417,10 +435,12 @@ class C2SoftDav1dDec::IntfImpl : public SimpleInterface<void>::BaseParams {
         return C2R::Ok();
     }
 
+    // Without frame threading dav1d holds no more than one frame.
     static C2R ActualOutputDelaySetter(bool mayBlock, C2P<C2PortActualDelayTuning::output>& me,
-                                  const C2P<C2GlobalLowLatencyModeTuning>& lowLatencyMode) {
+                                  const C2P<C2GlobalLowLatencyModeTuning>& lowLatencyMode,
+                                  const C2P<C2SoftFrameThreadingTuning>& frameThreading) {
         (void)mayBlock;
-        me.set().value = lowLatencyMode.v.value ? 1 : kOutputDelay;
+        me.set().value = (lowLatencyMode.v.value || !frameThreading.v.value) ? 1 : kOutputDelay;
         return C2R::Ok();
     }
 
@@ -438,6 +458,8 @@ class C2SoftDav1dDec::IntfImpl : public SimpleInterface<void>::BaseParams {
     std::shared_ptr<C2StreamHdr10PlusInfo::output> mHdr10PlusInfoOutput;
     std::shared_ptr<C2StreamHdrStaticInfo::output> mHdrStaticInfo;
     std::shared_ptr<C2GlobalLowLatencyModeTuning> mLowLatencyMode;
+    std::shared_ptr<C2SoftThreadCountTuning> mThreadCount;
+    std::shared_ptr<C2SoftFrameThreadingTuning> mFrameThreading;
 };
 
 C2SoftDav1dDec::C2SoftDav1dDec(const char* name, c2_node_id_t id,
@@ -536,6 +558,7 @@ bool C2SoftDav1dDec::initDecoder() {
         IntfImpl::Lock lock = mIntf->lock();
         mPixelFormatInfo = mIntf->getPixelFormat_l();
         mActualOutputDelayInfo = mIntf->getActualOutputDelay_l();
+        mThreadCountInfo = mIntf->getThreadCount_l();
     }
 
     const char* version = dav1d_version();
@@ -544,6 +567,9 @@ bool C2SoftDav1dDec::initDecoder() {
     dav1d_default_settings(&lib_settings);
     int cpu_count = GetCPUCoreCount();
     lib_settings.n_threads = std::max(cpu_count / 2, 1);  // use up to half the cores by default.
+    if (mThreadCountInfo->value > 0) {
+        lib_settings.n_threads = std::min<uint32_t>(mThreadCountInfo->value, cpu_count);
+    }
 
     int32_t numThreads =
             android::base::GetIntProperty(NUM_THREADS_DAV1D_PROPERTY, NUM_THREADS_DAV1D_DEFAULT);
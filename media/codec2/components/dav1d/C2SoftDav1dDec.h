@@ -25,6 +25,7 @@
 
 #include <C2Config.h>
 #include <SimpleC2Component.h>
+#include <SimpleC2VendorParams.h>
 
 #include <dav1d/dav1d.h>
 #include <deque>
@@ -63,6 +64,7 @@ struct C2SoftDav1dDec : public SimpleC2Component {
     // (TODO: keep this in intf but make them internal only)
     std::shared_ptr<C2StreamPixelFormatInfo::output> mPixelFormatInfo;
     std::shared_ptr<C2PortActualDelayTuning::output> mActualOutputDelayInfo;
+    std::shared_ptr<C2SoftThreadCountTuning> mThreadCountInfo;
 
     uint32_t mHalPixelFormat;
     uint32_t mWidth;
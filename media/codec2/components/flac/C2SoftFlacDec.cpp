@@ -47,6 +47,7 @@ public:
         noOutputReferences();
         noInputLatency();
         noTimeStretch();
+        multipleAccessUnits();
         setDerivedInstance(this);
 
         addParameter(
@@ -275,15 +276,19 @@ void C2SoftFlacDec::process(
         return;
     }
 
+    // The input holds one FLAC frame per access unit.
+    const std::vector<uint32_t> auSizes = getInputAccessUnitSizes(work, inSize);
+    const size_t numFrames = auSizes.empty() ? 1 : auSizes.size();
+
     const bool outputFloat = mIntf->getPcmEncodingInfo() == C2Config::PCM_FLOAT;
     const size_t sampleSize = outputFloat ? sizeof(float) : sizeof(short);
-    size_t outSize = mHasStreamInfo ?
+    const size_t maxFrameOutSize = mHasStreamInfo ?
             mStreamInfo.max_blocksize * mStreamInfo.channels * sampleSize
           : kMaxBlockSize * FLACDecoder::kMaxChannels * sampleSize;
 
     std::shared_ptr<C2LinearBlock> block;
     C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
-    c2_status_t err = pool->fetchLinearBlock(outSize, usage, &block);
+    c2_status_t err = pool->fetchLinearBlock(maxFrameOutSize * numFrames, usage, &block);
     if (err != C2_OK) {
         ALOGE("fetchLinearBlock for Output failed with status %d", err);
         work->result = C2_NO_MEMORY;
@@ -296,13 +301,22 @@ void C2SoftFlacDec::process(
         return;
     }
 
-    status_t decoderErr = mFLACDecoder->decodeOneFrame(
-                            input, inSize, wView.data(), &outSize, outputFloat);
-    if (decoderErr != OK) {
-        ALOGE("process: FLACDecoder decodeOneFrame returns error %d", decoderErr);
-        mSignalledError = true;
-        work->result = C2_CORRUPTED;
-        return;
+    size_t outSize = 0;
+    size_t inPos = 0;
+    for (size_t i = 0; i < numFrames; ++i) {
+        const size_t frameInSize = auSizes.empty() ? inSize : auSizes[i];
+        size_t frameOutSize = maxFrameOutSize;
+        status_t decoderErr = mFLACDecoder->decodeOneFrame(
+                                input + inPos, frameInSize, wView.data() + outSize,
+                                &frameOutSize, outputFloat);
+        if (decoderErr != OK) {
+            ALOGE("process: FLACDecoder decodeOneFrame returns error %d", decoderErr);
+            mSignalledError = true;
+            work->result = C2_CORRUPTED;
+            return;
+        }
+        inPos += frameInSize;
+        outSize += frameOutSize;
     }
 
     mInputBufferCount++;
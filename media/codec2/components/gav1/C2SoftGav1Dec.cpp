@@ -48,6 +48,9 @@ constexpr char COMPONENT_NAME[] = CODECNAME;
 
 constexpr size_t kMinInputBufferSize = 2 * 1024 * 1024;
 
+// Number of frames kept in flight when frame parallel decoding is enabled.
+constexpr uint32_t kFrameParallelOutputDelay = 4;
+
 class C2SoftGav1Dec::IntfImpl : public SimpleInterface<void>::BaseParams {
  public:
   explicit IntfImpl(const std::shared_ptr<C2ReflectorHelper> &helper)
@@ -244,6 +247,27 @@ class C2SoftGav1Dec::IntfImpl : public SimpleInterface<void>::BaseParams {
             .withFields({C2F(mPixelFormat, value).oneOf(pixelFormats)})
             .withSetter((Setter<decltype(*mPixelFormat)>::StrictValueWithNoDeps))
             .build());
+
+    addParameter(
+        DefineParam(mThreadCount, C2_PARAMKEY_SOFT_THREAD_COUNT)
+            .withDefault(new C2SoftThreadCountTuning(0u))
+            .withFields({C2F(mThreadCount, value).any()})
+            .withSetter(Setter<decltype(*mThreadCount)>::StrictValueWithNoDeps)
+            .build());
+
+    addParameter(
+        DefineParam(mFrameThreading, C2_PARAMKEY_SOFT_FRAME_THREADING)
+            .withDefault(new C2SoftFrameThreadingTuning(C2_FALSE))
+            .withFields({C2F(mFrameThreading, value).oneOf({0, 1})})
+            .withSetter(Setter<decltype(*mFrameThreading)>::StrictValueWithNoDeps)
+            .build());
+
+    addParameter(
+        DefineParam(mActualOutputDelay, C2_PARAMKEY_OUTPUT_DELAY)
+            .withDefault(new C2PortActualDelayTuning::output(0u))
+            .withFields({C2F(mActualOutputDelay, value).inRange(0, kFrameParallelOutputDelay)})
+            .withSetter(ActualOutputDelaySetter, mFrameThreading)
+            .build());
   }
 
   static C2R SizeSetter(bool mayBlock,
@@ -364,8 +388,19 @@ class C2SoftGav1Dec::IntfImpl : public SimpleInterface<void>::BaseParams {
     return C2R::Ok();
   }
 
+  static C2R ActualOutputDelaySetter(bool mayBlock, C2P<C2PortActualDelayTuning::output> &me,
+                                     const C2P<C2SoftFrameThreadingTuning> &frameThreading) {
+    (void)mayBlock;
+    me.set().value = frameThreading.v.value ? kFrameParallelOutputDelay : 0;
+    return C2R::Ok();
+  }
+
   // unsafe getters
   std::shared_ptr<C2StreamPixelFormatInfo::output> getPixelFormat_l() const { return mPixelFormat; }
+  std::shared_ptr<C2SoftThreadCountTuning> getThreadCount_l() const { return mThreadCount; }
+  std::shared_ptr<C2SoftFrameThreadingTuning> getFrameThreading_l() const {
+    return mFrameThreading;
+  }
 
   static C2R HdrStaticInfoSetter(bool mayBlock, C2P<C2StreamHdrStaticInfo::output> &me) {
     (void)mayBlock;
@@ -421,6 +456,9 @@ class C2SoftGav1Dec::IntfImpl : public SimpleInterface<void>::BaseParams {
   std::shared_ptr<C2StreamHdr10PlusInfo::input> mHdr10PlusInfoInput;
   std::shared_ptr<C2StreamHdr10PlusInfo::output> mHdr10PlusInfoOutput;
   std::shared_ptr<C2StreamHdrStaticInfo::output> mHdrStaticInfo;
+  std::shared_ptr<C2SoftThreadCountTuning> mThreadCount;
+  std::shared_ptr<C2SoftFrameThreadingTuning> mFrameThreading;
+  std::shared_ptr<C2PortActualDelayTuning::output> mActualOutputDelay;
 };
 
 C2SoftGav1Dec::C2SoftGav1Dec(const char *name, c2_node_id_t id,
@@ -473,6 +511,7 @@ c2_status_t C2SoftGav1Dec::onFlush_sm() {
           status);
     return C2_CORRUPTED;
   }
+  mEnqueuedFrames.clear();
 
   mSignalledError = false;
   mSignalledOutputEos = false;
@@ -497,10 +536,14 @@ bool C2SoftGav1Dec::initDecoder() {
   mSignalledError = false;
   mSignalledOutputEos = false;
   mHalPixelFormat = HAL_PIXEL_FORMAT_YV12;
+  uint32_t threadCount;
   {
       IntfImpl::Lock lock = mIntf->lock();
       mPixelFormatInfo = mIntf->getPixelFormat_l();
+      threadCount = mIntf->getThreadCount_l()->value;
+      mFrameParallel = mIntf->getFrameThreading_l()->value;
   }
+  mEnqueuedFrames.clear();
   mCodecCtx.reset(new libgav1::Decoder());
 
   if (mCodecCtx == nullptr) {
@@ -510,10 +553,17 @@ bool C2SoftGav1Dec::initDecoder() {
 
   libgav1::DecoderSettings settings = {};
   settings.threads = GetCPUCoreCount();
+  if (threadCount > 0 && threadCount < static_cast<uint32_t>(settings.threads)) {
+    settings.threads = threadCount;
+  }
   int32_t numThreads = android::base::GetIntProperty(kNumThreadsProperty, 0);
   if (numThreads > 0 && numThreads < settings.threads) {
     settings.threads = numThreads;
   }
+  // In frame parallel mode the outputs are dequeued only once kFrameParallelOutputDelay
+  // frames are in flight, so DequeueFrame() waits for the oldest frame to be decoded.
+  settings.frame_parallel = mFrameParallel;
+  settings.blocking_dequeue = mFrameParallel;
 
   ALOGV("Using libgav1 AV1 software decoder.");
   Libgav1StatusCode status = mCodecCtx->Init(&settings);
@@ -541,14 +591,18 @@ void fillEmptyWork(const std::unique_ptr<C2Work> &work) {
 
 void C2SoftGav1Dec::finishWork(uint64_t index,
                                const std::unique_ptr<C2Work> &work,
-                               const std::shared_ptr<C2GraphicBlock> &block) {
+                               const std::shared_ptr<C2GraphicBlock> &block,
+                               std::vector<std::unique_ptr<C2Param>> configUpdate) {
   std::shared_ptr<C2Buffer> buffer =
       createGraphicBuffer(block, C2Rect(mWidth, mHeight));
   {
       IntfImpl::Lock lock = mIntf->lock();
       buffer->setInfo(mIntf->getColorAspects_l());
   }
-  auto fillWork = [buffer, index](const std::unique_ptr<C2Work> &work) {
+  // std::function must be copyable
+  auto updates = std::make_shared<std::vector<std::unique_ptr<C2Param>>>(
+      std::move(configUpdate));
+  auto fillWork = [buffer, index, updates](const std::unique_ptr<C2Work> &work) {
     uint32_t flags = 0;
     if ((work->input.flags & C2FrameData::FLAG_END_OF_STREAM) &&
         (c2_cntr64_t(index) == work->input.ordinal.frameIndex)) {
@@ -559,6 +613,10 @@ void C2SoftGav1Dec::finishWork(uint64_t index,
     work->worklets.front()->output.buffers.clear();
     work->worklets.front()->output.buffers.push_back(buffer);
     work->worklets.front()->output.ordinal = work->input.ordinal;
+    for (std::unique_ptr<C2Param> &param : *updates) {
+      work->worklets.front()->output.configUpdate.push_back(std::move(param));
+    }
+    updates->clear();
     work->workletsProcessed = 1u;
   };
   if (work && c2_cntr64_t(index) == work->input.ordinal.frameIndex) {
@@ -609,12 +667,30 @@ void C2SoftGav1Dec::process(const std::unique_ptr<C2Work> &work,
   if (inSize) {
     uint8_t *bitstream = const_cast<uint8_t *>(rView.data() + inOffset);
 
+    if (mFrameParallel) {
+      // The frame is decoded after this work is returned to the pending queue, which
+      // drops the input buffer. Keep a copy until the frame is dequeued.
+      mEnqueuedFrames.push_back({work->input.ordinal.frameIndex.peeku(),
+                                 std::vector<uint8_t>(bitstream, bitstream + inSize)});
+      bitstream = mEnqueuedFrames.back().input.data();
+    }
+
     mTimeStart = systemTime();
     nsecs_t delay = mTimeStart - mTimeEnd;
 
-    const Libgav1StatusCode status =
+    Libgav1StatusCode status =
         mCodecCtx->EnqueueFrame(bitstream, inSize, frameIndex,
                                 /*buffer_private_data=*/nullptr);
+    // The decoder queue is full: wait for the oldest frame to make room.
+    while (status == kLibgav1StatusTryAgain && mEnqueuedFrames.size() > 1) {
+      (void)outputBuffer(pool, work);
+      if (mSignalledError) {
+        // |work| was returned with the other enqueued frames.
+        return;
+      }
+      status = mCodecCtx->EnqueueFrame(bitstream, inSize, frameIndex,
+                                       /*buffer_private_data=*/nullptr);
+    }
 
     mTimeEnd = systemTime();
     nsecs_t decodeTime = mTimeEnd - mTimeStart;
@@ -622,15 +698,25 @@ void C2SoftGav1Dec::process(const std::unique_ptr<C2Work> &work,
 
     if (status != kLibgav1StatusOk) {
       ALOGE("av1 decoder failed to decode frame. status: %d.", status);
-      work->result = C2_CORRUPTED;
-      work->workletsProcessed = 1u;
-      mSignalledError = true;
+      if (mFrameParallel) {
+        // The frame was not enqueued.
+        mEnqueuedFrames.pop_back();
+      }
+      setError(frameIndex, work, C2_CORRUPTED);
       return;
     }
 
   }
 
-  (void)outputBuffer(pool, work);
+  if (!mFrameParallel) {
+    (void)outputBuffer(pool, work);
+  } else {
+    // Return frames only once they are beyond the output delay, so that the decoder
+    // always has the next frames to work on.
+    while (mEnqueuedFrames.size() > kFrameParallelOutputDelay && !mSignalledError) {
+      (void)outputBuffer(pool, work);
+    }
+  }
 
   if (eos) {
     drainInternal(DRAIN_COMPONENT_WITH_EOS, pool, work);
@@ -641,7 +727,7 @@ void C2SoftGav1Dec::process(const std::unique_ptr<C2Work> &work,
 }
 
 void C2SoftGav1Dec::getHDRStaticParams(const libgav1::DecoderBuffer *buffer,
-                                       const std::unique_ptr<C2Work> &work) {
+                                       std::vector<std::unique_ptr<C2Param>> *configUpdate) {
   C2StreamHdrStaticMetadataInfo::output hdrStaticMetadataInfo{};
   bool infoPresent = false;
   if (buffer->has_hdr_mdcv) {
@@ -674,12 +760,12 @@ void C2SoftGav1Dec::getHDRStaticParams(const libgav1::DecoderBuffer *buffer,
   // config if static info has changed
   if (infoPresent && !(hdrStaticMetadataInfo == mHdrStaticMetadataInfo)) {
     mHdrStaticMetadataInfo = hdrStaticMetadataInfo;
-    work->worklets.front()->output.configUpdate.push_back(C2Param::Copy(mHdrStaticMetadataInfo));
+    configUpdate->push_back(C2Param::Copy(mHdrStaticMetadataInfo));
   }
 }
 
-void C2SoftGav1Dec::getHDR10PlusInfoData(const libgav1::DecoderBuffer *buffer,
-                                         const std::unique_ptr<C2Work> &work) {
+bool C2SoftGav1Dec::getHDR10PlusInfoData(const libgav1::DecoderBuffer *buffer,
+                                         std::vector<std::unique_ptr<C2Param>> *configUpdate) {
   if (buffer->has_itut_t35) {
     std::vector<uint8_t> payload;
     size_t payloadSize = buffer->itut_t35.payload_size;
@@ -696,18 +782,17 @@ void C2SoftGav1Dec::getHDR10PlusInfoData(const libgav1::DecoderBuffer *buffer,
             C2StreamHdr10PlusInfo::output::AllocUnique(payload.size());
     if (!hdr10PlusInfo) {
       ALOGE("Hdr10PlusInfo allocation failed");
-      mSignalledError = true;
-      work->result = C2_NO_MEMORY;
-      return;
+      return false;
     }
     memcpy(hdr10PlusInfo->m.value, payload.data(), payload.size());
 
     // config if hdr10Plus info has changed
     if (nullptr == mHdr10PlusInfo || !(*hdr10PlusInfo == *mHdr10PlusInfo)) {
       mHdr10PlusInfo = std::move(hdr10PlusInfo);
-      work->worklets.front()->output.configUpdate.push_back(std::move(mHdr10PlusInfo));
+      configUpdate->push_back(std::move(mHdr10PlusInfo));
     }
   }
+  return true;
 }
 
 void C2SoftGav1Dec::getVuiParams(const libgav1::DecoderBuffer *buffer) {
@@ -742,10 +827,41 @@ void C2SoftGav1Dec::getVuiParams(const libgav1::DecoderBuffer *buffer) {
     }
 }
 
-void C2SoftGav1Dec::setError(const std::unique_ptr<C2Work> &work, c2_status_t error) {
-    mSignalledError = true;
+void C2SoftGav1Dec::finishWithError(uint64_t index, const std::unique_ptr<C2Work> &work,
+                                    c2_status_t error) {
+  auto fillWork = [error](const std::unique_ptr<C2Work> &work) {
     work->result = error;
     work->workletsProcessed = 1u;
+  };
+  if (work && c2_cntr64_t(index) == work->input.ordinal.frameIndex) {
+    fillWork(work);
+  } else {
+    finish(index, fillWork);
+  }
+}
+
+void C2SoftGav1Dec::setError(uint64_t index, const std::unique_ptr<C2Work> &work,
+                             c2_status_t error) {
+    mSignalledError = true;
+    finishWithError(index, work, error);
+    failEnqueuedFrames(work, error);
+}
+
+void C2SoftGav1Dec::failEnqueuedFrames(const std::unique_ptr<C2Work> &work,
+                                       c2_status_t error) {
+    if (mEnqueuedFrames.empty()) {
+        return;
+    }
+    // The frames are not dequeued anymore: wait for the decoder to be done with their
+    // inputs before dropping them.
+    const Libgav1StatusCode status = mCodecCtx->SignalEOS();
+    if (status != kLibgav1StatusOk) {
+        ALOGE("Failed to flush av1 decoder. status: %d.", status);
+    }
+    for (const EnqueuedFrame &frame : mEnqueuedFrames) {
+        finishWithError(frame.index, work, error);
+    }
+    mEnqueuedFrames.clear();
 }
 
 bool C2SoftGav1Dec::allocTmpFrameBuffer(size_t size) {
@@ -775,31 +891,69 @@ bool C2SoftGav1Dec::fillMonochromeRow(int value) {
 
 bool C2SoftGav1Dec::outputBuffer(const std::shared_ptr<C2BlockPool> &pool,
                                  const std::unique_ptr<C2Work> &work) {
-  if (!(work && pool)) return false;
+  // |work| is null when draining without a work: the frames return their own works.
+  if (!pool) return false;
 
   const libgav1::DecoderBuffer *buffer;
   const Libgav1StatusCode status = mCodecCtx->DequeueFrame(&buffer);
 
-  if (status != kLibgav1StatusOk && status != kLibgav1StatusNothingToDequeue) {
+  if (status == kLibgav1StatusNothingToDequeue) {
+    if (!mEnqueuedFrames.empty()) {
+      ALOGE("av1 decoder lost %zu enqueued frames", mEnqueuedFrames.size());
+      mSignalledError = true;
+      failEnqueuedFrames(work, C2_CORRUPTED);
+    }
+    return false;
+  }
+
+  // Each dequeue completes the oldest enqueued frame, successfully or not. Without frame
+  // parallel decoding, that is the frame of |work|.
+  bool hasFrame = false;
+  uint64_t frameIndex = 0;
+  if (!mEnqueuedFrames.empty()) {
+    hasFrame = true;
+    frameIndex = mEnqueuedFrames.front().index;
+    mEnqueuedFrames.pop_front();
+  } else if (!mFrameParallel && work) {
+    hasFrame = true;
+    frameIndex = work->input.ordinal.frameIndex.peeku();
+  }
+
+  if (status != kLibgav1StatusOk) {
     ALOGE("av1 decoder DequeueFrame failed. status: %d.", status);
+    if (hasFrame) {
+      setError(frameIndex, work, C2_CORRUPTED);
+    } else {
+      mSignalledError = true;
+    }
     return false;
   }
 
-  // |buffer| can be NULL if status was equal to kLibgav1StatusOk or
-  // kLibgav1StatusNothingToDequeue. This is not an error. This could mean one
-  // of two things:
+  // |buffer| can be NULL if status was equal to kLibgav1StatusOk. This is not an
+  // error. This could mean one of two things:
   //  - The EnqueueFrame() call was either a flush (called with nullptr).
   //  - The enqueued frame did not have any displayable frames.
   if (!buffer) {
+    if (mFrameParallel && hasFrame) {
+      // Nothing else returns the work of the frame.
+      if (work && c2_cntr64_t(frameIndex) == work->input.ordinal.frameIndex) {
+        fillEmptyWork(work);
+      } else {
+        finish(frameIndex, fillEmptyWork);
+      }
+    }
     return false;
   }
 
+  // With frame parallel decoding, the frame may belong to a work returned to the pending
+  // queue before |work|: its results are attached to its own work.
+  const uint64_t index = buffer->user_private_data;
+  std::vector<std::unique_ptr<C2Param>> configUpdate;
+
 #if LIBYUV_VERSION < 1871
   if (buffer->bitdepth > 10) {
     ALOGE("bitdepth %d is not supported", buffer->bitdepth);
-    mSignalledError = true;
-    work->workletsProcessed = 1u;
-    work->result = C2_CORRUPTED;
+    setError(index, work, C2_CORRUPTED);
     return false;
   }
 #endif
@@ -814,29 +968,27 @@ bool C2SoftGav1Dec::outputBuffer(const std::shared_ptr<C2BlockPool> &pool,
     std::vector<std::unique_ptr<C2SettingResult>> failures;
     c2_status_t err = mIntf->config({&size}, C2_MAY_BLOCK, &failures);
     if (err == C2_OK) {
-      work->worklets.front()->output.configUpdate.push_back(
-          C2Param::Copy(size));
+      configUpdate.push_back(C2Param::Copy(size));
     } else {
       ALOGE("Config update size failed");
-      mSignalledError = true;
-      work->result = C2_CORRUPTED;
-      work->workletsProcessed = 1u;
+      setError(index, work, C2_CORRUPTED);
       return false;
     }
   }
 
   getVuiParams(buffer);
-  getHDRStaticParams(buffer, work);
-  getHDR10PlusInfoData(buffer, work);
+  getHDRStaticParams(buffer, &configUpdate);
+  if (!getHDR10PlusInfoData(buffer, &configUpdate)) {
+    setError(index, work, C2_NO_MEMORY);
+    return false;
+  }
 
 #if LIBYUV_VERSION < 1779
   if (buffer->bitdepth == 10 &&
       !(buffer->image_format == libgav1::kImageFormatYuv420 ||
         buffer->image_format == libgav1::kImageFormatMonochrome400)) {
     ALOGE("image_format %d not supported for 10bit", buffer->image_format);
-    mSignalledError = true;
-    work->workletsProcessed = 1u;
-    work->result = C2_CORRUPTED;
+    setError(index, work, C2_CORRUPTED);
     return false;
   }
 #endif
@@ -862,9 +1014,7 @@ bool C2SoftGav1Dec::outputBuffer(const std::shared_ptr<C2BlockPool> &pool,
         (buffer->image_format != libgav1::kImageFormatYuv420) &&
         (buffer->bitdepth == 10)) {
         ALOGE("Only YUV420 output is supported for 10-bit when targeting RGBA_1010102");
-      mSignalledError = true;
-      work->result = C2_OMITTED;
-      work->workletsProcessed = 1u;
+      setError(index, work, C2_OMITTED);
       return false;
     }
 #endif
@@ -887,14 +1037,11 @@ bool C2SoftGav1Dec::outputBuffer(const std::shared_ptr<C2BlockPool> &pool,
     std::vector<std::unique_ptr<C2SettingResult>> failures;
     c2_status_t err = mIntf->config({&pixelFormat }, C2_MAY_BLOCK, &failures);
     if (err == C2_OK) {
-      work->worklets.front()->output.configUpdate.push_back(
-          C2Param::Copy(pixelFormat));
+      configUpdate.push_back(C2Param::Copy(pixelFormat));
     } else {
       ALOGE("Config update pixelFormat failed");
-      mSignalledError = true;
-      work->workletsProcessed = 1u;
-      work->result = C2_CORRUPTED;
-      return UNKNOWN_ERROR;
+      setError(index, work, C2_CORRUPTED);
+      return false;
     }
     mHalPixelFormat = format;
   }
@@ -910,7 +1057,7 @@ bool C2SoftGav1Dec::outputBuffer(const std::shared_ptr<C2BlockPool> &pool,
 
   if (err != C2_OK) {
     ALOGE("fetchGraphicBlock for Output failed with status %d", err);
-    work->result = err;
+    finishWithError(index, work, err);
     return false;
   }
 
@@ -918,12 +1065,12 @@ bool C2SoftGav1Dec::outputBuffer(const std::shared_ptr<C2BlockPool> &pool,
 
   if (wView.error()) {
     ALOGE("graphic view map failed %d", wView.error());
-    work->result = C2_CORRUPTED;
+    finishWithError(index, work, C2_CORRUPTED);
     return false;
   }
 
   ALOGV("provided (%dx%d) required (%dx%d), out frameindex %d", block->width(),
-        block->height(), mWidth, mHeight, (int)buffer->user_private_data);
+        block->height(), mWidth, mHeight, (int)index);
 
   uint8_t *dstY = const_cast<uint8_t *>(wView.data()[C2PlanarLayout::PLANE_Y]);
   uint8_t *dstU = const_cast<uint8_t *>(wView.data()[C2PlanarLayout::PLANE_U]);
@@ -944,7 +1091,7 @@ bool C2SoftGav1Dec::outputBuffer(const std::shared_ptr<C2BlockPool> &pool,
       size_t srcVStride = buffer->stride[2] / 2;
       if (isMonochrome) {
           if (!fillMonochromeRow(2048)) {
-              setError(work, C2_NO_MEMORY);
+              setError(index, work, C2_NO_MEMORY);
               return false;
           }
           srcU = srcV = mTmpFrameBuffer.get();
@@ -994,7 +1141,7 @@ bool C2SoftGav1Dec::outputBuffer(const std::shared_ptr<C2BlockPool> &pool,
         if (!processed) {
             if (isMonochrome) {
                 if (!fillMonochromeRow(512)) {
-                    setError(work, C2_NO_MEMORY);
+                    setError(index, work, C2_NO_MEMORY);
                     return false;
                 }
                 srcU = srcV = mTmpFrameBuffer.get();
@@ -1020,7 +1167,7 @@ bool C2SoftGav1Dec::outputBuffer(const std::shared_ptr<C2BlockPool> &pool,
             const size_t tmpSize = dstYStride * mHeight + dstUStride * align(mHeight, 2);
             if (!allocTmpFrameBuffer(tmpSize)) {
                 ALOGE("Error allocating temp conversion buffer (%zu bytes)", tmpSize);
-                setError(work, C2_NO_MEMORY);
+                setError(index, work, C2_NO_MEMORY);
                 return false;
             }
             uint16_t *const tmpY = mTmpFrameBuffer.get();
@@ -1056,7 +1203,7 @@ bool C2SoftGav1Dec::outputBuffer(const std::shared_ptr<C2BlockPool> &pool,
             const size_t tmpSize = dstYStride * mHeight + dstUStride * align(mHeight, 2);
             if (!allocTmpFrameBuffer(tmpSize)) {
                 ALOGE("Error allocating temp conversion buffer (%zu bytes)", tmpSize);
-                setError(work, C2_NO_MEMORY);
+                setError(index, work, C2_NO_MEMORY);
                 return false;
             }
             uint16_t *const tmpY = mTmpFrameBuffer.get();
@@ -1105,7 +1252,7 @@ bool C2SoftGav1Dec::outputBuffer(const std::shared_ptr<C2BlockPool> &pool,
                                    isMonochrome);
     }
   }
-  finishWork(buffer->user_private_data, work, std::move(block));
+  finishWork(index, work, std::move(block), std::move(configUpdate));
   block = nullptr;
   return true;
 }
@@ -1122,6 +1269,13 @@ c2_status_t C2SoftGav1Dec::drainInternal(
     return C2_OMITTED;
   }
 
+  // Return the frames still being decoded before the decoder is reset. Their works are
+  // pending even when draining without a work, and only their frames return them.
+  while (pool && !mEnqueuedFrames.empty() && !mSignalledError) {
+    (void)outputBuffer(pool, work);
+  }
+  failEnqueuedFrames(work, C2_CORRUPTED);
+
   const Libgav1StatusCode status = mCodecCtx->SignalEOS();
   if (status != kLibgav1StatusOk) {
     ALOGE("Failed to flush av1 decoder. status: %d.", status);
@@ -19,11 +19,14 @@
 
 #include <inttypes.h>
 
+#include <deque>
 #include <memory>
+#include <vector>
 
 #include <media/stagefright/foundation/ColorUtils.h>
 
 #include <SimpleC2Component.h>
+#include <SimpleC2VendorParams.h>
 #include <C2Config.h>
 #include <gav1/decoder.h>
 #include <gav1/decoder_settings.h>
@@ -57,6 +60,16 @@ struct C2SoftGav1Dec : public SimpleC2Component {
   // (TODO: keep this in intf but make them internal only)
   std::shared_ptr<C2StreamPixelFormatInfo::output> mPixelFormatInfo;
 
+  // Whether libgav1 decodes several frames in parallel.
+  bool mFrameParallel = false;
+  // A frame enqueued in frame parallel mode: its work index and a copy of its input.
+  struct EnqueuedFrame {
+    uint64_t index;
+    std::vector<uint8_t> input;
+  };
+  // The frames enqueued in frame parallel mode and not dequeued yet, oldest first.
+  std::deque<EnqueuedFrame> mEnqueuedFrames;
+
   uint32_t mHalPixelFormat;
   uint32_t mWidth;
   uint32_t mHeight;
@@ -94,16 +107,24 @@ struct C2SoftGav1Dec : public SimpleC2Component {
   nsecs_t mTimeEnd = 0;    // Time at the end of decode()
 
   bool initDecoder();
+  // The config updates of the frame are added to |configUpdate|.
   void getHDRStaticParams(const libgav1::DecoderBuffer *buffer,
-                  const std::unique_ptr<C2Work> &work);
-  void getHDR10PlusInfoData(const libgav1::DecoderBuffer *buffer,
-                  const std::unique_ptr<C2Work> &work);
+                  std::vector<std::unique_ptr<C2Param>> *configUpdate);
+  // Returns false if the info cannot be allocated.
+  bool getHDR10PlusInfoData(const libgav1::DecoderBuffer *buffer,
+                  std::vector<std::unique_ptr<C2Param>> *configUpdate);
   void getVuiParams(const libgav1::DecoderBuffer *buffer);
   void destroyDecoder();
   void finishWork(uint64_t index, const std::unique_ptr<C2Work>& work,
-                  const std::shared_ptr<C2GraphicBlock>& block);
-  // Sets |work->result| and mSignalledError. Returns false.
-  void setError(const std::unique_ptr<C2Work> &work, c2_status_t error);
+                  const std::shared_ptr<C2GraphicBlock>& block,
+                  std::vector<std::unique_ptr<C2Param>> configUpdate);
+  // Returns the work of the frame |index|, |work| or a pending one, with |error|.
+  void finishWithError(uint64_t index, const std::unique_ptr<C2Work> &work,
+                       c2_status_t error);
+  // Same as finishWithError(), sets mSignalledError and fails the frames still enqueued.
+  void setError(uint64_t index, const std::unique_ptr<C2Work> &work, c2_status_t error);
+  // Discards the frames still enqueued and returns their works with |error|.
+  void failEnqueuedFrames(const std::unique_ptr<C2Work> &work, c2_status_t error);
   bool allocTmpFrameBuffer(size_t size);
   bool fillMonochromeRow(int value);
   bool outputBuffer(const std::shared_ptr<C2BlockPool>& pool,
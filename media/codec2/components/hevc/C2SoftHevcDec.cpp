@@ -339,6 +339,8 @@ C2SoftHevcDec::C2SoftHevcDec(
         mHeight(240),
         mHeaderDecoded(false),
         mOutIndex(0u) {
+    // the listener callbacks overlap with decoding
+    setPipelineStages(STAGE_OUTPUT);
 }
 
 C2SoftHevcDec::~C2SoftHevcDec() {
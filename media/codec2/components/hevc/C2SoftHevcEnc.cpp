@@ -99,13 +99,27 @@ class C2SoftHevcEnc::IntfImpl : public SimpleInterface<void>::BaseParams {
                 .withSetter(GopSetter)
                 .build());
 
+        addParameter(
+                DefineParam(mLookahead, C2_PARAMKEY_SOFT_LOOKAHEAD)
+                .withDefault(new C2SoftLookaheadTuning(DEFAULT_RC_LOOKAHEAD))
+                .withFields({C2F(mLookahead, value).inRange(0, MAX_RC_LOOKAHEAD)})
+                .withSetter(Setter<decltype(*mLookahead)>::NonStrictValueWithNoDeps)
+                .build());
+
         addParameter(
                 DefineParam(mActualInputDelay, C2_PARAMKEY_INPUT_DELAY)
                 .withDefault(new C2PortActualDelayTuning::input(
                     DEFAULT_B_FRAMES + DEFAULT_RC_LOOKAHEAD))
                 .withFields({C2F(mActualInputDelay, value).inRange(
                     0, MAX_B_FRAMES + MAX_RC_LOOKAHEAD)})
-                .calculatedAs(InputDelaySetter, mGop)
+                .calculatedAs(InputDelaySetter, mGop, mLookahead)
+                .build());
+
+        addParameter(
+                DefineParam(mThreadCount, C2_PARAMKEY_SOFT_THREAD_COUNT)
+                .withDefault(new C2SoftThreadCountTuning(0u))
+                .withFields({C2F(mThreadCount, value).any()})
+                .withSetter(Setter<decltype(*mThreadCount)>::StrictValueWithNoDeps)
                 .build());
 
         addParameter(
@@ -263,11 +277,12 @@ class C2SoftHevcEnc::IntfImpl : public SimpleInterface<void>::BaseParams {
     static C2R InputDelaySetter(
             bool mayBlock,
             C2P<C2PortActualDelayTuning::input> &me,
-            const C2P<C2StreamGopTuning::output> &gop) {
+            const C2P<C2StreamGopTuning::output> &gop,
+            const C2P<C2SoftLookaheadTuning> &lookahead) {
         (void)mayBlock;
         uint32_t maxBframes = 0;
         ParseGop(gop.v, nullptr, nullptr, &maxBframes);
-        me.set().value = maxBframes + DEFAULT_RC_LOOKAHEAD;
+        me.set().value = maxBframes + lookahead.v.value;
         return C2R::Ok();
     }
 
@@ -543,6 +558,12 @@ class C2SoftHevcEnc::IntfImpl : public SimpleInterface<void>::BaseParams {
     std::shared_ptr<C2StreamPictureQuantizationTuning::output> getPictureQuantization_l() const {
         return mPictureQuantization;
     }
+    std::shared_ptr<C2SoftThreadCountTuning> getThreadCount_l() const {
+        return mThreadCount;
+    }
+    std::shared_ptr<C2SoftLookaheadTuning> getLookahead_l() const {
+        return mLookahead;
+    }
 
    private:
     std::shared_ptr<C2StreamUsageTuning::input> mUsage;
@@ -559,6 +580,8 @@ class C2SoftHevcEnc::IntfImpl : public SimpleInterface<void>::BaseParams {
     std::shared_ptr<C2StreamColorAspectsInfo::input> mColorAspects;
     std::shared_ptr<C2StreamColorAspectsInfo::output> mCodedColorAspects;
     std::shared_ptr<C2StreamPictureQuantizationTuning::output> mPictureQuantization;
+    std::shared_ptr<C2SoftThreadCountTuning> mThreadCount;
+    std::shared_ptr<C2SoftLookaheadTuning> mLookahead;
 };
 
 static size_t GetCPUCoreCount() {
@@ -618,6 +641,7 @@ void C2SoftHevcEnc::onRelease() {
 }
 
 c2_status_t C2SoftHevcEnc::onFlush_sm() {
+    mInputTimes.clear();
     return C2_OK;
 }
 
@@ -648,7 +672,11 @@ static int getQpFromQuality(int quality) {
 }
 c2_status_t C2SoftHevcEnc::initEncParams() {
     mCodecCtx = nullptr;
-    mNumCores = std::min(GetCPUCoreCount(), (size_t) CODEC_MAX_CORES);
+    mNumCores = GetCPUCoreCount();
+    if (mThreadCount->value > 0) {
+        mNumCores = std::min((size_t) mThreadCount->value, mNumCores);
+    }
+    mNumCores = std::min(mNumCores, (size_t) CODEC_MAX_CORES);
     memset(&mEncParams, 0, sizeof(ihevce_static_cfg_params_t));
 
     // default configuration
@@ -719,7 +747,7 @@ c2_status_t C2SoftHevcEnc::initEncParams() {
     mIvVideoColorFormat = IV_YUV_420P;
     mEncParams.s_multi_thrd_prms.i4_max_num_cores = mNumCores;
     mEncParams.s_out_strm_prms.i4_codec_profile = mHevcEncProfile;
-    mEncParams.s_lap_prms.i4_rc_look_ahead_pics = DEFAULT_RC_LOOKAHEAD;
+    mEncParams.s_lap_prms.i4_rc_look_ahead_pics = mLookahead->value;
     if (mBframes == 0) {
         mEncParams.s_coding_tools_prms.i4_max_temporal_layers = 0;
     } else if (mBframes <= 2) {
@@ -792,6 +820,7 @@ c2_status_t C2SoftHevcEnc::initEncParams() {
 }
 
 c2_status_t C2SoftHevcEnc::releaseEncoder() {
+    mInputTimes.clear();
     mSpsPpsHeaderReceived = false;
     mSignalledEos = false;
     mSignalledError = false;
@@ -829,6 +858,8 @@ c2_status_t C2SoftHevcEnc::initEncoder() {
         mRequestSync = mIntf->getRequestSync_l();
         mColorAspects = mIntf->getCodedColorAspects_l();
         mQpBounds = mIntf->getPictureQuantization_l();;
+        mThreadCount = mIntf->getThreadCount_l();
+        mLookahead = mIntf->getLookahead_l();
     }
 
     c2_status_t status = initEncParams();
@@ -1039,6 +1070,13 @@ void C2SoftHevcEnc::finishWork(uint64_t index,
             0u /* stream id */, C2Config::SYNC_FRAME));
     }
 
+    auto it = mInputTimes.find(index);
+    if (it != mInputTimes.end()) {
+        buffer->setInfo(std::make_shared<C2SoftEncodeLatencyInfo::output>(
+            0u /* stream id */, ns2us(systemTime() - it->second)));
+        mInputTimes.erase(it);
+    }
+
     auto fillWork = [buffer](const std::unique_ptr<C2Work>& work) {
         work->worklets.front()->output.flags = (C2FrameData::flags_t)0;
         work->worklets.front()->output.buffers.clear();
@@ -1216,6 +1254,7 @@ void C2SoftHevcEnc::process(const std::unique_ptr<C2Work>& work,
     timeDelay = mTimeStart - mTimeEnd;
 
     if (inputBuffer) {
+        mInputTimes[workIndex] = mTimeStart;
         err = ihevce_encode(mCodecCtx, &s_encode_ip, &s_encode_op);
         if (IHEVCE_EOK != err) {
             ALOGE("Encode Frame failed : 0x%x", err);
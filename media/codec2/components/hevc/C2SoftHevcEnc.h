@@ -18,6 +18,7 @@
 #define ANDROID_C2_SOFT_HEVC_ENC_H_
 
 #include <SimpleC2Component.h>
+#include <SimpleC2VendorParams.h>
 #include <algorithm>
 #include <inttypes.h>
 #include <map>
@@ -30,7 +31,7 @@ namespace android {
 
 #define CODEC_MAX_CORES  4
 #define MAX_B_FRAMES     1
-#define MAX_RC_LOOKAHEAD 1
+#define MAX_RC_LOOKAHEAD 8
 
 #define DEFAULT_B_FRAMES     0
 #define DEFAULT_RC_LOOKAHEAD 0
@@ -89,6 +90,10 @@ struct C2SoftHevcEnc : public SimpleC2Component {
     std::shared_ptr<C2StreamRequestSyncFrameTuning::output> mRequestSync;
     std::shared_ptr<C2StreamColorAspectsInfo::output> mColorAspects;
     std::shared_ptr<C2StreamPictureQuantizationTuning::output> mQpBounds;
+    std::shared_ptr<C2SoftThreadCountTuning> mThreadCount;
+    std::shared_ptr<C2SoftLookaheadTuning> mLookahead;
+    // Time at which each work in flight was handed to the encoder, by work index.
+    std::map<uint64_t, nsecs_t> mInputTimes;
 #ifdef FILE_DUMP_ENABLE
     char mInFile[200];
     char mOutFile[200];
@@ -51,6 +51,7 @@ public:
         noOutputReferences();
         noInputLatency();
         noTimeStretch();
+        multipleAccessUnits();
         setDerivedInstance(this);
 
         addParameter(
@@ -403,6 +404,7 @@ void C2SoftMP3::process(
     auto it = decodedSizes.begin();
     size_t inPos = 0;
     int32_t samplingRate = mConfig->samplingRate;
+    // Frames are decoded up to the end of the input, which may hold several access units.
     while (inPos < inSize) {
         if (it == decodedSizes.end()) {
             ALOGE("unexpected trailing bytes, ignoring them");
@@ -51,6 +51,7 @@ public:
         noOutputReferences();
         noInputLatency();
         noTimeStretch();
+        multipleAccessUnits();
         setDerivedInstance(this);
 
         addParameter(
@@ -374,10 +375,15 @@ void C2SoftOpusDec::process(
     // other timestamp).
     if (work->input.ordinal.timestamp.peeku() == 0) mSamplesToDiscard = mCodecDelay;
 
+    // The input holds one Opus packet per access unit.
+    const std::vector<uint32_t> auSizes = getInputAccessUnitSizes(work, inSize);
+    const size_t numPackets = auSizes.empty() ? 1 : auSizes.size();
+
     std::shared_ptr<C2LinearBlock> block;
     C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
     c2_status_t err = pool->fetchLinearBlock(
-                          kMaxNumSamplesPerBuffer * kMaxChannels * sizeof(int16_t),
+                          numPackets * kMaxNumSamplesPerBuffer * mHeader.channels
+                                  * sizeof(int16_t),
                           usage, &block);
     if (err != C2_OK) {
         ALOGE("fetchLinearBlock for Output failed with status %d", err);
@@ -391,18 +397,25 @@ void C2SoftOpusDec::process(
         return;
     }
 
-    int numSamples = opus_multistream_decode(mDecoder,
-                                             data,
-                                             inSize,
-                                             reinterpret_cast<int16_t *> (wView.data()),
-                                             kMaxOpusOutputPacketSizeSamples,
-                                             0);
-    if (numSamples < 0) {
-        ALOGE("opus_multistream_decode returned numSamples %d", numSamples);
-        numSamples = 0;
-        mSignalledError = true;
-        work->result = C2_CORRUPTED;
-        return;
+    int numSamples = 0;
+    size_t inPos = 0;
+    for (size_t i = 0; i < numPackets; ++i) {
+        const size_t packetSize = auSizes.empty() ? inSize : auSizes[i];
+        int packetSamples = opus_multistream_decode(
+                mDecoder,
+                data + inPos,
+                packetSize,
+                reinterpret_cast<int16_t *> (wView.data()) + numSamples * mHeader.channels,
+                kMaxOpusOutputPacketSizeSamples,
+                0);
+        if (packetSamples < 0) {
+            ALOGE("opus_multistream_decode returned numSamples %d", packetSamples);
+            mSignalledError = true;
+            work->result = C2_CORRUPTED;
+            return;
+        }
+        inPos += packetSize;
+        numSamples += packetSamples;
     }
 
     int outOffset = 0;
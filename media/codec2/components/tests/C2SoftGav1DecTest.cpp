@@ -0,0 +1,244 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "C2SoftGav1DecTest"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <android-base/file.h>
+#include <log/log.h>
+#include <C2Buffer.h>
+#include <C2Component.h>
+#include <C2ComponentFactory.h>
+#include <C2Config.h>
+#include <C2PlatformSupport.h>
+#include <SimpleC2VendorParams.h>
+
+extern "C" ::C2ComponentFactory* CreateCodec2Factory();
+extern "C" void DestroyCodec2Factory(::C2ComponentFactory* factory);
+
+namespace android {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr char kComponentName[] = "c2.android.av1.decoder";
+// from media_c2_v1_video_decode_res
+constexpr char kInputFile[] = "bbb_av1_176_144.av1";
+constexpr char kInfoFile[] = "bbb_av1_176_144.info";
+// more frames than the decoder keeps in flight in frame parallel mode
+constexpr size_t kNumFrames = 12;
+constexpr std::chrono::seconds kTimeout = 5s;
+
+struct Frame {
+  std::vector<uint8_t> data;
+  uint64_t timestampUs;
+};
+
+// Reads the first |count| frames of the stream, as described by the info file.
+bool ReadFrames(size_t count, std::vector<Frame>* frames) {
+  const std::string dir = base::GetExecutableDirectory() + "/";
+  std::ifstream info(dir + kInfoFile);
+  std::ifstream input(dir + kInputFile, std::ifstream::binary);
+  if (!info.is_open() || !input.is_open()) {
+    return false;
+  }
+  size_t size;
+  uint32_t flags;
+  uint64_t timestampUs;
+  while (frames->size() < count && info >> size >> flags >> timestampUs) {
+    Frame frame{std::vector<uint8_t>(size), timestampUs};
+    if (!input.read(reinterpret_cast<char*>(frame.data.data()), size)) {
+      return false;
+    }
+    frames->push_back(std::move(frame));
+  }
+  return frames->size() == count;
+}
+
+class LinearBuffer : public C2Buffer {
+ public:
+  explicit LinearBuffer(const std::shared_ptr<C2LinearBlock>& block, size_t size)
+      : C2Buffer({block->share(block->offset(), size, ::C2Fence())}) {}
+};
+
+class Listener : public C2Component::Listener {
+ public:
+  void onWorkDone_nb(std::weak_ptr<C2Component>,
+                     std::list<std::unique_ptr<C2Work>> workItems) override {
+    std::lock_guard<std::mutex> lock(mLock);
+    for (std::unique_ptr<C2Work>& work : workItems) {
+      const uint64_t index = work->input.ordinal.frameIndex.peeku();
+      ++mNumDone[index];
+      mDone.push_back(std::move(work));
+    }
+    mCondition.notify_all();
+  }
+
+  void onTripped_nb(std::weak_ptr<C2Component>,
+                    std::vector<std::shared_ptr<C2SettingResult>>) override {}
+
+  void onError_nb(std::weak_ptr<C2Component>, uint32_t errorCode) override {
+    ALOGE("component error %u", errorCode);
+  }
+
+  // Waits until |count| works are done and returns them.
+  std::list<std::unique_ptr<C2Work>> waitForWorks(size_t count) {
+    std::unique_lock<std::mutex> lock(mLock);
+    mCondition.wait_for(lock, kTimeout, [this, count] { return mDone.size() >= count; });
+    std::list<std::unique_ptr<C2Work>> done;
+    done.swap(mDone);
+    return done;
+  }
+
+  // Number of times each work was returned, by frame index.
+  std::map<uint64_t, size_t> numDone() {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mNumDone;
+  }
+
+ private:
+  std::mutex mLock;
+  std::condition_variable mCondition;
+  std::list<std::unique_ptr<C2Work>> mDone;
+  std::map<uint64_t, size_t> mNumDone;
+};
+
+}  // namespace
+
+// Decodes with frame threading on, where the decoder keeps several frames in flight
+// after their works were returned to the pending queue.
+class C2SoftGav1DecTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(ReadFrames(kNumFrames, &mFrames)) << "cannot read " << kInputFile;
+
+    std::vector<std::tuple<C2String, C2ComponentFactory::CreateCodec2FactoryFunc,
+                           C2ComponentFactory::DestroyCodec2FactoryFunc>> factoryFuncs;
+    factoryFuncs.emplace_back(kComponentName, &CreateCodec2Factory, &DestroyCodec2Factory);
+    std::shared_ptr<C2ComponentStore> store = GetTestComponentStore(factoryFuncs);
+    ASSERT_NE(nullptr, store);
+    ASSERT_EQ(C2_OK, store->createComponent(kComponentName, &mComponent));
+    ASSERT_EQ(C2_OK, GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &mLinearPool));
+
+    C2SoftFrameThreadingTuning frameThreading(C2_TRUE);
+    std::vector<std::unique_ptr<C2SettingResult>> failures;
+    ASSERT_EQ(C2_OK, mComponent->intf()->config_vb({&frameThreading}, C2_MAY_BLOCK, &failures));
+    ASSERT_TRUE(failures.empty());
+
+    mListener = std::make_shared<Listener>();
+    ASSERT_EQ(C2_OK, mComponent->setListener_vb(mListener, C2_MAY_BLOCK));
+    ASSERT_EQ(C2_OK, mComponent->start());
+  }
+
+  void TearDown() override {
+    if (mComponent) {
+      (void)mComponent->stop();
+      (void)mComponent->release();
+    }
+  }
+
+  // Queues the frames, the last one with |lastFlags|.
+  void queueFrames(uint32_t lastFlags) {
+    std::list<std::unique_ptr<C2Work>> items;
+    for (size_t ix = 0; ix < mFrames.size(); ++ix) {
+      const Frame& frame = mFrames[ix];
+      std::shared_ptr<C2LinearBlock> block;
+      ASSERT_EQ(C2_OK, mLinearPool->fetchLinearBlock(
+                           frame.data.size(),
+                           {C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE}, &block));
+      C2WriteView view = block->map().get();
+      ASSERT_EQ(C2_OK, view.error());
+      memcpy(view.base(), frame.data.data(), frame.data.size());
+
+      std::unique_ptr<C2Work> work(new C2Work);
+      work->input.flags = (C2FrameData::flags_t)(ix + 1 == mFrames.size() ? lastFlags : 0);
+      work->input.ordinal.timestamp = frame.timestampUs;
+      work->input.ordinal.frameIndex = ix;
+      work->input.buffers.emplace_back(new LinearBuffer(block, frame.data.size()));
+      work->worklets.emplace_back(new C2Worklet);
+      items.push_back(std::move(work));
+    }
+    ASSERT_EQ(C2_OK, mComponent->queue_nb(&items));
+  }
+
+  // Checks that every work came back once, decoded, in order.
+  void checkWorks(const std::list<std::unique_ptr<C2Work>>& works, size_t count) {
+    ASSERT_EQ(count, works.size());
+    uint64_t index = 0;
+    for (const std::unique_ptr<C2Work>& work : works) {
+      SCOPED_TRACE(index);
+      EXPECT_EQ(c2_cntr64_t(index), work->input.ordinal.frameIndex);
+      EXPECT_EQ(C2_OK, work->result);
+      ASSERT_EQ(1u, work->workletsProcessed);
+      if (index < mFrames.size()) {
+        EXPECT_EQ(1u, work->worklets.front()->output.buffers.size());
+      }
+      ++index;
+    }
+    for (const auto& [workIndex, numDone] : mListener->numDone()) {
+      EXPECT_EQ(1u, numDone) << "work " << workIndex;
+    }
+  }
+
+  std::vector<Frame> mFrames;
+  std::shared_ptr<C2Component> mComponent;
+  std::shared_ptr<C2BlockPool> mLinearPool;
+  std::shared_ptr<Listener> mListener;
+};
+
+TEST_F(C2SoftGav1DecTest, DrainReturnsFramesInFlight) {
+  ASSERT_NO_FATAL_FAILURE(queueFrames(0));
+  ASSERT_EQ(C2_OK, mComponent->drain_nb(C2Component::DRAIN_COMPONENT_NO_EOS));
+  ASSERT_NO_FATAL_FAILURE(checkWorks(mListener->waitForWorks(mFrames.size()), mFrames.size()));
+}
+
+TEST_F(C2SoftGav1DecTest, EosOnLastFrameReturnsFramesInFlight) {
+  ASSERT_NO_FATAL_FAILURE(queueFrames(C2FrameData::FLAG_END_OF_STREAM));
+  std::list<std::unique_ptr<C2Work>> works = mListener->waitForWorks(mFrames.size());
+  ASSERT_NO_FATAL_FAILURE(checkWorks(works, mFrames.size()));
+  EXPECT_TRUE(works.back()->worklets.front()->output.flags & C2FrameData::FLAG_END_OF_STREAM);
+}
+
+TEST_F(C2SoftGav1DecTest, EmptyEosReturnsFramesInFlight) {
+  ASSERT_NO_FATAL_FAILURE(queueFrames(0));
+  std::unique_ptr<C2Work> eos(new C2Work);
+  eos->input.flags = C2FrameData::FLAG_END_OF_STREAM;
+  eos->input.ordinal.frameIndex = mFrames.size();
+  eos->worklets.emplace_back(new C2Worklet);
+  std::list<std::unique_ptr<C2Work>> items;
+  items.push_back(std::move(eos));
+  ASSERT_EQ(C2_OK, mComponent->queue_nb(&items));
+
+  std::list<std::unique_ptr<C2Work>> works = mListener->waitForWorks(mFrames.size() + 1);
+  ASSERT_NO_FATAL_FAILURE(checkWorks(works, mFrames.size() + 1));
+  EXPECT_TRUE(works.back()->worklets.front()->output.flags & C2FrameData::FLAG_END_OF_STREAM);
+}
+
+}  // namespace android
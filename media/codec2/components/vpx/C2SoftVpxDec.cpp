@@ -27,6 +27,7 @@
 #include <Codec2BufferUtils.h>
 #include <Codec2CommonUtils.h>
 #include <SimpleC2Interface.h>
+#include <SimpleC2VendorParams.h>
 
 #include "C2SoftVpxDec.h"
 
@@ -236,6 +237,22 @@ public:
                 .withSetter((Setter<decltype(*mPixelFormat)>::StrictValueWithNoDeps))
                 .build());
 
+        addParameter(
+                DefineParam(mThreadCount, C2_PARAMKEY_SOFT_THREAD_COUNT)
+                .withDefault(new C2SoftThreadCountTuning(0u))
+                .withFields({C2F(mThreadCount, value).any()})
+                .withSetter(Setter<decltype(*mThreadCount)>::StrictValueWithNoDeps)
+                .build());
+
+#ifdef VP9
+        // libvpx always decodes tile columns in parallel; this adds row based threading.
+        addParameter(
+                DefineParam(mTileThreading, C2_PARAMKEY_SOFT_TILE_THREADING)
+                .withDefault(new C2SoftTileThreadingTuning(C2_FALSE))
+                .withFields({C2F(mTileThreading, value).oneOf({0, 1})})
+                .withSetter(Setter<decltype(*mTileThreading)>::StrictValueWithNoDeps)
+                .build());
+#endif
     }
 
     static C2R SizeSetter(bool mayBlock, const C2P<C2StreamPictureSizeInfo::output> &oldMe,
@@ -315,6 +332,14 @@ public:
     std::shared_ptr<C2StreamPixelFormatInfo::output> getPixelFormat_l() const {
         return mPixelFormat;
     }
+    std::shared_ptr<C2SoftThreadCountTuning> getThreadCount_l() const {
+        return mThreadCount;
+    }
+#ifdef VP9
+    std::shared_ptr<C2SoftTileThreadingTuning> getTileThreading_l() const {
+        return mTileThreading;
+    }
+#endif
 
 private:
     std::shared_ptr<C2StreamProfileLevelInfo::input> mProfileLevel;
@@ -324,7 +349,9 @@ private:
     std::shared_ptr<C2StreamColorInfo::output> mColorInfo;
     std::shared_ptr<C2StreamPixelFormatInfo::output> mPixelFormat;
     std::shared_ptr<C2StreamColorAspectsTuning::output> mDefaultColorAspects;
+    std::shared_ptr<C2SoftThreadCountTuning> mThreadCount;
 #ifdef VP9
+    std::shared_ptr<C2SoftTileThreadingTuning> mTileThreading;
 #if 0
     std::shared_ptr<C2StreamHdrStaticInfo::output> mHdrStaticInfo;
 #endif
@@ -370,6 +397,8 @@ C2SoftVpxDec::C2SoftVpxDec(
       mCodecCtx(nullptr),
       mCoreCount(1),
       mQueue(new Mutexed<ConversionQueue>) {
+    // the listener callbacks overlap with decoding
+    setPipelineStages(STAGE_OUTPUT);
 }
 
 C2SoftVpxDec::~C2SoftVpxDec() {
@@ -443,10 +472,16 @@ status_t C2SoftVpxDec::initDecoder() {
     mMode = MODE_VP8;
 #endif
     mHalPixelFormat = HAL_PIXEL_FORMAT_YV12;
+    uint32_t threadCount;
+    bool rowMt = false;
     {
         IntfImpl::Lock lock = mIntf->lock();
         mPixelFormatInfo = mIntf->getPixelFormat_l();
         mColorAspects = mIntf->getDefaultColorAspects_l();
+        threadCount = mIntf->getThreadCount_l()->value;
+#ifdef VP9
+        rowMt = mIntf->getTileThreading_l()->value;
+#endif
     }
 
     mWidth = 320;
@@ -466,6 +501,9 @@ status_t C2SoftVpxDec::initDecoder() {
     vpx_codec_dec_cfg_t cfg;
     memset(&cfg, 0, sizeof(vpx_codec_dec_cfg_t));
     cfg.threads = mCoreCount = GetCPUCoreCount();
+    if (threadCount > 0 && threadCount < cfg.threads) {
+        cfg.threads = threadCount;
+    }
 
     vpx_codec_flags_t flags;
     memset(&flags, 0, sizeof(vpx_codec_flags_t));
@@ -479,6 +517,12 @@ status_t C2SoftVpxDec::initDecoder() {
         return UNKNOWN_ERROR;
     }
 
+    if (rowMt && cfg.threads > 1
+            && (vpx_err = vpx_codec_control(mCodecCtx, VP9D_SET_ROW_MT, 1))) {
+        // Not fatal: the decoder still uses tile based threading.
+        ALOGW("failed to enable row based multi-threading. (%d)", vpx_err);
+    }
+
     if (mMode == MODE_VP9) {
         using namespace std::string_literals;
         for (int i = 0; i < mCoreCount; ++i) {
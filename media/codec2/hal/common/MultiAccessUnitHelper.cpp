@@ -53,7 +53,9 @@ static C2R MultiAccessUnitParamsSetter(
 MultiAccessUnitInterface::MultiAccessUnitInterface(
         const std::shared_ptr<C2ComponentInterface>& interface,
         std::shared_ptr<C2ReflectorHelper> helper)
-        : C2InterfaceHelper(helper), mC2ComponentIntf(interface) {
+        : C2InterfaceHelper(helper),
+          mC2ComponentIntf(interface),
+          mMultipleAccessUnitInputSupported(false) {
     setDerivedInstance(this);
     addParameter(
             DefineParam(mLargeFrameParams, C2_PARAMKEY_OUTPUT_LARGE_FRAME)
@@ -77,6 +79,14 @@ MultiAccessUnitInterface::MultiAccessUnitInterface(
 
     if (mC2ComponentIntf) {
         c2_status_t err = mC2ComponentIntf->query_vb({&mKind}, {}, C2_MAY_BLOCK, nullptr);
+        std::vector<std::shared_ptr<C2ParamDescriptor>> componentParams;
+        mC2ComponentIntf->querySupportedParams_nb(&componentParams);
+        for (const std::shared_ptr<C2ParamDescriptor> &desc : componentParams) {
+            if (desc && desc->name().compare(C2_PARAMKEY_INPUT_ACCESS_UNIT_INFOS) == 0) {
+                mMultipleAccessUnitInputSupported = true;
+                break;
+            }
+        }
     }
 }
 
@@ -95,6 +105,10 @@ C2Component::kind_t MultiAccessUnitInterface::kind() const {
     return (C2Component::kind_t)(mKind.value);
 }
 
+bool MultiAccessUnitInterface::isMultipleAccessUnitInputSupported() const {
+    return mMultipleAccessUnitInputSupported;
+}
+
 bool MultiAccessUnitInterface::getDecoderSampleRateAndChannelCount(
         uint32_t * const sampleRate_, uint32_t * const channelCount_) const {
     if (sampleRate_ == nullptr || channelCount_ == nullptr) {
@@ -126,6 +140,29 @@ bool MultiAccessUnitInterface::getMaxInputSize(
     return true;
 }
 
+// Returns true if all the access units of the buffer can be queued in a single
+// work. Access units with flags, e.g. codec config data, are queued separately;
+// only the last access unit may end the stream.
+static bool canQueueAccessUnitsTogether(const std::shared_ptr<C2Buffer> &buffer) {
+    std::shared_ptr<const C2AccessUnitInfos::input> auInfo =
+            std::static_pointer_cast<const C2AccessUnitInfos::input>(
+            buffer->getInfo(C2AccessUnitInfos::input::PARAM_TYPE));
+    if (!auInfo || auInfo->flexCount() == 0 || buffer->data().linearBlocks().empty()) {
+        return false;
+    }
+    const size_t count = auInfo->flexCount();
+    for (size_t idx = 0; idx < count; ++idx) {
+        uint32_t flags = auInfo->m.values[idx].flags;
+        if (idx + 1 == count) {
+            flags &= ~C2FrameData::FLAG_END_OF_STREAM;
+        }
+        if (flags != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
 //C2MultiAccessUnitBuffer
 class C2MultiAccessUnitBuffer : public C2Buffer {
     public:
@@ -301,8 +338,6 @@ c2_status_t MultiAccessUnitHelper::scatter(
         MultiAccessUnitInfo frameInfo(inputOrdinal);
         std::set<uint64_t>& frameSet = frameInfo.mComponentFrameIds;
         uint64_t newFrameIdx = mFrameIndex++;
-        // TODO: Do not split buffers if component inherantly supports MultipleFrames.
-        // if thats case, only replace frameindex.
         auto cloneInputWork = [&frameInfo, &newFrameIdx, this]
                 (std::unique_ptr<C2Work>& inWork, uint32_t flags) -> std::unique_ptr<C2Work> {
             std::unique_ptr<C2Work> newWork(new C2Work);
@@ -350,6 +385,27 @@ c2_status_t MultiAccessUnitHelper::scatter(
             }
             frameSet.insert(newFrameIdx);
             processedWork->push_back(std::move(sliceWork));
+        } else if (mInterface->isMultipleAccessUnitInputSupported()
+                && canQueueAccessUnitsTogether(w->input.buffers.front())) {
+            // The component decodes all the access units of the buffer in a
+            // single work; only the frame index is replaced.
+            std::shared_ptr<const C2AccessUnitInfos::input> auInfo =
+                    std::static_pointer_cast<const C2AccessUnitInfos::input>(
+                    w->input.buffers.front()->getInfo(C2AccessUnitInfos::input::PARAM_TYPE));
+            uint32_t flags = w->input.flags;
+            if (auInfo->m.values[auInfo->flexCount() - 1].flags
+                    & C2FrameData::FLAG_END_OF_STREAM) {
+                flags |= C2FrameData::FLAG_END_OF_STREAM;
+            }
+            LOG(DEBUG) << "Queuing " << auInfo->flexCount() << " access-units of frameIndex "
+                    << inputOrdinal.frameIndex.peekull()
+                    << " in a single work with newFrameIndex " << newFrameIdx;
+            sliceWork.push_back(std::move(cloneInputWork(w, flags)));
+            // the output timestamps of the component start from the first access unit
+            sliceWork.back()->input.ordinal.timestamp = auInfo->m.values[0].timestamp;
+            sliceWork.back()->input.buffers = std::move(w->input.buffers);
+            frameSet.insert(newFrameIdx);
+            processedWork->push_back(std::move(sliceWork));
         }  else {
             const std::vector<std::shared_ptr<C2Buffer>>& inBuffers = w->input.buffers;
             if (inBuffers.front()->data().linearBlocks().size() == 0) {
@@ -597,12 +653,10 @@ c2_status_t MultiAccessUnitHelper::processWorklets(MultiAccessUnitInfo &frame,
             frame.reset();
             return C2_OK;
         }
-        int64_t sampleTimeUs = 0;
         uint32_t frameSize = 0;
         uint32_t sampleRate = 0;
         uint32_t channelCount = 0;
         if (mInterface->getDecoderSampleRateAndChannelCount(&sampleRate, &channelCount)) {
-            sampleTimeUs = (1000000u) / (sampleRate * channelCount * 2);
             frameSize = channelCount * 2;
             if (mInterface->kind() == C2Component::KIND_DECODER) {
                 frame.mLargeFrameTuning.maxSize =
@@ -703,10 +757,15 @@ c2_status_t MultiAccessUnitHelper::processWorklets(MultiAccessUnitInfo &frame,
                         toCopy = inputSize;
                     } else {
                         toCopy = c2_min(frame.mWview->size(), (inputSize - inputOffset));
-                        timestamp = workletTimestamp + inputOffset * sampleTimeUs;
+                        // A worklet may carry the output of several access units,
+                        // e.g. when they were decoded in a single work.
+                        if (frameSize != 0) {
+                            timestamp = workletTimestamp
+                                    + (int64_t)(inputOffset / frameSize) * 1000000 / sampleRate;
+                        }
                         LOG(DEBUG) << "ts " << timestamp
                                 << " copiedOutput " << inputOffset
-                                << " sampleTimeUs " << sampleTimeUs;
+                                << " sampleRate " << sampleRate;
                     }
                     LOG(DEBUG) << " Copy size " << toCopy
                             << " ts " << timestamp;
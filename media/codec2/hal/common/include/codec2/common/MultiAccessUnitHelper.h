@@ -43,6 +43,12 @@ struct MultiAccessUnitInterface : public C2InterfaceHelper {
     C2Component::kind_t kind() const;
     bool isValidField(const C2ParamField &field) const;
 
+    /*
+     * Returns true if the component consumes an input buffer with multiple
+     * access units in a single work, i.e. it supports C2AccessUnitInfos::input.
+     */
+    bool isMultipleAccessUnitInputSupported() const;
+
 protected:
     bool getDecoderSampleRateAndChannelCount(
             uint32_t * const sampleRate_, uint32_t * const channelCount_) const;
@@ -52,6 +58,7 @@ protected:
     C2ComponentKindSetting mKind;
     std::set<C2Param::Index> mSupportedParamIndexSet;
     std::vector<C2ParamField> mParamFields;
+    bool mMultipleAccessUnitInputSupported;
 
     friend struct MultiAccessUnitHelper;
 };
@@ -1764,6 +1764,13 @@ void CCodec::configure(const sp<AMessage> &msg) {
             config->mOutputFormat->setInt32("android._tunneled", 1);
         }
 
+        // byte-buffer clients not relying on fixed-size output buffers can read the output
+        // blocks directly instead of copies.
+        int32_t zeroCopyOutput = 0;
+        if (msg->findInt32("android._zero-copy-output", &zeroCopyOutput)) {
+            config->mOutputFormat->setInt32("android._zero-copy-output", zeroCopyOutput);
+        }
+
         // Convert an encoding statistics level to corresponding encoding statistics
         // kinds
         int32_t encodingStatisticsLevel = VIDEO_ENCODING_STATISTICS_LEVEL_NONE;
@@ -2227,6 +2234,7 @@ void CCodec::stop(bool pushBlankBuffer) {
         }
         comp = state->comp;
     }
+    reportBytesCopied();
 
     // Note: Logically mChannel->stopUseOutputSurface() should be after comp->stop().
     // But in the case some HAL implementations hang forever on comp->stop().
@@ -2339,6 +2347,7 @@ void CCodec::release(bool sendCallback, bool pushBlankBuffer) {
         }
         comp = state->comp;
     }
+    reportBytesCopied();
     // Note: Logically mChannel->stopUseOutputSurface() should be after comp->release().
     // But in the case some HAL implementations hang forever on comp->release().
     // (HAL is waiting for C2Fence until fetchGraphicBlock unblocks and not
@@ -2374,6 +2383,16 @@ void CCodec::release(bool sendCallback, bool pushBlankBuffer) {
     }
 }
 
+void CCodec::reportBytesCopied() {
+    uint64_t bytesCopied = mChannel->getOutputBytesCopied();
+    if (bytesCopied == 0) {
+        return;
+    }
+    sp<AMessage> metrics = new AMessage;
+    metrics->setInt64(kCodecBytesCopied, bytesCopied);
+    mCallback->onMetricsUpdated(metrics);
+}
+
 status_t CCodec::setSurface(const sp<Surface> &surface, uint32_t generation) {
     bool pushBlankBuffer = false;
     {
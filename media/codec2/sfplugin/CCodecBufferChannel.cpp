@@ -84,6 +84,13 @@ namespace {
 
 constexpr size_t kSmoothnessFactor = 4;
 
+// Lower bound of the smoothness factor when the pipeline depth adapts to the
+// latency of the component.
+constexpr uint32_t kMinSmoothnessFactor = 1;
+
+// Frame interval assumed for the latency target when the frame rate is unknown.
+constexpr int64_t kDefaultFrameIntervalUs = 16667;
+
 // This is for keeping IGBP's buffer dropping logic in legacy mode other
 // than making it non-blocking. Do not change this value.
 const static size_t kDequeueTimeoutNs = 0;
@@ -210,6 +217,7 @@ CCodecBufferChannel::CCodecBufferChannel(
         output->outputDelay = 0u;
         output->numSlots = kSmoothnessFactor;
         output->bounded = false;
+        output->zeroCopy = false;
     }
     {
         Mutexed<BlockPools>::Locked pools(mBlockPools);
@@ -1585,7 +1593,11 @@ void CCodecBufferChannel::getOutputBufferArray(Vector<sp<MediaCodecBuffer>> *arr
         return;
     }
     if (!output->buffers->isArrayMode()) {
-        output->buffers = output->buffers->toArrayMode(output->numSlots);
+        std::unique_ptr<OutputBuffersArray> buffers =
+            output->buffers->toArrayMode(output->numSlots);
+        // The slots of the array map the output blocks instead of holding copies.
+        buffers->setMapLinearBlocks(output->zeroCopy);
+        output->buffers = std::move(buffers);
     }
 
     output->buffers->getArray(array);
@@ -1605,6 +1617,8 @@ status_t CCodecBufferChannel::start(
     C2ActualPipelineDelayTuning pipelineDelay(0);
     C2SecureModeTuning secureMode(C2Config::SM_UNPROTECTED);
     C2StreamPictureSizeInfo::input picSize;
+    C2GlobalLowLatencyModeTuning lowLatency(C2_FALSE);
+    C2RealTimePriorityTuning priority(0);
 
     c2_status_t err = mComponent->query(
             {
@@ -1618,6 +1632,8 @@ status_t CCodecBufferChannel::start(
                 &outputDelay,
                 &secureMode,
                 &picSize,
+                &lowLatency,
+                &priority,
             },
             {},
             C2_DONT_BLOCK,
@@ -1953,6 +1969,7 @@ status_t CCodecBufferChannel::start(
         output->outputDelay = outputDelayValue;
         output->numSlots = numOutputSlots;
         output->bounded = bool(outputSurface);
+        output->zeroCopy = false;
         if (graphic) {
             if (outputSurface || !buffersBoundToCodec) {
                 output->buffers.reset(new GraphicOutputBuffers(mName));
@@ -1967,6 +1984,15 @@ status_t CCodecBufferChannel::start(
                 output->buffers.reset(new LinearMetadataOutputBuffers(mName));
             } else {
                 output->buffers.reset(new LinearOutputBuffers(mName));
+                int32_t zeroCopy = 0;
+                if (!outputFormat->findInt32("android._zero-copy-output", &zeroCopy)) {
+                    zeroCopy = android::base::GetBoolProperty(
+                            "debug.stagefright.ccodec_zero_copy_output", false);
+                }
+                // Only byte-buffer clients get copies; block model clients already map
+                // the blocks.
+                output->zeroCopy = zeroCopy && buffersBoundToCodec;
+                ALOGD_IF(output->zeroCopy, "[%s] Mapping output blocks to the client", mName);
             }
         }
         output->buffers->setFormat(outputFormat);
@@ -1998,10 +2024,11 @@ status_t CCodecBufferChannel::start(
         }
 
         if (oStreamFormat.value == C2BufferData::LINEAR) {
-            if (buffersBoundToCodec) {
+            if (buffersBoundToCodec && !output->zeroCopy) {
                 // WORKAROUND: if we're using early CSD workaround we convert to
                 //             array mode, to appease apps assuming the output
-                //             buffers to be of the same size.
+                //             buffers to be of the same size. Clients asking for
+                //             zero-copy output do not assume that.
                 output->buffers = output->buffers->toArrayMode(numOutputSlots);
             }
 
@@ -2023,6 +2050,7 @@ status_t CCodecBufferChannel::start(
                     // component, runs it through SkipCutBuffer and allocate local buffer to be
                     // used by fwk. Make initSkipCutBuffer() return OutputBuffers similar to
                     // toArrayMode().
+                    output->zeroCopy = false;
                     if (!output->buffers->isArrayMode()) {
                         output->buffers = output->buffers->toArrayMode(numOutputSlots);
                     }
@@ -2042,13 +2070,36 @@ status_t CCodecBufferChannel::start(
     // mOutputBuffers are initialized to make sure that lingering callbacks
     // about buffers from the previous generation do not interfere with the
     // newly initialized pipeline capacity.
+    //
+    // In low latency mode, the number of work items in flight beyond the
+    // delays of the component adapts to keep the latency from queueing to
+    // completion within a frame interval. Otherwise the pipeline is kept as
+    // deep as the slots allow, which is best for throughput.
     {
-        ALOGD("[%s] start: updating output delay %u", mName, outputDelayValue);
+        int64_t targetLatencyUs = android::base::GetIntProperty(
+                "debug.stagefright.ccodec_target_latency_us", int64_t(-1));
+        if (targetLatencyUs < 0) {
+            targetLatencyUs = 0;
+            if (lowLatency && lowLatency.value == C2_TRUE && priority.value >= 0) {
+                float frameRate = 0;
+                if ((inputFormat == nullptr
+                            || !inputFormat->findAsFloat(KEY_FRAME_RATE, &frameRate))
+                        && outputFormat != nullptr) {
+                    (void)outputFormat->findAsFloat(KEY_FRAME_RATE, &frameRate);
+                }
+                targetLatencyUs = frameRate > 0 ? int64_t(1000000 / frameRate)
+                                                : kDefaultFrameIntervalUs;
+            }
+        }
+        ALOGD("[%s] start: updating output delay %u, target latency %lldus",
+              mName, outputDelayValue, (long long)targetLatencyUs);
         Mutexed<PipelineWatcher>::Locked watcher(mPipelineWatcher);
         watcher->inputDelay(inputDelayValue)
                 .pipelineDelay(pipelineDelayValue)
                 .outputDelay(outputDelayValue)
                 .smoothnessFactor(kSmoothnessFactor)
+                .minSmoothnessFactor(kMinSmoothnessFactor)
+                .targetLatency(std::chrono::microseconds(targetLatencyUs))
                 .tunneled(mTunneled);
         watcher->flush();
     }
@@ -2615,6 +2666,7 @@ bool CCodecBufferChannel::handleWork(
             // the callback while holding the lock here. This assumes that
             // onOutputBufferAvailable() does not block. onOutputBufferAvailable()
             // callbacks are always sent with the Output lock held.
+            notifyOutputArrayChanged(output->buffers.get());
             mCallback->onOutputBufferAvailable(index, outBuffer);
         } else {
             ALOGD("[%s] onWorkDone: unable to register csd", mName);
@@ -2688,6 +2740,14 @@ bool CCodecBufferChannel::handleWork(
     return true;
 }
 
+void CCodecBufferChannel::notifyOutputArrayChanged(OutputBuffers *buffers) {
+    if (buffers->isArrayMode()
+            && static_cast<OutputBuffersArray *>(buffers)->takeArrayChanged()) {
+        ALOGV("[%s] output slot now maps another block", mName);
+        mCCodecCallback->onOutputBuffersChanged();
+    }
+}
+
 void CCodecBufferChannel::sendOutputBuffers() {
     OutputBuffers::BufferAction action;
     size_t index;
@@ -2738,6 +2798,7 @@ void CCodecBufferChannel::sendOutputBuffers() {
                     outBuffer->meta()->setObject("accessUnitInfo", obj);
                 }
             }
+            notifyOutputArrayChanged(output->buffers.get());
             mCallback->onOutputBufferAvailable(index, outBuffer);
             break;
         }
@@ -2884,6 +2945,14 @@ uint32_t CCodecBufferChannel::getInputBuffersPixelFormat() {
     return input->buffers->getPixelFormatIfApplicable();
 }
 
+uint64_t CCodecBufferChannel::getOutputBytesCopied() {
+    Mutexed<Output>::Locked output(mOutput);
+    if (output->buffers == nullptr) {
+        return 0;
+    }
+    return output->buffers->getBytesCopied();
+}
+
 uint32_t CCodecBufferChannel::getOutputBuffersPixelFormat() {
     Mutexed<Output>::Locked output(mOutput);
     if (output->buffers == nullptr) {
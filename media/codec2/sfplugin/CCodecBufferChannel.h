@@ -229,6 +229,12 @@ public:
 
     void resetBuffersPixelFormat(bool isEncoder);
 
+    /**
+     * Get the number of bytes copied from component output buffers to client
+     * buffers since start.
+     */
+    uint64_t getOutputBytesCopied();
+
     /**
      * Queue a C2 info buffer that will be sent to codec in the subsequent
      * queueInputBuffer
@@ -316,6 +322,12 @@ private:
             std::unique_ptr<C2Work> work, const sp<AMessage> &outputFormat,
             const C2StreamInitDataInfo::output *initData);
     void sendOutputBuffers();
+    /**
+     * Tell the client to fetch the output buffer array again if |buffers|
+     * replaced a slot of the array it holds. Called with the Output lock
+     * held, before the buffer in the new slot is reported.
+     */
+    void notifyOutputArrayChanged(OutputBuffers *buffers);
     void ensureDecryptDestination(size_t size);
     int32_t getHeapSeqNum(const sp<hardware::HidlMemory> &memory);
 
@@ -361,6 +373,9 @@ private:
         // true iff the underlying block pool is bounded --- for example,
         // a BufferQueue-based block pool would be bounded by the BufferQueue.
         bool bounded;
+        // true iff linear blocks are mapped to a byte-buffer client, also in
+        // the slots of the buffer array, instead of copied.
+        bool zeroCopy;
     };
     Mutexed<Output> mOutput;
     Mutexed<std::list<std::unique_ptr<C2Work>>> mFlushedConfigs;
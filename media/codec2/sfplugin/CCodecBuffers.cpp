@@ -871,6 +871,11 @@ bool BuffersArrayImpl::expireComponentBuffer(const std::shared_ptr<C2Buffer> &c2
     return false;
 }
 
+void BuffersArrayImpl::replaceBuffer(size_t index, const sp<Codec2Buffer> &buffer) {
+    CHECK_LT(index, mBuffers.size());
+    mBuffers[index].clientBuffer = buffer;
+}
+
 void BuffersArrayImpl::getArray(Vector<sp<MediaCodecBuffer>> *array) const {
     array->clear();
     for (const Entry &entry : mBuffers) {
@@ -1370,8 +1375,8 @@ status_t OutputBuffersArray::registerBuffer(
     status_t err = mImpl.grabBuffer(
             index,
             &c2Buffer,
-            [buffer](const sp<Codec2Buffer> &clientBuffer) {
-                return clientBuffer->canCopy(buffer);
+            [buffer, map = mMapLinearBlocks](const sp<Codec2Buffer> &clientBuffer) {
+                return map || clientBuffer->canCopy(buffer);
             });
     if (err == WOULD_BLOCK) {
         ALOGV("[%s] buffers temporarily not available", mName);
@@ -1380,10 +1385,22 @@ status_t OutputBuffersArray::registerBuffer(
         ALOGD("[%s] grabBuffer failed: %d", mName, err);
         return err;
     }
-    c2Buffer->setFormat(mFormat);
-    if (!convert(buffer, &c2Buffer) && !c2Buffer->copy(buffer)) {
-        ALOGD("[%s] copy buffer failed", mName);
-        return WOULD_BLOCK;
+    if (mMapLinearBlocks) {
+        sp<Codec2Buffer> mapped = mapLinearBlock(buffer);
+        if (mapped == nullptr) {
+            mImpl.returnBuffer(c2Buffer, nullptr, true);
+            return NO_MEMORY;
+        }
+        mImpl.replaceBuffer(*index, mapped);
+        mArrayChanged = mArrayChanged || mArrayHandedOut;
+        c2Buffer = mapped;
+    } else {
+        c2Buffer->setFormat(mFormat);
+        if (!convert(buffer, &c2Buffer) && !c2Buffer->copy(buffer)) {
+            ALOGD("[%s] copy buffer failed", mName);
+            return WOULD_BLOCK;
+        }
+        addBytesCopied(c2Buffer->size());
     }
     if (buffer && buffer->hasInfo(C2AccessUnitInfos::output::PARAM_TYPE)) {
         std::shared_ptr<const C2AccessUnitInfos::output> bufferMetadata =
@@ -1409,15 +1426,24 @@ status_t OutputBuffersArray::registerCsd(
     status_t err = mImpl.grabBuffer(
             index,
             &c2Buffer,
-            [csd](const sp<Codec2Buffer> &clientBuffer) {
-                return clientBuffer->base() != nullptr
-                        && clientBuffer->capacity() >= csd->flexCount();
+            [csd, map = mMapLinearBlocks](const sp<Codec2Buffer> &clientBuffer) {
+                return map || (clientBuffer->base() != nullptr
+                        && clientBuffer->capacity() >= csd->flexCount());
             });
     if (err != OK) {
         return err;
     }
-    memcpy(c2Buffer->base(), csd->m.value, csd->flexCount());
-    c2Buffer->setRange(0, csd->flexCount());
+    if (mMapLinearBlocks) {
+        // the slot may hold a mapped block too small for the CSD
+        c2Buffer = new LocalLinearBuffer(
+                mFormat, ABuffer::CreateAsCopy(csd->m.value, csd->flexCount()));
+        mImpl.replaceBuffer(*index, c2Buffer);
+        mArrayChanged = mArrayChanged || mArrayHandedOut;
+    } else {
+        memcpy(c2Buffer->base(), csd->m.value, csd->flexCount());
+        c2Buffer->setRange(0, csd->flexCount());
+    }
+    addBytesCopied(csd->flexCount());
     c2Buffer->setFormat(mFormat);
     *clientBuffer = c2Buffer;
     return OK;
@@ -1438,6 +1464,16 @@ void OutputBuffersArray::flush(const std::list<std::unique_ptr<C2Work>> &flushed
 
 void OutputBuffersArray::getArray(Vector<sp<MediaCodecBuffer>> *array) const {
     mImpl.getArray(array);
+    mArrayHandedOut = true;
+}
+
+bool OutputBuffersArray::takeArrayChanged() {
+    if (!mArrayChanged) {
+        return false;
+    }
+    mArrayChanged = false;
+    mArrayHandedOut = false;
+    return true;
 }
 
 size_t OutputBuffersArray::numActiveSlots() const {
@@ -1445,6 +1481,7 @@ size_t OutputBuffersArray::numActiveSlots() const {
 }
 
 void OutputBuffersArray::realloc(const std::shared_ptr<C2Buffer> &c2buffer) {
+    mMapLinearBlocks = false;
     switch (c2buffer->data().type()) {
         case C2BufferData::LINEAR: {
             uint32_t size = kLinearBufferSize;
@@ -1491,6 +1528,28 @@ void OutputBuffersArray::grow(size_t newSize) {
     mImpl.grow(newSize, mAlloc);
 }
 
+sp<Codec2Buffer> OutputBuffersArray::mapLinearBlock(const std::shared_ptr<C2Buffer> &buffer) {
+    sp<Codec2Buffer> clientBuffer;
+    if (convert(buffer, &clientBuffer)) {
+        addBytesCopied(clientBuffer->size());
+        return clientBuffer;
+    }
+    if (buffer == nullptr
+            || (buffer->data().type() == C2BufferData::LINEAR
+                && buffer->data().linearBlocks().size() == 1u
+                && buffer->data().linearBlocks().front().size() == 0)) {
+        clientBuffer = new LocalLinearBuffer(mFormat, new ABuffer(0));
+    } else {
+        clientBuffer = ConstLinearBlockBuffer::Allocate(mFormat, buffer);
+        if (clientBuffer == nullptr) {
+            ALOGD("[%s] ConstLinearBlockBuffer::Allocate failed", mName);
+            return nullptr;
+        }
+    }
+    clientBuffer->setFormat(mFormat);
+    return clientBuffer;
+}
+
 void OutputBuffersArray::transferFrom(OutputBuffers* source) {
     mFormat = source->mFormat;
     mSkipCutBuffer = source->mSkipCutBuffer;
@@ -1498,6 +1557,7 @@ void OutputBuffersArray::transferFrom(OutputBuffers* source) {
     mReorderStash = std::move(source->mReorderStash);
     mDepth = source->mDepth;
     mKey = source->mKey;
+    mBytesCopied = source->mBytesCopied;
 }
 
 // FlexOutputBuffers
@@ -1507,7 +1567,9 @@ status_t FlexOutputBuffers::registerBuffer(
         size_t *index,
         sp<MediaCodecBuffer> *clientBuffer) {
     sp<Codec2Buffer> newBuffer;
-    if (!convert(buffer, &newBuffer)) {
+    if (convert(buffer, &newBuffer)) {
+        addBytesCopied(newBuffer->size());
+    } else {
         newBuffer = wrap(buffer);
         if (newBuffer == nullptr) {
             return NO_MEMORY;
@@ -1529,6 +1591,7 @@ status_t FlexOutputBuffers::registerCsd(
         sp<MediaCodecBuffer> *clientBuffer) {
     sp<Codec2Buffer> newBuffer = new LocalLinearBuffer(
             mFormat, ABuffer::CreateAsCopy(csd->m.value, csd->flexCount()));
+    addBytesCopied(csd->flexCount());
     *index = mImpl.assignSlot(newBuffer);
     *clientBuffer = newBuffer;
     return OK;
@@ -1662,12 +1725,16 @@ sp<Codec2Buffer> RawGraphicOutputBuffers::wrap(const std::shared_ptr<C2Buffer> &
     if (buffer == nullptr) {
         return new Codec2Buffer(mFormat, new ABuffer(nullptr, 0));
     } else {
-        return ConstGraphicBlockBuffer::Allocate(
+        sp<ConstGraphicBlockBuffer> clientBuffer = ConstGraphicBlockBuffer::Allocate(
                 mFormat,
                 buffer,
                 [lbp = mLocalBufferPool](size_t capacity) {
                     return lbp->newBuffer(capacity);
                 });
+        if (clientBuffer != nullptr && !clientBuffer->isWrapped()) {
+            addBytesCopied(clientBuffer->size());
+        }
+        return clientBuffer;
     }
 }
 
@@ -241,6 +241,12 @@ public:
      */
     void updateSkipCutBuffer(const sp<AMessage> &format);
 
+    /**
+     * Return the number of bytes copied from component buffers to client
+     * buffers so far. Buffers mapped directly to the client are not counted.
+     */
+    uint64_t getBytesCopied() const { return mBytesCopied; }
+
     /**
      * Output Stash
      * ============
@@ -414,7 +420,14 @@ protected:
      */
     bool convert(const std::shared_ptr<C2Buffer> &src, sp<Codec2Buffer> *dst);
 
+    /**
+     * Account for |size| bytes copied to a client buffer.
+     */
+    void addBytesCopied(size_t size) { mBytesCopied += size; }
+
 private:
+    uint64_t mBytesCopied{0};
+
     // SkipCutBuffer
     int32_t mDelay;
     int32_t mPadding;
@@ -712,6 +725,14 @@ public:
      */
     bool expireComponentBuffer(const std::shared_ptr<C2Buffer> &c2buffer);
 
+    /**
+     * Replace the client buffer of a slot grabbed with grabBuffer().
+     *
+     * \param index[in]   index of the slot.
+     * \param buffer[in]  the new client buffer of the slot.
+     */
+    void replaceBuffer(size_t index, const sp<Codec2Buffer> &buffer);
+
     /**
      * Populate |array| with the underlying buffer array.
      *
@@ -761,7 +782,7 @@ private:
     const char *mName; ///< C-string version of name
 
     struct Entry {
-        const sp<Codec2Buffer> clientBuffer;
+        sp<Codec2Buffer> clientBuffer;
         std::weak_ptr<C2Buffer> compBuffer;
         bool ownedByClient;
     };
@@ -1106,9 +1127,34 @@ public:
      */
     void transferFrom(OutputBuffers* source);
 
+    /**
+     * Map the linear blocks from the component to the client instead of
+     * copying them into the slots. Each slot then holds the mapped block it
+     * was last registered with, and the array keeps its size and indices.
+     * An array already handed out is then stale; see takeArrayChanged().
+     * realloc() goes back to copying.
+     */
+    void setMapLinearBlocks(bool map) { mMapLinearBlocks = map; }
+
+    /**
+     * Return true if a slot was replaced with a mapped block since the
+     * array was last handed out by getArray(), and clear the flag. The
+     * client needs to fetch the array again to read the new slot.
+     */
+    bool takeArrayChanged();
+
 private:
+    /**
+     * Return a client buffer mapping |buffer|, or a converted copy of it.
+     * nullptr if |buffer| cannot be mapped.
+     */
+    sp<Codec2Buffer> mapLinearBlock(const std::shared_ptr<C2Buffer> &buffer);
+
     BuffersArrayImpl mImpl;
     std::function<sp<Codec2Buffer>()> mAlloc;
+    bool mMapLinearBlocks{false};
+    mutable bool mArrayHandedOut{false};
+    bool mArrayChanged{false};
 };
 
 class FlexOutputBuffers : public OutputBuffers {
@@ -319,6 +319,12 @@ public:
     bool canCopy(const std::shared_ptr<C2Buffer> &buffer) const override;
     bool copy(const std::shared_ptr<C2Buffer> &buffer) override;
 
+    /**
+     * \return true if the client accesses the mapping of the graphic block
+     *         directly, false if the content was copied to a local buffer.
+     */
+    bool isWrapped() const { return mWrapped; }
+
 private:
     ConstGraphicBlockBuffer(
             const sp<AMessage> &format,
@@ -17,6 +17,7 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "PipelineWatcher"
 
+#include <algorithm>
 #include <numeric>
 
 #include <log/log.h>
@@ -25,6 +26,16 @@
 
 namespace android {
 
+namespace {
+
+// Weight of a new sample in the latency averages, as a power of 2.
+constexpr int kLatencyWeightShift = 3;
+
+// Number of work items completed between two adjustments of the smoothness factor.
+constexpr uint32_t kAdaptInterval = 4;
+
+}  // namespace
+
 PipelineWatcher &PipelineWatcher::inputDelay(uint32_t value) {
     mInputDelay = value;
     return *this;
@@ -42,6 +53,7 @@ PipelineWatcher &PipelineWatcher::outputDelay(uint32_t value) {
 
 PipelineWatcher &PipelineWatcher::smoothnessFactor(uint32_t value) {
     mSmoothnessFactor = value;
+    mAdaptiveSmoothnessFactor = value;
     return *this;
 }
 
@@ -50,6 +62,25 @@ PipelineWatcher &PipelineWatcher::tunneled(bool value) {
     return *this;
 }
 
+PipelineWatcher &PipelineWatcher::targetLatency(Clock::duration value) {
+    mTargetLatency = value;
+    return *this;
+}
+
+PipelineWatcher &PipelineWatcher::minSmoothnessFactor(uint32_t value) {
+    mMinSmoothnessFactor = value;
+    return *this;
+}
+
+uint32_t PipelineWatcher::currentSmoothnessFactor() const {
+    if (mTargetLatency <= Clock::duration::zero()) {
+        return mSmoothnessFactor;
+    }
+    return std::clamp(mAdaptiveSmoothnessFactor,
+                      std::min(mMinSmoothnessFactor, mSmoothnessFactor),
+                      mSmoothnessFactor);
+}
+
 void PipelineWatcher::onWorkQueued(
         uint64_t frameIndex,
         std::vector<std::shared_ptr<C2Buffer>> &&buffers,
@@ -89,7 +120,13 @@ std::shared_ptr<C2Buffer> PipelineWatcher::onInputBufferReleased(
 }
 
 void PipelineWatcher::onWorkDone(uint64_t frameIndex) {
-    ALOGV("onWorkDone(frameIndex=%llu)", (unsigned long long)frameIndex);
+    onWorkDone(frameIndex, Clock::now());
+}
+
+void PipelineWatcher::onWorkDone(uint64_t frameIndex, const Clock::time_point &doneAt) {
+    ALOGV("onWorkDone(frameIndex=%llu, doneAt=%lld)",
+          (unsigned long long)frameIndex,
+          (long long)doneAt.time_since_epoch().count());
     auto it = mFramesInPipeline.find(frameIndex);
     if (it == mFramesInPipeline.end()) {
         if (!mTunneled) {
@@ -101,17 +138,53 @@ void PipelineWatcher::onWorkDone(uint64_t frameIndex) {
         }
         return;
     }
+    updateLatency(doneAt - it->second.queuedAt);
     (void)mFramesInPipeline.erase(it);
 }
 
+void PipelineWatcher::updateLatency(Clock::duration latency) {
+    if (mLatency == Clock::duration::zero()) {
+        mLatency = latency;
+    } else {
+        mLatency += (latency - mLatency) / (1 << kLatencyWeightShift);
+    }
+    Clock::duration deviation = latency > mLatency ? latency - mLatency : mLatency - latency;
+    mJitter += (deviation - mJitter) / (1 << kLatencyWeightShift);
+
+    if (mTargetLatency <= Clock::duration::zero() || ++mNumSamples < kAdaptInterval) {
+        return;
+    }
+    mNumSamples = 0;
+    uint32_t factor = currentSmoothnessFactor();
+    if (mLatency + mJitter > mTargetLatency) {
+        // Queueing more work only adds latency; keep fewer items in flight.
+        if (factor > std::min(mMinSmoothnessFactor, mSmoothnessFactor)) {
+            --factor;
+        }
+    } else if (mLatency + mJitter * 2 < mTargetLatency / 2) {
+        // Plenty of headroom; allow more items in flight to absorb jitter.
+        if (factor < mSmoothnessFactor) {
+            ++factor;
+        }
+    }
+    ALOGV_IF(factor != mAdaptiveSmoothnessFactor,
+             "smoothness factor %u -> %u (latency = %lldus, jitter = %lldus)",
+             mAdaptiveSmoothnessFactor, factor,
+             (long long)std::chrono::duration_cast<std::chrono::microseconds>(mLatency).count(),
+             (long long)std::chrono::duration_cast<std::chrono::microseconds>(mJitter).count());
+    mAdaptiveSmoothnessFactor = factor;
+}
+
 void PipelineWatcher::flush() {
     ALOGV("flush");
     mFramesInPipeline.clear();
+    mNumSamples = 0;
 }
 
 bool PipelineWatcher::pipelineFull(size_t *pipelineRoom) const {
+    const uint32_t smoothnessFactor = currentSmoothnessFactor();
     if (mFramesInPipeline.size() >=
-            mInputDelay + mPipelineDelay + mOutputDelay + mSmoothnessFactor) {
+            mInputDelay + mPipelineDelay + mOutputDelay + smoothnessFactor) {
         ALOGV("pipelineFull: too many frames in pipeline (%zu)", mFramesInPipeline.size());
         return true;
     }
@@ -127,14 +200,14 @@ bool PipelineWatcher::pipelineFull(size_t *pipelineRoom) const {
                 return true;
             });
     if (sizeWithInputReleased >=
-            mPipelineDelay + mOutputDelay + mSmoothnessFactor) {
+            mPipelineDelay + mOutputDelay + smoothnessFactor) {
         ALOGV("pipelineFull: too many frames in pipeline, with input released (%zu)",
               sizeWithInputReleased);
         return true;
     }
 
     size_t sizeWithInputsPending = mFramesInPipeline.size() - sizeWithInputReleased;
-    if (sizeWithInputsPending > mPipelineDelay + mInputDelay + mSmoothnessFactor) {
+    if (sizeWithInputsPending > mPipelineDelay + mInputDelay + smoothnessFactor) {
         ALOGV("pipelineFull: too many inputs pending (%zu) in pipeline, with inputs released (%zu)",
               sizeWithInputsPending, sizeWithInputReleased);
         return true;
@@ -142,7 +215,7 @@ bool PipelineWatcher::pipelineFull(size_t *pipelineRoom) const {
     ALOGV("pipeline has room (total: %zu, input released: %zu)",
           mFramesInPipeline.size(), sizeWithInputReleased);
     if (pipelineRoom) {
-        *pipelineRoom = mInputDelay + mPipelineDelay + mOutputDelay + mSmoothnessFactor
+        *pipelineRoom = mInputDelay + mPipelineDelay + mOutputDelay + smoothnessFactor
                                 - mFramesInPipeline.size();
     }
     return false;
@@ -38,7 +38,13 @@ public:
           mPipelineDelay(0),
           mOutputDelay(0),
           mSmoothnessFactor(0),
-          mTunneled(false) {}
+          mTunneled(false),
+          mTargetLatency(Clock::duration::zero()),
+          mMinSmoothnessFactor(1),
+          mAdaptiveSmoothnessFactor(0),
+          mLatency(Clock::duration::zero()),
+          mJitter(Clock::duration::zero()),
+          mNumSamples(0) {}
     ~PipelineWatcher() = default;
 
     /**
@@ -71,6 +77,41 @@ public:
      */
     PipelineWatcher &tunneled(bool value);
 
+    /**
+     * Adapt the number of work items in flight to the latency measured from
+     * queueing to completion. The smoothness factor is reduced, down to the
+     * minimum smoothness factor, while the latency exceeds the target, and
+     * increased back, up to the smoothness factor, while the latency is well
+     * under the target. The delays reported by the component are always
+     * honored.
+     *
+     * \param value the new target latency; zero keeps the smoothness factor
+     *              fixed, which is the default.
+     * \return  this object
+     */
+    PipelineWatcher &targetLatency(Clock::duration value);
+
+    /**
+     * \param value the new lower bound of the adaptive smoothness factor
+     * \return  this object
+     */
+    PipelineWatcher &minSmoothnessFactor(uint32_t value);
+
+    /**
+     * \return the smoothness factor currently in effect.
+     */
+    uint32_t currentSmoothnessFactor() const;
+
+    /**
+     * \return the average latency from queueing to completion of work items.
+     */
+    Clock::duration latency() const { return mLatency; }
+
+    /**
+     * \return the average deviation of the latency of work items.
+     */
+    Clock::duration jitter() const { return mJitter; }
+
     /**
      * Client queued a work item to the component.
      *
@@ -101,6 +142,14 @@ public:
      */
     void onWorkDone(uint64_t frameIndex);
 
+    /**
+     * The component finished processing a work item.
+     *
+     * \param frameIndex  input frame index
+     * \param doneAt      time when the work item was returned
+     */
+    void onWorkDone(uint64_t frameIndex, const Clock::time_point &doneAt);
+
     /**
      * Flush the pipeline.
      */
@@ -133,6 +182,20 @@ private:
     uint32_t mSmoothnessFactor;
     bool mTunneled;
 
+    // adaptive smoothness factor
+    Clock::duration mTargetLatency;
+    uint32_t mMinSmoothnessFactor;
+    uint32_t mAdaptiveSmoothnessFactor;
+    Clock::duration mLatency;
+    Clock::duration mJitter;
+    uint32_t mNumSamples;
+
+    /**
+     * Update the latency statistics with a new sample, and the adaptive
+     * smoothness factor every few samples.
+     */
+    void updateLatency(Clock::duration latency);
+
     struct Frame {
         Frame(std::vector<std::shared_ptr<C2Buffer>> &&b,
               const Clock::time_point &q)
@@ -113,6 +113,9 @@ private:
     void flush();
     void release(bool sendCallback, bool pushBlankBuffer);
 
+    /// reports the output bytes copied for the client to MediaCodec metrics
+    void reportBytesCopied();
+
     /**
      * Creates an input surface for the current device configuration compatible with CCodec.
      * This could be backed by the C2 HAL or the OMX HAL.
@@ -914,4 +914,87 @@ TEST(LinearOutputBuffersTest, PcmConvertFormat) {
     ASSERT_TRUE(buffers->releaseBuffer(clientBuffer, &c2Buffer));
 }
 
+TEST(LinearOutputBuffersTest, BytesCopied) {
+    std::shared_ptr<LinearOutputBuffers> buffers =
+        std::make_shared<LinearOutputBuffers>("test");
+    sp<AMessage> format{new AMessage};
+    buffers->setFormat(format);
+
+    std::shared_ptr<C2BlockPool> pool;
+    ASSERT_EQ(OK, GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &pool));
+    auto createBuffer = [&pool](size_t size) -> std::shared_ptr<C2Buffer> {
+        std::shared_ptr<C2LinearBlock> block;
+        if (pool->fetchLinearBlock(
+                size, C2MemoryUsage{C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE},
+                &block) != C2_OK) {
+            return nullptr;
+        }
+        return C2Buffer::CreateLinearBuffer(block->share(0, size, C2Fence()));
+    };
+
+    // The block is mapped to the client without copy.
+    std::shared_ptr<C2Buffer> c2Buffer = createBuffer(1024);
+    ASSERT_NE(nullptr, c2Buffer);
+    size_t index;
+    sp<MediaCodecBuffer> clientBuffer;
+    ASSERT_EQ(OK, buffers->registerBuffer(c2Buffer, &index, &clientBuffer));
+    EXPECT_EQ(1024u, clientBuffer->size());
+    EXPECT_EQ(0u, buffers->getBytesCopied());
+    ASSERT_TRUE(buffers->releaseBuffer(clientBuffer, &c2Buffer));
+    c2Buffer.reset();
+
+    // The array mode copies into the client slots, and keeps the count.
+    std::shared_ptr<OutputBuffersArray> array = buffers->toArrayMode(4);
+    c2Buffer = createBuffer(512);
+    ASSERT_NE(nullptr, c2Buffer);
+    ASSERT_EQ(OK, array->registerBuffer(c2Buffer, &index, &clientBuffer));
+    EXPECT_EQ(512u, clientBuffer->size());
+    EXPECT_EQ(512u, array->getBytesCopied());
+    ASSERT_TRUE(array->releaseBuffer(clientBuffer, &c2Buffer));
+}
+
+TEST(LinearOutputBuffersTest, MappedArrayMode) {
+    std::shared_ptr<LinearOutputBuffers> buffers =
+        std::make_shared<LinearOutputBuffers>("test");
+    sp<AMessage> format{new AMessage};
+    buffers->setFormat(format);
+    std::shared_ptr<OutputBuffersArray> array = buffers->toArrayMode(4);
+    array->setMapLinearBlocks(true);
+    Vector<sp<MediaCodecBuffer>> slots;
+    array->getArray(&slots);
+    ASSERT_EQ(4u, slots.size());
+
+    std::shared_ptr<C2BlockPool> pool;
+    ASSERT_EQ(OK, GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &pool));
+    std::shared_ptr<C2LinearBlock> block;
+    ASSERT_EQ(C2_OK, pool->fetchLinearBlock(
+            1024, C2MemoryUsage{C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE}, &block));
+    C2WriteView writeView = block->map().get();
+    ASSERT_EQ(C2_OK, writeView.error());
+    memset(writeView.data(), 0x5a, 1024);
+    std::shared_ptr<C2Buffer> c2Buffer =
+        C2Buffer::CreateLinearBuffer(block->share(0, 1024, C2Fence()));
+
+    // The slot maps the block instead of copying it.
+    size_t index;
+    sp<MediaCodecBuffer> clientBuffer;
+    ASSERT_EQ(OK, array->registerBuffer(c2Buffer, &index, &clientBuffer));
+    ASSERT_LT(index, slots.size());
+    EXPECT_EQ(c2Buffer, clientBuffer->asC2Buffer());
+    EXPECT_EQ(1024u, clientBuffer->size());
+    EXPECT_EQ(0x5a, clientBuffer->data()[1023]);
+    EXPECT_EQ(0u, array->getBytesCopied());
+    // The array handed out is stale; the client is told once to fetch it again.
+    EXPECT_TRUE(array->takeArrayChanged());
+    EXPECT_FALSE(array->takeArrayChanged());
+    array->getArray(&slots);
+    EXPECT_EQ(slots[index], clientBuffer);
+    EXPECT_FALSE(array->takeArrayChanged());
+
+    std::shared_ptr<C2Buffer> released;
+    ASSERT_TRUE(array->releaseBuffer(clientBuffer, &released));
+    EXPECT_EQ(c2Buffer, released);
+    EXPECT_EQ(nullptr, clientBuffer->asC2Buffer());
+}
+
 } // namespace android
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <system/graphics.h>
+
+#include <C2PlatformSupport.h>
+
+#include "Codec2BufferUtils.h"
+
+using namespace android;
+
+namespace {
+
+enum ImageLayout {
+    I420,
+    NV12,
+    P010,
+    YUV420_PLANAR_16,
+};
+
+// 10-bit media images as described by GraphicView2MediaImageConverter.
+MediaImage2 CreateYUV420_16bitMediaImage2(
+        uint32_t width, uint32_t height, uint32_t stride, uint32_t vstride, bool semiPlanar) {
+    MediaImage2 img = semiPlanar
+            ? CreateYUV420SemiPlanarMediaImage2(width, height, stride * 2, vstride)
+            : CreateYUV420PlanarMediaImage2(width, height, stride * 2, vstride);
+    img.mBitDepth = 10;
+    img.mBitDepthAllocated = 16;
+    for (uint32_t i = 0; i < img.mNumPlanes; ++i) {
+        img.mPlane[i].mColInc *= 2;
+    }
+    if (semiPlanar) {
+        img.mPlane[2].mOffset = img.mPlane[1].mOffset + 2;
+    }
+    return img;
+}
+
+MediaImage2 CreateMediaImage2(ImageLayout layout, uint32_t width, uint32_t height) {
+    switch (layout) {
+        case I420:
+            return CreateYUV420PlanarMediaImage2(width, height, width, height);
+        case NV12:
+            return CreateYUV420SemiPlanarMediaImage2(width, height, width, height);
+        case P010:
+            return CreateYUV420_16bitMediaImage2(width, height, width, height, true);
+        case YUV420_PLANAR_16:
+        default:
+            return CreateYUV420_16bitMediaImage2(width, height, width, height, false);
+    }
+}
+
+std::shared_ptr<C2GraphicBlock> FetchGraphicBlock(
+        benchmark::State &state, uint32_t width, uint32_t height, uint32_t format) {
+    std::shared_ptr<C2BlockPool> pool;
+    std::shared_ptr<C2GraphicBlock> block;
+    if (GetCodec2BlockPool(C2BlockPool::BASIC_GRAPHIC, nullptr, &pool) != C2_OK
+            || pool->fetchGraphicBlock(
+                    width, height, format,
+                    C2MemoryUsage{C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE},
+                    &block) != C2_OK) {
+        state.SkipWithError("cannot allocate graphic block");
+        return nullptr;
+    }
+    return block;
+}
+
+// state.range(0) and state.range(1) are the width and height of the frame.
+void BM_ImageCopyToMediaImage(benchmark::State &state, uint32_t format, ImageLayout layout) {
+    const uint32_t width = state.range(0);
+    const uint32_t height = state.range(1);
+    std::shared_ptr<C2GraphicBlock> block = FetchGraphicBlock(state, width, height, format);
+    if (!block) {
+        return;
+    }
+    const C2GraphicView view = block->map().get();
+    const MediaImage2 img = CreateMediaImage2(layout, width, height);
+    std::vector<uint8_t> buffer(width * height * 3 / 2 * (img.mBitDepthAllocated / 8));
+    for (auto _ : state) {
+        if (ImageCopy(buffer.data(), &img, view) != OK) {
+            state.SkipWithError("unsupported layout");
+            break;
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+
+void BM_ImageCopyFromMediaImage(benchmark::State &state, uint32_t format, ImageLayout layout) {
+    const uint32_t width = state.range(0);
+    const uint32_t height = state.range(1);
+    std::shared_ptr<C2GraphicBlock> block = FetchGraphicBlock(state, width, height, format);
+    if (!block) {
+        return;
+    }
+    C2GraphicView view = block->map().get();
+    const MediaImage2 img = CreateMediaImage2(layout, width, height);
+    const std::vector<uint8_t> buffer(
+            width * height * 3 / 2 * (img.mBitDepthAllocated / 8), 0x40);
+    for (auto _ : state) {
+        if (ImageCopy(view, buffer.data(), &img) != OK) {
+            state.SkipWithError("unsupported layout");
+            break;
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+
+void BM_ConvertRGBToPlanarYUV(benchmark::State &state, C2Color::matrix_t matrix) {
+    const uint32_t width = state.range(0);
+    const uint32_t height = state.range(1);
+    std::shared_ptr<C2GraphicBlock> block =
+        FetchGraphicBlock(state, width, height, HAL_PIXEL_FORMAT_RGBA_8888);
+    if (!block) {
+        return;
+    }
+    const C2GraphicView view = block->map().get();
+    std::vector<uint8_t> buffer(width * height * 3 / 2);
+    for (auto _ : state) {
+        ConvertRGBToPlanarYUV(buffer.data(), width, height, buffer.size(), view, matrix);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * width * height);
+}
+
+void FrameSizes(benchmark::internal::Benchmark *b) {
+    b->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_ImageCopyToMediaImage, YUV420_to_I420,
+                  HAL_PIXEL_FORMAT_YCBCR_420_888, I420)->Apply(FrameSizes);
+BENCHMARK_CAPTURE(BM_ImageCopyToMediaImage, YUV420_to_NV12,
+                  HAL_PIXEL_FORMAT_YCBCR_420_888, NV12)->Apply(FrameSizes);
+BENCHMARK_CAPTURE(BM_ImageCopyToMediaImage, P010_to_P010,
+                  HAL_PIXEL_FORMAT_YCBCR_P010, P010)->Apply(FrameSizes);
+BENCHMARK_CAPTURE(BM_ImageCopyToMediaImage, P010_to_YUV420Planar16,
+                  HAL_PIXEL_FORMAT_YCBCR_P010, YUV420_PLANAR_16)->Apply(FrameSizes);
+
+BENCHMARK_CAPTURE(BM_ImageCopyFromMediaImage, I420_to_YUV420,
+                  HAL_PIXEL_FORMAT_YCBCR_420_888, I420)->Apply(FrameSizes);
+BENCHMARK_CAPTURE(BM_ImageCopyFromMediaImage, NV12_to_YUV420,
+                  HAL_PIXEL_FORMAT_YCBCR_420_888, NV12)->Apply(FrameSizes);
+BENCHMARK_CAPTURE(BM_ImageCopyFromMediaImage, P010_to_P010,
+                  HAL_PIXEL_FORMAT_YCBCR_P010, P010)->Apply(FrameSizes);
+BENCHMARK_CAPTURE(BM_ImageCopyFromMediaImage, YUV420Planar16_to_P010,
+                  HAL_PIXEL_FORMAT_YCBCR_P010, YUV420_PLANAR_16)->Apply(FrameSizes);
+
+BENCHMARK_CAPTURE(BM_ConvertRGBToPlanarYUV, BT601, C2Color::MATRIX_BT601)->Apply(FrameSizes);
+BENCHMARK_CAPTURE(BM_ConvertRGBToPlanarYUV, BT709, C2Color::MATRIX_BT709)->Apply(FrameSizes);
+
+BENCHMARK_MAIN();
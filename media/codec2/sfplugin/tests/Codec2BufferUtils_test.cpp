@@ -0,0 +1,327 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Codec2BufferUtils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <system/graphics.h>
+
+#include <C2PlatformSupport.h>
+
+namespace android {
+
+namespace {
+
+struct FrameSize {
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;  // in samples
+    uint32_t vstride;
+};
+
+// Odd widths and heights, with odd and even strides.
+constexpr FrameSize kFrameSizes[] = {
+    { 33, 17, 37, 18 },
+    { 99, 35, 100, 36 },
+    { 64, 32, 67, 32 },
+};
+
+enum ImageLayout {
+    P010,
+    YUV420_PLANAR_16,
+    // planar, with every sample two samples apart so that only the generic copy applies
+    STRIDED_8,
+    STRIDED_16,
+};
+
+// 10-bit media images as described by GraphicView2MediaImageConverter.
+MediaImage2 CreateYUV420_16bitMediaImage2(
+        uint32_t width, uint32_t height, uint32_t stride, uint32_t vstride, bool semiPlanar) {
+    MediaImage2 img = semiPlanar
+            ? CreateYUV420SemiPlanarMediaImage2(width, height, stride * 2, vstride)
+            : CreateYUV420PlanarMediaImage2(width, height, stride * 2, vstride);
+    img.mBitDepth = 10;
+    img.mBitDepthAllocated = 16;
+    for (uint32_t i = 0; i < img.mNumPlanes; ++i) {
+        img.mPlane[i].mColInc *= 2;
+    }
+    if (semiPlanar) {
+        img.mPlane[2].mOffset = img.mPlane[1].mOffset + 2;
+    }
+    return img;
+}
+
+MediaImage2 CreateStridedMediaImage2(
+        uint32_t width, uint32_t height, uint32_t stride, uint32_t vstride, uint32_t bpp) {
+    MediaImage2 img = CreateYUV420PlanarMediaImage2(width, height, stride * 2 * bpp, vstride);
+    img.mBitDepth = bpp == 2 ? 10 : 8;
+    img.mBitDepthAllocated = bpp * 8;
+    for (uint32_t i = 0; i < img.mNumPlanes; ++i) {
+        img.mPlane[i].mColInc = 2 * bpp;
+    }
+    return img;
+}
+
+MediaImage2 CreateMediaImage2(ImageLayout layout, const FrameSize &size) {
+    switch (layout) {
+        case P010:
+            return CreateYUV420_16bitMediaImage2(
+                    size.width, size.height, size.stride, size.vstride, true);
+        case YUV420_PLANAR_16:
+            return CreateYUV420_16bitMediaImage2(
+                    size.width, size.height, size.stride, size.vstride, false);
+        case STRIDED_8:
+            return CreateStridedMediaImage2(size.width, size.height, size.stride, size.vstride, 1);
+        case STRIDED_16:
+        default:
+            return CreateStridedMediaImage2(size.width, size.height, size.stride, size.vstride, 2);
+    }
+}
+
+size_t GetMediaImageSize(const MediaImage2 &img) {
+    const size_t bpp = img.mBitDepthAllocated / 8;
+    size_t size = 0;
+    for (uint32_t i = 0; i < img.mNumPlanes; ++i) {
+        const MediaImage2::PlaneInfo &plane = img.mPlane[i];
+        const size_t planeW = img.mWidth / plane.mHorizSubsampling;
+        const size_t planeH = img.mHeight / plane.mVertSubsampling;
+        size = std::max(size, plane.mOffset + (planeH - 1) * plane.mRowInc
+                + (planeW - 1) * plane.mColInc + bpp);
+    }
+    return size;
+}
+
+/**
+ * Calls fn(plane, imgOffset, viewOffset) for every sample that ImageCopy copies, as the scalar
+ * copy used to visit them.
+ */
+template<typename Fn>
+void ForEachSample(const MediaImage2 &img, const C2PlanarLayout &layout, Fn fn) {
+    for (uint32_t i = 0; i < layout.numPlanes; ++i) {
+        const C2PlaneInfo &plane = layout.planes[i];
+        const MediaImage2::PlaneInfo &imgPlane = img.mPlane[i];
+        for (uint32_t row = 0; row < img.mHeight / plane.rowSampling; ++row) {
+            for (uint32_t col = 0; col < img.mWidth / plane.colSampling; ++col) {
+                fn(i,
+                   ptrdiff_t(imgPlane.mOffset) + ptrdiff_t(row) * imgPlane.mRowInc
+                           + ptrdiff_t(col) * imgPlane.mColInc,
+                   ptrdiff_t(row) * plane.rowInc + ptrdiff_t(col) * plane.colInc);
+            }
+        }
+    }
+}
+
+std::shared_ptr<C2GraphicBlock> FetchGraphicBlock(
+        uint32_t width, uint32_t height, uint32_t format) {
+    std::shared_ptr<C2BlockPool> pool;
+    std::shared_ptr<C2GraphicBlock> block;
+    // allocate even dimensions and crop, as YUV 420 allocations may need them
+    if (GetCodec2BlockPool(C2BlockPool::BASIC_GRAPHIC, nullptr, &pool) != C2_OK
+            || pool->fetchGraphicBlock(
+                    (width + 1) & ~1u, (height + 1) & ~1u, format,
+                    C2MemoryUsage{C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE},
+                    &block) != C2_OK) {
+        return nullptr;
+    }
+    return block;
+}
+
+void FillView(C2GraphicView &view, uint8_t seed) {
+    const C2PlanarLayout layout = view.layout();
+    for (uint32_t i = 0; i < layout.numPlanes; ++i) {
+        const C2PlaneInfo &plane = layout.planes[i];
+        const size_t bpp = (plane.allocatedDepth + 7) / 8;
+        for (uint32_t row = 0; row < view.crop().height / plane.rowSampling; ++row) {
+            for (uint32_t col = 0; col < view.crop().width / plane.colSampling; ++col) {
+                uint8_t *sample = view.data()[i] + row * plane.rowInc + col * plane.colInc;
+                for (size_t b = 0; b < bpp; ++b) {
+                    sample[b] = seed + i * 67 + row * 7 + col * 13 + b * 101;
+                }
+            }
+        }
+    }
+}
+
+void FillBuffer(std::vector<uint8_t> &buffer, uint8_t seed) {
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        buffer[i] = seed + i * 31 + (i >> 7);
+    }
+}
+
+void CheckImageCopy(uint32_t format, ImageLayout imageLayout) {
+    for (const FrameSize &size : kFrameSizes) {
+        SCOPED_TRACE(::testing::Message() << "layout " << imageLayout << " size " << size.width
+                     << "x" << size.height << " stride " << size.stride);
+        std::shared_ptr<C2GraphicBlock> block =
+            FetchGraphicBlock(size.width, size.height, format);
+        if (!block) {
+            GTEST_SKIP() << "cannot allocate graphic block";
+        }
+        C2GraphicView view = block->map().get();
+        ASSERT_EQ(C2_OK, view.error());
+        view.setCrop_be(C2Rect(size.width, size.height));
+        const C2PlanarLayout layout = view.layout();
+        const MediaImage2 img = CreateMediaImage2(imageLayout, size);
+        const size_t bpp = img.mBitDepthAllocated / 8;
+
+        // row and plane copies may also copy the row padding, so only the samples are compared
+        std::vector<uint8_t> buffer(GetMediaImageSize(img) + size.stride * 2 * bpp);
+        auto countMismatches = [&]() {
+            size_t mismatches = 0;
+            ForEachSample(img, layout, [&](uint32_t i, ptrdiff_t imgOffset, ptrdiff_t viewOff) {
+                if (memcmp(buffer.data() + imgOffset, view.data()[i] + viewOff, bpp)) {
+                    ++mismatches;
+                }
+            });
+            return mismatches;
+        };
+
+        FillView(view, 0x11);
+        FillBuffer(buffer, 0x5a);
+        ASSERT_EQ(OK, ImageCopy(buffer.data(), &img, view));
+        EXPECT_EQ(0u, countMismatches()) << "view to MediaImage";
+
+        FillView(view, 0x22);
+        FillBuffer(buffer, 0x33);
+        ASSERT_EQ(OK, ImageCopy(view, buffer.data(), &img));
+        EXPECT_EQ(0u, countMismatches()) << "MediaImage to view";
+    }
+}
+
+// RGB to YUV weights, as used by ConvertRGBToPlanarYUV.
+const int16_t kBt601Matrix[2][3][3] = {
+    { { 77, 150, 29 }, { -43, -85, 128 }, { 128, -107, -21 } }, /* RANGE_FULL */
+    { { 66, 129, 25 }, { -38, -74, 112 }, { 112, -94, -18 } },  /* RANGE_LIMITED */
+};
+
+const int16_t kBt709Matrix[2][3][3] = {
+    { { 54, 183, 19 }, { -29, -99, 128 }, { 128, -116, -12 } }, /* RANGE_FULL */
+    { { 47, 157, 16 }, { -26, -86, 112 }, { 112, -102, -10 } }, /* RANGE_LIMITED */
+};
+
+// The per-pixel conversion ConvertRGBToPlanarYUV used before it converted by row.
+void ScalarConvertRGBToPlanarYUV(
+        uint8_t *dstY, size_t dstStride, size_t dstVStride, const C2GraphicView &src,
+        C2Color::matrix_t colorMatrix, C2Color::range_t colorRange) {
+    uint8_t *dstU = dstY + dstStride * dstVStride;
+    uint8_t *dstV = dstU + (dstStride >> 1) * (dstVStride >> 1);
+
+    const C2PlanarLayout &layout = src.layout();
+    const uint8_t *pRed   = src.data()[C2PlanarLayout::PLANE_R];
+    const uint8_t *pGreen = src.data()[C2PlanarLayout::PLANE_G];
+    const uint8_t *pBlue  = src.data()[C2PlanarLayout::PLANE_B];
+
+    const int16_t (*weights)[3] = (colorMatrix == C2Color::MATRIX_BT709)
+            ? kBt709Matrix[colorRange - 1] : kBt601Matrix[colorRange - 1];
+    const int32_t zeroLvl = colorRange == C2Color::RANGE_FULL ? 0 : 16;
+    const int32_t maxLvlLuma = colorRange == C2Color::RANGE_FULL ? 255 : 235;
+    const int32_t maxLvlChroma = colorRange == C2Color::RANGE_FULL ? 255 : 240;
+
+    for (size_t y = 0; y < src.crop().height; ++y) {
+        for (size_t x = 0; x < src.crop().width; ++x) {
+            const int32_t red = pRed[x * layout.planes[C2PlanarLayout::PLANE_R].colInc];
+            const int32_t green = pGreen[x * layout.planes[C2PlanarLayout::PLANE_G].colInc];
+            const int32_t blue = pBlue[x * layout.planes[C2PlanarLayout::PLANE_B].colInc];
+
+            const int32_t luma = ((red * weights[0][0] + green * weights[0][1] +
+                                   blue * weights[0][2]) >> 8) + zeroLvl;
+            dstY[x] = std::clamp(luma, zeroLvl, maxLvlLuma);
+
+            if ((x & 1) == 0 && (y & 1) == 0) {
+                const int32_t u = ((red * weights[1][0] + green * weights[1][1] +
+                                    blue * weights[1][2]) >> 8) + 128;
+                const int32_t v = ((red * weights[2][0] + green * weights[2][1] +
+                                    blue * weights[2][2]) >> 8) + 128;
+                dstU[x >> 1] = std::clamp(u, zeroLvl, maxLvlChroma);
+                dstV[x >> 1] = std::clamp(v, zeroLvl, maxLvlChroma);
+            }
+        }
+        if ((y & 1) == 0) {
+            dstU += dstStride >> 1;
+            dstV += dstStride >> 1;
+        }
+        pRed   += layout.planes[C2PlanarLayout::PLANE_R].rowInc;
+        pGreen += layout.planes[C2PlanarLayout::PLANE_G].rowInc;
+        pBlue  += layout.planes[C2PlanarLayout::PLANE_B].rowInc;
+        dstY += dstStride;
+    }
+}
+
+void CheckConvertRGBToPlanarYUV(uint32_t format) {
+    for (const FrameSize &size : kFrameSizes) {
+        std::shared_ptr<C2GraphicBlock> block =
+            FetchGraphicBlock(size.width, size.height, format);
+        if (!block) {
+            GTEST_SKIP() << "cannot allocate graphic block";
+        }
+        C2GraphicView view = block->map().get();
+        ASSERT_EQ(C2_OK, view.error());
+        view.setCrop_be(C2Rect(size.width, size.height));
+        ASSERT_EQ(C2PlanarLayout::TYPE_RGB, view.layout().type);
+        // covers the whole input range so that every clip is exercised
+        FillView(view, 0x44);
+
+        const size_t bufferSize = size.stride * size.vstride * 3 / 2;
+        for (C2Color::matrix_t matrix : { C2Color::MATRIX_BT601, C2Color::MATRIX_BT709 }) {
+            for (C2Color::range_t range : { C2Color::RANGE_FULL, C2Color::RANGE_LIMITED }) {
+                SCOPED_TRACE(::testing::Message() << "size " << size.width << "x"
+                             << size.height << " stride " << size.stride
+                             << " matrix " << matrix << " range " << range);
+                std::vector<uint8_t> expected(bufferSize, 0xa5);
+                std::vector<uint8_t> actual = expected;
+                ScalarConvertRGBToPlanarYUV(
+                        expected.data(), size.stride, size.vstride, view, matrix, range);
+                ASSERT_EQ(OK, ConvertRGBToPlanarYUV(
+                        actual.data(), size.stride, size.vstride, actual.size(), view,
+                        matrix, range));
+                EXPECT_EQ(expected, actual);
+            }
+        }
+    }
+}
+
+}  // namespace
+
+// P010, YUV420Planar16 and strided 16-bit images, covering the libyuv 16-bit paths and the
+// 16-bit strided row copies.
+TEST(Codec2BufferUtilsTest, ImageCopyP010MatchesScalarCopy) {
+    for (ImageLayout layout : { P010, YUV420_PLANAR_16, STRIDED_16 }) {
+        CheckImageCopy(HAL_PIXEL_FORMAT_YCBCR_P010, layout);
+        if (HasFatalFailure() || IsSkipped()) {
+            return;
+        }
+    }
+}
+
+TEST(Codec2BufferUtilsTest, ImageCopyYUV420MatchesScalarCopy) {
+    CheckImageCopy(HAL_PIXEL_FORMAT_YCBCR_420_888, STRIDED_8);
+}
+
+TEST(Codec2BufferUtilsTest, ConvertRGBA8888MatchesScalarConversion) {
+    CheckConvertRGBToPlanarYUV(HAL_PIXEL_FORMAT_RGBA_8888);
+}
+
+TEST(Codec2BufferUtilsTest, ConvertRGB888MatchesScalarConversion) {
+    CheckConvertRGBToPlanarYUV(HAL_PIXEL_FORMAT_RGB_888);
+}
+
+}  // namespace android
@@ -14,9 +14,11 @@
  * limitations under the License.
  */
 
+#include <math.h>
 #include <stdlib.h>
 
 #include <algorithm>
+#include <vector>
 
 #include <binder/ProcessState.h>
 #include <gtest/gtest.h>
@@ -24,6 +26,7 @@
 #include <mediadrm/ICrypto.h>
 #include <media/MediaCodecBuffer.h>
 #include <media/hardware/VideoAPI.h>
+#include <media/stagefright/CodecBase.h>
 #include <media/stagefright/MediaCodec.h>
 #include <media/stagefright/MediaCodecConstants.h>
 #include <media/stagefright/foundation/ABuffer.h>
@@ -450,4 +453,289 @@ INSTANTIATE_TEST_CASE_P(InputSizes, MediaCodecByteBufferTest, ::testing::Values(
         COLOR_FormatYUV420PackedSemiPlanar,
         COLOR_FormatYUV420Flexible));
 
+class MediaCodecZeroCopyOutputTest : public MediaCodecSanityTest,
+        public ::testing::WithParamInterface<bool> {
+};
+
+TEST_P(MediaCodecZeroCopyOutputTest, TestRawDecoder) {
+    codec = MediaCodec::CreateByComponentName(looper, "c2.android.raw.decoder");
+    cfg->setInt32("sample-rate", 44100);
+    cfg->setInt32("channel-count", 2);
+    cfg->setString("mime", MIMETYPE_AUDIO_RAW);
+    const bool zeroCopy = GetParam();
+    cfg->setInt32("android._zero-copy-output", zeroCopy);
+
+    EXPECT_EQ(codec->configure(cfg, nullptr, nullptr, 0), OK);
+    EXPECT_EQ(codec->start(),  OK);
+    // byte-buffer clients ask for the output buffer array
+    Vector<sp<MediaCodecBuffer>> outputBuffers;
+    EXPECT_EQ(codec->getOutputBuffers(&outputBuffers), OK);
+    ASSERT_FALSE(outputBuffers.empty());
+
+    const size_t kFrameSize = 4096;
+    size_t ix;
+    sp<MediaCodecBuffer> buf;
+    EXPECT_EQ(codec->dequeueInputBuffer(&ix, 1000000), OK);
+    EXPECT_EQ(codec->getInputBuffer(ix, &buf),  OK);
+    ASSERT_GE(buf->capacity(), kFrameSize);
+    for (size_t i = 0; i < kFrameSize; ++i) {
+        buf->base()[i] = i & 0xff;
+    }
+    EXPECT_EQ(buf->setRange(0, kFrameSize), OK);
+    EXPECT_EQ(codec->queueInputBuffer(ix, 0, kFrameSize, 0, BUFFER_FLAG_END_OF_STREAM), OK);
+
+    size_t offset, size;
+    int64_t ts;
+    uint32_t flags;
+    while (true) {
+        status_t err = codec->dequeueOutputBuffer(&ix, &offset, &size, &ts, &flags, 1000000);
+        if (err == INFO_OUTPUT_BUFFERS_CHANGED) {
+            EXPECT_EQ(codec->getOutputBuffers(&outputBuffers), OK);
+        } else if (err != INFO_FORMAT_CHANGED) {
+            ASSERT_EQ(err, OK);
+            break;
+        }
+    }
+    EXPECT_EQ(codec->getOutputBuffer(ix, &buf), OK);
+    ASSERT_EQ(size, kFrameSize);
+    for (size_t i = 0; i < kFrameSize; ++i) {
+        ASSERT_EQ(buf->data()[i], i & 0xff) << "at byte " << i;
+    }
+    // legacy clients read the output from the array
+    ASSERT_LT(ix, outputBuffers.size());
+    EXPECT_EQ(outputBuffers[ix].get(), buf.get());
+    if (zeroCopy) {
+        // the slot maps the block of the component
+        EXPECT_NE(buf->asC2Buffer(), nullptr);
+    } else {
+        // the slot of the array holds a copy
+        EXPECT_EQ(buf->asC2Buffer(), nullptr);
+    }
+    EXPECT_EQ(codec->releaseOutputBuffer(ix), OK);
+}
+
+INSTANTIATE_TEST_CASE_P(ZeroCopy, MediaCodecZeroCopyOutputTest, ::testing::Bool());
+
+
+// an access unit produced by an encoder
+struct AccessUnit {
+    std::vector<uint8_t> data;
+    int64_t timeUs;
+    uint32_t flags;
+};
+
+// an output buffer of a decoder
+struct DecodedBuffer {
+    size_t frameOffset;  // number of PCM frames decoded before this buffer
+    int64_t timeUs;
+};
+
+// how the access units are queued to the decoder
+enum BatchMode {
+    kSingle,          // one access unit per input buffer
+    kBatched,         // batches of access units, end of stream in an empty buffer
+    kBatchedEos,      // batches of access units, end of stream on the last access unit
+    kBatchedConfig,   // batches of access units, the first one starting with the codec config
+};
+
+struct BatchedAudioDecoderParam {
+    const char *decoder;
+    const char *encoder;
+    const char *mime;
+};
+
+class MediaCodecBatchedAudioDecoderTest : public MediaCodecSanityTest,
+        public ::testing::WithParamInterface<BatchedAudioDecoderParam> {
+protected:
+    static constexpr int32_t kSampleRate = 48000;
+    static constexpr int32_t kChannelCount = 2;
+    static constexpr size_t kFrameSize = kChannelCount * sizeof(int16_t);
+    static constexpr size_t kBatchSize = 5;
+
+    // Encodes half a second of a stereo tone, codec config data included.
+    void encodeTone(std::vector<AccessUnit> *aus) {
+        codec = MediaCodec::CreateByComponentName(looper, GetParam().encoder);
+        ASSERT_NE(codec, nullptr);
+        cfg = new AMessage;
+        cfg->setString("mime", GetParam().mime);
+        cfg->setInt32("sample-rate", kSampleRate);
+        cfg->setInt32("channel-count", kChannelCount);
+        cfg->setInt32("bitrate", 128000);
+        ASSERT_EQ(codec->configure(cfg, nullptr, nullptr, MediaCodec::CONFIGURE_FLAG_ENCODE), OK);
+        ASSERT_EQ(codec->start(), OK);
+
+        const size_t totalFrames = kSampleRate / 2;
+        size_t framesQueued = 0;
+        bool inputDone = false;
+        while (true) {
+            size_t ix;
+            if (!inputDone && codec->dequeueInputBuffer(&ix, 10000) == OK) {
+                sp<MediaCodecBuffer> buf;
+                ASSERT_EQ(codec->getInputBuffer(ix, &buf), OK);
+                const size_t frames = std::min({totalFrames - framesQueued,
+                        buf->capacity() / kFrameSize, (size_t)1024});
+                int16_t *pcm = reinterpret_cast<int16_t *>(buf->base());
+                for (size_t i = 0; i < frames; ++i) {
+                    pcm[2 * i] = pcm[2 * i + 1] = (int16_t)(8000 * sin(
+                            2 * M_PI * 440 * (framesQueued + i) / kSampleRate));
+                }
+                const int64_t timeUs = framesQueued * 1000000ll / kSampleRate;
+                framesQueued += frames;
+                inputDone = (framesQueued == totalFrames);
+                ASSERT_EQ(buf->setRange(0, frames * kFrameSize), OK);
+                ASSERT_EQ(codec->queueInputBuffer(ix, 0, frames * kFrameSize, timeUs,
+                        inputDone ? BUFFER_FLAG_END_OF_STREAM : 0), OK);
+            }
+            size_t offset, size;
+            int64_t timeUs;
+            uint32_t flags;
+            status_t err = codec->dequeueOutputBuffer(&ix, &offset, &size, &timeUs, &flags, 10000);
+            if (err == -EAGAIN || err == INFO_FORMAT_CHANGED || err == INFO_OUTPUT_BUFFERS_CHANGED) {
+                continue;
+            }
+            ASSERT_EQ(err, OK);
+            sp<MediaCodecBuffer> buf;
+            ASSERT_EQ(codec->getOutputBuffer(ix, &buf), OK);
+            if (size > 0) {
+                aus->push_back({std::vector<uint8_t>(buf->data(), buf->data() + size), timeUs,
+                        flags & BUFFER_FLAG_CODEC_CONFIG});
+            }
+            ASSERT_EQ(codec->releaseOutputBuffer(ix), OK);
+            if (flags & BUFFER_FLAG_END_OF_STREAM) {
+                break;
+            }
+        }
+        codec->release();
+        codec.clear();
+        ASSERT_FALSE(aus->empty());
+        ASSERT_NE(aus->front().flags & BUFFER_FLAG_CODEC_CONFIG, 0u);
+    }
+
+    // Decodes the access units queued as |mode| says.
+    void decode(const std::vector<AccessUnit> &aus, BatchMode mode,
+                std::vector<DecodedBuffer> *out, size_t *totalFrames) {
+        // each input buffer holds the access units [first, last) of aus
+        std::vector<std::pair<size_t, size_t>> buffers;
+        size_t first = 0;
+        while (first < aus.size()) {
+            size_t last = first + 1;
+            const bool config = aus[first].flags & BUFFER_FLAG_CODEC_CONFIG;
+            if (mode != kSingle && (!config || mode == kBatchedConfig)) {
+                // the codec config data stays in a buffer of its own, or leads a batch
+                while (last < aus.size() && last - first < kBatchSize
+                        && !(aus[last].flags & BUFFER_FLAG_CODEC_CONFIG)) {
+                    ++last;
+                }
+            }
+            buffers.emplace_back(first, last);
+            first = last;
+        }
+
+        codec = MediaCodec::CreateByComponentName(looper, GetParam().decoder);
+        ASSERT_NE(codec, nullptr);
+        cfg = new AMessage;
+        cfg->setString("mime", GetParam().mime);
+        cfg->setInt32("sample-rate", kSampleRate);
+        cfg->setInt32("channel-count", kChannelCount);
+        cfg->setInt32("max-input-size", 1 << 20);
+        ASSERT_EQ(codec->configure(cfg, nullptr, nullptr, 0), OK);
+        ASSERT_EQ(codec->start(), OK);
+
+        size_t next = 0;
+        bool inputDone = false;
+        *totalFrames = 0;
+        while (true) {
+            size_t ix;
+            if (!inputDone && codec->dequeueInputBuffer(&ix, 10000) == OK) {
+                sp<MediaCodecBuffer> buf;
+                ASSERT_EQ(codec->getInputBuffer(ix, &buf), OK);
+                if (next == buffers.size()) {
+                    ASSERT_EQ(codec->queueInputBuffer(ix, 0, 0, aus.back().timeUs,
+                            BUFFER_FLAG_END_OF_STREAM), OK);
+                    inputDone = true;
+                    continue;
+                }
+                const bool lastBuffer = (next + 1 == buffers.size());
+                std::vector<AccessUnitInfo> infos;
+                size_t size = 0;
+                for (size_t i = buffers[next].first; i < buffers[next].second; ++i) {
+                    ASSERT_LE(size + aus[i].data.size(), buf->capacity());
+                    memcpy(buf->base() + size, aus[i].data.data(), aus[i].data.size());
+                    size += aus[i].data.size();
+                    uint32_t flags = aus[i].flags;
+                    if (mode == kBatchedEos && lastBuffer && i + 1 == buffers[next].second) {
+                        flags |= BUFFER_FLAG_END_OF_STREAM;
+                    }
+                    infos.emplace_back(flags, aus[i].data.size(), aus[i].timeUs);
+                }
+                ASSERT_EQ(buf->setRange(0, size), OK);
+                if (mode == kSingle) {
+                    ASSERT_EQ(codec->queueInputBuffer(
+                            ix, 0, size, infos.front().mTimestamp, infos.front().mFlags), OK);
+                } else {
+                    sp<BufferInfosWrapper> bufferInfos{new BufferInfosWrapper(std::move(infos))};
+                    ASSERT_EQ(codec->queueInputBuffers(ix, 0, size, bufferInfos), OK);
+                }
+                ++next;
+                inputDone = (mode == kBatchedEos && lastBuffer);
+            }
+            size_t offset, size;
+            int64_t timeUs;
+            uint32_t flags;
+            status_t err = codec->dequeueOutputBuffer(&ix, &offset, &size, &timeUs, &flags, 10000);
+            if (err == -EAGAIN || err == INFO_FORMAT_CHANGED || err == INFO_OUTPUT_BUFFERS_CHANGED) {
+                continue;
+            }
+            ASSERT_EQ(err, OK);
+            if (size > 0) {
+                out->push_back({*totalFrames, timeUs});
+                *totalFrames += size / kFrameSize;
+            }
+            ASSERT_EQ(codec->releaseOutputBuffer(ix), OK);
+            if (flags & BUFFER_FLAG_END_OF_STREAM) {
+                break;
+            }
+        }
+        codec->release();
+        codec.clear();
+    }
+};
+
+TEST_P(MediaCodecBatchedAudioDecoderTest, SameOutputAsSingleAccessUnits) {
+    std::vector<AccessUnit> aus;
+    ASSERT_NO_FATAL_FAILURE(encodeTone(&aus));
+
+    std::vector<DecodedBuffer> expected;
+    size_t expectedFrames;
+    ASSERT_NO_FATAL_FAILURE(decode(aus, kSingle, &expected, &expectedFrames));
+    ASSERT_FALSE(expected.empty());
+
+    for (BatchMode mode : {kBatched, kBatchedEos, kBatchedConfig}) {
+        SCOPED_TRACE(::testing::Message() << "batch mode " << mode);
+        std::vector<DecodedBuffer> out;
+        size_t frames;
+        ASSERT_NO_FATAL_FAILURE(decode(aus, mode, &out, &frames));
+        EXPECT_EQ(expectedFrames, frames);
+        ASSERT_FALSE(out.empty());
+        for (const DecodedBuffer &buffer : out) {
+            // the timestamp of the same PCM frame decoded one access unit at a time
+            auto it = std::upper_bound(expected.begin(), expected.end(), buffer.frameOffset,
+                    [](size_t offset, const DecodedBuffer &b) { return offset < b.frameOffset; });
+            ASSERT_NE(it, expected.begin());
+            --it;
+            const int64_t timeUs = it->timeUs
+                    + (int64_t)(buffer.frameOffset - it->frameOffset) * 1000000 / kSampleRate;
+            EXPECT_NEAR(timeUs, buffer.timeUs, 1) << "at frame " << buffer.frameOffset;
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(Decoders, MediaCodecBatchedAudioDecoderTest, ::testing::Values(
+        BatchedAudioDecoderParam{
+                "c2.android.aac.decoder", "c2.android.aac.encoder", MIMETYPE_AUDIO_AAC},
+        BatchedAudioDecoderParam{
+                "c2.android.flac.decoder", "c2.android.flac.encoder", MIMETYPE_AUDIO_FLAC},
+        BatchedAudioDecoderParam{
+                "c2.android.opus.decoder", "c2.android.opus.encoder", MIMETYPE_AUDIO_OPUS}));
+
 } // namespace android
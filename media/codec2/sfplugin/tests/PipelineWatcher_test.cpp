@@ -0,0 +1,115 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PipelineWatcher.h"
+
+#include <gtest/gtest.h>
+
+namespace android {
+
+using Clock = PipelineWatcher::Clock;
+using namespace std::chrono_literals;
+
+class PipelineWatcherTest : public ::testing::Test {
+protected:
+    static constexpr uint32_t kSmoothnessFactor = 4;
+
+    void SetUp() override {
+        // Work items queued by the tests carry no input buffers, so the
+        // input delay does not apply.
+        mWatcher.inputDelay(0)
+                .pipelineDelay(1)
+                .outputDelay(1)
+                .smoothnessFactor(kSmoothnessFactor)
+                .minSmoothnessFactor(1);
+        mWatcher.flush();
+    }
+
+    // Queues and completes |count| work items, each taking |latency|.
+    void runFrames(size_t count, Clock::duration latency) {
+        for (size_t i = 0; i < count; ++i) {
+            mWatcher.onWorkQueued(mFrameIndex, {}, mNow);
+            mWatcher.onWorkDone(mFrameIndex, mNow + latency);
+            ++mFrameIndex;
+            mNow += latency;
+        }
+    }
+
+    // Returns the number of work items that can be queued before the pipeline is full.
+    size_t fillPipeline() {
+        size_t queued = 0;
+        while (!mWatcher.pipelineFull(nullptr)) {
+            mWatcher.onWorkQueued(mFrameIndex++, {}, mNow);
+            ++queued;
+        }
+        mWatcher.flush();
+        return queued;
+    }
+
+    PipelineWatcher mWatcher;
+    Clock::time_point mNow;
+    uint64_t mFrameIndex = 0;
+};
+
+TEST_F(PipelineWatcherTest, StaticDepth) {
+    // Without a target latency the depth does not depend on the latency.
+    runFrames(64, 100ms);
+    EXPECT_EQ(kSmoothnessFactor, mWatcher.currentSmoothnessFactor());
+    EXPECT_EQ(2 + kSmoothnessFactor, fillPipeline());
+    EXPECT_EQ(100ms, mWatcher.latency());
+    EXPECT_EQ(0ms, mWatcher.jitter());
+}
+
+TEST_F(PipelineWatcherTest, ShrinkAboveTarget) {
+    mWatcher.targetLatency(20ms);
+    EXPECT_EQ(kSmoothnessFactor, mWatcher.currentSmoothnessFactor());
+
+    runFrames(64, 30ms);
+    EXPECT_EQ(1u, mWatcher.currentSmoothnessFactor());
+    // The delays of the component are always honored.
+    EXPECT_EQ(2u + 1u, fillPipeline());
+}
+
+TEST_F(PipelineWatcherTest, GrowBelowTarget) {
+    mWatcher.targetLatency(20ms);
+    runFrames(64, 30ms);
+    ASSERT_EQ(1u, mWatcher.currentSmoothnessFactor());
+
+    runFrames(256, 5ms);
+    EXPECT_EQ(kSmoothnessFactor, mWatcher.currentSmoothnessFactor());
+    EXPECT_EQ(2 + kSmoothnessFactor, fillPipeline());
+}
+
+TEST_F(PipelineWatcherTest, JitterCountsAgainstTarget) {
+    mWatcher.targetLatency(20ms);
+    // Average latency under the target, but with large variations.
+    for (size_t i = 0; i < 64; ++i) {
+        runFrames(1, (i % 2) ? 2ms : 30ms);
+    }
+    EXPECT_GT(mWatcher.jitter(), 5ms);
+    EXPECT_EQ(1u, mWatcher.currentSmoothnessFactor());
+}
+
+TEST_F(PipelineWatcherTest, StaticAfterTargetCleared) {
+    mWatcher.targetLatency(20ms);
+    runFrames(64, 30ms);
+    ASSERT_EQ(1u, mWatcher.currentSmoothnessFactor());
+
+    mWatcher.targetLatency(Clock::duration::zero());
+    EXPECT_EQ(kSmoothnessFactor, mWatcher.currentSmoothnessFactor());
+}
+
+}  // namespace android
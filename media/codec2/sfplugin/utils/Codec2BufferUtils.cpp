@@ -22,6 +22,7 @@
 
 #include <libyuv.h>
 
+#include <algorithm>
 #include <list>
 #include <mutex>
 
@@ -57,6 +58,62 @@ struct MemCopier<false, S> {
     }
 };
 
+/**
+ * Copies one row of a plane whose samples are not contiguous on one side, e.g. the chroma of an
+ * interleaved layout into a planar one. Increments are compile-time so the loop can be
+ * vectorized.
+ *
+ * \param T sample type
+ * \param DstInc, SrcInc increment between samples in units of T
+ */
+template<typename T, size_t DstInc, size_t SrcInc>
+static void CopyStridedRow(uint8_t *dst, const uint8_t *src, uint32_t width) {
+    for (uint32_t col = 0; col < width; ++col) {
+        T sample;
+        __builtin_memcpy(&sample, src + col * SrcInc * sizeof(T), sizeof(T));
+        __builtin_memcpy(dst + col * DstInc * sizeof(T), &sample, sizeof(T));
+    }
+}
+
+typedef void (*StridedRowCopier)(uint8_t *dst, const uint8_t *src, uint32_t width);
+
+/**
+ * Returns a row copier for the given sample size and increments in bytes, or nullptr if the
+ * combination is not one of the common semiplanar/planar layouts.
+ */
+static StridedRowCopier GetStridedRowCopier(size_t bpp, int32_t dstColInc, int32_t srcColInc) {
+    if (bpp != 1 && bpp != 2) {
+        return nullptr;
+    }
+    const int32_t size = bpp;
+    const int32_t dstInc = dstColInc / size;
+    const int32_t srcInc = srcColInc / size;
+    if (dstColInc % size || srcColInc % size
+            || dstInc < 1 || dstInc > 2 || srcInc < 1 || srcInc > 2) {
+        return nullptr;
+    }
+    static const StridedRowCopier kCopiers[2][2][2] = {
+        { { CopyStridedRow<uint8_t, 1, 1>, CopyStridedRow<uint8_t, 1, 2> },
+          { CopyStridedRow<uint8_t, 2, 1>, CopyStridedRow<uint8_t, 2, 2> } },
+        { { CopyStridedRow<uint16_t, 1, 1>, CopyStridedRow<uint16_t, 1, 2> },
+          { CopyStridedRow<uint16_t, 2, 1>, CopyStridedRow<uint16_t, 2, 2> } },
+    };
+    return kCopiers[bpp - 1][dstInc - 1][srcInc - 1];
+}
+
+/**
+ * Returns true iff every plane of a 16-bit MediaImage starts and steps on a sample boundary. The
+ * libyuv 16-bit paths take strides in samples, so other images use the generic copy.
+ */
+static bool HasSampleAlignedRows(const MediaImage2 *img) {
+    for (uint32_t i = 0; i < img->mNumPlanes; ++i) {
+        if ((img->mPlane[i].mOffset | img->mPlane[i].mRowInc) & 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /**
  * Copies between a MediaImage and a graphic view.
  *
@@ -101,6 +158,18 @@ static status_t _ImageCopy(View &view, const MediaImage2 *img, ImagePixel *imgBa
                 imgRow += img->mPlane[i].mRowInc;
                 viewRow += plane.rowInc;
             }
+        } else if (StridedRowCopier copyRow = ToMediaImage
+                ? GetStridedRowCopier(bpp, img->mPlane[i].mColInc, plane.colInc)
+                : GetStridedRowCopier(bpp, plane.colInc, img->mPlane[i].mColInc)) {
+            for (uint32_t row = 0; row < planeH; ++row) {
+                if constexpr (ToMediaImage) {
+                    copyRow(imgRow, viewRow, planeW);
+                } else {
+                    copyRow(viewRow, imgRow, planeW);
+                }
+                imgRow += img->mPlane[i].mRowInc;
+                viewRow += plane.rowInc;
+            }
         } else {
             for (uint32_t row = 0; row < planeH; ++row) {
                 decltype(imgRow) imgPtr = imgRow;
@@ -200,6 +269,31 @@ status_t ImageCopy(uint8_t *imgBase, const MediaImage2 *img, const C2GraphicView
             libyuv::CopyPlane(src_v, src_stride_v, dst_v, dst_stride_v, width / 2, height / 2);
             return OK;
         }
+#if LIBYUV_VERSION >= 1779
+    } else if (IsP010(view) && HasSampleAlignedRows(img)) {
+        if (IsP010(img)) {
+            // strides of 16-bit planes are in samples
+            ScopedTrace trace(ATRACE_TAG, "ImageCopy: P010->P010");
+            libyuv::CopyPlane_16(reinterpret_cast<const uint16_t*>(src_y), src_stride_y / 2,
+                                 reinterpret_cast<uint16_t*>(dst_y), dst_stride_y / 2,
+                                 width, height);
+            libyuv::CopyPlane_16(reinterpret_cast<const uint16_t*>(src_u), src_stride_u / 2,
+                                 reinterpret_cast<uint16_t*>(dst_u), dst_stride_u / 2,
+                                 width, height / 2);
+            return OK;
+        } else if (IsYUV420_10bitPlanar(img)) {
+            ScopedTrace trace(ATRACE_TAG, "ImageCopy: P010->YUV420Planar16");
+            libyuv::CopyPlane_16(reinterpret_cast<const uint16_t*>(src_y), src_stride_y / 2,
+                                 reinterpret_cast<uint16_t*>(dst_y), dst_stride_y / 2,
+                                 width, height);
+            // depth 16 keeps the samples in the MSBs
+            libyuv::SplitUVPlane_16(reinterpret_cast<const uint16_t*>(src_u), src_stride_u / 2,
+                                    reinterpret_cast<uint16_t*>(dst_u), dst_stride_u / 2,
+                                    reinterpret_cast<uint16_t*>(dst_v), dst_stride_v / 2,
+                                    width / 2, height / 2, 16);
+            return OK;
+        }
+#endif
     }
     ScopedTrace trace(ATRACE_TAG, "ImageCopy: generic");
     return _ImageCopy<true>(view, img, imgBase);
@@ -284,6 +378,33 @@ status_t ImageCopy(C2GraphicView &view, const uint8_t *imgBase, const MediaImage
             libyuv::CopyPlane(src_v, src_stride_v, dst_v, dst_stride_v, width / 2, height / 2);
             return OK;
         }
+#if LIBYUV_VERSION >= 1779
+    } else if (IsP010(img) && HasSampleAlignedRows(img)) {
+        if (IsP010(view)) {
+            // strides of 16-bit planes are in samples
+            ScopedTrace trace(ATRACE_TAG, "ImageCopy: P010->P010");
+            libyuv::CopyPlane_16(reinterpret_cast<const uint16_t*>(src_y), src_stride_y / 2,
+                                 reinterpret_cast<uint16_t*>(dst_y), dst_stride_y / 2,
+                                 width, height);
+            libyuv::CopyPlane_16(reinterpret_cast<const uint16_t*>(src_u), src_stride_u / 2,
+                                 reinterpret_cast<uint16_t*>(dst_u), dst_stride_u / 2,
+                                 width, height / 2);
+            return OK;
+        }
+    } else if (IsYUV420_10bitPlanar(img) && HasSampleAlignedRows(img)) {
+        if (IsP010(view)) {
+            ScopedTrace trace(ATRACE_TAG, "ImageCopy: YUV420Planar16->P010");
+            libyuv::CopyPlane_16(reinterpret_cast<const uint16_t*>(src_y), src_stride_y / 2,
+                                 reinterpret_cast<uint16_t*>(dst_y), dst_stride_y / 2,
+                                 width, height);
+            // depth 16 keeps the samples in the MSBs
+            libyuv::MergeUVPlane_16(reinterpret_cast<const uint16_t*>(src_u), src_stride_u / 2,
+                                    reinterpret_cast<const uint16_t*>(src_v), src_stride_v / 2,
+                                    reinterpret_cast<uint16_t*>(dst_u), dst_stride_u / 2,
+                                    width / 2, height / 2, 16);
+            return OK;
+        }
+#endif
     }
     ScopedTrace trace(ATRACE_TAG, "ImageCopy: generic");
     return _ImageCopy<false>(view, img, imgBase);
@@ -408,6 +529,19 @@ bool IsYUV420(const MediaImage2 *img) {
             && img->mPlane[2].mVertSubsampling == 2);
 }
 
+bool IsYUV420_10bit(const MediaImage2 *img) {
+    return (img->mType == MediaImage2::MEDIA_IMAGE_TYPE_YUV
+            && img->mNumPlanes == 3
+            && img->mBitDepth == 10
+            && img->mBitDepthAllocated == 16
+            && img->mPlane[0].mHorizSubsampling == 1
+            && img->mPlane[0].mVertSubsampling == 1
+            && img->mPlane[1].mHorizSubsampling == 2
+            && img->mPlane[1].mVertSubsampling == 2
+            && img->mPlane[2].mHorizSubsampling == 2
+            && img->mPlane[2].mVertSubsampling == 2);
+}
+
 bool IsNV12(const MediaImage2 *img) {
     if (!IsYUV420(img)) {
         return false;
@@ -417,6 +551,25 @@ bool IsNV12(const MediaImage2 *img) {
             && (img->mPlane[2].mOffset == img->mPlane[1].mOffset + 1));
 }
 
+bool IsP010(const MediaImage2 *img) {
+    if (!IsYUV420_10bit(img)) {
+        return false;
+    }
+    return (img->mPlane[0].mColInc == 2
+            && img->mPlane[1].mColInc == 4
+            && img->mPlane[2].mColInc == 4
+            && (img->mPlane[2].mOffset == img->mPlane[1].mOffset + 2));
+}
+
+bool IsYUV420_10bitPlanar(const MediaImage2 *img) {
+    if (!IsYUV420_10bit(img)) {
+        return false;
+    }
+    return (img->mPlane[0].mColInc == 2
+            && img->mPlane[1].mColInc == 2
+            && img->mPlane[2].mColInc == 2);
+}
+
 bool IsNV21(const MediaImage2 *img) {
     if (!IsYUV420(img)) {
         return false;
@@ -589,6 +742,88 @@ static const int16_t bt709Matrix[2][3][3] = {
     { { 47, 157, 16 }, { -26, -86, 112 }, { 112, -102, -10 } }, /* RANGE_LIMITED */
 };
 
+namespace {
+
+/**
+ * Converts one row of RGB pixels to luma. ColInc is the pixel increment of all the channels when
+ * known at compile time (3 for RGB888, 4 for RGBA8888), which lets the loop be vectorized, or 0
+ * to use the increments passed in.
+ */
+template<size_t ColInc>
+void ConvertRGBRowToY(
+        const uint8_t *r, const uint8_t *g, const uint8_t *b,
+        int32_t rColInc, int32_t gColInc, int32_t bColInc, size_t width,
+        const int16_t weights[3], int32_t zeroLvl, int32_t maxLvl, uint8_t *dstY) {
+    const ptrdiff_t rInc = ColInc ? ColInc : rColInc;
+    const ptrdiff_t gInc = ColInc ? ColInc : gColInc;
+    const ptrdiff_t bInc = ColInc ? ColInc : bColInc;
+    const int32_t wr = weights[0], wg = weights[1], wb = weights[2];
+    for (size_t x = 0; x < width; ++x) {
+        const int32_t luma =
+            ((r[x * rInc] * wr + g[x * gInc] * wg + b[x * bInc] * wb) >> 8) + zeroLvl;
+        dstY[x] = std::min(std::max(luma, zeroLvl), maxLvl);
+    }
+}
+
+/**
+ * Converts the even pixels of one row of RGB pixels to chroma.
+ */
+template<size_t ColInc>
+void ConvertRGBRowToUV(
+        const uint8_t *r, const uint8_t *g, const uint8_t *b,
+        int32_t rColInc, int32_t gColInc, int32_t bColInc, size_t width,
+        const int16_t (*weights)[3], int32_t zeroLvl, int32_t maxLvl,
+        uint8_t *dstU, uint8_t *dstV) {
+    const ptrdiff_t rInc = (ColInc ? ColInc : rColInc) * 2;
+    const ptrdiff_t gInc = (ColInc ? ColInc : gColInc) * 2;
+    const ptrdiff_t bInc = (ColInc ? ColInc : bColInc) * 2;
+    const int32_t ur = weights[1][0], ug = weights[1][1], ub = weights[1][2];
+    const int32_t vr = weights[2][0], vg = weights[2][1], vb = weights[2][2];
+    for (size_t x = 0; x < (width + 1) / 2; ++x) {
+        const int32_t red = r[x * rInc];
+        const int32_t green = g[x * gInc];
+        const int32_t blue = b[x * bInc];
+        const int32_t u = ((red * ur + green * ug + blue * ub) >> 8) + 128;
+        const int32_t v = ((red * vr + green * vg + blue * vb) >> 8) + 128;
+        dstU[x] = std::min(std::max(u, zeroLvl), maxLvl);
+        dstV[x] = std::min(std::max(v, zeroLvl), maxLvl);
+    }
+}
+
+template<size_t ColInc>
+void _ConvertRGBToPlanarYUV(
+        uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, size_t dstStride,
+        const C2GraphicView &src, const int16_t (*weights)[3],
+        int32_t zeroLvl, int32_t maxLvlLuma, int32_t maxLvlChroma) {
+    const C2PlanarLayout &layout = src.layout();
+    const C2PlaneInfo &red   = layout.planes[C2PlanarLayout::PLANE_R];
+    const C2PlaneInfo &green = layout.planes[C2PlanarLayout::PLANE_G];
+    const C2PlaneInfo &blue  = layout.planes[C2PlanarLayout::PLANE_B];
+    const uint8_t *pRed   = src.data()[C2PlanarLayout::PLANE_R];
+    const uint8_t *pGreen = src.data()[C2PlanarLayout::PLANE_G];
+    const uint8_t *pBlue  = src.data()[C2PlanarLayout::PLANE_B];
+    const size_t width = src.crop().width;
+
+    for (size_t y = 0; y < src.crop().height; ++y) {
+        ConvertRGBRowToY<ColInc>(
+                pRed, pGreen, pBlue, red.colInc, green.colInc, blue.colInc, width,
+                weights[0], zeroLvl, maxLvlLuma, dstY);
+        if ((y & 1) == 0) {
+            ConvertRGBRowToUV<ColInc>(
+                    pRed, pGreen, pBlue, red.colInc, green.colInc, blue.colInc, width,
+                    weights, zeroLvl, maxLvlChroma, dstU, dstV);
+            dstU += dstStride >> 1;
+            dstV += dstStride >> 1;
+        }
+        pRed   += red.rowInc;
+        pGreen += green.rowInc;
+        pBlue  += blue.rowInc;
+        dstY += dstStride;
+    }
+}
+
+}  // namespace
+
 status_t ConvertRGBToPlanarYUV(
         uint8_t *dstY, size_t dstStride, size_t dstVStride, size_t bufferSize,
         const C2GraphicView &src, C2Color::matrix_t colorMatrix, C2Color::range_t colorRange) {
@@ -603,9 +838,6 @@ status_t ConvertRGBToPlanarYUV(
     uint8_t *dstV = dstU + (dstStride >> 1) * (dstVStride >> 1);
 
     const C2PlanarLayout &layout = src.layout();
-    const uint8_t *pRed   = src.data()[C2PlanarLayout::PLANE_R];
-    const uint8_t *pGreen = src.data()[C2PlanarLayout::PLANE_G];
-    const uint8_t *pBlue  = src.data()[C2PlanarLayout::PLANE_B];
 
     // set default range as limited
     if (colorRange != C2Color::RANGE_FULL && colorRange != C2Color::RANGE_LIMITED) {
@@ -618,46 +850,23 @@ status_t ConvertRGBToPlanarYUV(
     uint8_t maxLvlLuma =  colorRange == C2Color::RANGE_FULL ? 255 : 235;
     uint8_t maxLvlChroma =  colorRange == C2Color::RANGE_FULL ? 255 : 240;
 
-#define CLIP3(min,v,max) (((v) < (min)) ? (min) : (((max) > (v)) ? (v) : (max)))
-    for (size_t y = 0; y < src.crop().height; ++y) {
-        for (size_t x = 0; x < src.crop().width; ++x) {
-            uint8_t r = *pRed;
-            uint8_t g = *pGreen;
-            uint8_t b = *pBlue;
-
-            unsigned luma = ((r * weights[0][0] + g * weights[0][1] + b * weights[0][2]) >> 8) +
-                             zeroLvl;
-
-            dstY[x] = CLIP3(zeroLvl, luma, maxLvlLuma);
-
-            if ((x & 1) == 0 && (y & 1) == 0) {
-                unsigned U = ((r * weights[1][0] + g * weights[1][1] + b * weights[1][2]) >> 8) +
-                              128;
-
-                unsigned V = ((r * weights[2][0] + g * weights[2][1] + b * weights[2][2]) >> 8) +
-                              128;
-
-                dstU[x >> 1] = CLIP3(zeroLvl, U, maxLvlChroma);
-                dstV[x >> 1] = CLIP3(zeroLvl, V, maxLvlChroma);
-            }
-            pRed   += layout.planes[C2PlanarLayout::PLANE_R].colInc;
-            pGreen += layout.planes[C2PlanarLayout::PLANE_G].colInc;
-            pBlue  += layout.planes[C2PlanarLayout::PLANE_B].colInc;
-        }
-
-        if ((y & 1) == 0) {
-            dstU += dstStride >> 1;
-            dstV += dstStride >> 1;
-        }
-
-        pRed   -= layout.planes[C2PlanarLayout::PLANE_R].colInc * src.width();
-        pGreen -= layout.planes[C2PlanarLayout::PLANE_G].colInc * src.width();
-        pBlue  -= layout.planes[C2PlanarLayout::PLANE_B].colInc * src.width();
-        pRed   += layout.planes[C2PlanarLayout::PLANE_R].rowInc;
-        pGreen += layout.planes[C2PlanarLayout::PLANE_G].rowInc;
-        pBlue  += layout.planes[C2PlanarLayout::PLANE_B].rowInc;
-
-        dstY += dstStride;
+    const int32_t colInc = layout.planes[C2PlanarLayout::PLANE_R].colInc;
+    const bool sameColInc = layout.planes[C2PlanarLayout::PLANE_G].colInc == colInc
+            && layout.planes[C2PlanarLayout::PLANE_B].colInc == colInc;
+    ScopedTrace trace(ATRACE_TAG, "ConvertRGBToPlanarYUV");
+    switch (sameColInc ? colInc : 0) {
+        case 4:
+            _ConvertRGBToPlanarYUV<4>(dstY, dstU, dstV, dstStride, src, weights,
+                                      zeroLvl, maxLvlLuma, maxLvlChroma);
+            break;
+        case 3:
+            _ConvertRGBToPlanarYUV<3>(dstY, dstU, dstV, dstStride, src, weights,
+                                      zeroLvl, maxLvlLuma, maxLvlChroma);
+            break;
+        default:
+            _ConvertRGBToPlanarYUV<0>(dstY, dstU, dstV, dstStride, src, weights,
+                                      zeroLvl, maxLvlLuma, maxLvlChroma);
+            break;
     }
     return OK;
 }
@@ -122,11 +122,27 @@ bool IsI420(const C2GraphicView &view);
  */
 bool IsYUV420(const MediaImage2 *img);
 
+/**
+ * Returns true iff a MediaImage2 has a YUV 420 10-10-10 layout.
+ */
+bool IsYUV420_10bit(const MediaImage2 *img);
+
 /**
  * Returns true iff a MediaImage2 has a NV12 layout.
  */
 bool IsNV12(const MediaImage2 *img);
 
+/**
+ * Returns true iff a MediaImage2 has a P010 layout.
+ */
+bool IsP010(const MediaImage2 *img);
+
+/**
+ * Returns true iff a MediaImage2 has a planar YUV 420 10-10-10 layout, with the samples in the
+ * MSBs of 16-bit words.
+ */
+bool IsYUV420_10bitPlanar(const MediaImage2 *img);
+
 /**
  * Returns true iff a MediaImage2 has a NV21 layout.
  */
@@ -0,0 +1,274 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "MultiAccessUnitHelper_test"
+
+#include <gtest/gtest.h>
+
+#include <C2PlatformSupport.h>
+#include <codec2/common/MultiAccessUnitHelper.h>
+
+#include <list>
+#include <memory>
+#include <vector>
+
+namespace android {
+
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr uint32_t kChannelCount = 2;
+constexpr uint32_t kFrameSize = kChannelCount * sizeof(int16_t);
+constexpr int64_t kTimestampUs = 1000000;
+
+// A decoder of 16-bit stereo PCM, which may take several access units in a single work.
+class TestInterface : public C2ComponentInterface {
+public:
+    explicit TestInterface(bool multipleAccessUnits)
+        : mMultipleAccessUnits(multipleAccessUnits) {}
+
+    C2String getName() const override { return "c2.test.multi-access-unit"; }
+    c2_node_id_t getId() const override { return 0; }
+    c2_status_t query_vb(
+            const std::vector<C2Param*> &stackParams,
+            const std::vector<C2Param::Index> &,
+            c2_blocking_t,
+            std::vector<std::unique_ptr<C2Param>>* const) const override {
+        for (C2Param *param : stackParams) {
+            if (C2ComponentKindSetting *kind = C2ComponentKindSetting::From(param)) {
+                kind->value = C2Component::KIND_DECODER;
+            } else if (C2StreamSampleRateInfo::output *rate =
+                    C2StreamSampleRateInfo::output::From(param)) {
+                rate->value = kSampleRate;
+            } else if (C2StreamChannelCountInfo::output *count =
+                    C2StreamChannelCountInfo::output::From(param)) {
+                count->value = kChannelCount;
+            } else {
+                param->invalidate();
+            }
+        }
+        return C2_OK;
+    }
+    c2_status_t config_vb(
+            const std::vector<C2Param*> &,
+            c2_blocking_t,
+            std::vector<std::unique_ptr<C2SettingResult>>* const) override {
+        return C2_OMITTED;
+    }
+    c2_status_t createTunnel_sm(c2_node_id_t) override { return C2_OMITTED; }
+    c2_status_t releaseTunnel_sm(c2_node_id_t) override { return C2_OMITTED; }
+    c2_status_t querySupportedParams_nb(
+            std::vector<std::shared_ptr<C2ParamDescriptor>> * const params) const override {
+        if (mMultipleAccessUnits) {
+            params->push_back(std::make_shared<C2ParamDescriptor>(
+                    false, C2_PARAMKEY_INPUT_ACCESS_UNIT_INFOS,
+                    (const C2AccessUnitInfos::input *)nullptr));
+        }
+        return C2_OK;
+    }
+    c2_status_t querySupportedValues_vb(
+            std::vector<C2FieldSupportedValuesQuery> &, c2_blocking_t) const override {
+        return C2_OMITTED;
+    }
+
+private:
+    const bool mMultipleAccessUnits;
+};
+
+}  // namespace
+
+class MultiAccessUnitHelperTest : public ::testing::TestWithParam<bool> {
+protected:
+    void SetUp() override {
+        ASSERT_EQ(C2_OK, GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &mPool));
+        mInterface = std::make_shared<MultiAccessUnitInterface>(
+                std::make_shared<TestInterface>(GetParam()),
+                std::make_shared<C2ReflectorHelper>());
+        mHelper = std::make_shared<MultiAccessUnitHelper>(mInterface, mPool);
+        ASSERT_TRUE(mHelper->getStatus());
+    }
+
+    // Re-chunks the output of the component into frames of |frames| PCM frames.
+    void setLargeFrame(uint32_t frames) {
+        C2LargeFrame::output largeFrame(0u, frames * kFrameSize, frames * kFrameSize);
+        std::vector<std::unique_ptr<C2SettingResult>> failures;
+        ASSERT_EQ(C2_OK, mInterface->config({&largeFrame}, C2_MAY_BLOCK, &failures));
+    }
+
+    // A client buffer of |sizes| access units, 10ms apart, with |lastFlags| on the last one.
+    std::unique_ptr<C2Work> makeBatchedWork(
+            const std::vector<uint32_t> &sizes, uint32_t lastFlags) {
+        uint32_t totalSize = 0;
+        std::vector<C2AccessUnitInfosStruct> infos;
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            uint32_t flags = (i + 1 == sizes.size()) ? lastFlags : 0;
+            infos.emplace_back(flags, sizes[i], kTimestampUs + i * 10000);
+            totalSize += sizes[i];
+        }
+        std::shared_ptr<C2LinearBlock> block;
+        EXPECT_EQ(C2_OK, mPool->fetchLinearBlock(
+                totalSize, {C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE}, &block));
+        std::shared_ptr<C2Buffer> buffer =
+                C2Buffer::CreateLinearBuffer(block->share(0, totalSize, C2Fence()));
+        buffer->setInfo(C2AccessUnitInfos::input::AllocShared(infos.size(), 0u, infos));
+
+        std::unique_ptr<C2Work> work(new C2Work);
+        work->input.ordinal.frameIndex = kClientFrameIndex;
+        work->input.ordinal.timestamp = kTimestampUs;
+        // the channel flags the buffer with the flags common to all the access units
+        work->input.flags = (C2FrameData::flags_t)(lastFlags & C2FrameData::FLAG_END_OF_STREAM);
+        work->input.buffers.push_back(buffer);
+        work->worklets.emplace_back(new C2Worklet);
+        return work;
+    }
+
+    std::list<std::unique_ptr<C2Work>> scatter(std::unique_ptr<C2Work> work) {
+        std::list<std::unique_ptr<C2Work>> in;
+        in.push_back(std::move(work));
+        std::list<std::list<std::unique_ptr<C2Work>>> processed;
+        EXPECT_EQ(C2_OK, mHelper->scatter(in, &processed));
+        std::list<std::unique_ptr<C2Work>> out;
+        for (std::list<std::unique_ptr<C2Work>> &slice : processed) {
+            out.splice(out.end(), slice);
+        }
+        return out;
+    }
+
+    // Completes |work| as the component does, with |frames| PCM frames in a single buffer.
+    std::list<std::unique_ptr<C2Work>> gather(std::unique_ptr<C2Work> work, uint32_t frames) {
+        std::shared_ptr<C2LinearBlock> block;
+        EXPECT_EQ(C2_OK, mPool->fetchLinearBlock(
+                frames * kFrameSize, {C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE},
+                &block));
+        C2FrameData &output = work->worklets.front()->output;
+        output.buffers.push_back(
+                C2Buffer::CreateLinearBuffer(block->share(0, frames * kFrameSize, C2Fence())));
+        output.ordinal = work->input.ordinal;
+        output.flags = (C2FrameData::flags_t)(
+                work->input.flags & C2FrameData::FLAG_END_OF_STREAM);
+        work->workletsProcessed = 1u;
+        work->result = C2_OK;
+
+        std::list<std::unique_ptr<C2Work>> in;
+        in.push_back(std::move(work));
+        std::list<std::unique_ptr<C2Work>> out;
+        EXPECT_EQ(C2_OK, mHelper->gather(in, &out));
+        return out;
+    }
+
+    static constexpr uint64_t kClientFrameIndex = 42;
+
+    std::shared_ptr<C2BlockPool> mPool;
+    std::shared_ptr<MultiAccessUnitInterface> mInterface;
+    std::shared_ptr<MultiAccessUnitHelper> mHelper;
+};
+
+TEST_P(MultiAccessUnitHelperTest, BatchedBuffer) {
+    const bool singleWork = GetParam();
+    const std::vector<uint32_t> sizes = {100, 200, 300, 400};
+    std::list<std::unique_ptr<C2Work>> works = scatter(makeBatchedWork(sizes, 0));
+
+    if (singleWork) {
+        ASSERT_EQ(1u, works.size());
+        const std::unique_ptr<C2Work> &work = works.front();
+        EXPECT_NE(kClientFrameIndex, work->input.ordinal.frameIndex.peeku());
+        EXPECT_EQ(kTimestampUs, work->input.ordinal.timestamp.peekll());
+        EXPECT_EQ(0u, (uint32_t)work->input.flags);
+        // the buffer of the client, with its access unit infos
+        ASSERT_EQ(1u, work->input.buffers.size());
+        EXPECT_EQ(1000u, work->input.buffers.front()->data().linearBlocks().front().size());
+        EXPECT_TRUE(work->input.buffers.front()->hasInfo(C2AccessUnitInfos::input::PARAM_TYPE));
+    } else {
+        ASSERT_EQ(sizes.size(), works.size());
+        size_t i = 0;
+        for (const std::unique_ptr<C2Work> &work : works) {
+            EXPECT_EQ(kTimestampUs + (int64_t)i * 10000, work->input.ordinal.timestamp.peekll());
+            EXPECT_EQ(sizes[i], work->input.buffers.front()->data().linearBlocks().front().size());
+            EXPECT_EQ(0u, (uint32_t)work->input.flags);
+            ++i;
+        }
+    }
+}
+
+TEST_P(MultiAccessUnitHelperTest, EndOfStreamOnLastAccessUnit) {
+    const bool singleWork = GetParam();
+    const std::vector<uint32_t> sizes = {100, 200, 300};
+    std::list<std::unique_ptr<C2Work>> works =
+            scatter(makeBatchedWork(sizes, C2FrameData::FLAG_END_OF_STREAM));
+
+    ASSERT_EQ(singleWork ? 1u : sizes.size(), works.size());
+    EXPECT_EQ(kTimestampUs, works.front()->input.ordinal.timestamp.peekll());
+    // only the last work ends the stream
+    for (const std::unique_ptr<C2Work> &work : works) {
+        const bool last = (work == works.back());
+        EXPECT_EQ(last, (work->input.flags & C2FrameData::FLAG_END_OF_STREAM) != 0);
+    }
+}
+
+TEST_P(MultiAccessUnitHelperTest, CodecConfigOnLastAccessUnit) {
+    const std::vector<uint32_t> sizes = {100, 200, 20};
+    std::list<std::unique_ptr<C2Work>> works =
+            scatter(makeBatchedWork(sizes, C2FrameData::FLAG_CODEC_CONFIG));
+
+    // codec config data is never decoded along with the other access units
+    ASSERT_EQ(sizes.size(), works.size());
+    size_t i = 0;
+    for (const std::unique_ptr<C2Work> &work : works) {
+        const bool last = (i + 1 == sizes.size());
+        EXPECT_EQ(kTimestampUs + (int64_t)i * 10000, work->input.ordinal.timestamp.peekll());
+        EXPECT_EQ(sizes[i], work->input.buffers.front()->data().linearBlocks().front().size());
+        EXPECT_EQ(last, (work->input.flags & C2FrameData::FLAG_CODEC_CONFIG) != 0);
+        ++i;
+    }
+}
+
+TEST_P(MultiAccessUnitHelperTest, OutputOfSingleWork) {
+    if (!GetParam()) {
+        GTEST_SKIP() << "the access units are decoded in separate works";
+    }
+    constexpr uint32_t kChunkFrames = 1024;
+    constexpr uint32_t kChunks = 4;
+    setLargeFrame(kChunkFrames);
+    std::list<std::unique_ptr<C2Work>> works =
+            scatter(makeBatchedWork({100, 200, 300, 400}, C2FrameData::FLAG_END_OF_STREAM));
+    ASSERT_EQ(1u, works.size());
+
+    // the decoded output of all the access units, re-chunked into large frames
+    std::list<std::unique_ptr<C2Work>> out =
+            gather(std::move(works.front()), kChunks * kChunkFrames);
+    ASSERT_EQ(kChunks, out.size());
+    uint32_t frames = 0;
+    for (const std::unique_ptr<C2Work> &work : out) {
+        EXPECT_EQ(C2_OK, work->result);
+        EXPECT_EQ(kClientFrameIndex, work->input.ordinal.frameIndex.peeku());
+        ASSERT_EQ(1u, work->worklets.size());
+        const C2FrameData &output = work->worklets.front()->output;
+        EXPECT_EQ(kTimestampUs + (int64_t)frames * 1000000 / kSampleRate,
+                  output.ordinal.timestamp.peekll()) << "at frame " << frames;
+        const bool last = (work == out.back());
+        EXPECT_EQ(last, (output.flags & C2FrameData::FLAG_END_OF_STREAM) != 0);
+        ASSERT_EQ(1u, output.buffers.size());
+        const uint32_t size = output.buffers.front()->data().linearBlocks().front().size();
+        EXPECT_EQ(kChunkFrames * kFrameSize, size);
+        frames += size / kFrameSize;
+    }
+    EXPECT_EQ(kChunks * kChunkFrames, frames);
+}
+
+INSTANTIATE_TEST_SUITE_P(SingleWork, MultiAccessUnitHelperTest, ::testing::Bool());
+
+}  // namespace android
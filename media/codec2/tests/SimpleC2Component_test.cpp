@@ -0,0 +1,292 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SimpleC2Component_test"
+
+#include <gtest/gtest.h>
+
+#include <SimpleC2Component.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+class TestInterface : public C2ComponentInterface {
+public:
+    C2String getName() const override { return "c2.test.pipeline"; }
+    c2_node_id_t getId() const override { return 0; }
+    c2_status_t query_vb(
+            const std::vector<C2Param*> &stackParams,
+            const std::vector<C2Param::Index> &,
+            c2_blocking_t,
+            std::vector<std::unique_ptr<C2Param>>* const) const override {
+        for (C2Param *param : stackParams) {
+            param->invalidate();
+        }
+        return C2_BAD_INDEX;
+    }
+    c2_status_t config_vb(
+            const std::vector<C2Param*> &,
+            c2_blocking_t,
+            std::vector<std::unique_ptr<C2SettingResult>>* const) override {
+        return C2_OMITTED;
+    }
+    c2_status_t createTunnel_sm(c2_node_id_t) override { return C2_OMITTED; }
+    c2_status_t releaseTunnel_sm(c2_node_id_t) override { return C2_OMITTED; }
+    c2_status_t querySupportedParams_nb(
+            std::vector<std::shared_ptr<C2ParamDescriptor>> * const) const override {
+        return C2_OK;
+    }
+    c2_status_t querySupportedValues_vb(
+            std::vector<C2FieldSupportedValuesQuery> &, c2_blocking_t) const override {
+        return C2_OMITTED;
+    }
+};
+
+// Returns every work as processed, with the output stage on its own thread.
+class TestComponent : public SimpleC2Component {
+public:
+    using SimpleC2Component::kMaxInFlightWork;
+
+    TestComponent() : SimpleC2Component(std::make_shared<TestInterface>()) {
+        setPipelineStages(STAGE_OUTPUT);
+    }
+
+    void setProcessTime(std::chrono::microseconds time) { mProcessTime = time; }
+
+    // process() of the work with frameIndex waits until releaseProcess() is called.
+    void blockProcessAt(uint64_t frameIndex) { mBlockedFrame = frameIndex; }
+    void releaseProcess() {
+        std::lock_guard<std::mutex> lock(mGateLock);
+        mReleased = true;
+        mGateCond.notify_all();
+    }
+
+protected:
+    c2_status_t onInit() override { return C2_OK; }
+    c2_status_t onStop() override { return C2_OK; }
+    void onReset() override {}
+    void onRelease() override {}
+    c2_status_t onFlush_sm() override { return C2_OK; }
+    void process(const std::unique_ptr<C2Work> &work,
+                 const std::shared_ptr<C2BlockPool> &) override {
+        if (work->input.ordinal.frameIndex.peeku() == mBlockedFrame) {
+            std::unique_lock<std::mutex> lock(mGateLock);
+            EXPECT_TRUE(mGateCond.wait_for(lock, 5s, [this] { return mReleased; }));
+        }
+        std::this_thread::sleep_for(mProcessTime.load());
+        work->worklets.front()->output.ordinal = work->input.ordinal;
+        work->workletsProcessed = 1u;
+        work->result = C2_OK;
+    }
+    c2_status_t drain(uint32_t, const std::shared_ptr<C2BlockPool> &) override {
+        return C2_OK;
+    }
+
+private:
+    std::atomic<std::chrono::microseconds> mProcessTime{0us};
+    std::atomic<uint64_t> mBlockedFrame{UINT64_MAX};
+    std::mutex mGateLock;
+    std::condition_variable mGateCond;
+    bool mReleased = false;
+};
+
+class TestListener : public C2Component::Listener {
+public:
+    struct Done {
+        uint64_t frameIndex;
+        c2_status_t result;
+        std::thread::id thread;
+    };
+
+    void onWorkDone_nb(std::weak_ptr<C2Component>,
+                       std::list<std::unique_ptr<C2Work>> workItems) override {
+        std::this_thread::sleep_for(mDeliveryTime.load());
+        std::lock_guard<std::mutex> lock(mLock);
+        for (const std::unique_ptr<C2Work> &work : workItems) {
+            mDone.push_back({work->input.ordinal.frameIndex.peeku(), work->result,
+                             std::this_thread::get_id()});
+        }
+        mCond.notify_all();
+    }
+    void onTripped_nb(std::weak_ptr<C2Component>,
+                      std::vector<std::shared_ptr<C2SettingResult>>) override {}
+    void onError_nb(std::weak_ptr<C2Component>, uint32_t) override {}
+
+    void setDeliveryTime(std::chrono::microseconds time) { mDeliveryTime = time; }
+
+    bool waitForDone(size_t count) {
+        std::unique_lock<std::mutex> lock(mLock);
+        return mCond.wait_for(lock, 5s, [this, count] { return mDone.size() >= count; });
+    }
+
+    std::vector<Done> done() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mDone;
+    }
+
+private:
+    std::atomic<std::chrono::microseconds> mDeliveryTime{0us};
+    std::mutex mLock;
+    std::condition_variable mCond;
+    std::vector<Done> mDone;
+};
+
+}  // namespace
+
+class SimpleC2ComponentPipelineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        mComponent = std::make_shared<TestComponent>();
+        mListener = std::make_shared<TestListener>();
+        ASSERT_EQ(C2_OK, mComponent->setListener_vb(mListener, C2_MAY_BLOCK));
+        ASSERT_EQ(C2_OK, mComponent->start());
+    }
+
+    void TearDown() override {
+        (void)mComponent->stop();
+        (void)mComponent->release();
+    }
+
+    // If onDropped is set, it is called once the works queued are all destroyed.
+    void queue(uint64_t first, size_t count, std::function<void()> onDropped = nullptr) {
+        // an empty input buffer, which process() does not see
+        std::shared_ptr<C2Buffer> tracker;
+        if (onDropped) {
+            tracker.reset(static_cast<C2Buffer*>(nullptr),
+                          [onDropped](C2Buffer *) { onDropped(); });
+        }
+        std::list<std::unique_ptr<C2Work>> items;
+        for (uint64_t i = first; i < first + count; ++i) {
+            std::unique_ptr<C2Work> work(new C2Work);
+            work->input.ordinal.frameIndex = i;
+            work->input.ordinal.timestamp = i * 1000;
+            if (tracker) {
+                work->input.buffers.push_back(tracker);
+            }
+            work->worklets.emplace_back(new C2Worklet);
+            items.push_back(std::move(work));
+        }
+        tracker.reset();
+        ASSERT_EQ(C2_OK, mComponent->queue_nb(&items));
+    }
+
+    std::shared_ptr<TestComponent> mComponent;
+    std::shared_ptr<TestListener> mListener;
+};
+
+TEST_F(SimpleC2ComponentPipelineTest, DeliversInOrderOffTheLooper) {
+    constexpr size_t kCount = 4 * TestComponent::kMaxInFlightWork;
+    mListener->setDeliveryTime(500us);
+    for (size_t i = 0; i < kCount; ++i) {
+        queue(i, 1);
+    }
+    ASSERT_TRUE(mListener->waitForDone(kCount));
+
+    std::vector<TestListener::Done> done = mListener->done();
+    ASSERT_EQ(kCount, done.size());
+    for (size_t i = 0; i < kCount; ++i) {
+        EXPECT_EQ(i, done[i].frameIndex);
+        EXPECT_EQ(C2_OK, done[i].result);
+        EXPECT_NE(std::this_thread::get_id(), done[i].thread);
+        // all deliveries run on the output stage
+        EXPECT_EQ(done[0].thread, done[i].thread);
+    }
+    EXPECT_EQ(kCount, mComponent->getStageTiming(SimpleC2Component::STAGE_PROCESS).count);
+    EXPECT_EQ(kCount, mComponent->getStageTiming(SimpleC2Component::STAGE_OUTPUT).count);
+}
+
+TEST_F(SimpleC2ComponentPipelineTest, FlushReturnsEveryWorkOnce) {
+    constexpr size_t kCount = 32;
+    mComponent->setProcessTime(200us);
+    mListener->setDeliveryTime(1ms);
+    queue(0, kCount);
+    ASSERT_TRUE(mListener->waitForDone(2));
+
+    std::list<std::unique_ptr<C2Work>> flushed;
+    ASSERT_EQ(C2_OK, mComponent->flush_sm(C2Component::FLUSH_COMPONENT, &flushed));
+    const size_t doneAtFlush = mListener->done().size();
+    // the work finished before the flush is not left behind in the output stage
+    ASSERT_EQ(C2_OK, mComponent->stop());
+
+    std::vector<bool> returned(kCount, false);
+    uint64_t lastDone = 0;
+    std::vector<TestListener::Done> done = mListener->done();
+    for (size_t i = 0; i < done.size(); ++i) {
+        ASSERT_LT(done[i].frameIndex, kCount);
+        EXPECT_FALSE(returned[done[i].frameIndex]) << "frame #" << done[i].frameIndex;
+        returned[done[i].frameIndex] = true;
+        if (i > 0) {
+            EXPECT_GT(done[i].frameIndex, lastDone);
+        }
+        lastDone = done[i].frameIndex;
+        if (i >= doneAtFlush) {
+            // at most the work under process() when the flush started, and what it raced with
+            EXPECT_LE(i, doneAtFlush + 1);
+        }
+    }
+    for (const std::unique_ptr<C2Work> &work : flushed) {
+        const uint64_t frameIndex = work->input.ordinal.frameIndex.peeku();
+        ASSERT_LT(frameIndex, kCount);
+        EXPECT_FALSE(returned[frameIndex]) << "frame #" << frameIndex;
+        returned[frameIndex] = true;
+    }
+    for (size_t i = 0; i < kCount; ++i) {
+        EXPECT_TRUE(returned[i]) << "frame #" << i << " not returned";
+    }
+}
+
+TEST_F(SimpleC2ComponentPipelineTest, StopWithWorkInFlight) {
+    constexpr size_t kCount = 4 * TestComponent::kMaxInFlightWork;
+    constexpr uint64_t kBlockedFrame = TestComponent::kMaxInFlightWork;
+    mListener->setDeliveryTime(2ms);
+    // process() of kBlockedFrame only returns once stop() dropped the work queued after it,
+    // so stop() runs with work in process(), in the output stage and in the queue.
+    mComponent->blockProcessAt(kBlockedFrame);
+    queue(0, kBlockedFrame + 1);
+    queue(kBlockedFrame + 1, kCount - kBlockedFrame - 1,
+          [component = mComponent.get()] { component->releaseProcess(); });
+
+    ASSERT_EQ(C2_OK, mComponent->stop());
+    // the work processed before stop() is delivered by then, the work queued is not
+    const size_t doneAtStop = mListener->done().size();
+    EXPECT_EQ(kBlockedFrame + 1, doneAtStop);
+    std::this_thread::sleep_for(50ms);
+    std::vector<TestListener::Done> done = mListener->done();
+    EXPECT_EQ(doneAtStop, done.size());
+    for (size_t i = 0; i < done.size(); ++i) {
+        EXPECT_EQ(i, done[i].frameIndex);
+    }
+
+    // the component restarts from an empty pipeline
+    ASSERT_EQ(C2_OK, mComponent->start());
+    queue(kCount, 1);
+    ASSERT_TRUE(mListener->waitForDone(doneAtStop + 1));
+    EXPECT_EQ(kCount, mListener->done().back().frameIndex);
+}
+
+}  // namespace android
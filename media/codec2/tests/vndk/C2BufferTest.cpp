@@ -22,6 +22,9 @@
 #include <C2Config.h>
 #include <C2ParamDef.h>
 #include <C2PlatformSupport.h>
+#include <bufferpool/BufferPoolTypes.h>
+
+#include <C2BlockInternal.h>
 
 #include <system/graphics.h>
 
@@ -432,6 +435,46 @@ TEST_F(C2BufferTest, BlockPoolTest) {
     }
 }
 
+TEST_F(C2BufferTest, BlockPoolSizeClassTest) {
+    // Both capacities round up to the same size class.
+    constexpr uint32_t kCapacity = 100000u;
+    constexpr uint32_t kLargerCapacity = 110000u;
+
+    std::shared_ptr<C2BlockPool> blockPool(makeLinearBlockPool());
+
+    // Fetches a block, along with the id of its buffer in the buffer pool.
+    auto fetch = [&blockPool](uint32_t capacity, std::shared_ptr<C2LinearBlock> *block,
+                              uint32_t *bufferId) {
+        ASSERT_EQ(C2_OK, blockPool->fetchLinearBlock(
+                capacity,
+                { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE },
+                block));
+        ASSERT_TRUE(*block);
+        ASSERT_EQ(capacity, (*block)->capacity());
+        std::shared_ptr<hardware::media::bufferpool::BufferPoolData> data;
+        ASSERT_TRUE(_C2BlockFactory::GetBufferPoolData(
+                _C2BlockFactory::GetLinearBlockPoolData(**block), &data));
+        ASSERT_TRUE(data);
+        *bufferId = data->mId;
+    };
+
+    std::shared_ptr<C2LinearBlock> block;
+    uint32_t bufferId;
+    ASSERT_NO_FATAL_FAILURE(fetch(kCapacity, &block, &bufferId));
+
+    // A buffer still in use is not handed out again.
+    std::shared_ptr<C2LinearBlock> otherBlock;
+    uint32_t otherBufferId;
+    ASSERT_NO_FATAL_FAILURE(fetch(kCapacity, &otherBlock, &otherBufferId));
+    ASSERT_NE(bufferId, otherBufferId);
+
+    // The released buffer is recycled for a request of a different capacity.
+    block.reset();
+    uint32_t recycledBufferId;
+    ASSERT_NO_FATAL_FAILURE(fetch(kLargerCapacity, &block, &recycledBufferId));
+    ASSERT_EQ(bufferId, recycledBufferId);
+}
+
 void fillPlane(const C2Rect rect, const C2PlaneInfo info, uint8_t *addr, uint8_t value) {
     for (uint32_t row = 0; row < rect.height / info.rowSampling; ++row) {
         int32_t rowOffset = (row + rect.top / info.rowSampling) * info.rowInc;
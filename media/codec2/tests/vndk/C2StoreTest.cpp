@@ -0,0 +1,281 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <C2Component.h>
+#include <C2ComponentFactory.h>
+#include <C2Config.h>
+#include <C2PlatformSupport.h>
+#include <util/C2InterfaceUtils.h>
+
+namespace android {
+
+namespace {
+
+constexpr size_t kNumComponents = 8;
+
+// number of interfaces created per component, including the ones made to list the components
+std::atomic_int gNumInterfaces[kNumComponents];
+
+C2String ComponentName(size_t ix) {
+    return "c2.test.component" + std::to_string(ix) + (ix % 2 ? ".decoder" : ".encoder");
+}
+
+template<typename T>
+std::unique_ptr<C2Param> AllocString(const std::string &value) {
+    std::unique_ptr<T> param = T::AllocUnique(value.size() + 1);
+    memcpy(param->m.value, value.c_str(), value.size() + 1);
+    return param;
+}
+
+class TestInterface : public C2ComponentInterface {
+public:
+    explicit TestInterface(size_t ix) : mIx(ix) {}
+
+    C2String getName() const override { return ComponentName(mIx); }
+
+    c2_node_id_t getId() const override { return 0; }
+
+    c2_status_t query_vb(
+            const std::vector<C2Param*> &stackParams,
+            const std::vector<C2Param::Index> &heapParamIndices,
+            c2_blocking_t,
+            std::vector<std::unique_ptr<C2Param>>* const heapParams) const override {
+        c2_status_t res = C2_OK;
+        for (C2Param *param : stackParams) {
+            if (C2ComponentKindSetting *kind = C2ComponentKindSetting::From(param)) {
+                kind->value = isEncoder() ? C2Component::KIND_ENCODER : C2Component::KIND_DECODER;
+            } else if (C2ComponentDomainSetting *domain = C2ComponentDomainSetting::From(param)) {
+                domain->value = isAudio() ? C2Component::DOMAIN_AUDIO : C2Component::DOMAIN_VIDEO;
+            } else {
+                param->invalidate();
+                res = C2_BAD_INDEX;
+            }
+        }
+        const std::string mediaType = isAudio() ? "audio/x-test" : "video/x-test";
+        for (C2Param::Index index : heapParamIndices) {
+            const uint32_t type = index;
+            if (type == C2PortMediaTypeSetting::input::PARAM_TYPE) {
+                heapParams->push_back(AllocString<C2PortMediaTypeSetting::input>(mediaType));
+            } else if (type == C2PortMediaTypeSetting::output::PARAM_TYPE) {
+                heapParams->push_back(AllocString<C2PortMediaTypeSetting::output>(mediaType));
+            } else if (type == C2ComponentAliasesSetting::PARAM_TYPE && mIx % 3 == 0) {
+                heapParams->push_back(AllocString<C2ComponentAliasesSetting>(
+                        "c2.test.alias" + std::to_string(mIx)));
+            } else {
+                res = C2_BAD_INDEX;
+            }
+        }
+        return res;
+    }
+
+    c2_status_t config_vb(
+            const std::vector<C2Param*> &, c2_blocking_t,
+            std::vector<std::unique_ptr<C2SettingResult>>* const) override {
+        return C2_OMITTED;
+    }
+
+    c2_status_t createTunnel_sm(c2_node_id_t) override { return C2_OMITTED; }
+
+    c2_status_t releaseTunnel_sm(c2_node_id_t) override { return C2_OMITTED; }
+
+    c2_status_t querySupportedParams_nb(
+            std::vector<std::shared_ptr<C2ParamDescriptor>> * const) const override {
+        return C2_OMITTED;
+    }
+
+    c2_status_t querySupportedValues_vb(
+            std::vector<C2FieldSupportedValuesQuery> &, c2_blocking_t) const override {
+        return C2_OMITTED;
+    }
+
+private:
+    bool isEncoder() const { return mIx % 2 == 0; }
+    bool isAudio() const { return mIx % 4 < 2; }
+
+    const size_t mIx;
+};
+
+class TestComponent : public C2Component {
+public:
+    explicit TestComponent(size_t ix) : mIntf(std::make_shared<TestInterface>(ix)) {}
+
+    c2_status_t setListener_vb(const std::shared_ptr<Listener> &, c2_blocking_t) override {
+        return C2_OK;
+    }
+    c2_status_t queue_nb(std::list<std::unique_ptr<C2Work>>* const) override {
+        return C2_OMITTED;
+    }
+    c2_status_t announce_nb(const std::vector<C2WorkOutline> &) override { return C2_OMITTED; }
+    c2_status_t flush_sm(flush_mode_t, std::list<std::unique_ptr<C2Work>>* const) override {
+        return C2_OMITTED;
+    }
+    c2_status_t drain_nb(drain_mode_t) override { return C2_OMITTED; }
+    c2_status_t start() override { return C2_OK; }
+    c2_status_t stop() override { return C2_OK; }
+    c2_status_t reset() override { return C2_OK; }
+    c2_status_t release() override { return C2_OK; }
+    std::shared_ptr<C2ComponentInterface> intf() override { return mIntf; }
+
+private:
+    const std::shared_ptr<C2ComponentInterface> mIntf;
+};
+
+class TestFactory : public C2ComponentFactory {
+public:
+    explicit TestFactory(size_t ix) : mIx(ix) {}
+
+    c2_status_t createComponent(
+            c2_node_id_t, std::shared_ptr<C2Component>* const component,
+            ComponentDeleter deleter) override {
+        *component = std::shared_ptr<C2Component>(new TestComponent(mIx), deleter);
+        return C2_OK;
+    }
+
+    c2_status_t createInterface(
+            c2_node_id_t, std::shared_ptr<C2ComponentInterface>* const interface,
+            InterfaceDeleter deleter) override {
+        ++gNumInterfaces[mIx];
+        *interface = std::shared_ptr<C2ComponentInterface>(new TestInterface(mIx), deleter);
+        return C2_OK;
+    }
+
+private:
+    const size_t mIx;
+};
+
+template<size_t Ix>
+::C2ComponentFactory *CreateTestFactory() {
+    return new TestFactory(Ix);
+}
+
+void DestroyTestFactory(::C2ComponentFactory *factory) {
+    delete factory;
+}
+
+template<size_t... Ix>
+std::vector<std::tuple<C2String, C2ComponentFactory::CreateCodec2FactoryFunc,
+        C2ComponentFactory::DestroyCodec2FactoryFunc>> TestFactoryFuncs(
+        std::index_sequence<Ix...>) {
+    return { std::make_tuple(ComponentName(Ix), &CreateTestFactory<Ix>, &DestroyTestFactory)... };
+}
+
+}  // namespace
+
+class C2StoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        for (std::atomic_int &numInterfaces : gNumInterfaces) {
+            numInterfaces = 0;
+        }
+        mStore = GetTestComponentStore(
+                TestFactoryFuncs(std::make_index_sequence<kNumComponents>()));
+        ASSERT_NE(nullptr, mStore);
+    }
+
+    std::shared_ptr<C2ComponentStore> mStore;
+};
+
+TEST_F(C2StoreTest, ListComponentsMatchesSerialLoading) {
+    std::vector<std::shared_ptr<const C2Component::Traits>> traitsList =
+        mStore->listComponents();
+    ASSERT_EQ(kNumComponents, traitsList.size());
+
+    // The components are listed in the order of their paths, which sort as their indices.
+    for (size_t ix = 0; ix < kNumComponents; ++ix) {
+        SCOPED_TRACE(ComponentName(ix));
+        EXPECT_EQ(1, gNumInterfaces[ix].load());
+
+        // what loading the module alone fills in
+        C2Component::Traits expected;
+        ASSERT_TRUE(C2InterfaceUtils::FillTraitsFromInterface(
+                &expected, std::make_shared<TestInterface>(ix)));
+        expected.rank = expected.domain == C2Component::DOMAIN_AUDIO ? 8 : 512;
+
+        const std::shared_ptr<const C2Component::Traits> &traits = traitsList[ix];
+        ASSERT_NE(nullptr, traits);
+        EXPECT_EQ(expected.name, traits->name);
+        EXPECT_EQ(expected.domain, traits->domain);
+        EXPECT_EQ(expected.kind, traits->kind);
+        EXPECT_EQ(expected.rank, traits->rank);
+        EXPECT_EQ(expected.mediaType, traits->mediaType);
+        EXPECT_EQ(expected.aliases, traits->aliases);
+    }
+
+    // A second listing and creating components (which reload the modules) keep the traits
+    // instead of querying the interfaces again.
+    EXPECT_EQ(traitsList, mStore->listComponents());
+    for (size_t ix = 0; ix < kNumComponents; ++ix) {
+        std::shared_ptr<C2Component> component;
+        ASSERT_EQ(C2_OK, mStore->createComponent(ComponentName(ix), &component));
+        ASSERT_NE(nullptr, component);
+        EXPECT_EQ(ComponentName(ix), component->intf()->getName());
+        EXPECT_EQ(1, gNumInterfaces[ix].load()) << ComponentName(ix);
+    }
+
+    // Aliases resolve to their component.
+    std::shared_ptr<C2Component> component;
+    ASSERT_EQ(C2_OK, mStore->createComponent("c2.test.alias3", &component));
+    EXPECT_EQ(ComponentName(3), component->intf()->getName());
+    EXPECT_EQ(C2_NOT_FOUND, mStore->createComponent("c2.test.missing", &component));
+}
+
+TEST_F(C2StoreTest, ConcurrentCreateAndList) {
+    constexpr size_t kNumThreads = 8;
+    constexpr size_t kNumIterations = 16;
+
+    std::atomic_int failures{0};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kNumThreads; ++t) {
+        threads.emplace_back([this, t, &failures] {
+            for (size_t i = 0; i < kNumIterations; ++i) {
+                if ((t + i) % 2) {
+                    if (mStore->listComponents().size() != kNumComponents) {
+                        ++failures;
+                    }
+                    continue;
+                }
+                const C2String name = ComponentName((t + i) % kNumComponents);
+                std::shared_ptr<C2Component> component;
+                if (mStore->createComponent(name, &component) != C2_OK
+                        || component == nullptr
+                        || component->intf()->getName() != name) {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(0, failures);
+
+    // However the loads raced, each interface was queried for traits once.
+    for (size_t ix = 0; ix < kNumComponents; ++ix) {
+        EXPECT_EQ(1, gNumInterfaces[ix].load()) << ComponentName(ix);
+    }
+}
+
+}  // namespace android
@@ -547,6 +547,33 @@ std::shared_ptr<C2LinearBlock> _C2BlockFactory::CreateLinearBlock(
     return nullptr;
 };
 
+namespace {
+
+// Linear allocations from buffer pools are rounded up to size classes, so that a
+// buffer can be recycled for a request of a slightly different capacity instead
+// of allocating a new one. Classes are spaced by a quarter of a power of two,
+// which wastes at most 25% of an allocation, from a page up to
+// kMaxLinearSizeClass. Larger allocations are only rounded up to a page.
+constexpr uint32_t kMinLinearSizeClass = 4096;
+constexpr uint32_t kMaxLinearSizeClass = 4 * 1024 * 1024;
+
+uint32_t GetLinearSizeClass(uint32_t capacity) {
+    if (capacity == 0) {
+        return 0;
+    }
+    uint32_t step = kMinLinearSizeClass;
+    if (capacity > kMinLinearSizeClass && capacity <= kMaxLinearSizeClass) {
+        // a quarter of the largest power of two below capacity
+        step = (1u << (31 - __builtin_clz(capacity - 1))) / 4;
+    }
+    if (capacity > UINT32_MAX - (step - 1)) {
+        return capacity;
+    }
+    return (capacity + step - 1) / step * step;
+}
+
+}  // namespace
+
 /**
  * Wrapped C2Allocator which is injected to buffer pool on behalf of
  * C2BlockPool.
@@ -570,7 +597,8 @@ public:
      * Transforms linear allocation parameters for C2Allocator to parameters
      * for buffer pool.
      *
-     * @param capacity      size of linear allocation
+     * @param capacity      size of linear allocation, rounded up to its size
+     *                      class
      * @param usage         memory usage pattern for linear allocation
      * @param params        allocation parameters for buffer pool
      */
@@ -736,7 +764,7 @@ bool _C2BufferPoolAllocator::compatible(
 
 void _C2BufferPoolAllocator::getLinearParams(
         uint32_t capacity, C2MemoryUsage usage, std::vector<uint8_t> *params) {
-    AllocParams c2Params(usage, capacity);
+    AllocParams c2Params(usage, GetLinearSizeClass(capacity));
     params->assign(c2Params.array, c2Params.array + sizeof(AllocParams));
 }
 
@@ -881,7 +909,8 @@ public:
      * Transforms linear allocation parameters for C2Allocator to parameters
      * for buffer pool.
      *
-     * @param capacity      size of linear allocation
+     * @param capacity      size of linear allocation, rounded up to its size
+     *                      class
      * @param usage         memory usage pattern for linear allocation
      * @param params        allocation parameters for buffer pool
      */
@@ -1047,7 +1076,7 @@ bool _C2BufferPoolAllocator2::compatible(
 
 void _C2BufferPoolAllocator2::getLinearParams(
         uint32_t capacity, C2MemoryUsage usage, std::vector<uint8_t> *params) {
-    AllocParams c2Params(usage, capacity);
+    AllocParams c2Params(usage, GetLinearSizeClass(capacity));
     params->assign(c2Params.array, c2Params.array + sizeof(AllocParams));
 }
 
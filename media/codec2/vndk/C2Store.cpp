@@ -38,9 +38,12 @@
 #include <dlfcn.h>
 #include <unistd.h> // getpagesize
 
+#include <algorithm>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <thread>
 
 #ifdef __ANDROID_APEX__
 #include <android-base/properties.h>
@@ -842,6 +845,8 @@ private:
          * \note Only used by ComponentLoader.
          *
          * \param libPath[in] library path
+         * \param traits[in]  traits of the component from a previous load of the module, or
+         *                    nullptr. If set, no interface is created to discover the traits.
          *
          * \retval C2_OK        the component module has been successfully loaded
          * \retval C2_NO_MEMORY not enough memory to loading the component module
@@ -850,13 +855,14 @@ private:
          * \retval C2_REFUSED   permission denied to load the component module (unexpected)
          * \retval C2_TIMED_OUT could not load the module within the time limit (unexpected)
          */
-        c2_status_t init(std::string libPath);
+        c2_status_t init(std::string libPath,
+                         std::shared_ptr<const C2Component::Traits> traits = nullptr);
 
         virtual ~ComponentModule() override;
 
     protected:
         std::recursive_mutex mLock; ///< lock protecting mTraits
-        std::shared_ptr<C2Component::Traits> mTraits; ///< cached component traits
+        std::shared_ptr<const C2Component::Traits> mTraits; ///< cached component traits
 
         c2_status_t mInit; ///< initialization result
 
@@ -876,7 +882,10 @@ private:
          * Load the component module.
          *
          * This method simply returns the component module if it is already currently loaded, or
-         * attempts to load it if it is not.
+         * attempts to load it if it is not. The traits of the module are kept across loads so
+         * that reloading a module does not query its interface again.
+         *
+         * This method may be called concurrently for different loaders.
          *
          * \param module[out] pointer to the shared pointer where the loaded module shall be stored.
          *                    This will be nullptr on error.
@@ -899,9 +908,12 @@ private:
                 } else {
                     localModule = std::make_shared<ComponentModule>();
                 }
-                res = localModule->init(mLibPath);
+                res = localModule->init(mLibPath, mTraits);
                 if (res == C2_OK) {
                     mModule = localModule;
+                    if (!mTraits) {
+                        mTraits = localModule->getTraits();
+                    }
                 }
             }
             *module = localModule;
@@ -925,6 +937,7 @@ private:
     private:
         std::mutex mMutex; ///< mutex guarding the module
         std::weak_ptr<ComponentModule> mModule; ///< weak reference to the loaded module
+        std::shared_ptr<const C2Component::Traits> mTraits; ///< traits of the module, once loaded
         std::string mLibPath; ///< library path
 
         // For testing only
@@ -1034,9 +1047,16 @@ private:
 
     /**
      * Loads each component module and discover its contents.
+     *
+     * Modules are loaded in parallel; the component list keeps the order of mComponents.
      */
     void visitComponents();
 
+    /**
+     * Maximum number of threads loading component modules in visitComponents().
+     */
+    static constexpr size_t kMaxVisitThreads = 4;
+
     std::mutex mMutex; ///< mutex guarding the component lists during construction
     bool mVisited; ///< component modules visited
     std::map<C2String, ComponentLoader> mComponents; ///< path -> component module
@@ -1053,7 +1073,7 @@ private:
 };
 
 c2_status_t C2PlatformComponentStore::ComponentModule::init(
-        std::string libPath) {
+        std::string libPath, std::shared_ptr<const C2Component::Traits> traits) {
     ALOGV("in %s", __func__);
     ALOGV("loading dll");
 
@@ -1081,7 +1101,8 @@ c2_status_t C2PlatformComponentStore::ComponentModule::init(
         mInit = C2_OK;
     }
 
-    if (mInit != C2_OK) {
+    if (mInit != C2_OK || traits) {
+        mTraits = traits;
         return mInit;
     }
 
@@ -1092,23 +1113,23 @@ c2_status_t C2PlatformComponentStore::ComponentModule::init(
         return mInit;
     }
 
-    std::shared_ptr<C2Component::Traits> traits(new (std::nothrow) C2Component::Traits);
-    if (traits) {
-        if (!C2InterfaceUtils::FillTraitsFromInterface(traits.get(), intf)) {
+    std::shared_ptr<C2Component::Traits> newTraits(new (std::nothrow) C2Component::Traits);
+    if (newTraits) {
+        if (!C2InterfaceUtils::FillTraitsFromInterface(newTraits.get(), intf)) {
             ALOGD("Failed to fill traits from interface");
             return mInit;
         }
 
         // TODO: get this properly from the store during emplace
-        switch (traits->domain) {
+        switch (newTraits->domain) {
         case C2Component::DOMAIN_AUDIO:
-            traits->rank = 8;
+            newTraits->rank = 8;
             break;
         default:
-            traits->rank = 512;
+            newTraits->rank = 512;
         }
     }
-    mTraits = traits;
+    mTraits = newTraits;
 
     return mInit;
 }
@@ -1249,18 +1270,42 @@ void C2PlatformComponentStore::visitComponents() {
     if (mVisited) {
         return;
     }
+
+    // Loading a module is dominated by dlopen and interface creation, which are independent
+    // between modules, so load them on a few worker threads. Each loader has its own mutex.
+    std::vector<std::pair<const C2String *, ComponentLoader *>> loaders;
     for (auto &pathAndLoader : mComponents) {
-        const C2String &path = pathAndLoader.first;
-        ComponentLoader &loader = pathAndLoader.second;
-        std::shared_ptr<ComponentModule> module;
-        if (loader.fetchModule(&module) == C2_OK) {
-            std::shared_ptr<const C2Component::Traits> traits = module->getTraits();
-            if (traits) {
-                mComponentList.push_back(traits);
-                mComponentNameToPath.emplace(traits->name, path);
-                for (const C2String &alias : traits->aliases) {
-                    mComponentNameToPath.emplace(alias, path);
-                }
+        loaders.emplace_back(&pathAndLoader.first, &pathAndLoader.second);
+    }
+    std::vector<std::shared_ptr<const C2Component::Traits>> traitsList(loaders.size());
+    std::atomic_size_t next{0};
+    auto loadModules = [&loaders, &traitsList, &next] {
+        for (size_t i = next++; i < loaders.size(); i = next++) {
+            std::shared_ptr<ComponentModule> module;
+            if (loaders[i].second->fetchModule(&module) == C2_OK) {
+                traitsList[i] = module->getTraits();
+            }
+        }
+    };
+    size_t numThreads = std::min<size_t>(
+            { loaders.size(), kMaxVisitThreads, std::thread::hardware_concurrency() });
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < numThreads; ++i) {
+        threads.emplace_back(loadModules);
+    }
+    loadModules();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    for (size_t i = 0; i < loaders.size(); ++i) {
+        const std::shared_ptr<const C2Component::Traits> &traits = traitsList[i];
+        if (traits) {
+            const C2String &path = *loaders[i].first;
+            mComponentList.push_back(traits);
+            mComponentNameToPath.emplace(traits->name, path);
+            for (const C2String &alias : traits->aliases) {
+                mComponentNameToPath.emplace(alias, path);
             }
         }
     }
@@ -33,6 +33,7 @@
 #include <media/PolicyAidlConversion.h>
 #include <media/TypeConverter.h>
 #include <math.h>
+#include <thread>
 
 #include <system/audio.h>
 #include <android/media/GetInputForAttrResponse.h>
@@ -106,6 +107,7 @@ public:
         }
         if (mClient == nullptr) {
             mClient = sp<Client>::make();
+            mUnlockedClient.store(mClient.get(), std::memory_order_release);
         } else {
             reportNoError = true;
         }
@@ -169,6 +171,12 @@ public:
         return mClient;
     }
 
+    // Returns the client if it has been created, without taking mMutex nor connecting to the
+    // service. The client is never released once created, the pointer remains valid.
+    Client* getClientUnlocked() const {
+        return mUnlockedClient.load(std::memory_order_acquire);
+    }
+
     void setBinder(const sp<IBinder>& binder) EXCLUDES(mMutex)  {
         std::lock_guard _l(mMutex);
         if (mService != nullptr) {
@@ -198,6 +206,7 @@ private:
     sp<ServiceInterface> mLocalService GUARDED_BY(mMutex);
     sp<ServiceInterface> mService GUARDED_BY(mMutex);
     sp<Client> mClient GUARDED_BY(mMutex);
+    std::atomic<Client*> mUnlockedClient = nullptr;  // mClient, for getClientUnlocked()
     std::atomic<bool> mCanStartThreadPool = true;
 };
 
@@ -247,6 +256,11 @@ status_t AudioSystem::setLocalAudioFlinger(const sp<IAudioFlinger>& af) {
 }
 
 sp<AudioIoDescriptor> AudioSystem::getIoDescriptor(audio_io_handle_t ioHandle) {
+    // Once connected, the descriptor table is read without taking any lock.
+    if (AudioFlingerClient* afc = gAudioFlingerServiceHandler.getClientUnlocked();
+            afc != nullptr) {
+        return afc->getIoDescriptor(ioHandle);
+    }
     sp<AudioIoDescriptor> desc;
     const sp<AudioFlingerClient> afc = getAudioFlingerClient();
     if (afc != 0) {
@@ -439,10 +453,10 @@ AudioSystem::getOutputSamplingRate(uint32_t* samplingRate, audio_stream_type_t s
 
 status_t AudioSystem::getSamplingRate(audio_io_handle_t ioHandle,
                                       uint32_t* samplingRate) {
-    const sp<IAudioFlinger> af = get_audio_flinger();
-    if (af == 0) return PERMISSION_DENIED;
     sp<AudioIoDescriptor> desc = getIoDescriptor(ioHandle);
     if (desc == 0) {
+        const sp<IAudioFlinger> af = get_audio_flinger();
+        if (af == 0) return PERMISSION_DENIED;
         *samplingRate = af->sampleRate(ioHandle);
     } else {
         *samplingRate = desc->getSamplingRate();
@@ -474,10 +488,10 @@ status_t AudioSystem::getOutputFrameCount(size_t* frameCount, audio_stream_type_
 
 status_t AudioSystem::getFrameCount(audio_io_handle_t ioHandle,
                                     size_t* frameCount) {
-    const sp<IAudioFlinger> af = get_audio_flinger();
-    if (af == 0) return PERMISSION_DENIED;
     sp<AudioIoDescriptor> desc = getIoDescriptor(ioHandle);
     if (desc == 0) {
+        const sp<IAudioFlinger> af = get_audio_flinger();
+        if (af == 0) return PERMISSION_DENIED;
         *frameCount = af->frameCount(ioHandle);
     } else {
         *frameCount = desc->getFrameCount();
@@ -509,10 +523,10 @@ status_t AudioSystem::getOutputLatency(uint32_t* latency, audio_stream_type_t st
 
 status_t AudioSystem::getLatency(audio_io_handle_t output,
                                  uint32_t* latency) {
-    const sp<IAudioFlinger> af = get_audio_flinger();
-    if (af == 0) return PERMISSION_DENIED;
     sp<AudioIoDescriptor> outputDesc = getIoDescriptor(output);
     if (outputDesc == 0) {
+        const sp<IAudioFlinger> af = get_audio_flinger();
+        if (af == 0) return PERMISSION_DENIED;
         *latency = af->latency(output);
     } else {
         *latency = outputDesc->getLatency();
@@ -597,10 +611,10 @@ status_t AudioSystem::audioPolicyReady() {
 
 status_t AudioSystem::getFrameCountHAL(audio_io_handle_t ioHandle,
                                        size_t* frameCount) {
-    const sp<IAudioFlinger> af = get_audio_flinger();
-    if (af == 0) return PERMISSION_DENIED;
     sp<AudioIoDescriptor> desc = getIoDescriptor(ioHandle);
     if (desc == 0) {
+        const sp<IAudioFlinger> af = get_audio_flinger();
+        if (af == 0) return PERMISSION_DENIED;
         *frameCount = af->frameCountHAL(ioHandle);
     } else {
         *frameCount = desc->getFrameCountHAL();
@@ -621,6 +635,7 @@ status_t AudioSystem::getFrameCountHAL(audio_io_handle_t ioHandle,
 void AudioSystem::AudioFlingerClient::clearIoCache() {
     std::lock_guard _l(mMutex);
     mIoDescriptors.clear();
+    publishIoDescriptors_l();
     mInBuffSize = 0;
     mInSamplingRate = 0;
     mInFormat = AUDIO_FORMAT_DEFAULT;
@@ -662,6 +677,7 @@ Status AudioSystem::AudioFlingerClient::ioConfigChanged(
                     deviceId = oldDesc->getDeviceId();
                 }
                 mIoDescriptors[ioDesc->getIoHandle()] = ioDesc;
+                publishIoDescriptors_l();
 
                 if (ioDesc->getDeviceId() != AUDIO_PORT_HANDLE_NONE) {
                     deviceId = ioDesc->getDeviceId();
@@ -691,6 +707,7 @@ Status AudioSystem::AudioFlingerClient::ioConfigChanged(
                       event == AUDIO_OUTPUT_CLOSED ? "output" : "input", ioDesc->getIoHandle());
 
                 mIoDescriptors.erase(ioDesc->getIoHandle());
+                publishIoDescriptors_l();
                 mAudioDeviceCallbacks.erase(ioDesc->getIoHandle());
             }
                 break;
@@ -707,6 +724,7 @@ Status AudioSystem::AudioFlingerClient::ioConfigChanged(
 
                 deviceId = oldDesc->getDeviceId();
                 mIoDescriptors[ioDesc->getIoHandle()] = ioDesc;
+                publishIoDescriptors_l();
 
                 if (deviceId != ioDesc->getDeviceId()) {
                     deviceId = ioDesc->getDeviceId();
@@ -826,9 +844,35 @@ AudioSystem::AudioFlingerClient::getIoDescriptor_l(audio_io_handle_t ioHandle) {
     return {};
 }
 
+void AudioSystem::AudioFlingerClient::publishIoDescriptors_l() {
+    const int next = 1 - mIoDescriptorsIndex.load(std::memory_order_relaxed);
+    // Readers which selected 'next' before the previous update may still be using it.
+    // They only perform a lookup, and updates are rare, so just yield until they are done.
+    while (mIoDescriptorsReaders[next].load() != 0) {
+        std::this_thread::yield();
+    }
+    mIoDescriptorsCopies[next] = mIoDescriptors;
+    mIoDescriptorsIndex.store(next);
+}
+
 sp<AudioIoDescriptor> AudioSystem::AudioFlingerClient::getIoDescriptor(audio_io_handle_t ioHandle) {
-    std::lock_guard _l(mMutex);
-    return getIoDescriptor_l(ioHandle);
+    // The sequentially consistent accesses below guarantee that a reader which still sees
+    // 'index' selected after registering itself is accounted for by the next update.
+    for (;;) {
+        const int index = mIoDescriptorsIndex.load();
+        mIoDescriptorsReaders[index].fetch_add(1);
+        if (mIoDescriptorsIndex.load() == index) {
+            sp<AudioIoDescriptor> desc;
+            const IoDescriptors& descriptors = mIoDescriptorsCopies[index];
+            if (const auto it = descriptors.find(ioHandle); it != descriptors.end()) {
+                desc = it->second;
+            }
+            mIoDescriptorsReaders[index].fetch_sub(1);
+            return desc;
+        }
+        // An update selected the other copy in the meantime, retry with it.
+        mIoDescriptorsReaders[index].fetch_sub(1);
+    }
 }
 
 status_t AudioSystem::AudioFlingerClient::addAudioDeviceCallback(
@@ -928,6 +928,11 @@ status_t AudioFlingerClientAdapter::resetReferencesForTest() {
     return OK;
 }
 
+status_t AudioFlingerClientAdapter::setStreamVolumes(
+        const std::vector<media::StreamVolumeInfo>& volumes) {
+    return statusTFromBinderStatus(mDelegate->setStreamVolumes(volumes));
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // AudioFlingerServerAdapter
 AudioFlingerServerAdapter::AudioFlingerServerAdapter(
@@ -1497,4 +1502,9 @@ Status AudioFlingerServerAdapter::resetReferencesForTest() {
     return Status::ok();
 }
 
+Status AudioFlingerServerAdapter::setStreamVolumes(
+        const std::vector<media::StreamVolumeInfo>& volumes) {
+    return Status::fromStatusT(mDelegate->setStreamVolumes(volumes));
+}
+
 } // namespace android
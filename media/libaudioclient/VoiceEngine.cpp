@@ -0,0 +1,420 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "VoiceEngine"
+
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string_view>
+
+#include <audio_utils/primitives.h>
+#include <media/VoiceEngine.h>
+#include <utils/Log.h>
+
+namespace android {
+
+namespace {
+
+constexpr float kMinRate = 0.125f;
+constexpr float kMaxRate = 8.0f;
+// The track is stopped after this much silence, and restarted by the next play().
+constexpr uint32_t kIdleStopMs = 1000;
+
+bool isSupportedFormat(audio_format_t format) {
+    switch (format) {
+    case AUDIO_FORMAT_PCM_8_BIT:
+    case AUDIO_FORMAT_PCM_16_BIT:
+    case AUDIO_FORMAT_PCM_24_BIT_PACKED:
+    case AUDIO_FORMAT_PCM_8_24_BIT:
+    case AUDIO_FORMAT_PCM_32_BIT:
+    case AUDIO_FORMAT_PCM_FLOAT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+}  // namespace
+
+VoiceSample::VoiceSample(float* data, size_t mappedSize, size_t frameCount,
+                         uint32_t channelCount, uint32_t sampleRate)
+    : mData(data),
+      mMappedSize(mappedSize),
+      mFrameCount(frameCount),
+      mChannelCount(channelCount),
+      mSampleRate(sampleRate)
+{
+}
+
+VoiceSample::~VoiceSample()
+{
+    munmap(mData, mMappedSize);
+}
+
+// static
+VoiceSampleCache& VoiceSampleCache::getInstance()
+{
+    static VoiceSampleCache cache;
+    return cache;
+}
+
+std::shared_ptr<const VoiceSample> VoiceSampleCache::load(const void* data, size_t frameCount,
+        audio_format_t format, audio_channel_mask_t channelMask, uint32_t sampleRate)
+{
+    const uint32_t channelCount = audio_channel_count_from_out_mask(channelMask);
+    if (data == nullptr || frameCount == 0 || sampleRate == 0 || !isSupportedFormat(format)
+            || (channelCount != 1 && channelCount != 2)) {
+        ALOGE("%s invalid sample: frames %zu format %#x channel mask %#x rate %u",
+                __func__, frameCount, format, channelMask, sampleRate);
+        return nullptr;
+    }
+    const size_t sampleCount = frameCount * channelCount;
+    const size_t size = sampleCount * sizeof(float);
+    void* const mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1 /* fd */, 0 /* offset */);
+    if (mapped == MAP_FAILED) {
+        ALOGE("%s cannot map %zu bytes", __func__, size);
+        return nullptr;
+    }
+    float* const samples = static_cast<float*>(mapped);
+    memcpy_by_audio_format(samples, AUDIO_FORMAT_PCM_FLOAT, data, format, sampleCount);
+    mprotect(mapped, size, PROT_READ);
+
+    // Deduplicate on the converted data so that the same sound decoded to different
+    // formats is only kept once.
+    const size_t hash = std::hash<std::string_view>{}(
+            std::string_view(static_cast<const char*>(mapped), size)) ^ sampleRate ^ channelCount;
+
+    std::lock_guard _l(mLock);
+    auto [first, last] = mSamples.equal_range(hash);
+    for (auto it = first; it != last; ++it) {
+        std::shared_ptr<const VoiceSample> sample = it->second.lock();
+        if (sample != nullptr && sample->frameCount() == frameCount
+                && sample->channelCount() == channelCount && sample->sampleRate() == sampleRate
+                && memcmp(sample->data(), samples, size) == 0) {
+            munmap(mapped, size);
+            ALOGV("%s reusing sample %p", __func__, sample.get());
+            return sample;
+        }
+    }
+    // drop entries of released samples
+    for (auto it = mSamples.begin(); it != mSamples.end(); ) {
+        it = it->second.expired() ? mSamples.erase(it) : std::next(it);
+    }
+    std::shared_ptr<const VoiceSample> sample(
+            new VoiceSample(samples, size, frameCount, channelCount, sampleRate));
+    mSamples.emplace(hash, sample);
+    return sample;
+}
+
+size_t VoiceSampleCache::size()
+{
+    std::lock_guard _l(mLock);
+    return std::count_if(mSamples.begin(), mSamples.end(),
+                         [](const auto& entry) { return !entry.second.expired(); });
+}
+
+VoiceEngine::VoiceEngine(const content::AttributionSourceState& attributionSource,
+                         const audio_attributes_t& attributes, size_t maxVoices)
+    : mAttributionSource(attributionSource),
+      mAttributes(attributes),
+      mMaxVoices(std::max<size_t>(1, maxVoices)),
+      mMixer(sp<Mixer>::make(mMaxVoices))
+{
+}
+
+void VoiceEngine::onFirstRef()
+{
+    mTrack = sp<AudioTrack>::make(mAttributionSource);
+    audio_attributes_t attributes = mAttributes;
+    attributes.flags = static_cast<audio_flags_mask_t>(attributes.flags | AUDIO_FLAG_LOW_LATENCY);
+    mStatus = mTrack->set(
+            AUDIO_STREAM_DEFAULT,
+            0,    // sampleRate
+            AUDIO_FORMAT_PCM_FLOAT,
+            AUDIO_CHANNEL_OUT_STEREO,
+            0,    // frameCount
+            AUDIO_OUTPUT_FLAG_FAST,
+            mMixer,
+            0,    // notificationFrames
+            nullptr,    // sharedBuffer
+            false,    // threadCanCallJava
+            AUDIO_SESSION_ALLOCATE,
+            AudioTrack::TRANSFER_CALLBACK,
+            nullptr,    // offloadInfo
+            mAttributionSource,
+            &attributes);
+    mTrack->setCallerName("voiceengine");
+    if (mStatus != NO_ERROR) {
+        ALOGE("%s AudioTrack set failed with error %d", __func__, mStatus);
+        mTrack.clear();
+        return;
+    }
+    mMixer->sampleRate = mTrack->getSampleRate();
+    ALOGW_IF((mTrack->getFlags() & AUDIO_OUTPUT_FLAG_FAST) == 0,
+             "%s fast track denied, latency will be higher", __func__);
+    mTrackControlThread = std::thread(&VoiceEngine::trackControlLoop, this);
+}
+
+VoiceEngine::~VoiceEngine()
+{
+    if (mTrackControlThread.joinable()) {
+        {
+            std::lock_guard _l(mMixer->lock);
+            mMixer->exitPending = true;
+        }
+        mMixer->condition.notify_all();
+        mTrackControlThread.join();
+    }
+    if (mTrack != nullptr) {
+        mTrack->stop();
+        mTrack.clear();
+    }
+}
+
+void VoiceEngine::trackControlLoop()
+{
+    pthread_setname_np(pthread_self(), "VoiceEngineCtl");
+    for (;;) {
+        {
+            std::unique_lock l(mMixer->lock);
+            mMixer->condition.wait(l, [this]() REQUIRES(mMixer->lock) {
+                return mMixer->stopRequested || mMixer->exitPending;
+            });
+            if (mMixer->exitPending) {
+                return;
+            }
+        }
+        std::lock_guard control(mTrackControlLock);
+        {
+            std::lock_guard _l(mMixer->lock);
+            if (!mMixer->stopRequested) {
+                continue;  // cancelled by play()
+            }
+            mMixer->stopRequested = false;
+        }
+        ALOGV("%s idle, stopping track", __func__);
+        mTrack->stop();
+        mTrackActive = false;
+    }
+}
+
+double VoiceEngine::stepForRate(const VoiceSample& sample, float rate) const
+{
+    return static_cast<double>(std::clamp(rate, kMinRate, kMaxRate)) * sample.sampleRate()
+            / mMixer->sampleRate;
+}
+
+VoiceEngine::Voice* VoiceEngine::Mixer::findVoice_l(int32_t voiceId)
+{
+    auto it = std::find_if(voices.begin(), voices.end(),
+                           [voiceId](const Voice& voice) { return voice.id == voiceId; });
+    return it == voices.end() ? nullptr : &*it;
+}
+
+int32_t VoiceEngine::play(const std::shared_ptr<const VoiceSample>& sample, float leftVolume,
+                          float rightVolume, float rate, int32_t loop, int32_t priority)
+{
+    if (mStatus != NO_ERROR) {
+        return mStatus;
+    }
+    if (sample == nullptr || loop < -1) {
+        return BAD_VALUE;
+    }
+    std::lock_guard control(mTrackControlLock);
+    int32_t voiceId;
+    {
+        std::lock_guard _l(mMixer->lock);
+        auto& voices = mMixer->voices;
+        if (voices.size() >= mMaxVoices) {
+            // voices are kept in start order, the first candidate found is the oldest
+            auto victim = voices.end();
+            for (auto it = voices.begin(); it != voices.end(); ++it) {
+                if (it->priority <= priority
+                        && (victim == voices.end() || it->priority < victim->priority)) {
+                    victim = it;
+                }
+            }
+            if (victim == voices.end()) {
+                ALOGV("%s no voice available for priority %d", __func__, priority);
+                return INVALID_OPERATION;
+            }
+            ALOGV("%s stealing voice %d", __func__, victim->id);
+            voices.erase(victim);
+        }
+        voiceId = mMixer->nextVoiceId;
+        mMixer->nextVoiceId = voiceId == INT32_MAX ? 1 : voiceId + 1;
+        voices.push_back(Voice{
+                .id = voiceId,
+                .priority = priority,
+                .sample = sample,
+                .position = 0.,
+                .step = stepForRate(*sample, rate),
+                .leftVolume = leftVolume,
+                .rightVolume = rightVolume,
+                .loop = loop,
+        });
+        mMixer->trackStarted = true;
+        mMixer->stopRequested = false;
+        mMixer->idleFrames = 0;
+    }
+    // Start the track without holding the mixer lock, the callback thread would be blocked
+    // for the duration of the binder call.
+    if (!mTrackActive) {
+        if (const status_t status = mTrack->start(); status != NO_ERROR) {
+            ALOGE("%s AudioTrack start failed with error %d", __func__, status);
+            std::lock_guard _l(mMixer->lock);
+            auto& voices = mMixer->voices;
+            voices.erase(std::remove_if(voices.begin(), voices.end(),
+                    [voiceId](const Voice& voice) { return voice.id == voiceId; }),
+                    voices.end());
+            mMixer->trackStarted = false;
+            return status;
+        }
+        mTrackActive = true;
+    }
+    return voiceId;
+}
+
+void VoiceEngine::stop(int32_t voiceId)
+{
+    {
+        std::lock_guard _l(mMixer->lock);
+        auto& voices = mMixer->voices;
+        voices.erase(std::remove_if(voices.begin(), voices.end(),
+                [voiceId](const Voice& voice) { return voice.id == voiceId; }),
+                voices.end());
+    }
+    mMixer->condition.notify_all();
+}
+
+void VoiceEngine::stopAll()
+{
+    {
+        std::lock_guard _l(mMixer->lock);
+        mMixer->voices.clear();
+    }
+    mMixer->condition.notify_all();
+}
+
+status_t VoiceEngine::setVolume(int32_t voiceId, float leftVolume, float rightVolume)
+{
+    std::lock_guard _l(mMixer->lock);
+    Voice* const voice = mMixer->findVoice_l(voiceId);
+    if (voice == nullptr) {
+        return BAD_VALUE;
+    }
+    voice->leftVolume = leftVolume;
+    voice->rightVolume = rightVolume;
+    return NO_ERROR;
+}
+
+status_t VoiceEngine::setRate(int32_t voiceId, float rate)
+{
+    std::lock_guard _l(mMixer->lock);
+    Voice* const voice = mMixer->findVoice_l(voiceId);
+    if (voice == nullptr) {
+        return BAD_VALUE;
+    }
+    voice->step = stepForRate(*voice->sample, rate);
+    return NO_ERROR;
+}
+
+size_t VoiceEngine::activeVoices()
+{
+    std::lock_guard _l(mMixer->lock);
+    return mMixer->voices.size();
+}
+
+bool VoiceEngine::waitForActiveVoices(size_t count, std::chrono::milliseconds timeout)
+{
+    std::unique_lock l(mMixer->lock);
+    return mMixer->condition.wait_for(l, timeout, [this, count]() REQUIRES(mMixer->lock) {
+        return mMixer->voices.size() <= count;
+    });
+}
+
+// static
+bool VoiceEngine::mixVoice(Voice& voice, float* out, size_t frameCount)
+{
+    const VoiceSample& sample = *voice.sample;
+    const float* const data = sample.data();
+    const size_t sampleFrames = sample.frameCount();
+    const size_t right = sample.channelCount() - 1;  // mono samples are panned
+    for (size_t i = 0; i < frameCount; ++i) {
+        if (voice.position >= sampleFrames) {
+            if (voice.loop == 0) {
+                return false;
+            }
+            voice.position = std::fmod(voice.position, static_cast<double>(sampleFrames));
+            if (voice.loop > 0) {
+                --voice.loop;
+            }
+        }
+        // linear interpolation, wrapping to the start when looping
+        const size_t index = static_cast<size_t>(voice.position);
+        const size_t next = index + 1 < sampleFrames ? index + 1 : (voice.loop != 0 ? 0 : index);
+        const float fraction = static_cast<float>(voice.position - index);
+        const float* const current = data + index * sample.channelCount();
+        const float* const following = data + next * sample.channelCount();
+        out[2 * i] += (current[0] + fraction * (following[0] - current[0])) * voice.leftVolume;
+        out[2 * i + 1] += (current[right] + fraction * (following[right] - current[right]))
+                * voice.rightVolume;
+        voice.position += voice.step;
+    }
+    return voice.position < sampleFrames || voice.loop != 0;
+}
+
+size_t VoiceEngine::Mixer::onMoreData(const AudioTrack::Buffer& buffer)
+{
+    if (buffer.size() == 0) {
+        return 0;
+    }
+    const size_t frameSize = 2 * sizeof(float);
+    const size_t frameCount = buffer.size() / frameSize;
+    float* const out = reinterpret_cast<float*>(buffer.data());
+    memset(out, 0, frameCount * frameSize);
+
+    std::lock_guard _l(lock);
+    const size_t previousCount = voices.size();
+    for (auto it = voices.begin(); it != voices.end(); ) {
+        it = mixVoice(*it, out, frameCount) ? std::next(it) : voices.erase(it);
+    }
+    bool notify = voices.size() < previousCount;
+    if (!voices.empty()) {
+        idleFrames = 0;
+    } else if (trackStarted) {
+        idleFrames += frameCount;
+        if (idleFrames >= static_cast<size_t>(sampleRate) * kIdleStopMs / 1000) {
+            // The track can not be stopped from its own callback thread, and stopping it
+            // involves a binder call: leave it to the track control thread.
+            trackStarted = false;
+            stopRequested = true;
+            idleFrames = 0;
+            notify = true;
+        }
+    }
+    if (notify) {
+        condition.notify_all();
+    }
+    return frameCount * frameSize;
+}
+
+}  // namespace android
@@ -19,6 +19,8 @@
 
 #include <sys/types.h>
 
+#include <atomic>
+#include <map>
 #include <mutex>
 #include <set>
 #include <vector>
@@ -836,8 +838,17 @@ public:
         audio_port_handle_t getDeviceIdForIo(audio_io_handle_t audioIo) EXCLUDES(mMutex);
 
     private:
+        using IoDescriptors = std::map<audio_io_handle_t, sp<AudioIoDescriptor>>;
+
         mutable std::mutex mMutex;
-        std::map<audio_io_handle_t, sp<AudioIoDescriptor>> mIoDescriptors GUARDED_BY(mMutex);
+        IoDescriptors mIoDescriptors GUARDED_BY(mMutex);
+        // Copies of mIoDescriptors read by getIoDescriptor() without taking mMutex
+        // (left-right scheme). Readers use the copy selected by mIoDescriptorsIndex and are
+        // counted in mIoDescriptorsReaders while they access it. An update waits for the
+        // readers of the other copy to be done, rewrites it and selects it.
+        IoDescriptors mIoDescriptorsCopies[2];
+        std::atomic<int> mIoDescriptorsIndex{0};
+        std::atomic<int> mIoDescriptorsReaders[2]{};
 
         std::map<audio_io_handle_t, std::map<audio_port_handle_t, wp<AudioDeviceCallback>>>
                 mAudioDeviceCallbacks GUARDED_BY(mMutex);
@@ -852,6 +863,7 @@ public:
         audio_channel_mask_t mInChannelMask GUARDED_BY(mMutex) = AUDIO_CHANNEL_NONE;
 
         sp<AudioIoDescriptor> getIoDescriptor_l(audio_io_handle_t ioHandle) REQUIRES(mMutex);
+        void publishIoDescriptors_l() REQUIRES(mMutex);
     };
 
     class AudioPolicyServiceClient: public IBinder::DeathRecipient,
@@ -60,6 +60,7 @@
 #include "android/media/OpenInputResponse.h"
 #include "android/media/OpenOutputRequest.h"
 #include "android/media/OpenOutputResponse.h"
+#include "android/media/StreamVolumeInfo.h"
 #include "android/media/TrackInternalMuteInfo.h"
 #include "android/media/TrackSecondaryOutputInfo.h"
 
@@ -394,6 +395,9 @@ public:
             const std::vector<media::TrackInternalMuteInfo>& tracksInternalMute) = 0;
 
     virtual status_t resetReferencesForTest() = 0;
+
+    // set the volume of several streams and outputs in one transaction
+    virtual status_t setStreamVolumes(const std::vector<media::StreamVolumeInfo>& volumes) = 0;
 };
 
 /**
@@ -513,6 +517,7 @@ public:
     status_t setTracksInternalMute(
             const std::vector<media::TrackInternalMuteInfo>& tracksInternalMute) override;
     status_t resetReferencesForTest() override;
+    status_t setStreamVolumes(const std::vector<media::StreamVolumeInfo>& volumes) override;
 
 private:
     const sp<media::IAudioFlingerService> mDelegate;
@@ -618,6 +623,7 @@ public:
             SET_TRACKS_INTERNAL_MUTE = media::BnAudioFlingerService::TRANSACTION_setTracksInternalMute,
             RESET_REFERENCES_FOR_TEST =
                     media::BnAudioFlingerService::TRANSACTION_resetReferencesForTest,
+            SET_STREAM_VOLUMES = media::BnAudioFlingerService::TRANSACTION_setStreamVolumes,
         };
 
     protected:
@@ -757,6 +763,7 @@ public:
     Status setTracksInternalMute(
             const std::vector<media::TrackInternalMuteInfo>& tracksInternalMute) override;
     Status resetReferencesForTest() override;
+    Status setStreamVolumes(const std::vector<media::StreamVolumeInfo>& volumes) override;
 private:
     const sp<AudioFlingerServerAdapter::Delegate> mDelegate;
 };
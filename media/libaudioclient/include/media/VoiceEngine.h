@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_VOICE_ENGINE_H
+#define ANDROID_VOICE_ENGINE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <android-base/thread_annotations.h>
+#include <media/AudioTrack.h>
+#include <system/audio.h>
+#include <utils/RefBase.h>
+
+namespace android {
+
+/**
+ * Immutable block of PCM samples ready to be mixed by a VoiceEngine.
+ *
+ * Samples are stored as interleaved float in a read-only anonymous mapping, with one or two
+ * channels at the sample rate of the source.
+ */
+class VoiceSample {
+public:
+    ~VoiceSample();
+
+    const float* data() const { return mData; }
+    size_t frameCount() const { return mFrameCount; }
+    uint32_t channelCount() const { return mChannelCount; }
+    uint32_t sampleRate() const { return mSampleRate; }
+
+private:
+    friend class VoiceSampleCache;
+
+    VoiceSample(float* data, size_t mappedSize, size_t frameCount, uint32_t channelCount,
+                uint32_t sampleRate);
+
+    float* const mData;
+    const size_t mMappedSize;
+    const size_t mFrameCount;
+    const uint32_t mChannelCount;
+    const uint32_t mSampleRate;
+};
+
+/**
+ * Process wide cache of decoded samples.
+ *
+ * Samples are deduplicated by content: loading the same PCM data twice returns the same
+ * VoiceSample. The cache only holds weak references, a sample is unmapped once the last
+ * user releases it.
+ */
+class VoiceSampleCache {
+public:
+    static VoiceSampleCache& getInstance();
+
+    // Converts frameCount frames of PCM data to the internal representation, or returns the
+    // cached sample with the same content. Only mono and stereo linear PCM are supported.
+    // Returns nullptr on error.
+    std::shared_ptr<const VoiceSample> load(const void* data, size_t frameCount,
+                                            audio_format_t format,
+                                            audio_channel_mask_t channelMask,
+                                            uint32_t sampleRate);
+
+    // Number of samples currently alive.
+    size_t size();
+
+private:
+    VoiceSampleCache() = default;
+
+    std::mutex mLock;
+    // keyed by a hash of the converted data
+    std::unordered_multimap<size_t, std::weak_ptr<const VoiceSample>> mSamples GUARDED_BY(mLock);
+};
+
+/**
+ * Low latency player for short sounds.
+ *
+ * All voices are mixed on the callback thread of a single fast AudioTrack, so triggering a
+ * sound neither creates a track nor decodes data. Each voice has its own volume per channel
+ * and playback rate.
+ */
+class VoiceEngine : public RefBase {
+public:
+    static constexpr size_t kDefaultMaxVoices = 32;
+
+    VoiceEngine(const content::AttributionSourceState& attributionSource,
+                const audio_attributes_t& attributes, size_t maxVoices = kDefaultMaxVoices);
+    ~VoiceEngine() override;
+
+    void onFirstRef() override;
+
+    status_t initCheck() const { return mStatus; }
+
+    // Starts playing sample and returns the ID of the new voice, or a negative status.
+    // loop is the number of times the sample is repeated after the first play, -1 for
+    // infinite. When all voices are in use, the oldest voice with the lowest priority not
+    // above priority is stolen.
+    int32_t play(const std::shared_ptr<const VoiceSample>& sample, float leftVolume,
+                 float rightVolume, float rate = 1.0f, int32_t loop = 0, int32_t priority = 0);
+
+    void stop(int32_t voiceId);
+    void stopAll();
+    status_t setVolume(int32_t voiceId, float leftVolume, float rightVolume);
+    // Rate relative to the natural pitch of the sample, in [0.125, 8].
+    status_t setRate(int32_t voiceId, float rate);
+
+    size_t activeVoices();
+    // Waits until at most count voices are active. Returns false on timeout.
+    bool waitForActiveVoices(size_t count, std::chrono::milliseconds timeout);
+
+private:
+    struct Voice {
+        int32_t id;
+        int32_t priority;
+        std::shared_ptr<const VoiceSample> sample;
+        double position;      // in frames of the sample
+        double step;          // sample frames per output frame
+        float leftVolume;
+        float rightVolume;
+        int32_t loop;
+    };
+
+    // State shared with the callback thread of the track. The track only holds a weak
+    // reference to the mixer, so the callback thread never drops the last reference to the
+    // engine, which stops and destroys the track.
+    struct Mixer : public AudioTrack::IAudioTrackCallback {
+        explicit Mixer(size_t maxVoices) { voices.reserve(maxVoices); }
+
+        size_t onMoreData(const AudioTrack::Buffer& buffer) override;
+
+        Voice* findVoice_l(int32_t voiceId) REQUIRES(lock);
+
+        uint32_t sampleRate = 0;  // of the track, set before it is started
+        std::mutex lock;
+        // signaled when voices end and when the track must be stopped
+        std::condition_variable condition;
+        std::vector<Voice> voices GUARDED_BY(lock);
+        int32_t nextVoiceId GUARDED_BY(lock) = 1;
+        // the track is active or about to be started
+        bool trackStarted GUARDED_BY(lock) = false;
+        // the track has been idle for too long, stopped by the track control thread
+        bool stopRequested GUARDED_BY(lock) = false;
+        bool exitPending GUARDED_BY(lock) = false;
+        size_t idleFrames GUARDED_BY(lock) = 0;
+    };
+
+    double stepForRate(const VoiceSample& sample, float rate) const;
+    // Mixes frameCount stereo frames of voice into out. Returns false when the voice ended.
+    static bool mixVoice(Voice& voice, float* out, size_t frameCount);
+    // Stops the track when the mixer requests it, outside of the callback thread.
+    void trackControlLoop();
+
+    const content::AttributionSourceState mAttributionSource;
+    const audio_attributes_t mAttributes;
+    const size_t mMaxVoices;
+    const sp<Mixer> mMixer;
+    status_t mStatus = NO_INIT;
+    sp<AudioTrack> mTrack;
+
+    // Serializes start and stop of the track, acquired before mMixer->lock.
+    // Never held by the callback thread.
+    std::mutex mTrackControlLock;
+    bool mTrackActive GUARDED_BY(mTrackControlLock) = false;
+    std::thread mTrackControlThread;
+};
+
+}  // namespace android
+
+#endif  // ANDROID_VOICE_ENGINE_H
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "AudioSystemBenchmark"
+
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+#include <binder/Binder.h>
+#include <binder/ProcessState.h>
+#include <media/AidlConversion.h>
+#include <media/AudioSystem.h>
+#include <media/AudioTrack.h>
+
+using namespace android;
+using android::content::AttributionSourceState;
+
+namespace {
+
+AttributionSourceState makeAttributionSource() {
+    AttributionSourceState attributionSource;
+    attributionSource.packageName = "AudioSystemBenchmark";
+    attributionSource.uid = VALUE_OR_FATAL(legacy2aidl_uid_t_int32_t(getuid()));
+    attributionSource.pid = VALUE_OR_FATAL(legacy2aidl_pid_t_int32_t(getpid()));
+    attributionSource.token = sp<BBinder>::make();
+    return attributionSource;
+}
+
+sp<AudioTrack> createTrack() {
+    const AttributionSourceState attributionSource = makeAttributionSource();
+    sp<AudioTrack> track = sp<AudioTrack>::make(attributionSource);
+    track->set(AUDIO_STREAM_MUSIC, 48000 /* sampleRate */, AUDIO_FORMAT_PCM_16_BIT,
+               AUDIO_CHANNEL_OUT_STEREO, 0 /* frameCount */, AUDIO_OUTPUT_FLAG_NONE,
+               nullptr /* callback */, 0 /* notificationFrames */, nullptr /* sharedBuffer */,
+               false /* canCallJava */, AUDIO_SESSION_ALLOCATE, AudioTrack::TRANSFER_OBTAIN,
+               nullptr /* offloadInfo */, attributionSource);
+    return track->initCheck() == NO_ERROR ? track : nullptr;
+}
+
+}  // namespace
+
+// Getters served from the client side I/O descriptor cache.
+static void BM_OutputDescriptorGetters(benchmark::State& state) {
+    static sp<AudioTrack> track = createTrack();
+    if (track == nullptr) {
+        state.SkipWithError("cannot create AudioTrack");
+        return;
+    }
+    const audio_io_handle_t output = track->getOutput();
+    for (auto _ : state) {
+        uint32_t samplingRate = 0, latency = 0;
+        size_t frameCount = 0;
+        AudioSystem::getSamplingRate(output, &samplingRate);
+        AudioSystem::getFrameCount(output, &frameCount);
+        AudioSystem::getLatency(output, &latency);
+        benchmark::DoNotOptimize(samplingRate + latency + frameCount);
+    }
+    state.SetItemsProcessed(state.iterations() * 3);
+}
+
+BENCHMARK(BM_OutputDescriptorGetters)->ThreadRange(1, 16)->UseRealTime();
+
+// Track creation and destruction from concurrent threads.
+static void BM_CreateAudioTrack(benchmark::State& state) {
+    for (auto _ : state) {
+        sp<AudioTrack> track = createTrack();
+        if (track == nullptr) {
+            state.SkipWithError("cannot create AudioTrack");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_CreateAudioTrack)->ThreadRange(1, 8)->UseRealTime();
+
+int main(int argc, char** argv) {
+    ProcessState::self()->startThreadPool();
+    ::benchmark::Initialize(&argc, argv);
+    ::benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
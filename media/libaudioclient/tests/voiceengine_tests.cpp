@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "VoiceEngineTest"
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include <binder/Binder.h>
+#include <binder/ProcessState.h>
+#include <gtest/gtest.h>
+#include <media/AidlConversion.h>
+#include <media/VoiceEngine.h>
+
+#include "test_execution_tracer.h"
+
+using namespace android;
+using android::content::AttributionSourceState;
+
+namespace {
+
+std::vector<int16_t> makeSine(size_t frameCount, int16_t amplitude) {
+    std::vector<int16_t> data(frameCount);
+    for (size_t i = 0; i < frameCount; ++i) {
+        data[i] = static_cast<int16_t>(amplitude * std::sin(2 * M_PI * 440 * i / 48000.));
+    }
+    return data;
+}
+
+AttributionSourceState makeAttributionSource() {
+    AttributionSourceState attributionSource;
+    attributionSource.packageName = "VoiceEngineTest";
+    attributionSource.uid = VALUE_OR_FATAL(legacy2aidl_uid_t_int32_t(getuid()));
+    attributionSource.pid = VALUE_OR_FATAL(legacy2aidl_pid_t_int32_t(getpid()));
+    attributionSource.token = sp<BBinder>::make();
+    return attributionSource;
+}
+
+}  // namespace
+
+TEST(VoiceSampleCacheTest, InvalidSample) {
+    auto& cache = VoiceSampleCache::getInstance();
+    const auto data = makeSine(480, 1000);
+    EXPECT_EQ(cache.load(nullptr, 480, AUDIO_FORMAT_PCM_16_BIT, AUDIO_CHANNEL_OUT_MONO, 48000),
+              nullptr);
+    EXPECT_EQ(cache.load(data.data(), 0, AUDIO_FORMAT_PCM_16_BIT, AUDIO_CHANNEL_OUT_MONO, 48000),
+              nullptr);
+    EXPECT_EQ(cache.load(data.data(), 480, AUDIO_FORMAT_MP3, AUDIO_CHANNEL_OUT_MONO, 48000),
+              nullptr);
+    EXPECT_EQ(cache.load(data.data(), 80, AUDIO_FORMAT_PCM_16_BIT, AUDIO_CHANNEL_OUT_5POINT1,
+                         48000),
+              nullptr);
+}
+
+TEST(VoiceSampleCacheTest, Deduplication) {
+    auto& cache = VoiceSampleCache::getInstance();
+    const size_t initialSize = cache.size();
+    const auto data = makeSine(4800, 1000);
+    const auto other = makeSine(4800, 2000);
+    {
+        auto sample = cache.load(data.data(), data.size(), AUDIO_FORMAT_PCM_16_BIT,
+                                 AUDIO_CHANNEL_OUT_MONO, 48000);
+        ASSERT_NE(sample, nullptr);
+        EXPECT_EQ(sample->frameCount(), data.size());
+        EXPECT_EQ(sample->channelCount(), 1u);
+        EXPECT_FLOAT_EQ(sample->data()[100], data[100] / 32768.f);
+
+        auto duplicate = cache.load(data.data(), data.size(), AUDIO_FORMAT_PCM_16_BIT,
+                                    AUDIO_CHANNEL_OUT_MONO, 48000);
+        EXPECT_EQ(duplicate, sample);
+        // same content at another rate or with another layout is a different sample
+        auto resampled = cache.load(data.data(), data.size(), AUDIO_FORMAT_PCM_16_BIT,
+                                    AUDIO_CHANNEL_OUT_MONO, 44100);
+        EXPECT_NE(resampled, sample);
+        auto different = cache.load(other.data(), other.size(), AUDIO_FORMAT_PCM_16_BIT,
+                                    AUDIO_CHANNEL_OUT_MONO, 48000);
+        EXPECT_NE(different, sample);
+        EXPECT_EQ(cache.size(), initialSize + 3);
+    }
+    EXPECT_EQ(cache.size(), initialSize);
+}
+
+TEST(VoiceEngineTest, PlayVoices) {
+    const audio_attributes_t attributes = {.usage = AUDIO_USAGE_GAME,
+                                           .content_type = AUDIO_CONTENT_TYPE_SONIFICATION};
+    const size_t maxVoices = 4;
+    sp<VoiceEngine> engine = sp<VoiceEngine>::make(makeAttributionSource(), attributes, maxVoices);
+    if (engine->initCheck() != NO_ERROR) {
+        GTEST_SKIP() << "cannot create AudioTrack";
+    }
+    const auto data = makeSine(4800, 1000);
+    auto sample = VoiceSampleCache::getInstance().load(data.data(), data.size(),
+                                                       AUDIO_FORMAT_PCM_16_BIT,
+                                                       AUDIO_CHANNEL_OUT_MONO, 48000);
+    ASSERT_NE(sample, nullptr);
+
+    EXPECT_EQ(engine->play(nullptr, 1.f, 1.f), BAD_VALUE);
+    std::vector<int32_t> voices;
+    for (size_t i = 0; i < maxVoices; ++i) {
+        const int32_t voiceId = engine->play(sample, 0.5f, 0.5f, 1.0f, -1 /* loop */, 1);
+        ASSERT_GT(voiceId, 0);
+        voices.push_back(voiceId);
+    }
+    EXPECT_EQ(engine->activeVoices(), maxVoices);
+    // lower priority cannot steal a voice, same priority steals the oldest one
+    EXPECT_EQ(engine->play(sample, 0.5f, 0.5f, 1.0f, 0, 0), INVALID_OPERATION);
+    const int32_t stealer = engine->play(sample, 0.5f, 0.5f, 2.0f, 0, 1);
+    ASSERT_GT(stealer, 0);
+    EXPECT_EQ(engine->setVolume(voices[0], 1.f, 1.f), BAD_VALUE);
+    EXPECT_EQ(engine->setVolume(voices[1], 1.f, 0.f), NO_ERROR);
+    EXPECT_EQ(engine->setRate(voices[1], 0.5f), NO_ERROR);
+
+    // the non looping voice, 50 ms long at twice the natural rate, ends by itself
+    EXPECT_TRUE(engine->waitForActiveVoices(maxVoices - 1, std::chrono::seconds(5)));
+    EXPECT_EQ(engine->activeVoices(), maxVoices - 1);
+    engine->stop(voices[1]);
+    EXPECT_EQ(engine->activeVoices(), maxVoices - 2);
+    engine->stopAll();
+    EXPECT_EQ(engine->activeVoices(), 0u);
+}
+
+TEST(VoiceEngineTest, ReleaseWhilePlaying) {
+    const audio_attributes_t attributes = {.usage = AUDIO_USAGE_GAME,
+                                           .content_type = AUDIO_CONTENT_TYPE_SONIFICATION};
+    const auto data = makeSine(480, 1000);
+    auto sample = VoiceSampleCache::getInstance().load(data.data(), data.size(),
+                                                       AUDIO_FORMAT_PCM_16_BIT,
+                                                       AUDIO_CHANNEL_OUT_MONO, 48000);
+    ASSERT_NE(sample, nullptr);
+    // Voices ending on the callback thread race with the release of the engine, which stops
+    // and destroys the track from this thread.
+    for (int i = 0; i < 10; ++i) {
+        sp<VoiceEngine> engine = sp<VoiceEngine>::make(makeAttributionSource(), attributes);
+        if (engine->initCheck() != NO_ERROR) {
+            GTEST_SKIP() << "cannot create AudioTrack";
+        }
+        ASSERT_GT(engine->play(sample, 0.5f, 0.5f, 8.0f), 0);
+        EXPECT_TRUE(engine->waitForActiveVoices(0, std::chrono::seconds(5)));
+        ASSERT_GT(engine->play(sample, 0.5f, 0.5f), 0);
+        engine.clear();
+    }
+}
+
+int main(int argc, char** argv) {
+    android::ProcessState::self()->startThreadPool();
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::UnitTest::GetInstance()->listeners().Append(new TestExecutionTracer());
+    return RUN_ALL_TESTS();
+}
@@ -18,6 +18,7 @@
 // #define LOG_NDEBUG 0
 
 #include <algorithm>
+#include <pthread.h>
 
 #include <aidl/android/hardware/audio/core/BnStreamCallback.h>
 #include <aidl/android/hardware/audio/core/BnStreamOutEventCallback.h>
@@ -113,6 +114,17 @@ DeviceHalAidl::DeviceHalAidl(const std::string& instance, const std::shared_ptr<
           mMapper(instance, module), mMapperAccessor(mMapper, mLock) {
 }
 
+DeviceHalAidl::~DeviceHalAidl() {
+    {
+        std::lock_guard l(mParametersLock);
+        mParametersThreadExit = true;
+    }
+    mParametersCondition.notify_one();
+    if (mParametersThread.joinable()) {
+        mParametersThread.join();
+    }
+}
+
 status_t DeviceHalAidl::getAudioPorts(std::vector<media::audio::common::AudioPort> *ports) {
     std::lock_guard l(mLock);
     return mMapper.getAudioPorts(ports, ndk2cpp_AudioPort);
@@ -188,6 +200,7 @@ status_t DeviceHalAidl::setMode(audio_mode_t mode) {
     ALOGD("%p %s::%s", this, getClassName().c_str(), __func__);
     TIME_CHECK();
     if (mModule == nullptr) return NO_INIT;
+    flushPendingParameters();
     AudioMode audioMode = VALUE_OR_FATAL(::aidl::android::legacy2aidl_audio_mode_t_AudioMode(mode));
     if (mTelephony != nullptr) {
         RETURN_STATUS_IF_ERROR(statusTFromBinderStatus(mTelephony->switchAudioMode(audioMode)));
@@ -231,9 +244,94 @@ status_t DeviceHalAidl::getMasterMute(bool *state) {
 
 status_t DeviceHalAidl::setParameters(const String8& kvPairs) {
     ALOGD("%p %s::%s", this, getClassName().c_str(), __func__);
-    TIME_CHECK();
     if (mModule == nullptr) return NO_INIT;
+    std::lock_guard applyLock(mApplyParametersLock);
+    // Apply the pending asynchronous parameters first to preserve the order of updates.
+    applyPendingParameters();
     AudioParameter parameters(kvPairs);
+    return applyParameters(parameters);
+}
+
+status_t DeviceHalAidl::setParametersAsync(
+        const String8& kvPairs, std::function<void(status_t)> callback) {
+    ALOGD("%p %s::%s", this, getClassName().c_str(), __func__);
+    if (mModule == nullptr) return NO_INIT;
+    AudioParameter parameters(kvPairs);
+    {
+        std::lock_guard l(mParametersLock);
+        queuePendingParameters_l(parameters, std::move(callback));
+        if (!mParametersThread.joinable()) {
+            mParametersThread = std::thread(&DeviceHalAidl::parametersThreadLoop, this);
+        }
+    }
+    mParametersCondition.notify_one();
+    return OK;
+}
+
+void DeviceHalAidl::queuePendingParameters_l(
+        const AudioParameter& parameters, std::function<void(status_t)> callback) {
+    // Repeated updates of the same keys, e.g. a BT suspend toggled several times in a row,
+    // are applied once with the last values. Merging different keys could apply them in
+    // another order than requested, these are queued separately.
+    bool sameKeys = !mPendingParameters.empty()
+            && mPendingParameters.back().parameters.size() == parameters.size();
+    for (size_t i = 0; sameKeys && i < parameters.size(); ++i) {
+        String8 key, value;
+        sameKeys = parameters.getAt(i, key) == OK
+                && mPendingParameters.back().parameters.get(key, value) == OK;
+    }
+    if (sameKeys) {
+        for (size_t i = 0; i < parameters.size(); ++i) {
+            String8 key, value;
+            if (parameters.getAt(i, key, value) == OK) {
+                mPendingParameters.back().parameters.add(key, value);
+            }
+        }
+    } else {
+        mPendingParameters.push_back({.parameters = parameters});
+    }
+    mPendingParameters.back().callbacks.push_back(std::move(callback));
+}
+
+void DeviceHalAidl::flushPendingParameters() {
+    std::lock_guard applyLock(mApplyParametersLock);
+    applyPendingParameters();
+}
+
+void DeviceHalAidl::applyPendingParameters() {
+    std::deque<PendingParameters> pending;
+    {
+        std::lock_guard l(mParametersLock);
+        pending.swap(mPendingParameters);
+    }
+    for (auto& batch : pending) {
+        const status_t status = applyParameters(batch.parameters);
+        for (const auto& callback : batch.callbacks) {
+            if (callback) callback(status);
+        }
+    }
+}
+
+void DeviceHalAidl::parametersThreadLoop() {
+    pthread_setname_np(pthread_self(), "DeviceHalParams");
+    for (;;) {
+        {
+            std::unique_lock l(mParametersLock);
+            while (!mParametersThreadExit && mPendingParameters.empty()) {
+                mParametersCondition.wait(l);
+            }
+            if (mPendingParameters.empty()) return;  // exiting
+        }
+        // Do not wait for requests while holding mApplyParametersLock, this would block
+        // synchronous requests. The queue is only dequeued once the lock is acquired, so that
+        // a synchronous request can not be applied ahead of it.
+        std::lock_guard applyLock(mApplyParametersLock);
+        applyPendingParameters();
+    }
+}
+
+status_t DeviceHalAidl::applyParameters(AudioParameter& parameters) {
+    TIME_CHECK();
     ALOGD("%s: parameters: \"%s\"", __func__, parameters.toString().c_str());
 
     if (status_t status = filterAndUpdateBtA2dpParameters(parameters); status != OK) {
@@ -584,6 +682,8 @@ status_t DeviceHalAidl::createAudioPatch(unsigned int num_sources,
     ALOGD("%p %s::%s", this, getClassName().c_str(), __func__);
     TIME_CHECK();
     if (mModule == nullptr) return NO_INIT;
+    // A BT SCO or suspend state set asynchronously must reach the HAL before the patch.
+    flushPendingParameters();
     if (num_sinks > AUDIO_PATCH_PORTS_MAX || num_sources > AUDIO_PATCH_PORTS_MAX ||
         sources == nullptr || sinks == nullptr || patch == nullptr) {
         return BAD_VALUE;
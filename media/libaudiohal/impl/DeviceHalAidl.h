@@ -16,10 +16,15 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <aidl/android/media/audio/IHalAdapterVendorExtension.h>
@@ -109,6 +114,11 @@ class DeviceHalAidl : public DeviceHalInterface, public ConversionHelperAidl,
     // Set global audio parameters.
     status_t setParameters(const String8& kvPairs) override;
 
+    // Queue global audio parameters, they are merged with the pending ones and applied
+    // by a worker thread.
+    status_t setParametersAsync(const String8& kvPairs,
+            std::function<void(status_t)> callback) override;
+
     // Get global audio parameters.
     status_t getParameters(const String8& keys, String8 *values) override;
 
@@ -204,7 +214,20 @@ class DeviceHalAidl : public DeviceHalInterface, public ConversionHelperAidl,
             const std::shared_ptr<::aidl::android::hardware::audio::core::IModule>& module,
             const std::shared_ptr<::aidl::android::media::audio::IHalAdapterVendorExtension>& vext);
 
-    ~DeviceHalAidl() override = default;
+    ~DeviceHalAidl() override;
+
+    // Applies parameters, consuming the keys handled by dedicated AIDL interfaces and passing
+    // the remaining ones to the vendor extension in one call.
+    status_t applyParameters(AudioParameter& parameters);
+    // Queues asynchronous parameters. A request setting the same keys as the last queued one
+    // replaces its values, other requests are applied after the queued ones.
+    void queuePendingParameters_l(const AudioParameter& parameters,
+            std::function<void(status_t)> callback) REQUIRES(mParametersLock);
+    // Applies the queued asynchronous parameters, in order. Called with mApplyParametersLock.
+    void applyPendingParameters();
+    // Applies the queued asynchronous parameters before a request that may depend on them.
+    void flushPendingParameters();
+    void parametersThreadLoop();
 
     status_t filterAndRetrieveBtA2dpParameters(AudioParameter &keys, AudioParameter *result);
     status_t filterAndRetrieveBtLeParameters(AudioParameter &keys, AudioParameter *result);
@@ -248,6 +271,18 @@ class DeviceHalAidl : public DeviceHalInterface, public ConversionHelperAidl,
     Hal2AidlMapper mMapper GUARDED_BY(mLock);
     LockedAccessor<Hal2AidlMapper> mMapperAccessor;
     Microphones mMicrophones GUARDED_BY(mLock);
+
+    // Serializes application of parameters to the HAL, acquired before mParametersLock.
+    std::mutex mApplyParametersLock;
+    std::mutex mParametersLock;
+    std::condition_variable mParametersCondition;
+    struct PendingParameters {
+        AudioParameter parameters;
+        std::vector<std::function<void(status_t)>> callbacks;
+    };
+    std::deque<PendingParameters> mPendingParameters GUARDED_BY(mParametersLock);
+    bool mParametersThreadExit GUARDED_BY(mParametersLock) = false;
+    std::thread mParametersThread;  // started on the first asynchronous request
 };
 
 } // namespace android
@@ -215,6 +215,13 @@ status_t DeviceHalHidl::setParameters(const String8& kvPairs) {
                          utils::setParameters(mDevice, {} /* context */, hidlParams));
 }
 
+status_t DeviceHalHidl::setParametersAsync(
+        const String8& kvPairs, std::function<void(status_t)> callback) {
+    status_t status = setParameters(kvPairs);
+    if (callback) callback(status);
+    return status;
+}
+
 status_t DeviceHalHidl::getParameters(const String8& keys, String8 *values) {
     TIME_CHECK();
     values->clear();
@@ -63,6 +63,10 @@ class DeviceHalHidl : public DeviceHalInterface, public CoreConversionHelperHidl
     // Set global audio parameters.
     status_t setParameters(const String8& kvPairs) override;
 
+    // Applied synchronously, the HIDL HAL has no batched parameter path.
+    status_t setParametersAsync(const String8& kvPairs,
+            std::function<void(status_t)> callback) override;
+
     // Get global audio parameters.
     status_t getParameters(const String8& keys, String8 *values) override;
 
@@ -19,8 +19,10 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <utility>
 
 #include <audio_utils/clock.h>
+#include <cutils/properties.h>
 #include <media/AidlConversion.h>
 #include <media/AidlConversionCore.h>
 #include <media/AidlConversionCppNdk.h>
@@ -88,7 +90,10 @@ StreamHalAidl::StreamHalAidl(
           mLastReplyLifeTimeNs(
                   std::min(static_cast<size_t>(20),
                            mContext.getBufferDurationMs(mConfig.sample_rate))
-                  * NANOS_PER_MILLISECOND)
+                  * NANOS_PER_MILLISECOND),
+          mPipelineBursts(!isInput && !mContext.isAsynchronous() &&
+                  mContext.getDataMQ() != nullptr &&
+                  property_get_bool("audio.hal.aidl.pipelined_burst", false /*default*/))
 {
     ALOGD("%p %s::%s", this, getClassName().c_str(), __func__);
     {
@@ -370,37 +375,19 @@ status_t StreamHalAidl::transfer(void *buffer, size_t bytes, size_t *transferred
     ALOGV("%p %s::%s", this, getClassName().c_str(), __func__);
     // TIME_CHECK();  // TODO(b/243839867) reenable only when optimized.
     if (!mStream || mContext.getDataMQ() == nullptr) return NO_INIT;
-    mWorkerTid.store(gettid(), std::memory_order_release);
-    // Switch the stream into an active state if needed.
-    // Note: in future we may add support for priming the audio pipeline
-    // with data prior to enabling output (thus we can issue a "burst" command in the "standby"
-    // stream state), however this scenario wasn't supported by the HIDL HAL.
-    if (getState() == StreamDescriptor::State::STANDBY) {
-        StreamDescriptor::Reply reply;
-        RETURN_STATUS_IF_ERROR(sendCommand(makeHalCommand<HalCommand::Tag::start>(), &reply));
-        if (reply.state != StreamDescriptor::State::IDLE) {
-            ALOGE("%s: failed to get the stream out of standby, actual state: %s",
-                    __func__, toString(reply.state).c_str());
-            return INVALID_OPERATION;
-        }
-    }
+    RETURN_STATUS_IF_ERROR(checkPipelinedBurst());
+    RETURN_STATUS_IF_ERROR(prepareTransfer());
     StreamContextAidl::DataMQ::Error fmqError = StreamContextAidl::DataMQ::Error::NONE;
     std::string fmqErrorMsg;
     if (!mIsInput) {
         bytes = std::min(bytes,
                 mContext.getDataMQ()->availableToWrite(&fmqError, &fmqErrorMsg));
-    }
-    StreamDescriptor::Command burst =
-            StreamDescriptor::Command::make<StreamDescriptor::Command::Tag::burst>(bytes);
-    if (!mIsInput) {
         if (!mContext.getDataMQ()->write(static_cast<const int8_t*>(buffer), bytes)) {
             ALOGE("%s: failed to write %zu bytes to data MQ", __func__, bytes);
             return NOT_ENOUGH_DATA;
         }
     }
-    StreamDescriptor::Reply reply;
-    RETURN_STATUS_IF_ERROR(sendCommand(burst, &reply));
-    *transferred = reply.fmqByteCount;
+    RETURN_STATUS_IF_ERROR(sendBurst(bytes, transferred));
     if (mIsInput) {
         LOG_ALWAYS_FATAL_IF(*transferred > bytes,
                 "%s: HAL module read %zu bytes, which exceeds requested count %zu",
@@ -417,6 +404,100 @@ status_t StreamHalAidl::transfer(void *buffer, size_t bytes, size_t *transferred
     return OK;
 }
 
+status_t StreamHalAidl::obtainDataRegion(size_t bytes, void** buffer, size_t* size) {
+    if (!mStream || mContext.getDataMQ() == nullptr) return NO_INIT;
+    if (mDataRegionBytes != 0) {
+        ALOGE("%s: previous region of %zu bytes was not committed", __func__, mDataRegionBytes);
+        return INVALID_OPERATION;
+    }
+    RETURN_STATUS_IF_ERROR(checkPipelinedBurst());
+    RETURN_STATUS_IF_ERROR(prepareTransfer());
+    StreamContextAidl::DataMQ::Error fmqError = StreamContextAidl::DataMQ::Error::NONE;
+    std::string fmqErrorMsg;
+    bytes = std::min(bytes, mContext.getDataMQ()->availableToWrite(&fmqError, &fmqErrorMsg));
+    LOG_ALWAYS_FATAL_IF(fmqError != StreamContextAidl::DataMQ::Error::NONE,
+            "%s", fmqErrorMsg.c_str());
+    StreamContextAidl::DataMQ::MemTransaction tx;
+    if (bytes == 0 || !mContext.getDataMQ()->beginWrite(bytes, &tx)) {
+        *buffer = nullptr;
+        *size = 0;
+        return bytes == 0 ? OK : NOT_ENOUGH_DATA;
+    }
+    // Only expose the contiguous part of the region, the rest is written on the next cycle.
+    const auto& region = tx.getFirstRegion();
+    *buffer = region.getAddress();
+    *size = region.getLength();
+    mDataRegion = *buffer;
+    mDataRegionBytes = *size;
+    return OK;
+}
+
+status_t StreamHalAidl::commitDataRegion(size_t bytes, size_t* transferred) {
+    if (!mStream || mContext.getDataMQ() == nullptr) return NO_INIT;
+    if (bytes > mDataRegionBytes) {
+        ALOGE("%s: committing %zu bytes, only %zu were obtained",
+                __func__, bytes, mDataRegionBytes);
+        return BAD_VALUE;
+    }
+    mDataRegionBytes = 0;
+    if (bytes == 0) {
+        // the region is released, nothing was written into the data MQ
+        *transferred = 0;
+        return OK;
+    }
+    if (!mContext.getDataMQ()->commitWrite(bytes)) {
+        ALOGE("%s: failed to commit %zu bytes to data MQ", __func__, bytes);
+        return NOT_ENOUGH_DATA;
+    }
+    RETURN_STATUS_IF_ERROR(sendBurst(bytes, transferred));
+    // The committed bytes are in the data MQ, those the HAL has not consumed yet are played
+    // after the current burst. Report them all so that the caller does not write them again.
+    *transferred = bytes;
+    mStreamPowerLog.log(mDataRegion, bytes);
+    return OK;
+}
+
+status_t StreamHalAidl::prepareTransfer() {
+    mWorkerTid.store(gettid(), std::memory_order_release);
+    // Switch the stream into an active state if needed.
+    // Note: in future we may add support for priming the audio pipeline
+    // with data prior to enabling output (thus we can issue a "burst" command in the "standby"
+    // stream state), however this scenario wasn't supported by the HIDL HAL.
+    if (getState() == StreamDescriptor::State::STANDBY) {
+        StreamDescriptor::Reply reply;
+        RETURN_STATUS_IF_ERROR(sendCommand(makeHalCommand<HalCommand::Tag::start>(), &reply));
+        if (reply.state != StreamDescriptor::State::IDLE) {
+            ALOGE("%s: failed to get the stream out of standby, actual state: %s",
+                    __func__, toString(reply.state).c_str());
+            return INVALID_OPERATION;
+        }
+    }
+    return OK;
+}
+
+status_t StreamHalAidl::sendBurst(size_t bytes, size_t *transferred) {
+    StreamDescriptor::Command burst =
+            StreamDescriptor::Command::make<StreamDescriptor::Command::Tag::burst>(bytes);
+    if (mPipelineBursts) {
+        // The reply is collected before the next command is sent, which lets the caller
+        // prepare the next burst while the HAL is consuming this one. Bytes the HAL did not
+        // consume during the previous burst are still in the data MQ, request them again.
+        // This way all the bytes placed into the data MQ by this call are consumed by the HAL
+        // unless it reports an error, in which case they are discarded by the next transfer.
+        burst = StreamDescriptor::Command::make<StreamDescriptor::Command::Tag::burst>(
+                static_cast<int32_t>(mContext.getDataMQ()->availableToRead()));
+        RETURN_STATUS_IF_ERROR(sendCommand(burst, nullptr /*reply*/,
+                        false /*safeFromNonWorkerThread*/, nullptr /*statePositions*/,
+                        true /*deferReply*/));
+        *transferred = bytes;
+        return OK;
+    }
+    StreamDescriptor::Reply reply;
+    RETURN_STATUS_IF_ERROR(sendCommand(burst, &reply));
+    *transferred = reply.fmqByteCount;
+    return OK;
+}
+
 status_t StreamHalAidl::pause(StreamDescriptor::Reply* reply) {
     ALOGD("%p %s::%s", this, getClassName().c_str(), __func__);
     TIME_CHECK();
@@ -618,7 +699,7 @@ status_t StreamHalAidl::legacyReleaseAudioPatch() {
 status_t StreamHalAidl::sendCommand(
         const ::aidl::android::hardware::audio::core::StreamDescriptor::Command& command,
         ::aidl::android::hardware::audio::core::StreamDescriptor::Reply* reply,
-        bool safeFromNonWorkerThread, StatePositions* statePositions) {
+        bool safeFromNonWorkerThread, StatePositions* statePositions, bool deferReply) {
     // TIME_CHECK();  // TODO(b/243839867) reenable only when optimized.
     if (!safeFromNonWorkerThread) {
         const pid_t workerTid = mWorkerTid.load(std::memory_order_acquire);
@@ -629,10 +710,17 @@ status_t StreamHalAidl::sendCommand(
     StreamDescriptor::Reply localReply{};
     {
         std::lock_guard l(mCommandReplyLock);
+        // The HAL replies to commands in order, collect the reply of a pipelined burst first.
+        readPendingBurstReply_l();
         if (!mContext.getCommandMQ()->writeBlocking(&command, 1)) {
             ALOGE("%s: failed to write command %s to MQ", __func__, command.toString().c_str());
             return NOT_ENOUGH_DATA;
         }
+        if (deferReply) {
+            mPendingBurst = command;
+            mBurstReplyPending = true;
+            return OK;
+        }
         if (reply == nullptr) {
             reply = &localReply;
         }
@@ -641,42 +729,90 @@ status_t StreamHalAidl::sendCommand(
                     __func__, command.toString().c_str());
             return NOT_ENOUGH_DATA;
         }
-        {
-            std::lock_guard l(mLock);
-            // Not every command replies with 'latencyMs' field filled out, substitute the last
-            // returned value in that case.
-            if (reply->latencyMs <= 0) {
-                reply->latencyMs = mLastReply.latencyMs;
-            }
-            mLastReply = *reply;
-            mLastReplyExpirationNs = uptimeNanos() + mLastReplyLifeTimeNs;
-            if (!mIsInput && reply->status == STATUS_OK) {
-                if (command.getTag() == StreamDescriptor::Command::standby &&
-                        reply->state == StreamDescriptor::State::STANDBY) {
-                    mStatePositions.framesAtStandby = reply->observable.frames;
-                } else if (command.getTag() == StreamDescriptor::Command::flush &&
-                           reply->state == StreamDescriptor::State::IDLE) {
-                    mStatePositions.framesAtFlushOrDrain = reply->observable.frames;
-                } else if (!mContext.isAsynchronous() &&
-                        command.getTag() == StreamDescriptor::Command::drain &&
-                        (reply->state == StreamDescriptor::State::IDLE ||
-                                reply->state == StreamDescriptor::State::DRAINING)) {
-                    mStatePositions.framesAtFlushOrDrain = reply->observable.frames;
-                } // for asynchronous drain, the frame count is saved in 'onAsyncDrainReady'
-            }
-            if (statePositions != nullptr) {
-                *statePositions = mStatePositions;
-            }
+        updateLastReply(command, reply, statePositions);
+    }
+    return statusFromReply(command, reply->status);
+}
+
+void StreamHalAidl::readPendingBurstReply_l() {
+    if (!mBurstReplyPending) return;
+    mBurstReplyPending = false;
+    StreamDescriptor::Reply reply{};
+    status_t status;
+    if (!mContext.getReplyMQ()->readBlocking(&reply, 1)) {
+        ALOGE("%s: failed to read from reply MQ, command %s",
+                __func__, mPendingBurst.toString().c_str());
+        status = NOT_ENOUGH_DATA;
+    } else {
+        updateLastReply(mPendingBurst, &reply, nullptr /*statePositions*/);
+        status = statusFromReply(mPendingBurst, reply.status);
+    }
+    // Keep the first error if the reply was collected by a command sent from another thread.
+    if (mDeferredBurstStatus == OK) {
+        mDeferredBurstStatus = status;
+    }
+}
+
+status_t StreamHalAidl::checkPipelinedBurst() {
+    if (!mPipelineBursts) return OK;
+    std::lock_guard l(mCommandReplyLock);
+    readPendingBurstReply_l();
+    if (mDeferredBurstStatus == OK) return OK;
+    // The HAL has replied, so it does not read the data MQ anymore. Drop what is left of the
+    // failed burst, otherwise it would be played ahead of the data of the next transfer.
+    auto dataMQ = mContext.getDataMQ();
+    if (const size_t queued = dataMQ->availableToRead(); queued != 0) {
+        StreamContextAidl::DataMQ::MemTransaction tx;
+        if (!dataMQ->beginRead(queued, &tx) || !dataMQ->commitRead(queued)) {
+            ALOGE("%s: failed to discard %zu bytes from data MQ", __func__, queued);
         }
     }
-    switch (reply->status) {
+    return std::exchange(mDeferredBurstStatus, OK);
+}
+
+void StreamHalAidl::updateLastReply(
+        const ::aidl::android::hardware::audio::core::StreamDescriptor::Command& command,
+        ::aidl::android::hardware::audio::core::StreamDescriptor::Reply* reply,
+        StatePositions* statePositions) {
+    std::lock_guard l(mLock);
+    // Not every command replies with 'latencyMs' field filled out, substitute the last
+    // returned value in that case.
+    if (reply->latencyMs <= 0) {
+        reply->latencyMs = mLastReply.latencyMs;
+    }
+    mLastReply = *reply;
+    mLastReplyExpirationNs = uptimeNanos() + mLastReplyLifeTimeNs;
+    if (!mIsInput && reply->status == STATUS_OK) {
+        if (command.getTag() == StreamDescriptor::Command::standby &&
+                reply->state == StreamDescriptor::State::STANDBY) {
+            mStatePositions.framesAtStandby = reply->observable.frames;
+        } else if (command.getTag() == StreamDescriptor::Command::flush &&
+                   reply->state == StreamDescriptor::State::IDLE) {
+            mStatePositions.framesAtFlushOrDrain = reply->observable.frames;
+        } else if (!mContext.isAsynchronous() &&
+                command.getTag() == StreamDescriptor::Command::drain &&
+                (reply->state == StreamDescriptor::State::IDLE ||
+                        reply->state == StreamDescriptor::State::DRAINING)) {
+            mStatePositions.framesAtFlushOrDrain = reply->observable.frames;
+        } // for asynchronous drain, the frame count is saved in 'onAsyncDrainReady'
+    }
+    if (statePositions != nullptr) {
+        *statePositions = mStatePositions;
+    }
+}
+
+// static
+status_t StreamHalAidl::statusFromReply(
+        const ::aidl::android::hardware::audio::core::StreamDescriptor::Command& command,
+        int32_t replyStatus) {
+    switch (replyStatus) {
         case STATUS_OK: return OK;
         case STATUS_BAD_VALUE: return BAD_VALUE;
         case STATUS_INVALID_OPERATION: return INVALID_OPERATION;
         case STATUS_NOT_ENOUGH_DATA: return NOT_ENOUGH_DATA;
         default:
             ALOGE("%s: unexpected status %d returned for command %s",
-                    __func__, reply->status, command.toString().c_str());
+                    __func__, replyStatus, command.toString().c_str());
             return INVALID_OPERATION;
     }
 }
@@ -786,6 +922,20 @@ status_t StreamOutHalAidl::write(const void *buffer, size_t bytes, size_t *writt
     return transfer(const_cast<void*>(buffer), bytes, written);
 }
 
+status_t StreamOutHalAidl::beginWrite(size_t bytes, void** buffer, size_t* size) {
+    if (buffer == nullptr || size == nullptr) {
+        return BAD_VALUE;
+    }
+    return obtainDataRegion(bytes, buffer, size);
+}
+
+status_t StreamOutHalAidl::commitWrite(size_t bytes, size_t* written) {
+    if (written == nullptr) {
+        return BAD_VALUE;
+    }
+    return commitDataRegion(bytes, written);
+}
+
 status_t StreamOutHalAidl::getRenderPosition(uint64_t *dspFrames) {
     if (dspFrames == nullptr) {
         return BAD_VALUE;
@@ -269,6 +269,11 @@ class StreamHalAidl : public virtual StreamHalInterface, public ConversionHelper
 
     status_t transfer(void *buffer, size_t bytes, size_t *transferred);
 
+    // Zero-copy variant of 'transfer' for output streams: exposes a contiguous region of the
+    // data MQ which is sent to the HAL by 'commitDataRegion'.
+    status_t obtainDataRegion(size_t bytes, void** buffer, size_t* size);
+    status_t commitDataRegion(size_t bytes, size_t* transferred);
+
     status_t pause(
             ::aidl::android::hardware::audio::core::StreamDescriptor::Reply* reply = nullptr);
 
@@ -314,7 +319,24 @@ class StreamHalAidl : public virtual StreamHalInterface, public ConversionHelper
             const ::aidl::android::hardware::audio::core::StreamDescriptor::Command& command,
             ::aidl::android::hardware::audio::core::StreamDescriptor::Reply* reply = nullptr,
             bool safeFromNonWorkerThread = false,
-            StatePositions* statePositions = nullptr);
+            StatePositions* statePositions = nullptr,
+            bool deferReply = false);
+    // Reads the reply of a burst sent with 'deferReply', if any. An error is saved into
+    // 'mDeferredBurstStatus' to be reported by the next transfer.
+    void readPendingBurstReply_l() REQUIRES(mCommandReplyLock);
+    // Collects the reply of the previous pipelined burst. Returns its error, if any, after
+    // discarding the data the HAL has not consumed.
+    status_t checkPipelinedBurst();
+    void updateLastReply(
+            const ::aidl::android::hardware::audio::core::StreamDescriptor::Command& command,
+            ::aidl::android::hardware::audio::core::StreamDescriptor::Reply* reply,
+            StatePositions* statePositions);
+    static status_t statusFromReply(
+            const ::aidl::android::hardware::audio::core::StreamDescriptor::Command& command,
+            int32_t replyStatus);
+    // Exits standby if needed, must be called by the worker thread before sending a burst.
+    status_t prepareTransfer();
+    status_t sendBurst(size_t bytes, size_t* transferred);
     status_t updateCountersIfNeeded(
             ::aidl::android::hardware::audio::core::StreamDescriptor::Reply* reply = nullptr,
             StatePositions* statePositions = nullptr);
@@ -331,6 +353,17 @@ class StreamHalAidl : public virtual StreamHalInterface, public ConversionHelper
     // mStreamPowerLog is used for audio signal power logging.
     StreamPowerLog mStreamPowerLog;
     std::atomic<pid_t> mWorkerTid = -1;
+    // When set, the reply to a burst command is only read before sending the next command,
+    // so that the worker thread does not wait for the HAL to consume the data it has written.
+    const bool mPipelineBursts;
+    ::aidl::android::hardware::audio::core::StreamDescriptor::Command mPendingBurst
+            GUARDED_BY(mCommandReplyLock);
+    bool mBurstReplyPending GUARDED_BY(mCommandReplyLock) = false;
+    // Error returned for a pipelined burst, reported by the next transfer.
+    status_t mDeferredBurstStatus GUARDED_BY(mCommandReplyLock) = OK;
+    // Region of the data MQ handed out by 'obtainDataRegion'. Only used by the worker thread.
+    void* mDataRegion = nullptr;
+    size_t mDataRegionBytes = 0;
 };
 
 class CallbackBroker;
@@ -354,6 +387,12 @@ class StreamOutHalAidl : public virtual StreamOutHalInterface,
     // Write audio buffer to driver.
     status_t write(const void *buffer, size_t bytes, size_t *written) override;
 
+    // Obtain a region of the data MQ to render into directly.
+    status_t beginWrite(size_t bytes, void** buffer, size_t* size) override;
+
+    // Send the data rendered into the region obtained by 'beginWrite' to the driver.
+    status_t commitWrite(size_t bytes, size_t* written) override;
+
     // Return the number of audio frames written by the audio dsp to DAC since
     // the output has exited standby.
     status_t getRenderPosition(uint64_t *dspFrames) override;
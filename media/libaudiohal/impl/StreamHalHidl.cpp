@@ -591,6 +591,15 @@ status_t StreamOutHalHidl::prepareForWriting(size_t bufferSize) {
     return OK;
 }
 
+status_t StreamOutHalHidl::beginWrite(
+        size_t bytes __unused, void** buffer __unused, size_t* size __unused) {
+    return INVALID_OPERATION;
+}
+
+status_t StreamOutHalHidl::commitWrite(size_t bytes __unused, size_t* written __unused) {
+    return INVALID_OPERATION;
+}
+
 status_t StreamOutHalHidl::getRenderPosition(uint64_t *dspFrames) {
     // TIME_CHECK();  // TODO(b/243839867) reenable only when optimized.
     if (mStream == 0) return NO_INIT;
@@ -139,6 +139,10 @@ class StreamOutHalHidl : public StreamOutHalInterface, public StreamHalHidl {
     // Write audio buffer to driver.
     virtual status_t write(const void *buffer, size_t bytes, size_t *written);
 
+    // Zero-copy writes are not supported by the HIDL HAL.
+    status_t beginWrite(size_t bytes, void** buffer, size_t* size) override;
+    status_t commitWrite(size_t bytes, size_t* written) override;
+
     // Return the number of audio frames written by the audio dsp to DAC since
     // the output has exited standby.
     virtual status_t getRenderPosition(uint64_t *dspFrames);
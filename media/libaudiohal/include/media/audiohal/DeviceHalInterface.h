@@ -17,6 +17,8 @@
 #ifndef ANDROID_HARDWARE_DEVICE_HAL_INTERFACE_H
 #define ANDROID_HARDWARE_DEVICE_HAL_INTERFACE_H
 
+#include <functional>
+
 #include <android/media/audio/common/AudioMMapPolicyInfo.h>
 #include <android/media/audio/common/AudioMMapPolicyType.h>
 #include <android/media/audio/common/AudioMode.h>
@@ -74,6 +76,12 @@ class DeviceHalInterface : public virtual RefBase
     // Set global audio parameters.
     virtual status_t setParameters(const String8& kvPairs) = 0;
 
+    // Set global audio parameters without waiting for the HAL to apply them. Requests received
+    // while a previous one is being applied are merged, so that the HAL sees a single update.
+    // The optional callback is invoked with the status once the parameters have been applied.
+    virtual status_t setParametersAsync(const String8& kvPairs,
+            std::function<void(status_t)> callback) = 0;
+
     // Get global audio parameters.
     virtual status_t getParameters(const String8& keys, String8 *values) = 0;
 
@@ -181,6 +181,16 @@ class StreamOutHalInterface : public virtual StreamHalInterface {
     // Write audio buffer to driver.
     virtual status_t write(const void *buffer, size_t bytes, size_t *written) = 0;
 
+    // Zero-copy alternative to 'write': obtains a contiguous region of at most 'bytes' bytes
+    // of the driver queue. 'buffer' receives its address and 'size' its length, which can be 0
+    // if the queue is full. The region must be handed back with 'commitWrite' before the
+    // next call. Returns INVALID_OPERATION if the stream has no directly accessible queue.
+    virtual status_t beginWrite(size_t bytes, void** buffer, size_t* size) = 0;
+
+    // Sends the first 'bytes' bytes of the region obtained by 'beginWrite' to the driver.
+    // Committing 0 bytes releases the region without sending anything.
+    virtual status_t commitWrite(size_t bytes, size_t* written) = 0;
+
     // Return the number of audio frames written by the audio dsp to DAC since
     // the output has exited standby.
     virtual status_t getRenderPosition(uint64_t *dspFrames) = 0;
@@ -15,9 +15,12 @@
  */
 
 #include <algorithm>
+#include <chrono>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #define LOG_TAG "CoreAudioHalAidlTest"
@@ -750,6 +753,90 @@ TEST_F(DeviceHalAidlTest, ScreenRotation) {
     EXPECT_EQ(ScreenRotation::DEG_0, mModule->getScreenRotation());
 }
 
+TEST_F(DeviceHalAidlTest, SetParametersAsync) {
+    using ScreenRotation = ::aidl::android::hardware::audio::core::IModule::ScreenRotation;
+    std::promise<status_t> applied;
+    EXPECT_EQ(OK, mDevice->setParametersAsync(
+                          createParameterString(AudioParameter::keyScreenState,
+                                                AudioParameter::valueOn),
+                          [&applied](status_t status) { applied.set_value(status); }));
+    EXPECT_EQ(OK, applied.get_future().get());
+    EXPECT_TRUE(mModule->isScreenTurnedOn());
+    // A synchronous request applies the pending asynchronous ones first.
+    std::vector<status_t> statuses;
+    std::mutex statusesLock;
+    auto onApplied = [&](status_t status) {
+        std::lock_guard l(statusesLock);
+        statuses.push_back(status);
+    };
+    EXPECT_EQ(OK, mDevice->setParametersAsync(
+                          createParameterString(AudioParameter::keyScreenRotation, 90),
+                          onApplied));
+    EXPECT_EQ(OK, mDevice->setParametersAsync(
+                          createParameterString(AudioParameter::keyScreenState,
+                                                AudioParameter::valueOn),
+                          onApplied));
+    EXPECT_EQ(OK, mDevice->setParameters(createParameterString(AudioParameter::keyScreenState,
+                                                               AudioParameter::valueOff)));
+    EXPECT_FALSE(mModule->isScreenTurnedOn());
+    EXPECT_EQ(ScreenRotation::DEG_90, mModule->getScreenRotation());
+    std::lock_guard l(statusesLock);
+    EXPECT_EQ(std::vector<status_t>({OK, OK}), statuses);
+}
+
+TEST_F(DeviceHalAidlTest, SetParametersAsyncKeepsOrder) {
+    using ScreenRotation = ::aidl::android::hardware::audio::core::IModule::ScreenRotation;
+    std::vector<status_t> statuses;
+    std::mutex statusesLock;
+    auto onApplied = [&](status_t status) {
+        std::lock_guard l(statusesLock);
+        statuses.push_back(status);
+    };
+    // Requests for different keys are applied one after another, repeated requests for the
+    // same keys may be coalesced, but each callback is still invoked.
+    EXPECT_EQ(OK, mDevice->setParametersAsync(
+                          createParameterString(AudioParameter::keyScreenRotation, 90),
+                          onApplied));
+    EXPECT_EQ(OK, mDevice->setParametersAsync(
+                          createParameterString(AudioParameter::keyScreenState,
+                                                AudioParameter::valueOff),
+                          onApplied));
+    EXPECT_EQ(OK, mDevice->setParametersAsync(
+                          createParameterString(AudioParameter::keyScreenRotation, 180),
+                          onApplied));
+    EXPECT_EQ(OK, mDevice->setParametersAsync(
+                          createParameterString(AudioParameter::keyScreenRotation, 270),
+                          onApplied));
+    EXPECT_EQ(OK, mDevice->setParameters(String8()));
+    EXPECT_FALSE(mModule->isScreenTurnedOn());
+    EXPECT_EQ(ScreenRotation::DEG_270, mModule->getScreenRotation());
+    std::lock_guard l(statusesLock);
+    EXPECT_EQ(std::vector<status_t>({OK, OK, OK, OK}), statuses);
+}
+
+TEST_F(DeviceHalAidlTest, SetParametersAfterAsyncBatch) {
+    using ScreenRotation = ::aidl::android::hardware::audio::core::IModule::ScreenRotation;
+    constexpr auto kTimeout = std::chrono::seconds(5);
+    for (int i = 0; i < 10; ++i) {
+        std::promise<status_t> applied;
+        EXPECT_EQ(OK, mDevice->setParametersAsync(
+                              createParameterString(AudioParameter::keyScreenRotation, 90),
+                              [&applied](status_t status) { applied.set_value(status); }));
+        EXPECT_EQ(OK, applied.get_future().get());
+        // The parameters thread is now idle, a synchronous request must not wait for it.
+        // Run it on a separate thread, so that a hang is reported as a failure.
+        std::packaged_task<status_t()> setParameters([device = mDevice] {
+            return device->setParameters(
+                    createParameterString(AudioParameter::keyScreenRotation, 0));
+        });
+        auto result = setParameters.get_future();
+        std::thread(std::move(setParameters)).detach();
+        ASSERT_EQ(std::future_status::ready, result.wait_for(kTimeout)) << "iteration " << i;
+        EXPECT_EQ(OK, result.get());
+        EXPECT_EQ(ScreenRotation::DEG_0, mModule->getScreenRotation());
+    }
+}
+
 class DeviceHalAidlVendorParametersTest : public testing::Test {
   public:
     void SetUp() override {
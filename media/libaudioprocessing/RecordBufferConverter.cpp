@@ -37,6 +37,88 @@ static inline T max(const T& a, const T& b)
 
 namespace android {
 
+namespace {
+
+template <typename T>
+inline float toFloat(T sample);
+
+template <>
+inline float toFloat(int16_t sample) { return float_from_i16(sample); }
+
+template <>
+inline float toFloat(float sample) { return sample; }
+
+template <typename T>
+inline T fromFloat(float sample);
+
+template <>
+inline int16_t fromFloat(float sample) { return clamp16_from_float(sample); }
+
+template <>
+inline float fromFloat(float sample) { return sample; }
+
+// Converts format and channel count in a single pass over the data.
+// Computation is done in float, so results are identical to the multi-stage path:
+// input conversion to float, legacy downmix or upmix, output conversion.
+template <typename S, typename D, uint32_t SRC_CHANNELS, uint32_t DST_CHANNELS>
+void fusedConvert(void *dst, const void *src, size_t frames)
+{
+    static_assert((SRC_CHANNELS == 1 && DST_CHANNELS == 2)
+            || (SRC_CHANNELS == 2 && DST_CHANNELS == 1));
+    const S *in = static_cast<const S *>(src);
+    D *out = static_cast<D *>(dst);
+    for (; frames > 0; --frames) {
+        if constexpr (SRC_CHANNELS == 2 && DST_CHANNELS == 1) {
+            *out++ = fromFloat<D>((toFloat(in[0]) + toFloat(in[1])) * 0.5f);
+            in += 2;
+        } else {
+            const D sample = fromFloat<D>(toFloat(*in++));
+            *out++ = sample;
+            *out++ = sample;
+        }
+    }
+}
+
+// same signature as RecordBufferConverter::FusedConvertFunc
+typedef void (*FusedConvertFunc)(void *dst, const void *src, size_t frames);
+
+template <typename S, typename D>
+FusedConvertFunc getFusedConvert(uint32_t srcChannelCount, uint32_t dstChannelCount)
+{
+    if (srcChannelCount == 1 && dstChannelCount == 2) {
+        return fusedConvert<S, D, 1, 2>;
+    }
+    if (srcChannelCount == 2 && dstChannelCount == 1) {
+        return fusedConvert<S, D, 2, 1>;
+    }
+    return nullptr;
+}
+
+// Returns the single pass converter for 16 bit or float mono to stereo or stereo to mono,
+// or nullptr if the configuration is not handled.
+FusedConvertFunc getFusedConvert(audio_format_t srcFormat, audio_format_t dstFormat,
+        uint32_t srcChannelCount, uint32_t dstChannelCount)
+{
+    if (srcFormat == AUDIO_FORMAT_PCM_16_BIT) {
+        if (dstFormat == AUDIO_FORMAT_PCM_16_BIT) {
+            return getFusedConvert<int16_t, int16_t>(srcChannelCount, dstChannelCount);
+        }
+        if (dstFormat == AUDIO_FORMAT_PCM_FLOAT) {
+            return getFusedConvert<int16_t, float>(srcChannelCount, dstChannelCount);
+        }
+    } else if (srcFormat == AUDIO_FORMAT_PCM_FLOAT) {
+        if (dstFormat == AUDIO_FORMAT_PCM_16_BIT) {
+            return getFusedConvert<float, int16_t>(srcChannelCount, dstChannelCount);
+        }
+        if (dstFormat == AUDIO_FORMAT_PCM_FLOAT) {
+            return getFusedConvert<float, float>(srcChannelCount, dstChannelCount);
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
 RecordBufferConverter::RecordBufferConverter(
         audio_channel_mask_t srcChannelMask, audio_format_t srcFormat,
         uint32_t srcSampleRate,
@@ -56,7 +138,8 @@ RecordBufferConverter::RecordBufferConverter(
             mIsLegacyDownmix(false),
             mIsLegacyUpmix(false),
             mRequiresFloat(false),
-            mInputConverterProvider(NULL)
+            mInputConverterProvider(NULL),
+            mFusedConvert(NULL)
 {
     (void)updateParameters(srcChannelMask, srcFormat, srcSampleRate,
             dstChannelMask, dstFormat, dstSampleRate);
@@ -185,14 +268,34 @@ status_t RecordBufferConverter::updateParameters(
                    && (mDstChannelMask == AUDIO_CHANNEL_IN_STEREO
                             || mDstChannelMask == AUDIO_CHANNEL_IN_FRONT_BACK);
 
+    // can format and channel conversion be done in a single pass?
+    // Without resampling this covers the legacy upmix and downmix, which otherwise need an
+    // input conversion to float, the remix and an output conversion. With resampling, the
+    // resampler output is always stereo float and a mono destination needs a downmix and
+    // an output conversion.
+    mFusedConvert = NULL;
+    if (mResampler == NULL) {
+        if (mIsLegacyUpmix || mIsLegacyDownmix) {
+            mFusedConvert = getFusedConvert(mSrcFormat, mDstFormat,
+                    mSrcChannelCount, mDstChannelCount);
+        }
+    } else if (mDstChannelCount == 1
+            && (mIsLegacyDownmix || mSrcChannelMask == mDstChannelMask)) {
+        mFusedConvert = getFusedConvert(AUDIO_FORMAT_PCM_FLOAT, mDstFormat,
+                FCC_2, mDstChannelCount);
+    }
+
     // do we need to process in float?
-    mRequiresFloat = mResampler != NULL || mIsLegacyDownmix || mIsLegacyUpmix;
+    mRequiresFloat = mResampler != NULL
+            || ((mIsLegacyDownmix || mIsLegacyUpmix) && mFusedConvert == NULL);
 
     // do we need a staging buffer to convert for destination (we can still optimize this)?
     // we use mBufFrameSize > 0 to indicate both frame size as well as buffer necessity
     if (mResampler != NULL) {
         mBufFrameSize = max(mSrcChannelCount, (uint32_t)FCC_2)
                 * audio_bytes_per_sample(AUDIO_FORMAT_PCM_FLOAT);
+    } else if (mFusedConvert != NULL) {
+        mBufFrameSize = 0;
     } else if (mIsLegacyUpmix || mIsLegacyDownmix) { // legacy modes always float
         mBufFrameSize = mDstChannelCount * audio_bytes_per_sample(AUDIO_FORMAT_PCM_FLOAT);
     } else if (mSrcChannelMask != mDstChannelMask && mDstFormat != mSrcFormat) {
@@ -224,6 +327,10 @@ status_t RecordBufferConverter::updateParameters(
 void RecordBufferConverter::convertNoResampler(
         void *dst, const void *src, size_t frames)
 {
+    if (mFusedConvert != NULL) {
+        mFusedConvert(dst, src, frames);
+        return;
+    }
     // src is native type unless there is legacy upmix or downmix, whereupon it is float.
     if (mBufFrameSize != 0 && mBufFrames < frames) {
         free(mBuf);
@@ -265,6 +372,10 @@ void RecordBufferConverter::convertResampler(
         void *dst, /*not-a-const*/ void *src, size_t frames)
 {
     // src buffer format is ALWAYS float when entering this routine
+    if (mFusedConvert != NULL) {
+        mFusedConvert(dst, src, frames);
+        return;
+    }
     if (mIsLegacyUpmix) {
         ; // mono to stereo already handled by resampler
     } else if (mIsLegacyDownmix
@@ -85,6 +85,9 @@ private:
     // format conversion when using resampler; modifies src in-place
     void convertResampler(void *dst, /*not-a-const*/ void *src, size_t frames);
 
+    // single pass format and channel conversion, see updateParameters()
+    typedef void (*FusedConvertFunc)(void *dst, const void *src, size_t frames);
+
     // user provided information
     audio_channel_mask_t mSrcChannelMask;
     audio_format_t       mSrcFormat;
@@ -111,6 +114,7 @@ private:
     bool                 mRequiresFloat;    // data processing requires float (e.g. resampler)
     PassthruBufferProvider *mInputConverterProvider;    // converts input to float
     int8_t               mIdxAry[sizeof(uint32_t) * 8]; // used for channel mask conversion
+    FusedConvertFunc     mFusedConvert;     // non-null if conversion is done in one pass
 };
 
 // ----------------------------------------------------------------------------
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include <audio_utils/primitives.h>
+#include <benchmark/benchmark.h>
+#include <media/RecordBufferConverter.h>
+
+using namespace android;
+
+namespace {
+
+// Endless source of frames, as provided by a RecordThread.
+class SourceBufferProvider : public AudioBufferProvider {
+public:
+    SourceBufferProvider(audio_format_t format, uint32_t channelCount, size_t frameCount)
+        : mFrameSize(audio_bytes_per_sample(format) * channelCount),
+          mFrameCount(frameCount),
+          mData(mFrameSize * frameCount) {
+        // any non-silent content
+        for (size_t i = 0; i < mData.size(); ++i) {
+            mData[i] = static_cast<uint8_t>(i * 7);
+        }
+        if (format == AUDIO_FORMAT_PCM_FLOAT) {
+            memcpy_to_float_from_i16(reinterpret_cast<float*>(mData.data()),
+                                     reinterpret_cast<const int16_t*>(mData.data()),
+                                     frameCount * channelCount);
+        }
+    }
+
+    status_t getNextBuffer(Buffer* buffer) override {
+        buffer->frameCount = std::min(buffer->frameCount, mFrameCount - mPosition);
+        buffer->raw = mData.data() + mPosition * mFrameSize;
+        return NO_ERROR;
+    }
+
+    void releaseBuffer(Buffer* buffer) override {
+        mPosition = (mPosition + buffer->frameCount) % mFrameCount;
+        buffer->frameCount = 0;
+        buffer->raw = nullptr;
+    }
+
+private:
+    const size_t mFrameSize;
+    const size_t mFrameCount;
+    std::vector<uint8_t> mData;
+    size_t mPosition = 0;
+};
+
+// 20 ms at 48 kHz, a typical RecordThread period.
+constexpr size_t kSourceFrames = 960;
+
+void runConverter(benchmark::State& state, audio_channel_mask_t srcChannelMask,
+                  audio_format_t srcFormat, uint32_t srcSampleRate,
+                  audio_channel_mask_t dstChannelMask, audio_format_t dstFormat,
+                  uint32_t dstSampleRate) {
+    RecordBufferConverter converter(srcChannelMask, srcFormat, srcSampleRate, dstChannelMask,
+                                    dstFormat, dstSampleRate);
+    if (converter.initCheck() != NO_ERROR) {
+        state.SkipWithError("invalid configuration");
+        return;
+    }
+    SourceBufferProvider provider(srcFormat, audio_channel_count_from_in_mask(srcChannelMask),
+                                  kSourceFrames);
+    const size_t dstFrames = kSourceFrames * dstSampleRate / srcSampleRate;
+    std::vector<uint8_t> dst(dstFrames * audio_bytes_per_frame(
+            audio_channel_count_from_in_mask(dstChannelMask), dstFormat));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(converter.convert(dst.data(), &provider, dstFrames));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * dstFrames);
+}
+
+}  // namespace
+
+// Channel conversion only: legacy downmix and upmix.
+BENCHMARK_CAPTURE(runConverter, stereo_i16_to_mono_i16_48k,
+                  AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_16_BIT, 48000,
+                  AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, 48000);
+BENCHMARK_CAPTURE(runConverter, stereo_float_to_mono_i16_48k,
+                  AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_FLOAT, 48000,
+                  AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, 48000);
+BENCHMARK_CAPTURE(runConverter, mono_i16_to_stereo_float_48k,
+                  AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, 48000,
+                  AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_FLOAT, 48000);
+
+// Resampling to a voice recognition rate.
+BENCHMARK_CAPTURE(runConverter, mono_i16_48k_to_mono_i16_16k,
+                  AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, 48000,
+                  AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, 16000);
+BENCHMARK_CAPTURE(runConverter, stereo_i16_48k_to_mono_i16_16k,
+                  AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_16_BIT, 48000,
+                  AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, 16000);
+BENCHMARK_CAPTURE(runConverter, stereo_float_48k_to_mono_float_16k,
+                  AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_FLOAT, 48000,
+                  AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_FLOAT, 16000);
+BENCHMARK_CAPTURE(runConverter, mono_i16_16k_to_stereo_i16_48k,
+                  AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, 16000,
+                  AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_16_BIT, 48000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "media/HeadTrackingProcessor.h"
+#include "media/QuaternionUtil.h"
+
+using namespace android::media;
+
+namespace {
+
+constexpr int64_t kNanosPerSecond = 1'000'000'000;
+
+// Calculation period: the spatializer mixer calculates the pose on each buffer processed.
+constexpr int64_t kCalculatePeriodNs = 10'000'000;
+
+// Same configuration as the audio policy service SpatializerPoseController.
+HeadTrackingProcessor::Options makeOptions() {
+    return HeadTrackingProcessor::Options{
+            .maxTranslationalVelocity = 2.f / kNanosPerSecond,
+            .maxRotationalVelocity = 0.8f / kNanosPerSecond,
+            .freshnessTimeout = 120'000'000,
+            .predictionDuration = 120'000'000,
+            .autoRecenterWindowDuration = 6 * kNanosPerSecond,
+            .autoRecenterTranslationalThreshold = 0.1f,
+            .autoRecenterRotationalThreshold = 10.5f / 180 * M_PI,
+            .screenStillnessWindowDuration = 750'000'000,
+            .screenStillnessTranslationalThreshold = 0.1f,
+            .screenStillnessRotationalThreshold = 15.0f / 180 * M_PI,
+    };
+}
+
+// Slow head motion, within the auto-recenter thresholds so the stillness window stays full.
+std::vector<HeadTrackingProcessor::HeadSample> makeSamples(int64_t rateHz, int64_t durationNs) {
+    std::vector<HeadTrackingProcessor::HeadSample> samples;
+    const int64_t periodNs = kNanosPerSecond / rateHz;
+    for (int64_t t = periodNs; t <= durationNs; t += periodNs) {
+        const float angle = 0.05f * std::sin(2 * M_PI * t / (4 * kNanosPerSecond));
+        samples.push_back({t, Pose3f(rotateY(angle)),
+                           Twist3f(Eigen::Vector3f::Zero(), Eigen::Vector3f(0, 1e-10f, 0))});
+    }
+    return samples;
+}
+
+// Runs the full processing graph on 10 s of head samples at the given rate.
+// state.range(0) is the sensor rate in Hz, state.range(1) selects the batched API.
+void BM_HeadTrackingProcessor(benchmark::State& state) {
+    const int64_t rateHz = state.range(0);
+    const bool batched = state.range(1) != 0;
+    const int64_t durationNs = 10 * kNanosPerSecond;
+    const auto samples = makeSamples(rateHz, durationNs);
+
+    for (auto _ : state) {
+        auto processor = createHeadTrackingProcessor(makeOptions(),
+                                                     HeadTrackingMode::WORLD_RELATIVE);
+        processor->setPosePredictorType(PosePredictorType::LEAST_SQUARES);
+        size_t next = 0;
+        for (int64_t now = kCalculatePeriodNs; now <= durationNs; now += kCalculatePeriodNs) {
+            // Samples received since the previous calculation.
+            size_t end = next;
+            while (end < samples.size() && samples[end].timestamp <= now) ++end;
+            if (batched) {
+                processor->setWorldToHeadPoses(samples.data() + next, end - next);
+            } else {
+                for (size_t i = next; i < end; ++i) {
+                    processor->setWorldToHeadPose(samples[i].timestamp, samples[i].worldToHead,
+                                                  samples[i].headTwist);
+                }
+            }
+            next = end;
+            processor->setWorldToScreenPose(now, Pose3f());
+            processor->calculate(now);
+            benchmark::DoNotOptimize(processor->getHeadToStagePose());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * samples.size());
+}
+
+BENCHMARK(BM_HeadTrackingProcessor)->ArgsProduct({{100, 200, 400}, {0, 1}});
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -17,6 +17,8 @@
 #include "media/HeadTrackingProcessor.h"
 #include "media/QuaternionUtil.h"
 
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "TestUtil.h"
@@ -106,6 +108,63 @@ TEST(HeadTrackingProcessor, Prediction) {
     EXPECT_EQ(processor->getHeadToStagePose(), Pose3f());
 }
 
+TEST(HeadTrackingProcessor, PredictionDurationUpdate) {
+    const Pose3f worldToHead{{1, 2, 3}, Quaternionf::UnitRandom()};
+    const Twist3f headTwist{{4, 5, 6}, quaternionToRotationVector(Quaternionf::UnitRandom()) / 10};
+
+    std::unique_ptr<HeadTrackingProcessor> processor = createHeadTrackingProcessor(
+            Options{.predictionDuration = 2.f}, HeadTrackingMode::WORLD_RELATIVE);
+
+    processor->setPosePredictorType(PosePredictorType::TWIST);
+
+    // Establish a baseline for the drift compensators.
+    processor->setWorldToHeadPose(0, Pose3f(), Twist3f());
+    processor->setWorldToScreenPose(0, Pose3f());
+
+    // The new duration applies to the following samples.
+    processor->setPredictionDuration(5.f);
+    processor->setWorldToHeadPose(0, worldToHead, headTwist);
+    processor->setWorldToScreenPose(0, Pose3f());
+    processor->calculate(0);
+    ASSERT_EQ(processor->getActualMode(), HeadTrackingMode::WORLD_RELATIVE);
+    EXPECT_EQ(processor->getHeadToStagePose(), (worldToHead * integrate(headTwist, 5.f)).inverse());
+
+    processor->setPredictionDuration(0.f);
+    processor->setWorldToHeadPose(0, worldToHead, headTwist);
+    processor->calculate(0);
+    EXPECT_EQ(processor->getHeadToStagePose(), worldToHead.inverse());
+}
+
+TEST(HeadTrackingProcessor, BatchedHeadPoses) {
+    const Options options{.predictionDuration = 2.f,
+                          .autoRecenterWindowDuration = 10,
+                          .autoRecenterTranslationalThreshold = 1,
+                          .autoRecenterRotationalThreshold = 0.1};
+    std::unique_ptr<HeadTrackingProcessor> single =
+            createHeadTrackingProcessor(options, HeadTrackingMode::WORLD_RELATIVE);
+    std::unique_ptr<HeadTrackingProcessor> batched =
+            createHeadTrackingProcessor(options, HeadTrackingMode::WORLD_RELATIVE);
+
+    std::vector<HeadTrackingProcessor::HeadSample> samples;
+    for (int64_t t = 0; t < 40; ++t) {
+        samples.push_back({t, Pose3f({0.01f * t, 0, 0}, rotateZ(0.02f * t)),
+                           Twist3f({0.01f, 0, 0}, {0, 0, 0.02f})});
+    }
+    for (size_t start = 0; start < samples.size(); start += 8) {
+        for (size_t i = start; i < start + 8; ++i) {
+            single->setWorldToHeadPose(samples[i].timestamp, samples[i].worldToHead,
+                                       samples[i].headTwist);
+            single->setWorldToScreenPose(samples[i].timestamp, Pose3f());
+        }
+        batched->setWorldToHeadPoses(&samples[start], 8);
+        batched->setWorldToScreenPose(samples[start + 7].timestamp, Pose3f());
+        single->calculate(samples[start + 7].timestamp);
+        batched->calculate(samples[start + 7].timestamp);
+        EXPECT_EQ(single->getActualMode(), batched->getActualMode());
+        EXPECT_EQ(single->getHeadToStagePose(), batched->getHeadToStagePose());
+    }
+}
+
 TEST(HeadTrackingProcessor, SmoothModeSwitch) {
     const Pose3f targetHeadToWorld = Pose3f({4, 0, 0}, rotateZ(M_PI / 2));
 
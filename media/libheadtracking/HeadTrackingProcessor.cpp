@@ -38,6 +38,7 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
   public:
     HeadTrackingProcessorImpl(const Options& options, HeadTrackingMode initialMode)
         : mOptions(options),
+          mPredictionDuration(options.predictionDuration),
           mHeadStillnessDetector(StillnessDetector::Options{
                   .defaultValue = false,
                   .windowDuration = options.autoRecenterWindowDuration,
@@ -60,11 +61,22 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
 
     void setWorldToHeadPose(int64_t timestamp, const Pose3f& worldToHead,
                             const Twist3f& headTwist) override {
-        const Pose3f predictedWorldToHead = mPosePredictor.predict(
-                timestamp, worldToHead, headTwist, mOptions.predictionDuration);
+        const HeadSample sample{timestamp, worldToHead, headTwist};
+        setWorldToHeadPoses(&sample, 1);
+    }
+
+    void setWorldToHeadPoses(const HeadSample* samples, size_t count) override {
+        if (count == 0) return;
+        // Every sample goes through the predictor and the stillness window, but the bias only
+        // holds the last input until the next calculate().
+        Pose3f predictedWorldToHead;
+        for (size_t i = 0; i < count; ++i) {
+            predictedWorldToHead = mPosePredictor.predict(samples[i].timestamp,
+                    samples[i].worldToHead, samples[i].headTwist, mPredictionDuration);
+            mHeadStillnessDetector.setInput(samples[i].timestamp, predictedWorldToHead);
+        }
         mHeadPoseBias.setInput(predictedWorldToHead);
-        mHeadStillnessDetector.setInput(timestamp, predictedWorldToHead);
-        mWorldToHeadTimestamp = timestamp;
+        mWorldToHeadTimestamp = samples[count - 1].timestamp;
     }
 
     void setWorldToScreenPose(int64_t timestamp, const Pose3f& worldToScreen) override {
@@ -166,6 +178,10 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
         mPosePredictor.setPosePredictorType(type);
     }
 
+    void setPredictionDuration(float predictionDuration) override {
+        mPredictionDuration = predictionDuration;
+    }
+
     std::string toString_l(unsigned level) const override {
         std::string prefixSpace(level, ' ');
         std::string ss = prefixSpace + "HeadTrackingProcessor:\n";
@@ -175,7 +191,8 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
                       mOptions.maxRotationalVelocity);
         StringAppendF(&ss, "%s freshnessTimeout: %0.4f ms\n", prefixSpace.c_str(),
                       media::nsToFloatMs(mOptions.freshnessTimeout));
-        StringAppendF(&ss, "%s predictionDuration: %0.4f ms\n", prefixSpace.c_str(),
+        StringAppendF(&ss, "%s predictionDuration: %0.4f ms (initial %0.4f ms)\n",
+                      prefixSpace.c_str(), media::nsToFloatMs(mPredictionDuration),
                       media::nsToFloatMs(mOptions.predictionDuration));
         StringAppendF(&ss, "%s autoRecenterWindowDuration: %0.4f ms\n", prefixSpace.c_str(),
                       media::nsToFloatMs(mOptions.autoRecenterWindowDuration));
@@ -199,6 +216,7 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
 
   private:
     const Options mOptions;
+    float mPredictionDuration;
     float mPhysicalToLogicalAngle = 0;
     // We store the physical to logical angle as "pending" until the next world-to-screen sample it
     // applies to arrives.
@@ -19,6 +19,7 @@
 #define LOG_TAG "SensorPoseProvider"
 
 #include <algorithm>
+#include <array>
 #include <future>
 #include <inttypes.h>
 #include <limits>
@@ -44,6 +45,8 @@ using android::base::StringAppendF;
 // The number 19 is arbitrary, only useful if using multiple objects on the same looper.
 // Note: Instead of a fixed number, the SensorEventQueue's fd could be used instead.
 constexpr int kIdent = 19;
+// Events read from the sensor queue at once, a FIFO batch at the usual head tracker rates.
+constexpr size_t kMaxEventsPerRead = 16;
 
 static inline Looper* ALooper_to_Looper(ALooper* alooper) {
     return reinterpret_cast<Looper*>(alooper);
@@ -269,6 +272,8 @@ class SensorPoseProviderImpl : public SensorPoseProvider {
 
         initFinished(true);
 
+        std::array<ASensorEvent, kMaxEventsPerRead> events;
+        std::array<Listener::PoseSample, kMaxEventsPerRead> samples;
         while (!mQuit) {
             const int ret = mLooper->pollOnce(-1 /* no timeout */, nullptr /* outFd */,
                     nullptr /* outEvents */, nullptr /* outData */);
@@ -293,15 +298,14 @@ class SensorPoseProviderImpl : public SensorPoseProvider {
                     continue;
             }
 
-            // Process an event.
-            ASensorEvent event;
-            ssize_t actual = mQueue->read(&event, 1);
+            // Process the events, all those batched by the sensor FIFO are read at once.
+            ssize_t actual = mQueue->read(events.data(), events.size());
             if (actual > 0) {
-                mQueue->sendAck(&event, actual);
+                mQueue->sendAck(events.data(), actual);
             }
-            ssize_t size = mQueue->filterEvents(&event, actual);
+            ssize_t size = mQueue->filterEvents(events.data(), actual);
 
-            if (size < 0 || size > 1) {
+            if (size < 0 || size > actual) {
                 ALOGE("%s: Unexpected return value from SensorEventQueue::filterEvents: %zd",
                         __func__, size);
                 break;
@@ -311,25 +315,32 @@ class SensorPoseProviderImpl : public SensorPoseProvider {
                 continue;
             }
 
-            handleEvent(event);
+            handleEvents(events.data(), size, samples.data());
         }
         ALOGD("%s: Exiting sensor event loop", __func__);
     }
 
-    void handleEvent(const ASensorEvent& event) {
-        PoseEvent value;
+    void handleEvents(const ASensorEvent* events, size_t count, Listener::PoseSample* samples) {
+        size_t sampleCount = 0;
         {
             std::lock_guard lock(mMutex);
-            auto iter = mEnabledSensorsExtra.find(event.sensor);
-            if (iter == mEnabledSensorsExtra.end()) {
-                // This can happen if we have any pending events shortly after stopping.
-                return;
+            for (size_t i = 0; i < count; ++i) {
+                const ASensorEvent& event = events[i];
+                auto iter = mEnabledSensorsExtra.find(event.sensor);
+                if (iter == mEnabledSensorsExtra.end()) {
+                    // This can happen if we have any pending events shortly after stopping.
+                    continue;
+                }
+                const PoseEvent value = parseEvent(event, iter->second.format,
+                        &iter->second.discontinuityCount);
+                updateEventTimestamp(event, iter->second);
+                samples[sampleCount++] = Listener::PoseSample{event.timestamp, event.sensor,
+                        value.pose, value.twist, value.isNewReference};
             }
-            value = parseEvent(event, iter->second.format, &iter->second.discontinuityCount);
-            updateEventTimestamp(event, iter->second);
         }
-        mListener->onPose(event.timestamp, event.sensor, value.pose, value.twist,
-                          value.isNewReference);
+        if (sampleCount > 0) {
+            mListener->onPoses(samples, sampleCount);
+        }
     }
 
     DataFormat getSensorFormat(int32_t handle) {
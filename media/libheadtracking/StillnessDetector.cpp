@@ -16,6 +16,8 @@
 
 #include "StillnessDetector.h"
 
+#include <algorithm>
+
 namespace android {
 namespace media {
 
@@ -32,7 +34,7 @@ void StillnessDetector::reset() {
 }
 
 void StillnessDetector::setInput(int64_t timestamp, const Pose3f& input) {
-    mFifo.push_back(TimestampedPose{timestamp, input});
+    mFifo.push_back(timestamp, input);
     discardOld(timestamp);
 }
 
@@ -52,20 +54,13 @@ bool StillnessDetector::calculate(int64_t timestamp) {
     // deadline correctly. We always go from end to start, to find the most recent pose that
     // violated stillness and update the suppression deadline if it has not been set or if the new
     // one ends after the current one.
-    bool moved = false;
-
-    if (!mFifo.empty()) {
-        for (auto iter = mFifo.rbegin() + 1; iter != mFifo.rend(); ++iter) {
-            const auto& event = *iter;
-            if (!areNear(event.pose, mFifo.back().pose)) {
-                // Enable suppression for the duration of the window.
-                int64_t deadline = event.timestamp + mOptions.windowDuration;
-                if (!mSuppressionDeadline.has_value() || mSuppressionDeadline.value() < deadline) {
-                    mSuppressionDeadline = deadline;
-                }
-                moved = true;
-                break;
-            }
+    const std::optional<size_t> lastMoved = findLastMoved();
+    const bool moved = lastMoved.has_value();
+    if (moved) {
+        // Enable suppression for the duration of the window.
+        int64_t deadline = mFifo.timestamp[lastMoved.value()] + mOptions.windowDuration;
+        if (!mSuppressionDeadline.has_value() || mSuppressionDeadline.value() < deadline) {
+            mSuppressionDeadline = deadline;
         }
     }
 
@@ -94,7 +89,7 @@ void StillnessDetector::discardOld(int64_t timestamp) {
     // Remove any events from the queue that are older than the window. If there were any such
     // events we consider the window full.
     const int64_t windowStart = timestamp - mOptions.windowDuration;
-    while (!mFifo.empty() && mFifo.front().timestamp <= windowStart) {
+    while (!mFifo.empty() && mFifo.timestamp[mFifo.begin] <= windowStart) {
         mWindowFull = true;
         mFifo.pop_front();
     }
@@ -105,23 +100,74 @@ void StillnessDetector::discardOld(int64_t timestamp) {
     }
 }
 
-bool StillnessDetector::areNear(const Pose3f& pose1, const Pose3f& pose2) const {
-    // Check translation. We use the L1 norm to reduce computational load on expense of accuracy.
-    // The L1 norm is an upper bound for the actual (L2) norm, so this approach will err on the side
-    // of "not near".
-    if ((pose1.translation() - pose2.translation()).lpNorm<1>() > mOptions.translationalThreshold) {
-        return false;
+std::optional<size_t> StillnessDetector::findLastMoved() const {
+    if (mFifo.empty()) return std::nullopt;
+
+    // Poses are compared to the latest one a block at a time, from the most recent block, so
+    // that motion in the recent poses stops the search early.
+    // A pose is near the latest one if:
+    // - the L1 norm of the translation difference is within the threshold. The L1 norm is an
+    //   upper bound for the actual (L2) norm, so this errs on the side of "not near".
+    // - the angle x between the rotations is within the threshold, i.e.
+    //   cos(x/2) >= cos(threshold/2), with cos(x/2) the dot product of the quaternions.
+    constexpr size_t kBlockSize = 16;
+    using Block = Eigen::Array<float, Eigen::Dynamic, 1, 0, kBlockSize, 1>;
+    using Map = Eigen::Map<const Eigen::ArrayXf>;
+    const size_t last = mFifo.size() - 1;
+    for (size_t end = last; end > mFifo.begin; ) {
+        const size_t start = end - std::min(end - mFifo.begin, kBlockSize);
+        const Eigen::Index n = end - start;
+        const Block l1 = (Map(&mFifo.tx[start], n) - mFifo.tx[last]).abs()
+                + (Map(&mFifo.ty[start], n) - mFifo.ty[last]).abs()
+                + (Map(&mFifo.tz[start], n) - mFifo.tz[last]).abs();
+        const Block dot = Map(&mFifo.qw[start], n) * mFifo.qw[last]
+                + Map(&mFifo.qx[start], n) * mFifo.qx[last]
+                + Map(&mFifo.qy[start], n) * mFifo.qy[last]
+                + Map(&mFifo.qz[start], n) * mFifo.qz[last];
+        if ((l1 > mOptions.translationalThreshold).any()
+                || (dot < mCosHalfRotationalThreshold).any()) {
+            for (Eigen::Index i = n - 1; i >= 0; --i) {
+                if (l1[i] > mOptions.translationalThreshold
+                        || dot[i] < mCosHalfRotationalThreshold) {
+                    return start + i;
+                }
+            }
+        }
+        end = start;
     }
+    return std::nullopt;
+}
+
+void StillnessDetector::Window::push_back(int64_t t, const Pose3f& pose) {
+    timestamp.push_back(t);
+    tx.push_back(pose.translation().x());
+    ty.push_back(pose.translation().y());
+    tz.push_back(pose.translation().z());
+    qw.push_back(pose.rotation().w());
+    qx.push_back(pose.rotation().x());
+    qy.push_back(pose.rotation().y());
+    qz.push_back(pose.rotation().z());
+}
 
-    // Check orientation.
-    // The angle x between the quaternions is greater than that threshold iff
-    // cos(x/2) < cos(threshold/2).
-    // cos(x/2) can be efficiently calculated as the dot product of both quaternions.
-    if (pose1.rotation().dot(pose2.rotation()) < mCosHalfRotationalThreshold) {
-        return false;
+void StillnessDetector::Window::pop_front() {
+    ++begin;
+    // Reclaim the space of the discarded entries once they are the majority, so that the
+    // arrays stay about twice the window size without moving data on each sample.
+    if (begin * 2 >= size() && begin >= 64) {
+        for (auto* v : {&tx, &ty, &tz, &qw, &qx, &qy, &qz}) {
+            v->erase(v->begin(), v->begin() + begin);
+        }
+        timestamp.erase(timestamp.begin(), timestamp.begin() + begin);
+        begin = 0;
     }
+}
 
-    return true;
+void StillnessDetector::Window::clear() {
+    timestamp.clear();
+    for (auto* v : {&tx, &ty, &tz, &qw, &qx, &qy, &qz}) {
+        v->clear();
+    }
+    begin = 0;
 }
 
 }  // namespace media
@@ -15,7 +15,8 @@
  */
 #pragma once
 
-#include <deque>
+#include <optional>
+#include <vector>
 
 #include <media/Pose.h>
 
@@ -83,15 +84,27 @@ class StillnessDetector {
     /** Return the stillness state from the previous call to calculate() */
     bool getPreviousState() const;
   private:
-    struct TimestampedPose {
-        int64_t timestamp;
-        Pose3f pose;
+    /**
+     * The window, stored as one contiguous array per component so that the poses can be
+     * compared to the latest one with vector operations. Entries [mBegin, size()) are valid.
+     */
+    struct Window {
+        std::vector<int64_t> timestamp;
+        std::vector<float> tx, ty, tz;      // translation
+        std::vector<float> qw, qx, qy, qz;  // rotation
+        size_t begin = 0;
+
+        size_t size() const { return timestamp.size(); }
+        bool empty() const { return begin == size(); }
+        void push_back(int64_t timestamp, const Pose3f& pose);
+        void pop_front();
+        void clear();
     };
 
     const Options mOptions;
     // Precalculated cos(mOptions.rotationalThreshold / 2)
     const float mCosHalfRotationalThreshold;
-    std::deque<TimestampedPose> mFifo;
+    Window mFifo;
     bool mWindowFull = false;
     bool mCurrentState = true;
     bool mPreviousState = true;
@@ -101,7 +114,8 @@ class StillnessDetector {
     // stillness, we may toggle back and forth at a rate faster than the window side.
     std::optional<int64_t> mSuppressionDeadline;
 
-    bool areNear(const Pose3f& pose1, const Pose3f& pose2) const;
+    // Returns the index of the most recent pose not near the latest one, or nullopt.
+    std::optional<size_t> findLastMoved() const;
     void discardOld(int64_t timestamp);
 };
 
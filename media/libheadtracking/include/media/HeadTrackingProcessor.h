@@ -59,6 +59,19 @@ class HeadTrackingProcessor {
     virtual void setWorldToHeadPose(int64_t timestamp, const Pose3f& worldToHead,
                                     const Twist3f& headTwist) = 0;
 
+    /** A world-to-head pose sample, as given to setWorldToHeadPose(). */
+    struct HeadSample {
+        int64_t timestamp;
+        Pose3f worldToHead;
+        Twist3f headTwist;
+    };
+
+    /**
+     * Sets several world-to-head samples at once, in timestamp order, e.g. the events read
+     * together from a sensor FIFO. Same result as calling setWorldToHeadPose() for each sample.
+     */
+    virtual void setWorldToHeadPoses(const HeadSample* samples, size_t count) = 0;
+
     /**
      * Sets the world-to-screen pose.
      */
@@ -104,6 +117,13 @@ class HeadTrackingProcessor {
      */
     virtual void setPosePredictorType(PosePredictorType type) = 0;
 
+    /**
+     * Sets how far past the head sensor samples the head pose is predicted, in the same units as
+     * the timestamps. Applies to the samples set from now on. Ideally the time between a sample
+     * and the presentation of the audio rendered with it.
+     */
+    virtual void setPredictionDuration(float predictionDuration) = 0;
+
     /**
      * Dump HeadTrackingProcessor parameters under caller lock.
      */
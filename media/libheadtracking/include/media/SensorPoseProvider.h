@@ -62,10 +62,30 @@ class SensorPoseProvider {
      */
     class Listener {
       public:
+        /** An event, as given to onPose(). */
+        struct PoseSample {
+            int64_t timestamp;
+            int32_t handle;
+            Pose3f pose;
+            std::optional<Twist3f> twist;
+            bool isNewReference;
+        };
+
         virtual ~Listener() = default;
 
         virtual void onPose(int64_t timestamp, int32_t handle, const Pose3f& pose,
                             const std::optional<Twist3f>& twist, bool isNewReference) = 0;
+
+        /**
+         * Events read together from the sensor queue, in order. The default implementation
+         * calls onPose() for each of them.
+         */
+        virtual void onPoses(const PoseSample* samples, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                onPose(samples[i].timestamp, samples[i].handle, samples[i].pose,
+                       samples[i].twist, samples[i].isNewReference);
+            }
+        }
     };
 
     /**
@@ -34,6 +34,7 @@ AudioStreamOutSink::AudioStreamOutSink(sp<StreamOutHalInterface> stream) :
 
 AudioStreamOutSink::~AudioStreamOutSink()
 {
+    unregisterMelQueue();
     mStream.clear();
 }
 
@@ -51,7 +52,8 @@ ssize_t AudioStreamOutSink::negotiate(const NBAIO_Format offers[], size_t numOff
                 audio_channel_count_from_out_mask(config.channel_mask), config.format);
         mFrameSize = Format_frameSize(mFormat);
 
-        // update format for MEL computation
+        // update format for MEL computation. The MelProcessingWorker queue, if any, was
+        // registered by startMelComputation(), not on the thread writing to the sink.
         auto processor = mMelProcessor.load();
         if (processor) {
             processor->updateAudioFormat(config.sample_rate,
@@ -71,11 +73,7 @@ ssize_t AudioStreamOutSink::write(const void *buffer, size_t count)
     size_t written;
     status_t ret = mStream->write(buffer, count * mFrameSize, &written);
     if (ret == OK && written > 0) {
-        // Send to MelProcessor for sound dose measurement.
-        auto processor = mMelProcessor.load();
-        if (processor) {
-            processor->process(buffer, written);
-        }
+        processMel(buffer, written / mFrameSize);
 
         written /= mFrameSize;
         mFramesWritten += written;
@@ -88,6 +86,56 @@ ssize_t AudioStreamOutSink::write(const void *buffer, size_t count)
     }
 }
 
+ssize_t AudioStreamOutSink::obtainWriteRegion(size_t count, void **buffer)
+{
+    if (!mNegotiated) {
+        return NEGOTIATE;
+    }
+    if (mWriteRegionUnsupported) {
+        return INVALID_OPERATION;
+    }
+    size_t size = 0;
+    status_t ret = mStream->beginWrite(count * mFrameSize, buffer, &size);
+    if (ret == INVALID_OPERATION) {
+        mWriteRegionUnsupported = true;
+    }
+    if (ret != OK) {
+        return ret;
+    }
+    mWriteRegion = *buffer;
+    return size / mFrameSize;
+}
+
+ssize_t AudioStreamOutSink::commitWriteRegion(size_t count)
+{
+    ALOG_ASSERT(mWriteRegion != nullptr || count == 0);
+    if (count > 0) {
+        // the HAL does not modify the data, it can be read before it is consumed
+        processMel(mWriteRegion, count);
+    }
+    mWriteRegion = nullptr;
+    size_t written = 0;
+    status_t ret = mStream->commitWrite(count * mFrameSize, &written);
+    if (ret != OK) {
+        ALOGE("Error while committing data to HAL: %d", ret);
+        return ret;
+    }
+    written /= mFrameSize;
+    mFramesWritten += written;
+    return written;
+}
+
+void AudioStreamOutSink::processMel(const void *buffer, size_t frames)
+{
+    // Send to MelProcessor for sound dose measurement, either directly or through the
+    // MelProcessingWorker queue when the computation is offloaded.
+    if (auto queue = mMelQueue.load(); queue) {
+        queue->push(buffer, frames);
+    } else if (auto processor = mMelProcessor.load(); processor) {
+        processor->process(buffer, frames * mFrameSize);
+    }
+}
+
 status_t AudioStreamOutSink::getTimestamp(ExtendedTimestamp &timestamp)
 {
     uint64_t position64;
@@ -112,7 +160,7 @@ void AudioStreamOutSink::startMelComputation(const sp<audio_utils::MelProcessor>
                                      mFormat.mFormat);
         processor->resume();
     }
-
+    registerMelQueue();
 }
 
 void AudioStreamOutSink::stopMelComputation()
@@ -122,6 +170,41 @@ void AudioStreamOutSink::stopMelComputation()
         ALOGV("%s pause mel computation for device %d", __func__, melProcessor->getDeviceId());
         melProcessor->pause();
     }
+    unregisterMelQueue();
+}
+
+void AudioStreamOutSink::registerMelQueue()
+{
+    if (!MelProcessingWorker::isEnabled()) {
+        return;
+    }
+    uint32_t sampleRate = mFormat.mSampleRate;
+    size_t frameSize = mFrameSize;
+    if (!Format_isValid(mFormat)) {
+        // not negotiated yet, the queue is registered now rather than from negotiate()
+        audio_config_base_t config = AUDIO_CONFIG_BASE_INITIALIZER;
+        if (mStream->getAudioProperties(&config) != OK) {
+            return;
+        }
+        sampleRate = config.sample_rate;
+        frameSize = audio_bytes_per_frame(
+                audio_channel_count_from_out_mask(config.channel_mask), config.format);
+    }
+    // the new queue replaces the previous one before it is unregistered, so write() always
+    // finds a queue and never waits for the worker
+    const sp<MelProcessingWorker::MelQueue> previous = mMelQueue.load();
+    mMelQueue.store(MelProcessingWorker::getInstance().registerProcessor(
+            mMelProcessor.load(), frameSize, sampleRate));
+    MelProcessingWorker::getInstance().unregisterQueue(previous);
+}
+
+void AudioStreamOutSink::unregisterMelQueue()
+{
+    auto queue = mMelQueue.load();
+    if (queue != nullptr) {
+        mMelQueue.store(nullptr);
+        MelProcessingWorker::getInstance().unregisterQueue(queue);
+    }
 }
 
 }   // namespace android
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "MelProcessingWorker"
+//#define LOG_NDEBUG 0
+
+#include <algorithm>
+#include <chrono>
+
+#include <cutils/properties.h>
+#include <media/nbaio/MelProcessingWorker.h>
+#include <pthread.h>
+#include <utils/AndroidThreads.h>
+#include <utils/Log.h>
+#include <utils/ThreadDefs.h>
+
+namespace android {
+
+namespace {
+
+// Amount of audio each queue can hold before the sink starts dropping frames.
+constexpr uint32_t kQueueDurationMs = 200;
+// Interval at which the worker drains the queues while at least one is registered.
+constexpr std::chrono::milliseconds kDrainPeriod{40};
+
+}  // namespace
+
+MelProcessingWorker::MelQueue::MelQueue(const sp<audio_utils::MelProcessor>& processor,
+                                        size_t frameSize, uint32_t sampleRate)
+    : mProcessor(processor),
+      mFrameSize(frameSize),
+      mBuffer(new uint8_t[frameSize * std::max(1u, sampleRate * kQueueDurationMs / 1000)]),
+      mFifo(std::max(1u, sampleRate * kQueueDurationMs / 1000), frameSize, mBuffer.get(),
+            true /*throttlesWriter*/),
+      mWriter(mFifo),
+      mReader(mFifo, true /*throttlesWriter*/)
+{
+}
+
+void MelProcessingWorker::MelQueue::push(const void* buffer, size_t frameCount)
+{
+    // a NULL timeout makes the write non-blocking
+    const ssize_t written = mWriter.write(buffer, frameCount, nullptr /*timeout*/);
+    const size_t dropped = written < 0 ? frameCount : frameCount - written;
+    if (dropped > 0) {
+        mDroppedFrames.fetch_add(dropped, std::memory_order_relaxed);
+    }
+}
+
+void MelProcessingWorker::MelQueue::drain()
+{
+    for (;;) {
+        audio_utils_iovec iovec[2];
+        const ssize_t available = mReader.obtain(iovec, mFifo.capacity(), nullptr /*timeout*/);
+        if (available <= 0) {
+            return;
+        }
+        for (const auto& part : iovec) {
+            if (part.mLength > 0) {
+                mProcessor->process(mBuffer.get() + part.mOffset * mFrameSize,
+                                    part.mLength * mFrameSize);
+            }
+        }
+        mReader.release(available);
+    }
+}
+
+// static
+bool MelProcessingWorker::isEnabled()
+{
+    static const bool enabled = property_get_bool("audio.sounddose.offload_mel", false);
+    return enabled;
+}
+
+// static
+MelProcessingWorker& MelProcessingWorker::getInstance()
+{
+    static MelProcessingWorker worker;
+    return worker;
+}
+
+MelProcessingWorker::MelProcessingWorker()
+    : mThread(&MelProcessingWorker::threadLoop, this)
+{
+    pthread_setname_np(mThread.native_handle(), "MelWorker");
+}
+
+MelProcessingWorker::~MelProcessingWorker()
+{
+    {
+        std::lock_guard _l(mLock);
+        mExitPending = true;
+    }
+    mCondition.notify_one();
+    mThread.join();
+}
+
+sp<MelProcessingWorker::MelQueue> MelProcessingWorker::registerProcessor(
+        const sp<audio_utils::MelProcessor>& processor, size_t frameSize, uint32_t sampleRate)
+{
+    if (processor == nullptr || frameSize == 0 || sampleRate == 0) {
+        return nullptr;
+    }
+    sp<MelQueue> queue = sp<MelQueue>::make(processor, frameSize, sampleRate);
+    {
+        std::lock_guard _l(mLock);
+        mQueues.push_back(queue);
+    }
+    ALOGV("%s queue for device %d", __func__, processor->getDeviceId());
+    mCondition.notify_one();
+    return queue;
+}
+
+void MelProcessingWorker::unregisterQueue(const sp<MelQueue>& queue)
+{
+    if (queue == nullptr) {
+        return;
+    }
+    std::unique_lock l(mLock);
+    mQueues.erase(std::remove(mQueues.begin(), mQueues.end(), queue), mQueues.end());
+    // the processor must not be fed anymore once this returns
+    mDrainCondition.wait(l, [&] { return mDrainingQueue != queue.get(); });
+    // a sink thread may still hold a reference obtained before the queue was unregistered,
+    // keep the queue alive until the worker can release it
+    mRetiredQueues.push_back(queue);
+    ALOGW_IF(queue->droppedFrames() > 0, "%s queue dropped %zu frames",
+             __func__, queue->droppedFrames());
+}
+
+void MelProcessingWorker::releaseRetiredQueues_l()
+{
+    // only release queues not referenced anymore by a sink so that the memory is freed here
+    mRetiredQueues.erase(std::remove_if(mRetiredQueues.begin(), mRetiredQueues.end(),
+            [](const sp<MelQueue>& queue) { return queue->getStrongCount() == 1; }),
+            mRetiredQueues.end());
+}
+
+void MelProcessingWorker::threadLoop()
+{
+    androidSetThreadPriority(0, ANDROID_PRIORITY_BACKGROUND);
+
+    std::unique_lock l(mLock);
+    while (!mExitPending) {
+        releaseRetiredQueues_l();
+        if (mQueues.empty()) {
+            if (mRetiredQueues.empty()) {
+                mCondition.wait(l);
+            } else {
+                mCondition.wait_for(l, kDrainPeriod);
+            }
+            continue;
+        }
+        const std::vector<sp<MelQueue>> queues = mQueues;
+        for (const auto& queue : queues) {
+            if (std::find(mQueues.begin(), mQueues.end(), queue) == mQueues.end()) {
+                continue;  // unregistered while draining the previous queues
+            }
+            // process outside of the lock so that sinks can register without waiting
+            mDrainingQueue = queue.get();
+            l.unlock();
+            queue->drain();
+            l.lock();
+            mDrainingQueue = nullptr;
+            mDrainCondition.notify_all();
+        }
+        mCondition.wait_for(l, kDrainPeriod);
+    }
+}
+
+}   // namespace android
@@ -18,6 +18,7 @@
 #define ANDROID_AUDIO_STREAM_OUT_SINK_H
 
 #include <audio_utils/MelProcessor.h>
+#include <media/nbaio/MelProcessingWorker.h>
 #include <media/nbaio/NBAIO.h>
 #include <mediautils/Synchronization.h>
 
@@ -50,6 +51,16 @@ public:
 
     // NBAIO_Sink end
 
+    // Zero-copy alternative to write(): obtains a contiguous region of the HAL queue in which
+    // up to count frames can be rendered. Returns the number of frames of the region, which is
+    // 0 if the queue is full, or a negative status if the stream does not support it.
+    // The region must be handed back with commitWriteRegion() before any other write.
+    ssize_t obtainWriteRegion(size_t count, void **buffer);
+
+    // Sends the first count frames of the region obtained by obtainWriteRegion() to the HAL.
+    // Committing 0 frames releases the region. Returns the number of frames written.
+    ssize_t commitWriteRegion(size_t count);
+
     void startMelComputation(const sp<audio_utils::MelProcessor>& processor);
 
     void stopMelComputation();
@@ -62,6 +73,18 @@ private:
     sp<StreamOutHalInterface> mStream;
     size_t              mStreamBufferSizeBytes; // as reported by get_buffer_size()
     mediautils::atomic_sp<audio_utils::MelProcessor> mMelProcessor;
+    // non-null when the MEL computation is offloaded to the MelProcessingWorker
+    mediautils::atomic_sp<MelProcessingWorker::MelQueue> mMelQueue;
+    // region obtained by obtainWriteRegion(), not committed yet
+    void*               mWriteRegion = nullptr;
+    // set once the stream reported it does not support zero-copy writes
+    bool                mWriteRegionUnsupported = false;
+
+    // feeds the frames written to the HAL to the MEL computation
+    void processMel(const void *buffer, size_t frames);
+
+    void registerMelQueue();
+    void unregisterMelQueue();
 };
 
 }   // namespace android
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_MEL_PROCESSING_WORKER_H
+#define ANDROID_MEL_PROCESSING_WORKER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <audio_utils/fifo.h>
+#include <audio_utils/MelProcessor.h>
+#include <utils/RefBase.h>
+
+namespace android {
+
+/**
+ * Shared low priority thread computing the momentary exposure level of output streams.
+ *
+ * When enabled, a sink does not call MelProcessor::process() on its (possibly real-time) thread
+ * but copies the written data into a per-stream MelQueue instead. The worker periodically drains
+ * all registered queues and feeds the data to the corresponding MelProcessor.
+ */
+class MelProcessingWorker {
+public:
+    // Single writer, single reader FIFO between a sink and the worker.
+    class MelQueue : public RefBase {
+    public:
+        MelQueue(const sp<audio_utils::MelProcessor>& processor, size_t frameSize,
+                 uint32_t sampleRate);
+
+        // Copies up to frameCount frames into the queue without blocking. Frames which do
+        // not fit are dropped and accounted for in droppedFrames().
+        // Safe to call from a real-time thread.
+        void push(const void* buffer, size_t frameCount);
+
+        // Feeds all the queued frames to the MEL processor. Called by the worker thread only.
+        void drain();
+
+        size_t droppedFrames() const { return mDroppedFrames.load(std::memory_order_relaxed); }
+
+    private:
+        const sp<audio_utils::MelProcessor> mProcessor;
+        const size_t mFrameSize;
+        std::unique_ptr<uint8_t[]> mBuffer;
+        audio_utils_fifo mFifo;
+        audio_utils_fifo_writer mWriter;
+        audio_utils_fifo_reader mReader;
+        std::atomic<size_t> mDroppedFrames{0};
+    };
+
+    // Returns true when offloading of the MEL computation is enabled on this device.
+    static bool isEnabled();
+
+    static MelProcessingWorker& getInstance();
+
+    ~MelProcessingWorker();
+
+    // Creates a queue feeding processor and starts draining it.
+    sp<MelQueue> registerProcessor(const sp<audio_utils::MelProcessor>& processor,
+                                   size_t frameSize, uint32_t sampleRate);
+
+    // Stops draining queue. Data still pending in the queue is discarded.
+    // Waits for the worker to be done with the queue if it is being drained, so the MEL processor
+    // is not called anymore on return. The queue itself is freed by the worker thread once it is
+    // not referenced anymore by the caller. Must not be called from a real-time thread.
+    void unregisterQueue(const sp<MelQueue>& queue);
+
+private:
+    MelProcessingWorker();
+
+    void threadLoop();
+    void releaseRetiredQueues_l();
+
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::condition_variable mDrainCondition;   // signaled when a queue has been drained
+    std::vector<sp<MelQueue>> mQueues;         // guarded by mLock
+    std::vector<sp<MelQueue>> mRetiredQueues;  // guarded by mLock
+    MelQueue* mDrainingQueue = nullptr;        // guarded by mLock
+    bool mExitPending = false;                 // guarded by mLock
+    std::thread mThread;
+};
+
+}   // namespace android
+
+#endif  // ANDROID_MEL_PROCESSING_WORKER_H
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "MelProcessingWorker_test"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/nbaio/MelProcessingWorker.h>
+
+namespace android {
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr uint32_t kChannelCount = 2;
+constexpr size_t kFrameSize = kChannelCount * sizeof(float);
+constexpr std::chrono::seconds kReleaseTimeout{2};
+
+class MelCallback : public audio_utils::MelProcessor::MelCallback {
+public:
+    void onNewMelValues(const std::vector<float>& /*mels*/, size_t /*offset*/, size_t /*length*/,
+                        audio_port_handle_t /*deviceId*/, bool /*attenuated*/) const override {}
+    void onMomentaryExposure(float /*currentMel*/, audio_port_handle_t /*deviceId*/) const override
+    {}
+};
+
+// Records the thread on which the processor, only referenced by its queue, is destroyed.
+class ReleaseTracker {
+public:
+    void onDestroyed() {
+        std::lock_guard _l(mLock);
+        mThreadId = std::this_thread::get_id();
+        mDestroyed = true;
+        mCondition.notify_all();
+    }
+
+    bool waitForDestruction(std::thread::id* threadId) {
+        std::unique_lock l(mLock);
+        if (!mCondition.wait_for(l, kReleaseTimeout, [this] { return mDestroyed; })) {
+            return false;
+        }
+        *threadId = mThreadId;
+        return true;
+    }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    bool mDestroyed = false;
+    std::thread::id mThreadId;
+};
+
+class TrackedMelProcessor : public audio_utils::MelProcessor {
+public:
+    TrackedMelProcessor(const sp<MelCallback>& callback, ReleaseTracker* tracker)
+        : MelProcessor(kSampleRate, kChannelCount, AUDIO_FORMAT_PCM_FLOAT, callback,
+                       AUDIO_PORT_HANDLE_NONE, 100.f /*rs2Value*/),
+          mTracker(tracker) {}
+
+    ~TrackedMelProcessor() override { mTracker->onDestroyed(); }
+
+private:
+    ReleaseTracker* const mTracker;
+};
+
+class MelProcessingWorkerTest : public ::testing::Test {
+protected:
+    MelProcessingWorker& mWorker = MelProcessingWorker::getInstance();
+    const sp<MelCallback> mCallback = sp<MelCallback>::make();
+    const std::vector<float> mBuffer = std::vector<float>(kSampleRate / 100 * kChannelCount, 0.5f);
+};
+
+TEST_F(MelProcessingWorkerTest, QueueIsFreedByWorker) {
+    ReleaseTracker tracker;
+    sp<MelProcessingWorker::MelQueue> queue = mWorker.registerProcessor(
+            sp<TrackedMelProcessor>::make(mCallback, &tracker), kFrameSize, kSampleRate);
+    ASSERT_NE(nullptr, queue);
+    queue->push(mBuffer.data(), mBuffer.size() / kChannelCount);
+
+    // reference still held by a sink thread at the time the queue is unregistered
+    sp<MelProcessingWorker::MelQueue> sinkReference = queue;
+    mWorker.unregisterQueue(queue);
+    queue.clear();
+    sinkReference->push(mBuffer.data(), mBuffer.size() / kChannelCount);
+    sinkReference.clear();
+
+    std::thread::id threadId;
+    ASSERT_TRUE(tracker.waitForDestruction(&threadId));
+    EXPECT_NE(std::this_thread::get_id(), threadId);
+}
+
+TEST_F(MelProcessingWorkerTest, UnregisterWhileDraining) {
+    constexpr int kIterations = 50;
+    for (int i = 0; i < kIterations; ++i) {
+        ReleaseTracker tracker;
+        sp<MelProcessingWorker::MelQueue> queue = mWorker.registerProcessor(
+                sp<TrackedMelProcessor>::make(mCallback, &tracker), kFrameSize, kSampleRate);
+        ASSERT_NE(nullptr, queue);
+
+        std::atomic<bool> stop = false;
+        std::thread sink([&] {
+            while (!stop) {
+                queue->push(mBuffer.data(), mBuffer.size() / kChannelCount);
+                std::this_thread::yield();
+            }
+        });
+        // let the worker pick up the queue before unregistering it
+        std::this_thread::sleep_for(std::chrono::milliseconds(i % 10 * 5));
+        mWorker.unregisterQueue(queue);
+        stop = true;
+        sink.join();
+        queue.clear();
+
+        std::thread::id threadId;
+        ASSERT_TRUE(tracker.waitForDestruction(&threadId));
+        EXPECT_NE(std::this_thread::get_id(), threadId);
+    }
+}
+
+}  // namespace
+}  // namespace android
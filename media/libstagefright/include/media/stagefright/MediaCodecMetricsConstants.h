@@ -25,6 +25,8 @@ namespace android {
 // NB: These are not yet exposed as public Java API constants.
 inline constexpr char kCodecPixelFormat[] =
         "android.media.mediacodec.pixel-format";
+inline constexpr char kCodecBytesCopied[] =
+        "android.media.mediacodec.bytes-copied";
 
 }
 
@@ -46,6 +46,9 @@ namespace {
 
     static constexpr nsecs_t kEvictGranularityNs = 1000000000; // 1 sec
     static constexpr nsecs_t kEvictDurationNs = 5000000000; // 5 secs
+
+    // Polls of the invalidator which may skip acks when the pool is busy.
+    static constexpr uint32_t kMaxInvalidateAckMisses = 16;
 }
 
 // Buffer structure in bufferpool process
@@ -171,7 +174,7 @@ ConnectionId Accessor::Impl::ConnectionIdGenerator::getConnectionId() {
 
 Accessor::Impl::Impl(
         const std::shared_ptr<BufferPoolAllocator> &allocator)
-        : mAllocator(allocator), mScheduleEvictTs(0) {}
+        : mAllocator(allocator), mScheduleEvictTs(0), mInvalidateAckMisses(0) {}
 
 Accessor::Impl::~Impl() {
 }
@@ -294,7 +297,19 @@ void Accessor::Impl::handleInvalidateAck() {
     std::map<ConnectionId, const sp<IObserver>> observers;
     uint32_t invalidationId;
     {
-        std::lock_guard<std::mutex> lock(mBufferPool.mMutex);
+        // The invalidator polls pending invalidations. Do not make allocations
+        // and transfers wait for it; retry on the next poll instead. Under
+        // steady contention, wait for the lock so that acks are not starved.
+        std::unique_lock<std::mutex> lock(mBufferPool.mMutex, std::defer_lock);
+        if (mInvalidateAckMisses < kMaxInvalidateAckMisses) {
+            if (!lock.try_lock()) {
+                ++mInvalidateAckMisses;
+                return;
+            }
+        } else {
+            lock.lock();
+        }
+        mInvalidateAckMisses = 0;
         mBufferPool.processStatusMessages();
         mBufferPool.mInvalidation.onHandleAck(&observers, &invalidationId);
     }
@@ -477,7 +492,7 @@ bool Accessor::Impl::BufferPool::handleReleaseBuffer(
                 iter->second->mTransactionCount == 0) {
             if (!iter->second->mInvalidated) {
                 mStats.onBufferUnused(iter->second->mAllocSize);
-                mFreeBuffers.insert(bufferId);
+                addFreeBuffer(bufferId, iter->second->mConfig);
             } else {
                 mStats.onBufferUnused(iter->second->mAllocSize);
                 mStats.onBufferEvicted(iter->second->mAllocSize);
@@ -566,7 +581,7 @@ bool Accessor::Impl::BufferPool::handleTransferResult(const BufferStatusMessage
                 && bufferIter->second->mTransactionCount == 0) {
                 if (!bufferIter->second->mInvalidated) {
                     mStats.onBufferUnused(bufferIter->second->mAllocSize);
-                    mFreeBuffers.insert(message.bufferId);
+                    addFreeBuffer(message.bufferId, bufferIter->second->mConfig);
                 } else {
                     mStats.onBufferUnused(bufferIter->second->mAllocSize);
                     mStats.onBufferEvicted(bufferIter->second->mAllocSize);
@@ -586,7 +601,7 @@ bool Accessor::Impl::BufferPool::handleTransferResult(const BufferStatusMessage
 }
 
 void Accessor::Impl::BufferPool::processStatusMessages() {
-    std::vector<BufferStatusMessage> messages;
+    std::vector<BufferStatusMessage> &messages = mMessages;
     mObserver.getBufferStatusChanges(messages);
     mTimestampUs = getTimestampNow();
     for (BufferStatusMessage& message: messages) {
@@ -645,7 +660,7 @@ bool Accessor::Impl::BufferPool::handleClose(ConnectionId connectionId) {
                     // TODO: handle freebuffer insert fail
                     if (!bufferIter->second->mInvalidated) {
                         mStats.onBufferUnused(bufferIter->second->mAllocSize);
-                        mFreeBuffers.insert(bufferId);
+                        addFreeBuffer(bufferId, bufferIter->second->mConfig);
                     } else {
                         mStats.onBufferUnused(bufferIter->second->mAllocSize);
                         mStats.onBufferEvicted(bufferIter->second->mAllocSize);
@@ -675,7 +690,7 @@ bool Accessor::Impl::BufferPool::handleClose(ConnectionId connectionId) {
                     // TODO: handle freebuffer insert fail
                     if (!bufferIter->second->mInvalidated) {
                         mStats.onBufferUnused(bufferIter->second->mAllocSize);
-                        mFreeBuffers.insert(bufferId);
+                        addFreeBuffer(bufferId, bufferIter->second->mConfig);
                     } else {
                         mStats.onBufferUnused(bufferIter->second->mAllocSize);
                         mStats.onBufferEvicted(bufferIter->second->mAllocSize);
@@ -695,18 +710,22 @@ bool Accessor::Impl::BufferPool::getFreeBuffer(
         const std::shared_ptr<BufferPoolAllocator> &allocator,
         const std::vector<uint8_t> &params, BufferId *pId,
         const native_handle_t** handle) {
-    auto bufferIt = mFreeBuffers.begin();
-    for (;bufferIt != mFreeBuffers.end(); ++bufferIt) {
-        BufferId bufferId = *bufferIt;
-        if (allocator->compatible(params, mBuffers[bufferId]->mConfig)) {
-            break;
-        }
-    }
-    if (bufferIt != mFreeBuffers.end()) {
-        BufferId id = *bufferIt;
-        mFreeBuffers.erase(bufferIt);
-        mStats.onBufferRecycled(mBuffers[id]->mAllocSize);
-        *handle = mBuffers[id]->handle();
+    // Buffers of the same configuration are all compatible or not; check
+    // each configuration once, and recycle its oldest buffer.
+    for (auto configIt = mFreeBuffersByConfig.begin();
+            configIt != mFreeBuffersByConfig.end(); ++configIt) {
+        if (!allocator->compatible(params, configIt->first)) {
+            continue;
+        }
+        BufferId id = *configIt->second.begin();
+        auto bufferIt = mBuffers.find(id);
+        if (bufferIt == mBuffers.end()) {
+            ALOGW("bufferpool2 inconsistent!");
+            return false;
+        }
+        eraseFreeBuffer(mFreeBuffers.find(id), bufferIt->second->mConfig);
+        mStats.onBufferRecycled(bufferIt->second->mAllocSize);
+        *handle = bufferIt->second->handle();
         *pId = id;
         ALOGV("recycle a buffer %u %p", id, *handle);
         return true;
@@ -714,6 +733,24 @@ bool Accessor::Impl::BufferPool::getFreeBuffer(
     return false;
 }
 
+void Accessor::Impl::BufferPool::addFreeBuffer(
+        BufferId bufferId, const std::vector<uint8_t> &config) {
+    mFreeBuffers.insert(bufferId);
+    mFreeBuffersByConfig[config].insert(bufferId);
+}
+
+std::set<BufferId>::iterator Accessor::Impl::BufferPool::eraseFreeBuffer(
+        std::set<BufferId>::iterator freeIt, const std::vector<uint8_t> &config) {
+    auto configIt = mFreeBuffersByConfig.find(config);
+    if (configIt != mFreeBuffersByConfig.end()) {
+        configIt->second.erase(*freeIt);
+        if (configIt->second.empty()) {
+            mFreeBuffersByConfig.erase(configIt);
+        }
+    }
+    return mFreeBuffers.erase(freeIt);
+}
+
 ResultStatus Accessor::Impl::BufferPool::addNewBuffer(
         const std::shared_ptr<BufferPoolAllocation> &alloc,
         const size_t allocSize,
@@ -766,8 +803,8 @@ void Accessor::Impl::BufferPool::cleanUp(bool clearCache) {
             if (it != mBuffers.end() &&
                     it->second->mOwnerCount == 0 && it->second->mTransactionCount == 0) {
                 mStats.onBufferEvicted(it->second->mAllocSize);
+                freeIt = eraseFreeBuffer(freeIt, it->second->mConfig);
                 mBuffers.erase(it);
-                freeIt = mFreeBuffers.erase(freeIt);
             } else {
                 ++freeIt;
                 ALOGW("bufferpool2 inconsistent!");
@@ -785,8 +822,8 @@ void Accessor::Impl::BufferPool::invalidate(
             if (it != mBuffers.end() &&
                 it->second->mOwnerCount == 0 && it->second->mTransactionCount == 0) {
                 mStats.onBufferEvicted(it->second->mAllocSize);
+                freeIt = eraseFreeBuffer(freeIt, it->second->mConfig);
                 mBuffers.erase(it);
-                freeIt = mFreeBuffers.erase(freeIt);
                 continue;
             } else {
                 ALOGW("bufferpool2 inconsistent!");
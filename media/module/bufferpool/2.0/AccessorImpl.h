@@ -90,6 +90,10 @@ private:
 
     nsecs_t mScheduleEvictTs;
 
+    // Consecutive polls of the invalidator which found the pool locked.
+    // Only accessed from the invalidator thread.
+    uint32_t mInvalidateAckMisses;
+
     /**
      * Buffer pool implementation.
      *
@@ -122,7 +126,12 @@ private:
 
         std::map<BufferId, std::unique_ptr<InternalBuffer>> mBuffers;
         std::set<BufferId> mFreeBuffers;
+        // Free buffers indexed by their allocation parameters, so that
+        // recycling checks compatibility once per distinct configuration.
+        std::map<std::vector<uint8_t>, std::set<BufferId>> mFreeBuffersByConfig;
         std::set<ConnectionId> mConnectionIds;
+        // Buffer status messages being processed, kept to avoid reallocation.
+        std::vector<BufferStatusMessage> mMessages;
 
         struct Invalidation {
             static std::atomic<std::uint32_t> sInvSeqId;
@@ -253,6 +262,17 @@ private:
             return mValid;
         }
 
+        /** Makes a buffer available for recycling. */
+        void addFreeBuffer(BufferId bufferId, const std::vector<uint8_t> &config);
+
+        /**
+         * Removes a buffer from the free buffers.
+         *
+         * @return the iterator following the removed buffer in mFreeBuffers.
+         */
+        std::set<BufferId>::iterator eraseFreeBuffer(
+                std::set<BufferId>::iterator freeIt, const std::vector<uint8_t> &config);
+
         void invalidate(bool needsAck, BufferId from, BufferId to,
                         const std::shared_ptr<Accessor::Impl> &impl);
 
@@ -86,19 +86,23 @@ ResultStatus BufferStatusObserver::close(ConnectionId id) {
 
 void BufferStatusObserver::getBufferStatusChanges(std::vector<BufferStatusMessage> &messages) {
     for (auto it = mBufferStatusQueues.begin(); it != mBufferStatusQueues.end(); ++it) {
-        BufferStatusMessage message;
         size_t avail = it->second->availableToRead();
-        while (avail > 0) {
-            if (!it->second->read(&message, 1)) {
-                // Since avaliable # of reads are already confirmed,
-                // this should not happen.
-                // TODO: error handling (spurious client?)
-                ALOGW("FMQ message cannot be read from %lld", (long long)it->first);
-                return;
-            }
-            message.connectionId = it->first;
-            messages.push_back(message);
-            --avail;
+        if (avail == 0) {
+            continue;
+        }
+        // Read all the pending messages of a connection at once.
+        size_t base = messages.size();
+        messages.resize(base + avail);
+        if (!it->second->read(&messages[base], avail)) {
+            // Since avaliable # of reads are already confirmed,
+            // this should not happen.
+            // TODO: error handling (spurious client?)
+            ALOGW("FMQ message cannot be read from %lld", (long long)it->first);
+            messages.resize(base);
+            return;
+        }
+        for (size_t i = base; i < messages.size(); ++i) {
+            messages[i].connectionId = it->first;
         }
     }
 }
@@ -127,28 +131,42 @@ bool BufferStatusChannel::needsSync() {
     return false;
 }
 
+bool BufferStatusChannel::writeReleases(
+        ConnectionId connectionId, size_t numReleases,
+        std::list<BufferId> &pending, std::list<BufferId> &posted,
+        const BufferStatusMessage *message) {
+    mMessages.clear();
+    auto it = pending.begin();
+    for (size_t i = 0; i < numReleases; ++i, ++it) {
+        BufferStatusMessage &release = mMessages.emplace_back();
+        release.newStatus = BufferStatus::NOT_USED;
+        release.bufferId = *it;
+        release.connectionId = connectionId;
+    }
+    if (message) {
+        mMessages.push_back(*message);
+    }
+    if (mMessages.empty()) {
+        return true;
+    }
+    if (!mBufferStatusQueue->write(mMessages.data(), mMessages.size())) {
+        // Since avaliable # of writes are already confirmed,
+        // this should not happen.
+        // TODO: error handing?
+        ALOGW("FMQ message cannot be sent from %lld", (long long)connectionId);
+        return false;
+    }
+    posted.splice(posted.end(), pending, pending.begin(), it);
+    return true;
+}
+
 void BufferStatusChannel::postBufferRelease(
         ConnectionId connectionId,
         std::list<BufferId> &pending, std::list<BufferId> &posted) {
     if (mValid && pending.size() > 0) {
         size_t avail = mBufferStatusQueue->availableToWrite();
         avail = std::min(avail, pending.size());
-        BufferStatusMessage message;
-        for (size_t i = 0 ; i < avail; ++i) {
-            BufferId id = pending.front();
-            message.newStatus = BufferStatus::NOT_USED;
-            message.bufferId = id;
-            message.connectionId = connectionId;
-            if (!mBufferStatusQueue->write(&message, 1)) {
-                // Since avaliable # of writes are already confirmed,
-                // this should not happen.
-                // TODO: error handing?
-                ALOGW("FMQ message cannot be sent from %lld", (long long)connectionId);
-                return;
-            }
-            pending.pop_front();
-            posted.push_back(id);
-        }
+        (void)writeReleases(connectionId, avail, pending, posted, nullptr);
     }
 }
 
@@ -183,22 +201,7 @@ bool BufferStatusChannel::postBufferStatusMessage(
         size_t avail = mBufferStatusQueue->availableToWrite();
         size_t numPending = pending.size();
         if (avail >= numPending + 1) {
-            BufferStatusMessage release, message;
-            for (size_t i = 0; i < numPending; ++i) {
-                BufferId id = pending.front();
-                release.newStatus = BufferStatus::NOT_USED;
-                release.bufferId = id;
-                release.connectionId = connectionId;
-                if (!mBufferStatusQueue->write(&release, 1)) {
-                    // Since avaliable # of writes are already confirmed,
-                    // this should not happen.
-                    // TODO: error handling?
-                    ALOGW("FMQ message cannot be sent from %lld", (long long)connectionId);
-                    return false;
-                }
-                pending.pop_front();
-                posted.push_back(id);
-            }
+            BufferStatusMessage message;
             message.transactionId = transactionId;
             message.bufferId = bufferId;
             message.newStatus = status;
@@ -206,13 +209,7 @@ bool BufferStatusChannel::postBufferStatusMessage(
             message.targetConnectionId = targetId;
             // TODO : timesatamp
             message.timestampUs = 0;
-            if (!mBufferStatusQueue->write(&message, 1)) {
-                // Since avaliable # of writes are already confirmed,
-                // this should not happen.
-                ALOGW("FMQ message cannot be sent from %lld", (long long)connectionId);
-                return false;
-            }
-            return true;
+            return writeReleases(connectionId, numPending, pending, posted, &message);
         }
     }
     return false;
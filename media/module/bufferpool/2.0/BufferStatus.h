@@ -88,6 +88,18 @@ class BufferStatusChannel {
 private:
     bool mValid;
     std::unique_ptr<BufferStatusQueue> mBufferStatusQueue;
+    // Messages written to the FMQ at once. Clients post messages under a lock.
+    std::vector<BufferStatusMessage> mMessages;
+
+    /**
+     * Writes the release messages of the first numReleases pending buffers,
+     * followed by message if it is not null, to the FMQ in a single write.
+     * The released buffers are moved from pending to posted on success.
+     */
+    bool writeReleases(
+            ConnectionId connectionId, size_t numReleases,
+            std::list<BufferId> &pending, std::list<BufferId> &posted,
+            const BufferStatusMessage *message);
 
 public:
     /**
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <list>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <bufferpool/ClientManager.h>
+#include <cutils/native_handle.h>
+
+#include "Accessor.h"
+#include "BufferStatus.h"
+#include "allocator.h"
+
+using android::sp;
+using android::hardware::media::bufferpool::BufferPoolData;
+using android::hardware::media::bufferpool::V2_0::ResultStatus;
+using android::hardware::media::bufferpool::V2_0::implementation::Accessor;
+using android::hardware::media::bufferpool::V2_0::implementation::BufferId;
+using android::hardware::media::bufferpool::V2_0::implementation::BufferStatusChannel;
+using android::hardware::media::bufferpool::V2_0::implementation::ClientManager;
+using android::hardware::media::bufferpool::V2_0::implementation::Connection;
+using android::hardware::media::bufferpool::V2_0::implementation::ConnectionId;
+using android::hardware::media::bufferpool::V2_0::implementation::InvalidationDescriptor;
+using android::hardware::media::bufferpool::V2_0::implementation::StatusDescriptor;
+
+namespace {
+
+// Buffers held at a time by a connection, as a decoder holding a few frames.
+constexpr size_t kBuffersInFlight = 4;
+
+// Allocates kBuffersInFlight buffers from the connection, then releases them.
+// Returns false on allocation failure.
+bool allocateAndRelease(const sp<ClientManager> &manager, ConnectionId connectionId,
+                        const std::vector<uint8_t> &params) {
+    std::vector<std::shared_ptr<BufferPoolData>> buffers;
+    buffers.reserve(kBuffersInFlight);
+    for (size_t i = 0; i < kBuffersInFlight; ++i) {
+        native_handle_t *handle = nullptr;
+        std::shared_ptr<BufferPoolData> buffer;
+        if (manager->allocate(connectionId, params, &handle, &buffer) != ResultStatus::OK) {
+            return false;
+        }
+        if (handle) {
+            native_handle_close(handle);
+            native_handle_delete(handle);
+        }
+        buffers.push_back(std::move(buffer));
+    }
+    return true;
+}
+
+// Each thread allocates from its own buffer pool, as concurrent codec instances do.
+void BM_AllocateSeparatePools(benchmark::State &state) {
+    sp<ClientManager> manager = ClientManager::getInstance();
+    std::shared_ptr<BufferPoolAllocator> allocator = std::make_shared<TestBufferPoolAllocator>();
+    std::vector<uint8_t> params;
+    getTestAllocatorParams(&params);
+    ConnectionId connectionId;
+    if (manager->create(allocator, &connectionId) != ResultStatus::OK) {
+        state.SkipWithError("cannot create buffer pool");
+        return;
+    }
+    for (auto _ : state) {
+        if (!allocateAndRelease(manager, connectionId, params)) {
+            state.SkipWithError("allocation failed");
+            break;
+        }
+    }
+    manager->close(connectionId);
+    state.SetItemsProcessed(state.iterations() * kBuffersInFlight);
+}
+
+// All the threads allocate from the same buffer pool connection. The pool is
+// created once and kept for the lifetime of the benchmark process.
+void BM_AllocateSharedPool(benchmark::State &state) {
+    static const sp<ClientManager> sManager = ClientManager::getInstance();
+    static const ConnectionId sConnectionId = [] {
+        ConnectionId connectionId = -1;
+        (void)sManager->create(std::make_shared<TestBufferPoolAllocator>(), &connectionId);
+        return connectionId;
+    }();
+    std::vector<uint8_t> params;
+    getTestAllocatorParams(&params);
+    for (auto _ : state) {
+        if (!allocateAndRelease(sManager, sConnectionId, params)) {
+            state.SkipWithError("allocation failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kBuffersInFlight);
+}
+
+// Each thread allocates from its own connection to the same buffer pool, as the
+// clients of a pool shared by several processes. The connections contend on the
+// pool, which also processes the releases each of them posts to its status FMQ.
+void BM_AllocateSharedPoolConnections(benchmark::State &state) {
+    static const sp<Accessor> sAccessor =
+            new Accessor(std::make_shared<TestBufferPoolAllocator>());
+    if (!sAccessor->isValid()) {
+        state.SkipWithError("cannot create buffer pool");
+        return;
+    }
+    sp<Connection> connection;
+    ConnectionId connectionId;
+    uint32_t msgId;
+    const StatusDescriptor *statusDesc;
+    const InvalidationDescriptor *invDesc;
+    if (sAccessor->connect(nullptr, true /* local */, &connection, &connectionId, &msgId,
+                           &statusDesc, &invDesc) != ResultStatus::OK) {
+        state.SkipWithError("cannot connect to buffer pool");
+        return;
+    }
+    BufferStatusChannel statusChannel(*statusDesc);
+    std::vector<uint8_t> params;
+    getTestAllocatorParams(&params);
+    std::list<BufferId> releasing;
+    std::list<BufferId> released;
+    for (auto _ : state) {
+        for (size_t i = 0; i < kBuffersInFlight; ++i) {
+            BufferId bufferId;
+            const native_handle_t *handle = nullptr;
+            if (sAccessor->allocate(connectionId, params, &bufferId, &handle)
+                    != ResultStatus::OK) {
+                state.SkipWithError("allocation failed");
+                break;
+            }
+            releasing.push_back(bufferId);
+        }
+        statusChannel.postBufferRelease(connectionId, releasing, released);
+        released.clear();
+    }
+    sAccessor->close(connectionId);
+    state.SetItemsProcessed(state.iterations() * kBuffersInFlight);
+}
+
+}  // namespace
+
+BENCHMARK(BM_AllocateSeparatePools)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_AllocateSharedPool)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_AllocateSharedPoolConnections)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -20,6 +20,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <cstring>
 #include <iomanip>
 #include <limits>
 #include <mutex>
@@ -27,6 +28,7 @@
 #include <string>
 #include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 #include <binder/MemoryBase.h>
 #include <binder/MemoryHeapBase.h>
@@ -452,6 +454,103 @@ class IndirectAllocator {
     const std::shared_ptr<Allocator> mAllocator;
 };
 
+// An allocator which keeps up to MaxCachedBlocks deallocated blocks of at most MaxBlockSize
+// bytes, and hands them out again (zeroed) for requests of the same rounded size instead of
+// going back to the underlying allocator. Cached blocks are still accounted for by the
+// underlying allocator until they are evicted, so this does not bypass its policies.
+// Meant to be used per client, as a recycled block may still be mapped by its previous user.
+template <typename Allocator, size_t MaxCachedBlocks, size_t MaxBlockSize>
+class CachingAllocator {
+  public:
+    static_assert(MaxCachedBlocks > 0);
+
+    static size_t alignment() { return Allocator::alignment(); }
+
+    explicit CachingAllocator(Allocator allocator) : mAllocator(std::move(allocator)) {}
+
+    // Default construct the underlying allocator
+    CachingAllocator() = default;
+
+    ~CachingAllocator() { flush(); }
+
+    template <typename T>
+    AllocationType allocate(T&& request) {
+        static_assert(std::is_base_of_v<BasicAllocRequest, std::decay_t<T>>);
+        const size_t size = shared_allocator_impl::roundup(request.size, alignment());
+        // Most recently cached blocks are at the back.
+        for (auto it = mCache.rbegin(); it != mCache.rend(); ++it) {
+            if ((*it)->size() == size) {
+                AllocationType allocation = std::move(*it);
+                mCache.erase(std::next(it).base());
+                std::memset(allocation->unsecurePointer(), 0, allocation->size());
+                mHits++;
+                return allocation;
+            }
+        }
+        mMisses++;
+        if (mCache.empty()) {
+            return mAllocator.allocate(std::forward<T>(request));
+        }
+        AllocationType allocation = mAllocator.allocate(request);
+        if (allocation == nullptr) {
+            // The cached blocks may be what exhausts the underlying pools.
+            flush();
+            allocation = mAllocator.allocate(std::forward<T>(request));
+        }
+        return allocation;
+    }
+
+    void deallocate(const AllocationType& allocation) {
+        if (!allocation) return;
+        if (allocation->size() > MaxBlockSize) {
+            mAllocator.deallocate(allocation);
+            return;
+        }
+        if (mCache.size() == MaxCachedBlocks) {
+            mAllocator.deallocate(mCache.front());
+            mCache.erase(mCache.begin());
+        }
+        mCache.push_back(allocation);
+    }
+
+    // Returns the cached blocks to the underlying allocator.
+    void flush() {
+        for (const auto& allocation : mCache) {
+            mAllocator.deallocate(allocation);
+        }
+        mCache.clear();
+    }
+
+    template <typename Enable = void>
+    auto deallocate_all()
+            -> std::enable_if_t<shared_allocator_impl::has_deallocate_all<Allocator>, Enable> {
+        mCache.clear();
+        mAllocator.deallocate_all();
+    }
+
+    template <typename Enable = bool>
+    auto owns(const AllocationType& allocation) const
+            -> std::enable_if_t<shared_allocator_impl::has_owns<Allocator>, Enable> {
+        return mAllocator.owns(allocation);
+    }
+
+    template <typename Enable = std::string>
+    auto dump() const -> std::enable_if_t<shared_allocator_impl::has_dump<Allocator>, Enable> {
+        std::ostringstream dump;
+        dump << "Cached blocks: " << mCache.size() << " hits: " << mHits
+             << " misses: " << mMisses << "\n";
+        return dump.str() + mAllocator.dump();
+    }
+
+    size_t cachedBlocks() const { return mCache.size(); }
+
+  private:
+    [[no_unique_address]] Allocator mAllocator;
+    std::vector<AllocationType> mCache;
+    size_t mHits = 0;
+    size_t mMisses = 0;
+};
+
 // Stateless. This allocator allocates full page-aligned MemoryHeapBases (backed by
 // a shared memory mapped anonymous file) as allocations.
 class MemoryHeapBaseAllocator {
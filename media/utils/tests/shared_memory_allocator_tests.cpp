@@ -356,3 +356,47 @@ TEST(shared_memory_allocator_tests, scoped_allocator) {
     ScopedAllocator<ValidateForwarding<0>> forwarding{};
     EXPECT_EQ(forwarding.dump(), ValidateForwarding<0>::dump_string);
 }
+
+TEST(shared_memory_allocator_tests, caching_allocator) {
+    const auto underlying_allocator =
+            std::make_shared<SnoopingAllocator<MemoryHeapBaseAllocator>>("Allocator");
+    const auto& allocations = underlying_allocator->getAllocations();
+    {
+        CachingAllocator<IndirectAllocator<SnoopingAllocator<MemoryHeapBaseAllocator>>, 2,
+                         kMaxPageSize * 2>
+                allocator{IndirectAllocator{underlying_allocator}};
+        const auto first_memory = allocator.allocate(NamedAllocRequest{{kPageSize}, "first"});
+        validate_block(first_memory);
+        const auto heap_id = first_memory->getMemory()->getHeapID();
+        allocator.deallocate(first_memory);
+        // Cached blocks are still held from the underlying allocator
+        EXPECT_EQ(allocator.cachedBlocks(), 1ul);
+        EXPECT_EQ(allocations.size(), 1ul);
+        // A different size is not served from the cache
+        const auto other_memory = allocator.allocate(NamedAllocRequest{{kPageSize * 2}, "other"});
+        EXPECT_EQ(allocations.size(), 2ul);
+        // The same size reuses the cached block, zeroed
+        const auto reused_memory = allocator.allocate(NamedAllocRequest{{kPageSize}, "reused"});
+        ASSERT_TRUE(reused_memory != nullptr);
+        EXPECT_EQ(reused_memory->getMemory()->getHeapID(), heap_id);
+        EXPECT_EQ(*(static_cast<char*>(reused_memory->unsecurePointer()) + 100), 0);
+        EXPECT_EQ(allocator.cachedBlocks(), 0ul);
+        EXPECT_EQ(allocations.size(), 2ul);
+        // Blocks larger than the limit are not cached
+        const auto large_memory =
+                allocator.allocate(NamedAllocRequest{{kMaxPageSize * 3}, "large"});
+        allocator.deallocate(large_memory);
+        EXPECT_EQ(allocator.cachedBlocks(), 0ul);
+        EXPECT_EQ(allocations.size(), 2ul);
+        // Blocks beyond the cache size are returned to the underlying allocator
+        const auto third_memory = allocator.allocate(NamedAllocRequest{{kPageSize}, "third"});
+        allocator.deallocate(reused_memory);
+        allocator.deallocate(other_memory);
+        allocator.deallocate(third_memory);
+        EXPECT_EQ(allocator.cachedBlocks(), 2ul);
+        EXPECT_EQ(allocations.size(), 2ul);
+        EXPECT_FALSE(underlying_allocator->owns(reused_memory));
+    }
+    // Destruction returns the cached blocks
+    EXPECT_EQ(allocations.size(), 0ul);
+}
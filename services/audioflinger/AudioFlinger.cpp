@@ -194,6 +194,7 @@ BINDER_METHOD_ENTRY(getSoundDoseInterface) \
 BINDER_METHOD_ENTRY(getAudioPolicyConfig) \
 BINDER_METHOD_ENTRY(getAudioMixPort) \
 BINDER_METHOD_ENTRY(resetReferencesForTest) \
+BINDER_METHOD_ENTRY(setStreamVolumes) \
 
 // singleton for Binder Method Statistics for IAudioFlinger
 static auto& getIAudioFlingerStatistics() {
@@ -1565,6 +1566,65 @@ status_t AudioFlinger::setStreamVolume(audio_stream_type_t stream, float value,
     return NO_ERROR;
 }
 
+status_t AudioFlinger::setStreamVolumes(const std::vector<media::StreamVolumeInfo>& volumes)
+{
+    // check calling permissions
+    if (!settingsAllowed()) {
+        return PERMISSION_DENIED;
+    }
+
+    struct LegacyVolume {
+        audio_stream_type_t stream;
+        float value;
+        audio_io_handle_t output;
+    };
+    // An invalid entry fails on its own, as separate setStreamVolume() calls would,
+    // the other volumes of the batch are still applied.
+    status_t status = NO_ERROR;
+    std::vector<LegacyVolume> legacyVolumes;
+    legacyVolumes.reserve(volumes.size());
+    for (const auto& volume : volumes) {
+        const ConversionResult<audio_stream_type_t> stream =
+                aidl2legacy_AudioStreamType_audio_stream_type_t(volume.stream);
+        const ConversionResult<audio_io_handle_t> output =
+                aidl2legacy_int32_t_audio_io_handle_t(volume.output);
+        if (!stream.ok() || !output.ok()) {
+            ALOGW("%s: invalid stream %d or output %d", __func__,
+                    static_cast<int>(volume.stream), volume.output);
+            status = BAD_VALUE;
+            continue;
+        }
+        const LegacyVolume legacy = {
+            .stream = stream.value(),
+            .value = volume.volume,
+            .output = output.value(),
+        };
+        if (checkStreamType(legacy.stream) != NO_ERROR
+                || legacy.output == AUDIO_IO_HANDLE_NONE) {
+            ALOGW("%s: invalid stream %d or output %d", __func__, legacy.stream, legacy.output);
+            status = BAD_VALUE;
+            continue;
+        }
+        LOG_ALWAYS_FATAL_IF(legacy.stream == AUDIO_STREAM_PATCH && legacy.value != 1.0f,
+                            "AUDIO_STREAM_PATCH must have full scale volume");
+        legacyVolumes.push_back(legacy);
+    }
+
+    // Apply all volumes under a single acquisition of the AudioFlinger lock so that a routing
+    // decision is observed atomically by the playback threads.
+    audio_utils::lock_guard lock(mutex());
+    for (const auto& legacy : legacyVolumes) {
+        sp<VolumeInterface> volumeInterface = getVolumeInterface_l(legacy.output);
+        if (volumeInterface == nullptr) {
+            ALOGW("%s: no output %d for stream %d", __func__, legacy.output, legacy.stream);
+            status = BAD_VALUE;
+            continue;
+        }
+        volumeInterface->setStreamVolume(legacy.stream, legacy.value);
+    }
+    return status;
+}
+
 status_t AudioFlinger::setRequestedLatencyMode(
         audio_io_handle_t output, audio_latency_mode_t mode) {
     if (output == AUDIO_IO_HANDLE_NONE) {
@@ -1817,6 +1877,20 @@ status_t AudioFlinger::setParameters(audio_io_handle_t ioHandle, const String8&
 
     // AUDIO_IO_HANDLE_NONE means the parameters are global to the audio hardware interface
     if (ioHandle == AUDIO_IO_HANDLE_NONE) {
+        AudioParameter param = AudioParameter(filteredKeyValuePairs);
+        // Screen state, rotation and BT SCO / suspend states are notifications which can be
+        // sent in bursts, do not hold the locks below while the HAL applies them. The HAL
+        // device applies them in order, and before any later synchronous request or patch.
+        bool applyAsync = param.size() > 0;
+        for (size_t i = 0; applyAsync && i < param.size(); i++) {
+            String8 key;
+            applyAsync = param.getAt(i, key) == NO_ERROR &&
+                    (key == AudioParameter::keyScreenState ||
+                     key == AudioParameter::keyScreenRotation ||
+                     key == AudioParameter::keyBtSco ||
+                     key == AudioParameter::keyBtA2dpSuspended ||
+                     key == AudioParameter::keyBtLeSuspended);
+        }
         audio_utils::lock_guard _l(mutex());
         // result will remain NO_INIT if no audio device is present
         status_t final_result = NO_INIT;
@@ -1825,7 +1899,9 @@ status_t AudioFlinger::setParameters(audio_io_handle_t ioHandle, const String8&
             mHardwareStatus = AUDIO_HW_SET_PARAMETER;
             for (size_t i = 0; i < mAudioHwDevs.size(); i++) {
                 sp<DeviceHalInterface> dev = mAudioHwDevs.valueAt(i)->hwDevice();
-                status_t result = dev->setParameters(filteredKeyValuePairs);
+                status_t result = applyAsync ?
+                        dev->setParametersAsync(filteredKeyValuePairs, nullptr /*callback*/) :
+                        dev->setParameters(filteredKeyValuePairs);
                 // return success if at least one audio device accepts the parameters as not all
                 // HALs are requested to support all parameters. If no audio device supports the
                 // requested parameters, the last error is reported.
@@ -1836,7 +1912,6 @@ status_t AudioFlinger::setParameters(audio_io_handle_t ioHandle, const String8&
             mHardwareStatus = AUDIO_HW_IDLE;
         }
         // disable AEC and NS if the device is a BT SCO headset supporting those pre processings
-        AudioParameter param = AudioParameter(filteredKeyValuePairs);
         String8 value;
         if (param.get(String8(AudioParameter::keyBtNrec), value) == NO_ERROR) {
             bool btNrecIsOff = (value == AudioParameter::valueOff);
@@ -5013,6 +5088,7 @@ status_t AudioFlinger::onTransactWrapper(TransactionCode code,
     // make sure transactions reserved to AudioPolicyManager do not come from other processes
     switch (code) {
         case TransactionCode::SET_STREAM_VOLUME:
+        case TransactionCode::SET_STREAM_VOLUMES:
         case TransactionCode::SET_STREAM_MUTE:
         case TransactionCode::OPEN_OUTPUT:
         case TransactionCode::OPEN_DUPLICATE_OUTPUT:
@@ -93,6 +93,8 @@ private:
 
     status_t setStreamVolume(audio_stream_type_t stream, float value,
             audio_io_handle_t output) final EXCLUDES_AudioFlinger_Mutex;
+    status_t setStreamVolumes(const std::vector<media::StreamVolumeInfo>& volumes) final
+            EXCLUDES_AudioFlinger_Mutex;
     status_t setStreamMute(audio_stream_type_t stream, bool muted) final
             EXCLUDES_AudioFlinger_Mutex;
 
@@ -205,6 +205,8 @@ public:
             mRecord = other.mRecord;
             mThread = other.mThread;
             mIsEndpointPatch = other.mIsEndpointPatch;
+            mIsDirect = other.mIsDirect;
+            mFrameCount = other.mFrameCount;
         }
         Patch(Patch&& other) noexcept { swap(other); }
         Patch& operator=(Patch&& other) noexcept {
@@ -220,6 +222,8 @@ public:
             swap(mRecord, other.mRecord);
             swap(mThread, other.mThread);
             swap(mIsEndpointPatch, other.mIsEndpointPatch);
+            swap(mIsDirect, other.mIsDirect);
+            swap(mFrameCount, other.mFrameCount);
         }
 
         friend void swap(Patch& a, Patch& b) noexcept { a.swap(b); }
@@ -256,6 +260,11 @@ public:
 
         wp<IAfThreadBase> mThread;
         bool mIsEndpointPatch;
+        // software patch whose record and playback threads have the same configuration:
+        // the shared buffer is sized from the thread periods, see softwarePatchFrameCount().
+        bool mIsDirect = false;
+        // frame count of the buffer shared by the PatchRecord and the PatchTrack
+        size_t mFrameCount = 0;
     };
 
     /* List connected audio ports and their attributes */
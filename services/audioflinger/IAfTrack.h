@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include "OutputFanOut.h"  // OutputFanOut::Destination
+
 #include <android/media/BnAudioRecord.h>
 #include <android/media/BnAudioTrack.h>
 #include <audio_utils/mutex.h>
@@ -440,11 +442,18 @@ public:
             IAfPlaybackThread* playbackThread,
             IAfDuplicatingThread* sourceThread, uint32_t sampleRate,
             audio_format_t format, audio_channel_mask_t channelMask, size_t frameCount,
-            const AttributionSourceState& attributionSource);
+            const AttributionSourceState& attributionSource,
+            const sp<OutputFanOut>& fanOut = nullptr);
 
     virtual ssize_t write(void* data, uint32_t frames) = 0;
     virtual bool bufferQueueEmpty() const = 0;
     virtual bool isActive() const = 0;
+    /** Ring shared with the other OutputTracks of the DuplicatingThread, or nullptr. */
+    virtual const sp<OutputFanOut>& fanOut() const = 0;
+    /** Reader of fanOut(), written by the DuplicatingThread only. */
+    virtual OutputFanOut::Destination* fanOutDestination() = 0;
+    /** Frames written by the DuplicatingThread not yet consumed by the destination. */
+    virtual size_t framesPending() const = 0;
 
     /** Set the metadatas of the upstream tracks. Thread safe. */
     virtual void setMetadatas(const SourceMetadatas& metadatas) = 0;
@@ -542,6 +551,8 @@ public:
     virtual AudioBufferProvider::Buffer& sinkBuffer() = 0;
     virtual audioflinger::SynchronizedRecordState& synchronizedRecordState() = 0;
     virtual RecordBufferConverter* recordBufferConverter() const = 0;
+    // Replaces the converter, and returns the previous one, now owned by the caller.
+    virtual RecordBufferConverter* swapRecordBufferConverter(RecordBufferConverter* converter) = 0;
     virtual ResamplerBufferProvider* resamplerBufferProvider() const = 0;
 };
 
@@ -0,0 +1,379 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "AF::OutputFanOut"
+//#define LOG_NDEBUG 0
+
+#include "OutputFanOut.h"
+
+#include <audio_utils/roundup.h>
+#include <utils/Log.h>
+#include <utils/Timers.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace android {
+
+namespace {
+
+// Subtracts the time elapsed since startTime from the wait time left.
+void consumeWaitTime(nsecs_t startTime, uint32_t* waitTimeLeftMs)
+{
+    const uint32_t waitTimeMs = (uint32_t)ns2ms(systemTime() - startTime);
+    *waitTimeLeftMs = *waitTimeLeftMs >= waitTimeMs ? *waitTimeLeftMs - waitTimeMs : 0;
+}
+
+} // namespace
+
+OutputFanOut::OutputFanOut(size_t frameCount, size_t frameSize)
+    :   mFrameCount(roundup(frameCount)),
+        mFrameSize(frameSize),
+        mBuffer(new uint8_t[mFrameCount * mFrameSize]()),
+        mQueueFrameCount(kMaxQueuedRings * mFrameCount),
+        mQueue(new uint8_t[mQueueFrameCount * mFrameSize])
+{
+    for (auto* scratch : {&mDestinations, &mInSync, &mReady, &mStarting, &mStandby}) {
+        scratch->reserve(kMaxDestinations);
+    }
+}
+
+void OutputFanOut::addDestination(size_t frameCount)
+{
+    mDestinationCount.fetch_add(1);
+    frameCount = std::min(frameCount, mFrameCount);
+    size_t required = mRequiredFrames.load();
+    while (required < frameCount && !mRequiredFrames.compare_exchange_weak(required, frameCount)) {
+    }
+}
+
+ssize_t OutputFanOut::write(const std::vector<Destination*>& destinations, const void* data,
+        uint32_t frames, uint32_t waitTimeMs)
+{
+    ALOG_ASSERT(destinations.size() <= kMaxDestinations);
+    mDestinations.assign(destinations.begin(), destinations.end());
+    leaveIdle();
+    if (frames != 0) {
+        startDestinations();
+    }
+
+    mInSync.clear();
+    const int32_t rear = mRear.load(std::memory_order_relaxed);
+    const size_t requiredFrames = mRequiredFrames.load();
+    for (Destination* destination : mDestinations) {
+        if (!destination->isActive()) {
+            continue;
+        }
+        if (destination->bufferSizeInFrames() != requiredFrames) {
+            destination->setBufferSizeInFrames(requiredFrames);
+        }
+        if (destination->rear() != rear) {
+            catchUp(destination);
+        }
+        if (destination->isActive() && destination->rear() == rear) {
+            mInSync.push_back(destination);
+        }
+    }
+
+    // First write the queued data, then the new data.
+    mLimiting = nullptr;
+    uint32_t waitTimeLeftMs = waitTimeMs;
+    size_t written = 0;
+    if (writeQueued(&waitTimeLeftMs)) {
+        written = writeInSync(mInSync, data, frames, &waitTimeLeftMs);
+    }
+    // If we could not write all frames, queue them for next time.
+    if (written < frames && !mInSync.empty()
+            && queue((const uint8_t*)data + written * mFrameSize, frames - written)) {
+        written = frames;
+    }
+    checkStalled();
+
+    // Calling write() with a 0 length buffer means that no more data will be written.
+    if (frames == 0 && mQueuedFrames == 0) {
+        for (Destination* destination : mDestinations) {
+            if (destination->isActive()) {
+                destination->stop();
+            }
+        }
+    }
+    return written;  // number of frames consumed.
+}
+
+void OutputFanOut::leaveIdle()
+{
+    for (Destination* destination : mDestinations) {
+        if (destination->mJoined && !destination->isActive()
+                && (destination->front() == destination->rear() || !destination->isReading())) {
+            // the ring moves on without it, it rejoins at the rear on the next start
+            destination->mJoined = false;
+        }
+    }
+}
+
+void OutputFanOut::startDestinations()
+{
+    bool anyActive = false;
+    std::vector<Destination*>& starting = mStarting;
+    starting.clear();
+    for (Destination* destination : mDestinations) {
+        if (destination->isActive()) {
+            anyActive = true;
+            continue;
+        }
+        if (destination->mJoined) {
+            if (destination->mDropped) {
+                continue;  // wait for the destination thread to discard the frames
+            }
+        } else {
+            // the destination thread may still play the frames of the previous start
+            if (!destination->resync(mRear.load(std::memory_order_relaxed))) {
+                continue;
+            }
+            destination->mJoined = true;
+            destination->mDropped = false;
+            destination->mStalledWrites = 0;
+        }
+        starting.push_back(destination);
+    }
+    if (starting.empty()) {
+        return;
+    }
+    if (!anyActive) {
+        // the data queued when the destinations were stopped is stale
+        clearQueue();
+    }
+
+    std::vector<Destination*>& standby = mStandby;
+    standby.clear();
+    for (Destination* destination : starting) {
+        if (destination->inStandby()) {
+            standby.push_back(destination);
+        }
+    }
+    if (!anyActive && !standby.empty()) {
+        // preload one silent buffer to trigger the mixers on start().
+        // Not done for a late destination, so as not to interrupt the others.
+        uint32_t startThreshold = 0;
+        for (Destination* destination : starting) {
+            startThreshold = std::max(startThreshold, destination->startThresholdInFrames());
+        }
+        uint32_t noWaitMs = 0;
+        (void) writeInSync(starting, nullptr /* data */, startThreshold, &noWaitMs);
+    }
+    for (Destination* destination : starting) {
+        (void) destination->start();
+    }
+
+    // wait for the HAL streams to start before sending actual audio, so that playback
+    // starts on all the output streams together.
+    for (Destination* destination : standby) {
+        if (!destination->waitForStart()) {
+            ALOGW("%s(%d): timeout waiting for thread to exit standby",
+                    __func__, destination->id());
+            destination->stop();
+        }
+    }
+}
+
+void OutputFanOut::catchUp(Destination* destination)
+{
+    const int32_t rear = mRear.load(std::memory_order_relaxed);
+    // The frames missed are still in the ring as the writes wait for the joined destinations,
+    // never release frames written over.
+    if (!destination->mJoined || (uint32_t)(rear - destination->front()) > mFrameCount) {
+        drop(destination, "lapped by the ring");
+        return;
+    }
+    for (int i = 0; i < 2; i++) {  // at most two contiguous parts
+        const uint32_t missed = (uint32_t)(rear - destination->rear());
+        if (missed == 0) {
+            break;
+        }
+        size_t frameCount = missed;
+        void* raw = nullptr;
+        if (destination->obtainBuffer(&frameCount, &raw, 0 /* waitTimeMs */) != NO_ERROR
+                || frameCount == 0) {
+            break;
+        }
+        destination->releaseBuffer(frameCount);
+    }
+    ALOGV_IF(destination->rear() == rear, "%s(%d): back in sync", __func__, destination->id());
+}
+
+size_t OutputFanOut::ringSpace(Destination** slowest) const
+{
+    const int32_t rear = mRear.load(std::memory_order_relaxed);
+    size_t space = mFrameCount;
+    *slowest = nullptr;
+    for (Destination* destination : mDestinations) {
+        if (!destination->mJoined) {
+            continue;
+        }
+        const uint32_t unread = (uint32_t)(rear - destination->front());
+        const size_t room = unread < mFrameCount ? mFrameCount - unread : 0;
+        if (*slowest == nullptr || room < space) {
+            space = room;
+            *slowest = destination;
+        }
+    }
+    return space;
+}
+
+size_t OutputFanOut::writeInSync(const std::vector<Destination*>& destinations, const void* data,
+        size_t frames, uint32_t* waitTimeLeftMs)
+{
+    size_t written = 0;
+    bool waited = false;
+    std::vector<Destination*>& ready = mReady;
+    while (written < frames && !destinations.empty()) {
+        // do not write over the frames a destination behind the others has not read yet
+        Destination* slowest = nullptr;
+        size_t count = std::min(frames - written, ringSpace(&slowest));
+        if (count == 0) {
+            mLimiting = slowest;
+            if (waited || *waitTimeLeftMs == 0) {
+                break;
+            }
+            const nsecs_t startTime = systemTime();
+            slowest->waitForRead(*waitTimeLeftMs);
+            consumeWaitTime(startTime, waitTimeLeftMs);
+            waited = true;
+            continue;
+        }
+
+        // space available in every destination still in sync
+        const int32_t rear = mRear.load(std::memory_order_relaxed);
+        uint8_t* const raw = mBuffer.get() + (rear & (mFrameCount - 1)) * mFrameSize;
+        ready.clear();
+        for (Destination* destination : destinations) {
+            if (destination->mDropped || destination->rear() != rear) {
+                continue;  // fell behind earlier in this write
+            }
+            size_t frameCount = count;
+            void* trackRaw = nullptr;
+            const nsecs_t startTime = systemTime();
+            const status_t status = destination->obtainBuffer(&frameCount, &trackRaw,
+                    *waitTimeLeftMs);
+            consumeWaitTime(startTime, waitTimeLeftMs);
+            if (status != NO_ERROR || frameCount == 0) {
+                ALOGV("%s(%d): no more output buffers; status %d",
+                        __func__, destination->id(), status);
+                continue;  // this destination falls behind
+            }
+            if (trackRaw != raw) {
+                // all the destinations in sync share the ring position
+                destination->releaseBuffer(0);
+                drop(destination, "out of sync with the ring");
+                continue;
+            }
+            count = std::min(count, frameCount);
+            ready.push_back(destination);
+        }
+        if (ready.empty()) {
+            break;
+        }
+        if (data != nullptr) {
+            memcpy(raw, (const uint8_t*)data + written * mFrameSize, count * mFrameSize);
+        } else {
+            memset(raw, 0, count * mFrameSize);
+        }
+        for (Destination* destination : ready) {
+            destination->releaseBuffer(count);
+        }
+        mRear.fetch_add(count, std::memory_order_release);
+        mFramesWritten.fetch_add(count, std::memory_order_relaxed);
+        written += count;
+        waited = false;
+    }
+    return written;
+}
+
+void OutputFanOut::checkStalled()
+{
+    Destination* const slowest = mLimiting;
+    if (slowest == nullptr) {
+        return;
+    }
+    const int32_t front = slowest->front();
+    if (slowest->mStalledWrites == 0 || front != slowest->mStalledFront) {
+        slowest->mStalledFront = front;
+        slowest->mStalledWrites = 1;
+        return;
+    }
+    if (++slowest->mStalledWrites < kMaxStalledWrites) {
+        return;
+    }
+    slowest->mStalledWrites = 0;
+    if (!slowest->mDropped) {
+        drop(slowest, "stalled");
+    } else {
+        // The flush still pending makes its thread discard the frames on the next read,
+        // the others cannot wait any longer.
+        ALOGW("%s(%d): leaving the ring before the flush", __func__, slowest->id());
+        slowest->mJoined = false;
+    }
+}
+
+void OutputFanOut::drop(Destination* destination, const char* reason)
+{
+    if (destination->mDropped) {
+        return;
+    }
+    ALOGW("%s(%d): %s, dropping the frames not played", __func__, destination->id(), reason);
+    destination->mDropped = true;
+    destination->mStalledWrites = 0;
+    destination->flush();
+    if (destination->isActive()) {
+        destination->stop();
+    }
+}
+
+bool OutputFanOut::queue(const void* data, size_t frames)
+{
+    const size_t queued = mQueuedFrames.load(std::memory_order_relaxed);
+    if (queued + frames > mQueueFrameCount) {
+        ALOGW("%s: no more room to queue %zu frames", __func__, frames);
+        return false;
+    }
+    // the free space may wrap around the end of the queue
+    const size_t rear = (mQueueFront + queued) % mQueueFrameCount;
+    const size_t part1 = std::min(frames, mQueueFrameCount - rear);
+    memcpy(mQueue.get() + rear * mFrameSize, data, part1 * mFrameSize);
+    memcpy(mQueue.get(), (const uint8_t*)data + part1 * mFrameSize, (frames - part1) * mFrameSize);
+    mQueuedFrames.store(queued + frames, std::memory_order_relaxed);
+    return true;
+}
+
+bool OutputFanOut::writeQueued(uint32_t* waitTimeLeftMs)
+{
+    size_t queued = mQueuedFrames.load(std::memory_order_relaxed);
+    while (queued > 0) {
+        // the queued frames may wrap around the end of the queue
+        const size_t part = std::min(queued, mQueueFrameCount - mQueueFront);
+        const size_t written = writeInSync(mInSync, mQueue.get() + mQueueFront * mFrameSize,
+                part, waitTimeLeftMs);
+        mQueueFront = (mQueueFront + written) % mQueueFrameCount;
+        queued -= written;
+        mQueuedFrames.store(queued, std::memory_order_relaxed);
+        if (written < part) {
+            break;
+        }
+    }
+    return queued == 0;
+}
+
+} // namespace android
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <utils/Errors.h>
+#include <utils/RefBase.h>
+
+namespace android {
+
+/* The OutputFanOut is a ring buffer shared by the OutputTracks of a DuplicatingThread.
+ *
+ * Each OutputTrack keeps its own control block, so the destination threads mix it and
+ * report positions as before, but the audio data is written once for all the destinations:
+ * the rear of the member tracks advances together and the DuplicatingThread only writes
+ * into the space released by every destination in sync.
+ *
+ * A destination which cannot take data within the wait time falls behind and no longer
+ * limits the others. It catches up on the following writes by releasing the frames already
+ * in the ring, without copy. The ring is never written over frames a destination has not
+ * read yet: a destination which stops reading is flushed and stopped, and rejoins the
+ * others at the rear of the ring once its thread no longer plays it.
+ *
+ * Written by the DuplicatingThread threadLoop() only. framesWritten(), rear() and
+ * framesQueued() can be read from any thread.
+ */
+class OutputFanOut : public RefBase
+{
+public:
+    /* A reader of the ring, implemented by OutputTrack.
+     *
+     * front() and rear() are the positions in the control block of the track, rear() is
+     * only moved by the OutputFanOut.
+     */
+    class Destination {
+    public:
+        virtual ~Destination() = default;
+
+        virtual int id() const = 0;
+        virtual int32_t front() const = 0;
+        virtual int32_t rear() const = 0;
+
+        // Started by the OutputFanOut and not stopped since.
+        virtual bool isActive() const = 0;
+        virtual status_t start() = 0;
+        // The destination thread plays the frames released before stop().
+        virtual void stop() = 0;
+        // Discards the frames released and not read yet by the destination thread.
+        virtual void flush() = 0;
+        // Whether the destination thread may still read the buffer.
+        virtual bool isReading() const = 0;
+        // Moves both ends of the buffer to rear. Fails if the destination thread reads it.
+        virtual bool resync(int32_t rear) = 0;
+
+        virtual bool inStandby() const = 0;
+        // Returns false if the destination thread did not exit standby in time.
+        virtual bool waitForStart() = 0;
+
+        virtual size_t bufferSizeInFrames() const = 0;
+        virtual void setBufferSizeInFrames(size_t frameCount) = 0;
+        virtual uint32_t startThresholdInFrames() const = 0;
+
+        // Same as ClientProxy::obtainBuffer() and releaseBuffer(), a disabled track is
+        // restarted. A waitTimeMs of 0 does not block.
+        virtual status_t obtainBuffer(size_t* frameCount, void** raw, uint32_t waitTimeMs) = 0;
+        virtual void releaseBuffer(size_t frameCount) = 0;
+        // Waits for the destination thread to read frames, at most waitTimeMs.
+        virtual void waitForRead(uint32_t waitTimeMs) = 0;
+
+    private:
+        friend class OutputFanOut;
+
+        // The ring is not written over the frames from front() on.
+        bool mJoined = false;
+        // Flushed and stopped, rejoins the ring once its thread is done with it.
+        bool mDropped = false;
+        // Writes limited by this destination while its front did not move.
+        uint32_t mStalledWrites = 0;
+        int32_t mStalledFront = 0;
+    };
+
+    // Destinations sharing a ring, the threadLoop() scratch is allocated for that many.
+    static constexpr size_t kMaxDestinations = 8;
+
+    // frameCount is rounded up to a power of 2.
+    OutputFanOut(size_t frameCount, size_t frameSize);
+
+    void* buffer() const { return mBuffer.get(); }
+    size_t frameCount() const { return mFrameCount; }
+    size_t bufferSize() const { return mFrameCount * mFrameSize; }
+
+    // true if a destination requiring frameCount frames of buffering can share the ring.
+    bool canHost(size_t frameCount) const {
+        return frameCount <= mFrameCount && mDestinationCount.load() < kMaxDestinations;
+    }
+    // Called when a destination requiring frameCount frames of buffering joins the ring.
+    // The buffering of the member tracks is the largest requirement of the destinations,
+    // as all the members are filled together.
+    void addDestination(size_t frameCount);
+    // Called when a destination no longer writes to the ring.
+    void removeDestination() { mDestinationCount.fetch_sub(1); }
+
+    // Writes frames to all the destinations with a single copy into the ring.
+    // Same semantics as OutputTrack::write(): frames == 0 drains the data queued and then
+    // stops the destinations. Returns the number of frames consumed.
+    ssize_t write(const std::vector<Destination*>& destinations, const void* data,
+            uint32_t frames, uint32_t waitTimeMs);
+
+    int64_t framesWritten() const { return mFramesWritten.load(std::memory_order_relaxed); }
+    int32_t rear() const { return mRear.load(std::memory_order_acquire); }
+    size_t framesQueued() const { return mQueuedFrames.load(std::memory_order_relaxed); }
+
+private:
+    // Size of the queue in rings, about as many writes as the overflow buffers of OutputTrack.
+    static constexpr size_t kMaxQueuedRings = 5;
+    // Writes limited by a destination which does not read before it is dropped.
+    static constexpr uint32_t kMaxStalledWrites = 4;
+
+    // Stops following the destinations done reading.
+    void leaveIdle();
+    // Starts the inactive destinations, preloading silence if all of them are idle.
+    void startDestinations();
+    // Releases to a destination that fell behind the frames written since.
+    void catchUp(Destination* destination);
+    // Frames which can be written without overwriting data not read yet, and the
+    // destination with the least room.
+    size_t ringSpace(Destination** slowest) const;
+    // Writes frames of data, or silence if data is nullptr, to the destinations in sync
+    // with the ring. Returns the number of frames written.
+    size_t writeInSync(const std::vector<Destination*>& destinations, const void* data,
+            size_t frames, uint32_t* waitTimeLeftMs);
+    // Drops the destination limiting the writes if it does not read anymore.
+    void checkStalled();
+    // Flushes and stops a destination, it rejoins the ring on the next start.
+    void drop(Destination* destination, const char* reason);
+    // Returns false if the queue is full and the data is dropped.
+    bool queue(const void* data, size_t frames);
+    // Writes the queued frames first, returns false if some are left in the queue.
+    bool writeQueued(uint32_t* waitTimeLeftMs);
+    void clearQueue() { mQueueFront = 0; mQueuedFrames = 0; }
+
+    const size_t mFrameCount;
+    const size_t mFrameSize;
+    const std::unique_ptr<uint8_t[]> mBuffer;
+    std::atomic<size_t> mRequiredFrames = 0;         // set when a destination is added
+    std::atomic<size_t> mDestinationCount = 0;
+
+    std::atomic<int32_t> mRear = 0;                 // same wrapping as the control block rear
+    std::atomic<int64_t> mFramesWritten = 0;
+    // Data not yet written, a FIFO of mQueueFrameCount frames from mQueueFront,
+    // allocated up front as it is filled by the threadLoop().
+    const size_t mQueueFrameCount;
+    const std::unique_ptr<uint8_t[]> mQueue;
+    size_t mQueueFront = 0;
+    std::atomic<size_t> mQueuedFrames = 0;
+
+    // threadLoop() scratch, reserved for kMaxDestinations so that a write does not allocate
+    std::vector<Destination*> mDestinations;
+    std::vector<Destination*> mInSync;
+    std::vector<Destination*> mReady;
+    std::vector<Destination*> mStarting;
+    std::vector<Destination*> mStandby;
+    Destination* mLimiting = nullptr;               // set by writeInSync() if ring bound
+};
+
+} // namespace android
@@ -22,7 +22,9 @@
 #include "PatchPanel.h"
 #include "PatchCommandThread.h"
 
+#include <afutils/PatchFrameCount.h>
 #include <audio_utils/primitives.h>
+#include <cutils/properties.h>
 #include <media/AudioParameter.h>
 #include <media/AudioValidator.h>
 #include <media/DeviceDescriptorBase.h>
@@ -585,6 +587,12 @@ status_t PatchPanel::Patch::createConnections_l(const sp<IAfPatchPanel>& panel)
     const size_t playbackFrameCount = mPlayback.thread()->frameCount();
     const size_t recordFrameCount = mRecord.thread()->frameCount();
     size_t frameCount = 0;
+    mIsDirect = !usePassthruPatchRecord &&
+            property_get_bool("af.patch.direct", true /* default_value */) &&
+            audio_is_linear_pcm(format) &&
+            format == inputFormat &&
+            sampleRate == mRecord.thread()->sampleRate() &&
+            inChannelMask == mRecord.thread()->channelMask();
     if (usePassthruPatchRecord) {
         // PassthruPatchRecord producesBufferOnDemand, so use
         // maximum of playback and record thread framecounts
@@ -600,13 +608,8 @@ status_t PatchPanel::Patch::createConnections_l(const sp<IAfPatchPanel>& panel)
                                                  inputFlags,
                                                  source);
     } else {
-        // use a pseudo LCM between input and output framecount
-        int playbackShift = __builtin_ctz(playbackFrameCount);
-        int shift = __builtin_ctz(recordFrameCount);
-        if (playbackShift < shift) {
-            shift = playbackShift;
-        }
-        frameCount = (playbackFrameCount * recordFrameCount) >> shift;
+        frameCount = afutils::softwarePatchFrameCount(
+                playbackFrameCount, recordFrameCount, mIsDirect);
         ALOGV("%s() playframeCount %zu recordFrameCount %zu frameCount %zu",
             __func__, playbackFrameCount, recordFrameCount, frameCount);
 
@@ -626,6 +629,7 @@ status_t PatchPanel::Patch::createConnections_l(const sp<IAfPatchPanel>& panel)
     if (status != NO_ERROR) {
         return status;
     }
+    mFrameCount = frameCount;
 
     // create a special playback track to render to playback thread.
     // this track is given the same buffer as the PatchRecord buffer
@@ -764,6 +768,10 @@ String8 PatchPanel::Patch::dump(audio_patch_handle_t myHandle) const
     if (getLatencyMs(&latencyMs) == OK) {
         result.appendFormat("  latency: %.2lf ms", latencyMs);
     }
+    if (isSoftware()) {
+        result.appendFormat("  %s frameCount: %zu", mIsDirect ? "direct" : "converted",
+                mFrameCount);
+    }
     return result;
 }
 
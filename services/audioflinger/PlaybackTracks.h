@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include "OutputFanOut.h"
 #include "TrackBase.h"
 
 #include <android/os/BnExternalVibrationController.h>
@@ -423,7 +424,8 @@ public:
                                 audio_format_t format,
                                 audio_channel_mask_t channelMask,
                                 size_t frameCount,
-                                const AttributionSourceState& attributionSource);
+                                const AttributionSourceState& attributionSource,
+                                const sp<OutputFanOut>& fanOut);
     ~OutputTrack() override;
 
     status_t start(AudioSystem::sync_event_t event =
@@ -433,6 +435,9 @@ public:
     ssize_t write(void* data, uint32_t frames) final;
     bool bufferQueueEmpty() const final { return mBufferQueue.size() == 0; }
     bool isActive() const final { return mActive; }
+    const sp<OutputFanOut>& fanOut() const final { return mFanOut; }
+    OutputFanOut::Destination* fanOutDestination() final { return &mFanOutDestination; }
+    size_t framesPending() const final;
 
     void copyMetadataTo(MetadataInserter& backInserter) const final;
     /** Set the metadatas of the upstream tracks. Thread safe. */
@@ -450,6 +455,39 @@ public:
                             return timestamp;
                         }
 private:
+    // Reader of mFanOut, see OutputFanOut::Destination.
+    class FanOutDestination final : public OutputFanOut::Destination {
+    public:
+        explicit FanOutDestination(OutputTrack& track) : mTrack(track) {}
+
+        int id() const final { return mTrack.id(); }
+        int32_t front() const final;
+        int32_t rear() const final { return mTrack.rear(); }
+        bool isActive() const final { return mTrack.mActive; }
+        status_t start() final { return mTrack.start(); }
+        void stop() final { mTrack.stop(); }
+        void flush() final { mTrack.mClientProxy->flush(); }
+        bool isReading() const final;
+        bool resync(int32_t rear) final;
+        bool inStandby() const final;
+        bool waitForStart() final;
+        size_t bufferSizeInFrames() const final {
+            return mTrack.mClientProxy->getBufferSizeInFrames();
+        }
+        void setBufferSizeInFrames(size_t frameCount) final {
+            (void) mTrack.mClientProxy->setBufferSizeInFrames(frameCount);
+        }
+        uint32_t startThresholdInFrames() const final {
+            return mTrack.mClientProxy->getStartThresholdInFrames();
+        }
+        status_t obtainBuffer(size_t* frameCount, void** raw, uint32_t waitTimeMs) final;
+        void releaseBuffer(size_t frameCount) final;
+        void waitForRead(uint32_t waitTimeMs) final;
+
+    private:
+        OutputTrack& mTrack;
+    };
+
     status_t            obtainBuffer(AudioBufferProvider::Buffer* buffer,
                                      uint32_t waitTimeMs);
     void                queueBuffer(Buffer& inBuffer);
@@ -457,6 +495,8 @@ private:
 
     void                restartIfDisabled();
 
+    int32_t             rear() const { return mCblk->u.mStreaming.mRear; }
+
     // Maximum number of pending buffers allocated by OutputTrack::write()
     static const uint8_t kMaxOverFlowBuffers = 10;
 
@@ -465,6 +505,12 @@ private:
     bool                        mActive;
     IAfDuplicatingThread* const mSourceThread; // for waitTimeMs() in write()
     sp<AudioTrackClientProxy>   mClientProxy;
+    std::atomic<size_t>         mQueuedFrames = 0;  // frames in mBufferQueue, for dump
+
+    // Buffer shared with the other OutputTracks of the DuplicatingThread, or nullptr.
+    // Written by the OutputFanOut instead of write().
+    const sp<OutputFanOut>      mFanOut;
+    FanOutDestination           mFanOutDestination{*this};
 
     /** Attributes of the source tracks.
      *
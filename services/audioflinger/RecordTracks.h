@@ -94,6 +94,10 @@ public:
         return mSynchronizedRecordState;
     }
     RecordBufferConverter* recordBufferConverter() const final { return mRecordBufferConverter; }
+    RecordBufferConverter* swapRecordBufferConverter(RecordBufferConverter* converter) final {
+        std::swap(converter, mRecordBufferConverter);
+        return converter;
+    }
     ResamplerBufferProvider* resamplerBufferProvider() const final {
         return mResamplerBufferProvider;
     }
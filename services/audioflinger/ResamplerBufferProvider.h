@@ -19,6 +19,8 @@
 namespace android {
 
 class IAfRecordTrack;
+class IAfThreadBase;
+class RecordThread;
 
 /* The ResamplerBufferProvider is used to retrieve recorded input data from the
  * RecordThread.  It maintains local state on the relative position of the read
@@ -30,6 +32,11 @@ public:
     explicit ResamplerBufferProvider(IAfRecordTrack* recordTrack) :
         mRecordTrack(recordTrack) {}
 
+    // Reads the RecordThread data on behalf of a SharedRecordConversion.
+    // reset() must not be called on such a provider.
+    explicit ResamplerBufferProvider(RecordThread* recordThread) :
+        mRecordTrack(nullptr), mRecordThread(recordThread) {}
+
     // called to set the ResamplerBufferProvider to head of the RecordThread data buffer,
     // skipping any previous data read from the hal.
     void reset();
@@ -55,7 +62,12 @@ public:
     void setFront(int32_t front) { mRsmpInFront = front; }
 
 private:
+    // Returns the RecordThread to read from, or nullptr if it is gone.
+    // threadBase holds a reference on the thread for the duration of the call.
+    RecordThread* recordThread(sp<IAfThreadBase>* threadBase) const;
+
     IAfRecordTrack* const mRecordTrack;
+    RecordThread* const mRecordThread = nullptr;  // set if not reading for a track
     size_t mRsmpInUnrel = 0;   // unreleased frames remaining from
                                // most recent getNextBuffer
                                // for debug only
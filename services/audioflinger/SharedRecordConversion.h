@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <media/RecordBufferConverter.h>
+
+#include "ResamplerBufferProvider.h"
+
+namespace android {
+
+class IAfRecordTrack;
+class RecordThread;
+
+/* The SharedRecordConversion converts the RecordThread input once for all the
+ * RecordTracks requesting the same format, channel mask and sample rate.
+ * The converted data is kept in a ring buffer, which each track reads with its own cursor.
+ *
+ * Only accessed by the RecordThread threadLoop().
+ */
+class SharedRecordConversion
+{
+public:
+    // front is the RecordThread input position from which conversion starts.
+    // inputFrames is the size of the RecordThread input buffer.
+    SharedRecordConversion(RecordThread* recordThread, int32_t front,
+            audio_channel_mask_t srcChannelMask, audio_format_t srcFormat,
+            uint32_t srcSampleRate,
+            audio_channel_mask_t dstChannelMask, audio_format_t dstFormat,
+            uint32_t dstSampleRate, size_t inputFrames);
+
+    status_t initCheck() const { return mConverter->initCheck(); }
+
+    // true if the track requests the output of this conversion
+    bool matches(const sp<IAfRecordTrack>& track) const;
+
+    ResamplerBufferProvider* provider() { return &mProvider; }
+
+    // The track reads the data converted from now on.
+    void addTrack(const sp<IAfRecordTrack>& track) { mCursors[track] = mRear; }
+    // Continues with the converter of the track, which has been converting the same input
+    // on its own, so that the resampler state and thus the track output remain continuous.
+    // The track gets the unused converter of this conversion in exchange.
+    void adoptConverter(const sp<IAfRecordTrack>& track);
+    // Removes the tracks for which pred returns true. The conversion state is kept, the
+    // output of the remaining tracks is not affected.
+    // If removed is not null, the references to the removed tracks are moved there,
+    // so that the caller can release them outside of a lock.
+    template <typename Pred>
+    void removeTracksIf(Pred pred, std::vector<sp<IAfRecordTrack>>* removed = nullptr) {
+        for (auto it = mCursors.begin(); it != mCursors.end(); ) {
+            if (!pred(it->first)) {
+                ++it;
+                continue;
+            }
+            if (removed != nullptr) {
+                removed->push_back(it->first);
+            }
+            it = mCursors.erase(it);
+        }
+    }
+    bool hasTrack(const sp<IAfRecordTrack>& track) const { return mCursors.count(track) != 0; }
+    bool empty() const { return mCursors.empty(); }
+    size_t trackCount() const { return mCursors.size(); }
+
+    // Converts all the input available since the previous call,
+    // and moves the input position of the tracks along.
+    void convert();
+
+    // Returns the number of converted frames not yet read by the track.
+    // If the track fell behind by more than the buffer size, it skips to the oldest
+    // data available and hasOverrun is set to true.
+    size_t framesAvailable(const sp<IAfRecordTrack>& track, bool* hasOverrun);
+
+    // Copies up to frames converted frames for the track to dst.
+    // Returns the number of frames copied.
+    size_t read(const sp<IAfRecordTrack>& track, void* dst, size_t frames);
+
+private:
+    const audio_channel_mask_t mChannelMask;
+    const audio_format_t mFormat;
+    const uint32_t mSrcSampleRate;
+    const uint32_t mSampleRate;
+    const size_t mFrameSize;
+
+    std::unique_ptr<RecordBufferConverter> mConverter;
+    ResamplerBufferProvider mProvider;
+
+    size_t mFramesP2;                   // ring buffer size in frames, a power of 2
+    std::unique_ptr<uint8_t[]> mBuffer;
+    int64_t mRear = 0;                  // frames converted, never cleared
+    std::map<sp<IAfRecordTrack>, int64_t> mCursors;  // next frame to read per track
+};
+
+} // namespace android
@@ -25,7 +25,9 @@
 #include "Client.h"
 #include "IAfEffect.h"
 #include "MelReporter.h"
+#include "OutputFanOut.h"
 #include "ResamplerBufferProvider.h"
+#include "SharedRecordConversion.h"
 
 #include <afutils/DumpTryLock.h>
 #include <afutils/Permission.h>
@@ -3593,18 +3595,29 @@ ssize_t PlaybackThread::threadLoop_write()
                         (pipe->maxFrames() * 7) / 8 : mNormalFrameCount * 2);
             }
         }
-        ssize_t framesWritten = mNormalSink->write((char *)mSinkBuffer + offset, count);
+        ssize_t framesWritten;
+        char* const sinkBuffer =
+                (char *)(mHalWriteRegion != nullptr ? mHalWriteRegion : mSinkBuffer);
+        if (mHalWriteRegion != nullptr) {
+            // the sink buffer was rendered into the HAL queue, only send it
+            framesWritten =
+                    static_cast<AudioStreamOutSink*>(mOutputSink.get())->commitWriteRegion(count);
+        } else {
+            framesWritten = mNormalSink->write(sinkBuffer + offset, count);
+        }
         ATRACE_END();
 
         if (framesWritten > 0) {
             bytesWritten = framesWritten * mFrameSize;
 
 #ifdef TEE_SINK
-            mTee.write((char *)mSinkBuffer + offset, framesWritten);
+            // the HAL does not modify the committed region, it can still be read
+            mTee.write(sinkBuffer + offset, framesWritten);
 #endif
         } else {
             bytesWritten = framesWritten;
         }
+        mHalWriteRegion = nullptr;
     // otherwise use the HAL / AudioStreamOut directly
     } else {
         // Direct output and offload threads
@@ -3641,6 +3654,33 @@ ssize_t PlaybackThread::threadLoop_write()
     return bytesWritten;
 }
 
+void* PlaybackThread::obtainHalWriteRegion()
+{
+    // Only a mixer thread writing its sink buffer to the HAL itself. Haptic channels are
+    // excluded since they are compacted in place after the conversion.
+    if (mType != MIXER || hasFastMixer() || mHapticChannelCount > 0
+            || mOutputSink == nullptr || mNormalSink != mOutputSink) {
+        return nullptr;
+    }
+    auto outputSink = static_cast<AudioStreamOutSink*>(mOutputSink.get());
+    if (mHalWriteRegion != nullptr) {
+        // not committed by the previous cycle
+        (void) outputSink->commitWriteRegion(0);
+        mHalWriteRegion = nullptr;
+    }
+    void* region = nullptr;
+    const ssize_t frames = outputSink->obtainWriteRegion(mNormalFrameCount, &region);
+    if (frames < 0) {
+        return nullptr;
+    }
+    if ((size_t) frames < mNormalFrameCount) {
+        // the contiguous part of the queue is too small, write the sink buffer this cycle
+        (void) outputSink->commitWriteRegion(0);
+        return nullptr;
+    }
+    return region;
+}
+
 // startMelComputation_l() must be called with AudioFlinger::mutex() held
 void PlaybackThread::startMelComputation_l(
         const sp<audio_utils::MelProcessor>& processor)
@@ -4337,8 +4377,16 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
             // TODO use mSleepTimeUs == 0 as an additional condition.
             uint32_t mixerChannelCount = mEffectBufferValid ?
                         audio_channel_count_from_out_mask(mMixerChannelMask) : mChannelCount;
+            // When all of the sink buffer is written by the format conversion below, and not
+            // processed in place by effects, render it directly into the HAL queue.
+            if (mSleepTimeUs == 0 && !isSuspended() && mCurrentWriteLength == mSinkBufferSize
+                    && !mHasDataCopiedToSinkBuffer && (mMixerBufferValid || mEffectBufferValid)
+                    && (mEffectBufferValid || effectChains.empty())) {
+                mHalWriteRegion = obtainHalWriteRegion();
+            }
             if (mMixerBufferValid && (mEffectBufferValid || !mHasDataCopiedToSinkBuffer)) {
-                void *buffer = mEffectBufferValid ? mEffectBuffer : mSinkBuffer;
+                void *buffer = mEffectBufferValid ? mEffectBuffer
+                        : mHalWriteRegion != nullptr ? mHalWriteRegion : mSinkBuffer;
                 audio_format_t format = mEffectBufferValid ? mEffectBufferFormat : mFormat;
 
                 // Apply mono blending and balancing if the effect buffer is not valid. Otherwise,
@@ -4462,16 +4510,17 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                                        mNormalFrameCount * mHapticChannelCount);
             }
             const size_t framesToCopy = mNormalFrameCount * (mChannelCount + mHapticChannelCount);
+            void* const sinkBuffer = mHalWriteRegion != nullptr ? mHalWriteRegion : mSinkBuffer;
             if (mFormat == AUDIO_FORMAT_PCM_FLOAT &&
                     mEffectBufferFormat == AUDIO_FORMAT_PCM_FLOAT) {
                 // Clamp PCM float values more than this distance from 0 to insulate
                 // a HAL which doesn't handle NaN correctly.
                 static constexpr float HAL_FLOAT_SAMPLE_LIMIT = 2.0f;
-                memcpy_to_float_from_float_with_clamping(static_cast<float*>(mSinkBuffer),
+                memcpy_to_float_from_float_with_clamping(static_cast<float*>(sinkBuffer),
                         static_cast<const float*>(effectBuffer),
                         framesToCopy, HAL_FLOAT_SAMPLE_LIMIT /* absMax */);
             } else {
-                memcpy_by_audio_format(mSinkBuffer, mFormat,
+                memcpy_by_audio_format(sinkBuffer, mFormat,
                         effectBuffer, mEffectBufferFormat, framesToCopy);
             }
             // The sample data is partially interleaved when haptic channels exist,
@@ -7778,8 +7827,10 @@ DuplicatingThread::DuplicatingThread(const sp<IAfThreadCallback>& afThreadCallba
        IAfPlaybackThread* mainThread, audio_io_handle_t id, bool systemReady)
     :   MixerThread(afThreadCallback, mainThread->getOutput(), id,
                     systemReady, DUPLICATING),
-        mWaitTimeMs(UINT_MAX)
+        mWaitTimeMs(UINT_MAX),
+        mFanOutEnabled(property_get_bool("af.duplicating.fan_out", true))
 {
+    mFanOutDestinations.reserve(OutputFanOut::kMaxDestinations);
     addOutputTrack(mainThread);
 }
 
@@ -7830,8 +7881,23 @@ void DuplicatingThread::threadLoop_sleepTime()
 
 ssize_t DuplicatingThread::threadLoop_write()
 {
+    // The outputs sharing the fan out ring are written with a single copy.
+    OutputFanOut* fanOut = nullptr;
+    mFanOutDestinations.clear();
     for (size_t i = 0; i < outputTracks.size(); i++) {
-        const ssize_t actualWritten = outputTracks[i]->write(mSinkBuffer, writeFrames);
+        if (outputTracks[i]->fanOut() != nullptr) {
+            fanOut = outputTracks[i]->fanOut().get();
+            mFanOutDestinations.push_back(outputTracks[i]->fanOutDestination());
+        }
+    }
+    ssize_t fanOutWritten = 0;
+    if (fanOut != nullptr) {
+        fanOutWritten = fanOut->write(mFanOutDestinations, mSinkBuffer, writeFrames, mWaitTimeMs);
+    }
+
+    for (size_t i = 0; i < outputTracks.size(); i++) {
+        const ssize_t actualWritten = outputTracks[i]->fanOut() != nullptr
+                ? fanOutWritten : outputTracks[i]->write(mSinkBuffer, writeFrames);
 
         // Consider the first OutputTrack for timestamp and frame counting.
 
@@ -7902,6 +7968,18 @@ void DuplicatingThread::dumpInternals_l(int fd, const Vector<String16>& args)
         }
     }
     ss << "\n";
+    if (mFanOut != nullptr) {
+        ss << "  Fan out: " << mFanOut->frameCount() << " frames ring, "
+                << mFanOut->framesWritten() << " frames written, "
+                << mFanOut->framesQueued() << " frames queued\n";
+    }
+    // frames written to each output not yet consumed by its thread
+    for (const auto &track : mOutputTracks) {
+        const size_t pending = track->framesPending();
+        ss << "  OutputTrack " << track->id() << (track->fanOut() != nullptr ? " fan out" : "")
+                << " lag: " << pending << " frames ("
+                << (mSampleRate != 0 ? pending * 1000. / mSampleRate : 0.) << " ms)\n";
+    }
     std::string result = ss.str();
     write(fd, result.c_str(), result.size());
 }
@@ -7935,18 +8013,34 @@ void DuplicatingThread::addOutputTrack(IAfPlaybackThread* thread)
     attributionSource.pid = VALUE_OR_FATAL(legacy2aidl_pid_t_int32_t(
       IPCThreadState::self()->getCallingPid()));
     attributionSource.token = sp<BBinder>::make();
+    // The ring is sized after the first output, with room for outputs with a longer period.
+    // An output needing more buffering than the ring gets its own buffer.
+    sp<OutputFanOut> fanOut;
+    if (mFanOutEnabled) {
+        if (mFanOut == nullptr) {
+            mFanOut = sp<OutputFanOut>::make(2 * frameCount, audio_bytes_per_frame(
+                    audio_channel_count_from_out_mask(mChannelMask), mFormat));
+        }
+        if (mFanOut->canHost(frameCount)) {
+            fanOut = mFanOut;
+        }
+    }
     sp<IAfOutputTrack> outputTrack = IAfOutputTrack::create(thread,
                                             this,
                                             mSampleRate,
                                             mFormat,
                                             mChannelMask,
                                             frameCount,
-                                            attributionSource);
+                                            attributionSource,
+                                            fanOut);
     status_t status = outputTrack != 0 ? outputTrack->initCheck() : (status_t) NO_MEMORY;
     if (status != NO_ERROR) {
         ALOGE("addOutputTrack() initCheck failed %d", status);
         return;
     }
+    if (fanOut != nullptr) {
+        fanOut->addDestination(frameCount);
+    }
     thread->setStreamVolume(AUDIO_STREAM_PATCH, 1.0f);
     mOutputTracks.add(outputTrack);
     ALOGV("addOutputTrack() track %p, on thread %p", outputTrack.get(), thread);
@@ -7958,6 +8052,9 @@ void DuplicatingThread::removeOutputTrack(IAfPlaybackThread* thread)
     audio_utils::lock_guard _l(mutex());
     for (size_t i = 0; i < mOutputTracks.size(); i++) {
         if (mOutputTracks[i]->thread() == thread) {
+            if (mOutputTracks[i]->fanOut() != nullptr) {
+                mOutputTracks[i]->fanOut()->removeDestination();
+            }
             mOutputTracks[i]->destroy();
             mOutputTracks.removeAt(i);
             updateWaitTime_l();
@@ -8199,6 +8296,7 @@ RecordThread::RecordThread(const sp<IAfThreadCallback>& afThreadCallback,
     // mFastCaptureNBLogWriter
     , mFastTrackAvail(false)
     , mBtNrecSuspended(false)
+    , mSharedConversionEnabled(property_get_bool("af.record.shared_conversion", true))
 {
     snprintf(mThreadName, kThreadNameLength, "AudioIn_%X", id);
     mNBLogWriter = afThreadCallback->newWriter_l(kLogSize, mThreadName);
@@ -8433,6 +8531,10 @@ reacquire_wakelock:
                 continue;
             }
 
+            // Tracks removed from mActiveTracks no longer read from a shared conversion,
+            // even if no input is read until they are started again.
+            removeInactiveSharedConversionTracks_l(&oldActiveTracks);
+
             // if no active track(s), then standby and release wakelock
             size_t size = mActiveTracks.size();
             if (size == 0) {
@@ -8783,6 +8885,10 @@ reacquire_wakelock:
         }
         mRsmpInRear = audio_utils::safe_add_overflow(mRsmpInRear, (int32_t)framesRead);
 
+        if (mSharedConversionEnabled) {
+            updateSharedConversions(activeTracks);
+        }
+
         size = activeTracks.size();
 
         // loop over each active track
@@ -8803,6 +8909,9 @@ reacquire_wakelock:
                 OVERRUN_FALSE
             } overrun = OVERRUN_UNKNOWN;
 
+            // non-null if the track reads data converted once for several tracks
+            SharedRecordConversion* const sharedConversion = this->sharedConversion(activeTrack);
+
             // loop over getNextBuffer to handle circular sink
             for (;;) {
 
@@ -8815,7 +8924,12 @@ reacquire_wakelock:
                 // if the record track isn't draining fast enough.
                 bool hasOverrun;
                 size_t framesIn;
-                activeTrack->resamplerBufferProvider()->sync(&framesIn, &hasOverrun);
+                if (sharedConversion != nullptr) {
+                    // framesIn is already converted
+                    framesIn = sharedConversion->framesAvailable(activeTrack, &hasOverrun);
+                } else {
+                    activeTrack->resamplerBufferProvider()->sync(&framesIn, &hasOverrun);
+                }
                 if (hasOverrun) {
                     overrun = OVERRUN_TRUE;
                 }
@@ -8827,7 +8941,9 @@ reacquire_wakelock:
                 // from framesIn.
                 // This isn't strictly necessary but helps limit buffer resizing in
                 // RecordBufferConverter.  TODO: remove when no longer needed.
-                if (audio_is_linear_pcm(activeTrack->format())) {
+                if (sharedConversion != nullptr) {
+                    framesOut = min(framesOut, framesIn);
+                } else if (audio_is_linear_pcm(activeTrack->format())) {
                     framesOut = min(framesOut,
                             destinationFramesPossible(
                                     framesIn, mSampleRate, activeTrack->sampleRate()));
@@ -8853,6 +8969,9 @@ reacquire_wakelock:
                         ALOGE("%s() cannot fill request, status: %d, frameCount: %zu",
                             __func__, getNextBufferStatus, buffer.frameCount);
                     }
+                } else if (sharedConversion != nullptr) {
+                    framesOut = sharedConversion->read(
+                            activeTrack, activeTrack->sinkBuffer().raw, framesOut);
                 } else {
                     // process frames from the RecordThread buffer provider to the RecordTrack
                     // buffer
@@ -9605,11 +9724,23 @@ void ResamplerBufferProvider::reset()
     mRsmpInFront = audio_utils::safe_sub_overflow(rear, static_cast<int32_t>(deltaFrames));
 }
 
+RecordThread* ResamplerBufferProvider::recordThread(sp<IAfThreadBase>* threadBase) const
+{
+    if (mRecordThread != nullptr) {
+        return mRecordThread;
+    }
+    *threadBase = mRecordTrack->thread().promote();
+    if (*threadBase == nullptr) {
+        return nullptr;
+    }
+    return static_cast<RecordThread *>((*threadBase)->asIAfRecordThread().get());
+}
+
 void ResamplerBufferProvider::sync(
         size_t *framesAvailable, bool *hasOverrun)
 {
-    const auto threadBase = mRecordTrack->thread().promote();
-    auto* const recordThread = static_cast<RecordThread *>(threadBase->asIAfRecordThread().get());
+    sp<IAfThreadBase> threadBase;
+    auto* const recordThread = this->recordThread(&threadBase);
     const int32_t rear = recordThread->mRsmpInRear;
     const int32_t front = mRsmpInFront;
     const ssize_t filled = audio_utils::safe_sub_overflow(rear, front);
@@ -9642,13 +9773,13 @@ void ResamplerBufferProvider::sync(
 status_t ResamplerBufferProvider::getNextBuffer(
         AudioBufferProvider::Buffer* buffer)
 {
-    const auto threadBase = mRecordTrack->thread().promote();
-    if (threadBase == 0) {
+    sp<IAfThreadBase> threadBase;
+    auto* const recordThread = this->recordThread(&threadBase);
+    if (recordThread == nullptr) {
         buffer->frameCount = 0;
         buffer->raw = NULL;
         return NOT_ENOUGH_DATA;
     }
-    auto* const recordThread = static_cast<RecordThread *>(threadBase->asIAfRecordThread().get());
     int32_t rear = recordThread->mRsmpInRear;
     int32_t front = mRsmpInFront;
     ssize_t filled = audio_utils::safe_sub_overflow(rear, front);
@@ -9696,6 +9827,201 @@ void ResamplerBufferProvider::releaseBuffer(
     buffer->frameCount = 0;
 }
 
+SharedRecordConversion::SharedRecordConversion(RecordThread* recordThread, int32_t front,
+        audio_channel_mask_t srcChannelMask, audio_format_t srcFormat,
+        uint32_t srcSampleRate,
+        audio_channel_mask_t dstChannelMask, audio_format_t dstFormat,
+        uint32_t dstSampleRate, size_t inputFrames)
+    : mChannelMask(dstChannelMask),
+      mFormat(dstFormat),
+      mSrcSampleRate(srcSampleRate),
+      mSampleRate(dstSampleRate),
+      mFrameSize(audio_bytes_per_frame(
+              audio_channel_count_from_in_mask(dstChannelMask), dstFormat)),
+      mConverter(std::make_unique<RecordBufferConverter>(srcChannelMask, srcFormat,
+              srcSampleRate, dstChannelMask, dstFormat, dstSampleRate)),
+      mProvider(recordThread)
+{
+    mProvider.setFront(front);
+    // Hold as much converted data as the input buffer, so that a track falls behind
+    // no sooner than it would reading the input on its own.
+    mFramesP2 = roundup(
+            destinationFramesPossible(inputFrames, srcSampleRate, dstSampleRate) + 1);
+    mBuffer = std::make_unique<uint8_t[]>(mFramesP2 * mFrameSize);
+}
+
+void SharedRecordConversion::adoptConverter(const sp<IAfRecordTrack>& track)
+{
+    ALOG_ASSERT(matches(track) && mRear == 0);
+    mConverter.reset(track->swapRecordBufferConverter(mConverter.release()));
+}
+
+bool SharedRecordConversion::matches(const sp<IAfRecordTrack>& track) const
+{
+    return track->format() == mFormat
+            && track->channelMask() == mChannelMask
+            && track->sampleRate() == mSampleRate;
+}
+
+void SharedRecordConversion::convert()
+{
+    size_t framesIn;
+    mProvider.sync(&framesIn);
+    while (framesIn > 0) {
+        // the ring buffer may be non-contiguous, convert up to its end first
+        const size_t offset = static_cast<size_t>(mRear) & (mFramesP2 - 1);
+        const size_t framesOut = std::min(mFramesP2 - offset,
+                destinationFramesPossible(framesIn, mSrcSampleRate, mSampleRate));
+        if (framesOut == 0) {
+            break;
+        }
+        const size_t converted = mConverter->convert(
+                mBuffer.get() + offset * mFrameSize, &mProvider, framesOut);
+        if (converted == 0) {
+            break;
+        }
+        mRear += converted;
+        mProvider.sync(&framesIn);
+    }
+    // keep the track positions consistent for getOldestFront_l() and updateFronts_l()
+    for (const auto& [track, cursor] : mCursors) {
+        track->resamplerBufferProvider()->setFront(mProvider.getFront());
+    }
+}
+
+size_t SharedRecordConversion::framesAvailable(
+        const sp<IAfRecordTrack>& track, bool* hasOverrun)
+{
+    int64_t& cursor = mCursors.at(track);
+    *hasOverrun = mRear - cursor > static_cast<int64_t>(mFramesP2);
+    if (*hasOverrun) {
+        // client is not keeping up with server, but give it latest data
+        cursor = mRear - mFramesP2;
+    }
+    return mRear - cursor;
+}
+
+size_t SharedRecordConversion::read(const sp<IAfRecordTrack>& track, void* dst, size_t frames)
+{
+    int64_t& cursor = mCursors.at(track);
+    frames = std::min(frames, static_cast<size_t>(mRear - cursor));
+    const size_t offset = static_cast<size_t>(cursor) & (mFramesP2 - 1);
+    const size_t part1 = std::min(frames, mFramesP2 - offset);
+    memcpy(dst, mBuffer.get() + offset * mFrameSize, part1 * mFrameSize);
+    if (frames > part1) {
+        memcpy(static_cast<uint8_t*>(dst) + part1 * mFrameSize, mBuffer.get(),
+                (frames - part1) * mFrameSize);
+    }
+    cursor += frames;
+    return frames;
+}
+
+void RecordThread::updateSharedConversions(const Vector<sp<IAfRecordTrack>>& activeTracks)
+{
+    // Drop the tracks which restarted and thus moved their input position, the data they
+    // have not read yet precedes the restart. Tracks which stopped are already removed
+    // by removeInactiveSharedConversionTracks_l().
+    for (const auto& conversion : mSharedConversions) {
+        const int32_t front = conversion->provider()->getFront();
+        conversion->removeTracksIf([&](const sp<IAfRecordTrack>& track) {
+            return activeTracks.indexOf(track) < 0
+                    || track->resamplerBufferProvider()->getFront() != front;
+        });
+    }
+    mSharedConversions.erase(std::remove_if(mSharedConversions.begin(), mSharedConversions.end(),
+            [](const auto& conversion) { return conversion->empty(); }),
+            mSharedConversions.end());
+
+    // Attach the other tracks to a conversion when they read the same input position
+    // with the same parameters.
+    std::vector<sp<IAfRecordTrack>> candidates;
+    for (const auto& track : activeTracks) {
+        if (!track->isFastTrack() && !track->isDirect() && audio_is_linear_pcm(track->format())
+                && sharedConversion(track) == nullptr) {
+            candidates.push_back(track);
+        }
+    }
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        const sp<IAfRecordTrack>& track = candidates[i];
+        if (track == nullptr) {
+            continue;  // already attached
+        }
+        const int32_t front = track->resamplerBufferProvider()->getFront();
+        SharedRecordConversion* conversion = nullptr;
+        for (const auto& existing : mSharedConversions) {
+            if (existing->matches(track) && existing->provider()->getFront() == front) {
+                conversion = existing.get();
+                break;
+            }
+        }
+        if (conversion == nullptr) {
+            // only worth it if another track can share the conversion
+            const auto other = std::find_if(candidates.begin() + i + 1, candidates.end(),
+                    [&](const sp<IAfRecordTrack>& candidate) {
+                        return candidate != nullptr
+                                && candidate->format() == track->format()
+                                && candidate->channelMask() == track->channelMask()
+                                && candidate->sampleRate() == track->sampleRate()
+                                && candidate->resamplerBufferProvider()->getFront() == front;
+                    });
+            if (other == candidates.end()) {
+                continue;
+            }
+            auto created = std::make_unique<SharedRecordConversion>(this, front,
+                    mChannelMask, mFormat, mSampleRate,
+                    track->channelMask(), track->format(), track->sampleRate(),
+                    mRsmpInFrames);
+            if (created->initCheck() != NO_ERROR) {
+                continue;
+            }
+            // The candidates are in start order, continue the conversion of the track
+            // which has been running the longest. The others read the same input from
+            // the same position, their resampler state may only differ by the phase.
+            created->adoptConverter(track);
+            conversion = created.get();
+            mSharedConversions.push_back(std::move(created));
+            ALOGV("%s new shared conversion for format %#x channel mask %#x rate %u",
+                    __func__, track->format(), track->channelMask(), track->sampleRate());
+        }
+        conversion->addTrack(track);
+        candidates[i].clear();
+        for (size_t j = i + 1; j < candidates.size(); ++j) {
+            if (candidates[j] != nullptr && conversion->matches(candidates[j])
+                    && candidates[j]->resamplerBufferProvider()->getFront() == front) {
+                conversion->addTrack(candidates[j]);
+                candidates[j].clear();
+            }
+        }
+    }
+
+    for (const auto& conversion : mSharedConversions) {
+        conversion->convert();
+    }
+}
+
+void RecordThread::removeInactiveSharedConversionTracks_l(
+        std::vector<sp<IAfRecordTrack>>* removed)
+{
+    for (const auto& conversion : mSharedConversions) {
+        conversion->removeTracksIf([this](const sp<IAfRecordTrack>& track) {
+            return mActiveTracks.indexOf(track) < 0;
+        }, removed);
+    }
+    mSharedConversions.erase(std::remove_if(mSharedConversions.begin(), mSharedConversions.end(),
+            [](const auto& conversion) { return conversion->empty(); }),
+            mSharedConversions.end());
+}
+
+SharedRecordConversion* RecordThread::sharedConversion(const sp<IAfRecordTrack>& track) const
+{
+    for (const auto& conversion : mSharedConversions) {
+        if (conversion->hasTrack(track)) {
+            return conversion.get();
+        }
+    }
+    return nullptr;
+}
+
 void RecordThread::checkBtNrec()
 {
     audio_utils::lock_guard _l(mutex());
@@ -9840,6 +10166,8 @@ void RecordThread::ioConfigChanged_l(audio_io_config_event_t event, pid_t pid,
 
 void RecordThread::readInputParameters_l()
 {
+    // shared conversions are set up for the previous input configuration
+    mSharedConversions.clear();
     const audio_config_base_t audioConfig = mInput->getAudioProperties();
     mSampleRate = audioConfig.sample_rate;
     mChannelMask = audioConfig.channel_mask;
@@ -10089,6 +10417,11 @@ void RecordThread::updateFronts_l(int32_t offset)
         front = audio_utils::safe_sub_overflow(front, offset);
         mTracks[i]->resamplerBufferProvider()->setFront(front);
     }
+    for (const auto& conversion : mSharedConversions) {
+        int32_t front = conversion->provider()->getFront();
+        front = audio_utils::safe_sub_overflow(front, offset);
+        conversion->provider()->setFront(front);
+    }
 }
 
 void RecordThread::resizeInputBuffer_l(int32_t maxSharedAudioHistoryMs)
@@ -39,6 +39,7 @@
 namespace android {
 
 class AsyncCallbackThread;
+class SharedRecordConversion;
 
 class ThreadBase : public virtual IAfThreadBase, public Thread {
 public:
@@ -1289,6 +1290,12 @@ protected:
     // Set to "true" to enable when data has already copied to sink
     bool mHasDataCopiedToSinkBuffer GUARDED_BY(ThreadBase_ThreadLoop) = false;
 
+    // Region of the HAL queue the sink buffer of the current cycle is rendered into, instead of
+    // mSinkBuffer, when the HAL supports zero-copy writes. Committed by threadLoop_write().
+    void* mHalWriteRegion GUARDED_BY(ThreadBase_ThreadLoop) = nullptr;
+    // Returns the region of the HAL queue to render the whole sink buffer into, or nullptr.
+    void* obtainHalWriteRegion() REQUIRES(ThreadBase_ThreadLoop);
+
     // Frame size aligned buffer used as input and output to all post processing effects
     // except the Spatializer in a SPATIALIZER thread. Non spatialized tracks are mixed into
     // this buffer so that post processing effects can be applied.
@@ -1920,6 +1927,13 @@ private:
     // NO_THREAD_SAFETY_ANALYSIS  GUARDED_BY(ThreadBase_ThreadLoop)
     SortedVector <sp<IAfOutputTrack>> outputTracks;
     SortedVector <sp<IAfOutputTrack>> mOutputTracks GUARDED_BY(mutex());
+
+    // Ring shared by the OutputTracks so that the mix is copied once for all the outputs,
+    // see OutputFanOut. nullptr if disabled.
+    const bool mFanOutEnabled;
+    sp<OutputFanOut> mFanOut GUARDED_BY(mutex());
+    // threadLoop() scratch: the outputTracks written through the fan out
+    std::vector<OutputFanOut::Destination*> mFanOutDestinations;
 public:
     virtual     bool        hasFastMixer() const { return false; }
                 status_t    threadloop_getHalTimestamp_l(
@@ -2135,6 +2149,16 @@ private:
     int32_t getOldestFront_l() REQUIRES(mutex());
     void updateFronts_l(int32_t offset) REQUIRES(mutex());
 
+    // Groups the active tracks requesting the same conversion of the input, and converts
+    // the new input once per group. Called by threadLoop() only.
+    void updateSharedConversions(const Vector<sp<IAfRecordTrack>>& activeTracks);
+    // Removes the tracks no longer active from the shared conversions. The references are
+    // moved to removed, to be released with mutex() unlocked. Called by threadLoop() only.
+    void removeInactiveSharedConversionTracks_l(std::vector<sp<IAfRecordTrack>>* removed)
+            REQUIRES(mutex());
+    // Returns the conversion the track reads from, or nullptr if it converts on its own.
+    SharedRecordConversion* sharedConversion(const sp<IAfRecordTrack>& track) const;
+
             AudioStreamIn                       *mInput;
             Source                              *mSource;
             SortedVector <sp<IAfRecordTrack>>    mTracks;
@@ -2196,6 +2220,9 @@ private:
             bool                                mFastTrackAvail;    // true if fast track available
             // common state to all record threads
             std::atomic_bool                    mBtNrecSuspended;
+            const bool                          mSharedConversionEnabled;
+            // accessible only within the threadLoop(), no locks required
+            std::vector<std::unique_ptr<SharedRecordConversion>> mSharedConversions;
 
             int64_t                             mFramesRead = 0;    // continuous running counter.
 
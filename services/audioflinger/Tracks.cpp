@@ -2157,7 +2157,8 @@ sp<IAfOutputTrack> IAfOutputTrack::create(
         audio_format_t format,
         audio_channel_mask_t channelMask,
         size_t frameCount,
-        const AttributionSourceState& attributionSource) {
+        const AttributionSourceState& attributionSource,
+        const sp<OutputFanOut>& fanOut) {
     return sp<OutputTrack>::make(
             playbackThread,
             sourceThread,
@@ -2165,7 +2166,8 @@ sp<IAfOutputTrack> IAfOutputTrack::create(
             format,
             channelMask,
             frameCount,
-            attributionSource);
+            attributionSource,
+            fanOut);
 }
 
 OutputTrack::OutputTrack(
@@ -2175,14 +2177,18 @@ OutputTrack::OutputTrack(
             audio_format_t format,
             audio_channel_mask_t channelMask,
             size_t frameCount,
-            const AttributionSourceState& attributionSource)
+            const AttributionSourceState& attributionSource,
+            const sp<OutputFanOut>& fanOut)
     :   Track(playbackThread, NULL, AUDIO_STREAM_PATCH,
               audio_attributes_t{} /* currently unused for output track */,
-              sampleRate, format, channelMask, frameCount,
-              nullptr /* buffer */, (size_t)0 /* bufferSize */, nullptr /* sharedBuffer */,
+              sampleRate, format, channelMask,
+              fanOut != nullptr ? fanOut->frameCount() : frameCount,
+              fanOut != nullptr ? fanOut->buffer() : nullptr,
+              fanOut != nullptr ? fanOut->bufferSize() : (size_t)0,
+              nullptr /* sharedBuffer */,
               AUDIO_SESSION_NONE, getpid(), attributionSource, AUDIO_OUTPUT_FLAG_NONE,
               TYPE_OUTPUT),
-    mActive(false), mSourceThread(sourceThread)
+    mActive(false), mSourceThread(sourceThread), mFanOut(fanOut)
 {
 
     if (mCblk != NULL) {
@@ -2199,6 +2205,10 @@ OutputTrack::OutputTrack(
         mClientProxy->setVolumeLR(GAIN_MINIFLOAT_PACKED_UNITY);
         mClientProxy->setSendLevel(0.0);
         mClientProxy->setSampleRate(sampleRate);
+        if (mFanOut != nullptr) {
+            // the ring is sized for all the destinations, only buffer what this one needs
+            mClientProxy->setBufferSizeInFrames(frameCount);
+        }
     } else {
         ALOGW("%s(%d): Error creating output track on thread %d",
                 __func__, mId, (int)mThreadIoHandle);
@@ -2355,6 +2365,12 @@ ssize_t OutputTrack::write(void* data, uint32_t frames)
         stop();
     }
 
+    size_t queuedFrames = 0;
+    for (size_t i = 0; i < mBufferQueue.size(); i++) {
+        queuedFrames += mBufferQueue.itemAt(i)->frameCount;
+    }
+    mQueuedFrames = queuedFrames;
+
     return frames - inBuffer.frameCount;  // number of frames consumed.
 }
 
@@ -2420,6 +2436,7 @@ void OutputTrack::clearBufferQueue()
         delete pBuffer;
     }
     mBufferQueue.clear();
+    mQueuedFrames = 0;
 }
 
 void OutputTrack::restartIfDisabled()
@@ -2430,6 +2447,103 @@ void OutputTrack::restartIfDisabled()
     }
 }
 
+size_t OutputTrack::framesPending() const
+{
+    const int32_t front = android_atomic_acquire_load(&mCblk->u.mStreaming.mFront);
+    if (mFanOut != nullptr) {
+        // a destination behind the others has not been given the latest frames yet
+        return (uint32_t)(mFanOut->rear() - front) + mFanOut->framesQueued();
+    }
+    return (uint32_t)(rear() - front) + mQueuedFrames;
+}
+
+int32_t OutputTrack::FanOutDestination::front() const
+{
+    return android_atomic_acquire_load(&mTrack.mCblk->u.mStreaming.mFront);
+}
+
+bool OutputTrack::FanOutDestination::isReading() const
+{
+    const sp<IAfThreadBase> thread = mTrack.mThread.promote();
+    if (thread == nullptr) {
+        return false;
+    }
+    audio_utils::lock_guard _l(thread->mutex());
+    auto* const playbackThread = thread->asIAfPlaybackThread().get();
+    return playbackThread->isTrackActive(&mTrack);
+}
+
+bool OutputTrack::FanOutDestination::resync(int32_t rear)
+{
+    const sp<IAfThreadBase> thread = mTrack.mThread.promote();
+    if (thread == nullptr) {
+        return false;
+    }
+    audio_utils::lock_guard _l(thread->mutex());
+    auto* const playbackThread = thread->asIAfPlaybackThread().get();
+    if (playbackThread->isTrackActive(&mTrack)) {
+        return false;
+    }
+    // The destination thread does not read the buffer of a track it does not play,
+    // so both ends of the buffer can be moved. A flush left by OutputFanOut::drop() is
+    // applied first, it would move the front on the next read otherwise.
+    mTrack.mServerProxy->flushBufferIfNeeded();
+    android_atomic_release_store(rear, &mTrack.mCblk->u.mStreaming.mFront);
+    android_atomic_release_store(rear, &mTrack.mCblk->u.mStreaming.mRear);
+    return true;
+}
+
+bool OutputTrack::FanOutDestination::inStandby() const
+{
+    const sp<IAfThreadBase> thread = mTrack.mThread.promote();
+    return thread != nullptr && thread->inStandby();
+}
+
+bool OutputTrack::FanOutDestination::waitForStart()
+{
+    const sp<IAfThreadBase> thread = mTrack.mThread.promote();
+    return thread != nullptr && thread->asIAfPlaybackThread()->waitForHalStart();
+}
+
+status_t OutputTrack::FanOutDestination::obtainBuffer(
+        size_t* frameCount, void** raw, uint32_t waitTimeMs)
+{
+    AudioBufferProvider::Buffer buffer;
+    buffer.frameCount = *frameCount;
+    status_t status = mTrack.obtainBuffer(&buffer, waitTimeMs);
+    if (status == NOT_ENOUGH_DATA) {
+        mTrack.restartIfDisabled();
+        buffer.frameCount = *frameCount;
+        status = mTrack.obtainBuffer(&buffer, waitTimeMs);
+    }
+    *frameCount = buffer.frameCount;
+    *raw = buffer.raw;
+    return status;
+}
+
+void OutputTrack::FanOutDestination::releaseBuffer(size_t frameCount)
+{
+    Proxy::Buffer buf;
+    buf.mFrameCount = frameCount;
+    buf.mRaw = nullptr;
+    mTrack.mClientProxy->releaseBuffer(&buf);
+    mTrack.restartIfDisabled();
+}
+
+void OutputTrack::FanOutDestination::waitForRead(uint32_t waitTimeMs)
+{
+    // woken up by the destination thread releasing frames, as in ClientProxy::obtainBuffer()
+    audio_track_cblk_t* const cblk = mTrack.mCblk;
+    const int32_t old = android_atomic_and(~CBLK_FUTEX_WAKE, &cblk->mFutex);
+    if (!(old & CBLK_FUTEX_WAKE)) {
+        struct timespec timeout;
+        timeout.tv_sec = waitTimeMs / 1000;
+        timeout.tv_nsec = (int) (waitTimeMs % 1000) * 1000000;
+        (void) syscall(__NR_futex, &cblk->mFutex, FUTEX_WAIT_PRIVATE,
+                old & ~CBLK_FUTEX_WAKE, &timeout);
+    }
+}
+
 // ----------------------------------------------------------------------------
 #undef LOG_TAG
 #define LOG_TAG "AF::PatchTrack"
@@ -66,6 +66,9 @@ inline auto wrapWithPolicySnooping(Allocator allocator, std::string_view name) {
 constexpr inline size_t CLIENT_BOUND = 32;
 // Maximum amount of shared pools a single client can take (50%).
 constexpr inline size_t ADV_THRESHOLD_INV = 2;
+// Freed small blocks a client keeps for its next tracks, saving the heap creation and
+// mapping on each track creation. They remain accounted for in the pools.
+constexpr inline size_t CLIENT_CACHED_BLOCKS = 8;
 
 inline auto getClientAllocator() {
     using namespace mediautils;
@@ -83,10 +86,13 @@ inline auto getClientAllocator() {
                 getSharedSmall(), "Small Shared");
     };
 
-    return ScopedAllocator{std::make_shared<
+    using PoolAllocator =
             FallbackAllocator<decltype(makeDedPool()),
-                              decltype(FallbackAllocator(makeLargeShared(), makeSmallShared()))>>(
-            makeDedPool(), FallbackAllocator{makeLargeShared(), makeSmallShared()})};
+                              decltype(FallbackAllocator(makeLargeShared(), makeSmallShared()))>;
+    return ScopedAllocator{
+            std::make_shared<CachingAllocator<PoolAllocator, CLIENT_CACHED_BLOCKS,
+                                              SMALL_THRESHOLD>>(PoolAllocator{
+                    makeDedPool(), FallbackAllocator{makeLargeShared(), makeSmallShared()}})};
 }
 
 using ClientAllocator = decltype(getClientAllocator());
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+namespace android::afutils {
+
+/**
+ * Returns the frame count of the buffer shared by the PatchRecord and the PatchTrack of a
+ * software patch.
+ *
+ * For a direct patch, the record thread writes straight into the buffer read by the playback
+ * thread. The buffer holds one period of each thread, plus one more period of the larger of
+ * the two to absorb the drift between the clocks of the two devices.
+ * Other patches use a pseudo LCM of the two periods.
+ */
+inline size_t softwarePatchFrameCount(
+        size_t playbackFrameCount, size_t recordFrameCount, bool direct)
+{
+    if (direct) {
+        return playbackFrameCount + recordFrameCount
+                + std::max(playbackFrameCount, recordFrameCount);
+    }
+    int playbackShift = __builtin_ctz(playbackFrameCount);
+    int shift = __builtin_ctz(recordFrameCount);
+    if (playbackShift < shift) {
+        shift = playbackShift;
+    }
+    return (playbackFrameCount * recordFrameCount) >> shift;
+}
+
+}  // namespace android::afutils
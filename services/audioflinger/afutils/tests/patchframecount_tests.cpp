@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "patchframecount_tests"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <afutils/PatchFrameCount.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+using android::afutils::softwarePatchFrameCount;
+
+// Simulates the record thread writing and the playback thread reading the shared buffer of a
+// direct patch for the given duration. The record device clock is off by driftPpm and each
+// thread wakes up late by up to half a period. Returns the highest fill level reached, in frames.
+size_t maxFillLevel(size_t playbackFrameCount, size_t recordFrameCount, double driftPpm,
+        unsigned seed)
+{
+    constexpr double kDurationFrames = 10 * 48000.;
+    std::mt19937 generator(seed);
+    std::vector<std::pair<double, bool /*isRecord*/>> events;
+    const auto addEvents = [&](size_t period, double rate, bool isRecord) {
+        std::uniform_real_distribution<double> lateness(0., period / 2.);
+        for (size_t i = 1; i * period < kDurationFrames; ++i) {
+            events.emplace_back(i * period / rate + lateness(generator), isRecord);
+        }
+    };
+    addEvents(recordFrameCount, 1. + driftPpm / 1e6, true);
+    addEvents(playbackFrameCount, 1., false);
+    std::sort(events.begin(), events.end());
+
+    size_t filled = 0;
+    size_t maxFilled = 0;
+    bool started = false;  // the playback thread starts as soon as one frame is ready
+    for (const auto& [time, isRecord] : events) {
+        if (isRecord) {
+            filled += recordFrameCount;
+            maxFilled = std::max(maxFilled, filled);
+            started = true;
+        } else if (started) {
+            filled -= std::min(filled, playbackFrameCount);
+        }
+    }
+    return maxFilled;
+}
+
+TEST(PatchFrameCount, DirectHasOneExtraPeriod) {
+    EXPECT_EQ(3 * 256u, softwarePatchFrameCount(256, 256, true /*direct*/));
+    EXPECT_EQ(192u + 480u + 480u, softwarePatchFrameCount(192, 480, true /*direct*/));
+    EXPECT_EQ(960u + 240u + 960u, softwarePatchFrameCount(960, 240, true /*direct*/));
+}
+
+TEST(PatchFrameCount, ConvertedUsesPseudoLcm) {
+    EXPECT_EQ(256u, softwarePatchFrameCount(256, 256, false /*direct*/));
+    EXPECT_EQ(2880u, softwarePatchFrameCount(192, 480, false /*direct*/));
+    EXPECT_EQ(14400u, softwarePatchFrameCount(960, 240, false /*direct*/));
+}
+
+TEST(PatchFrameCount, DirectAbsorbsDriftAndJitter) {
+    for (const auto& [playback, record] : { std::pair<size_t, size_t>{256, 256},
+                                            {192, 480}, {480, 192}, {960, 240} }) {
+        const size_t frameCount = softwarePatchFrameCount(playback, record, true /*direct*/);
+        for (const double driftPpm : { -100., 0., 100. }) {
+            for (unsigned seed = 0; seed < 3; ++seed) {
+                EXPECT_LE(maxFillLevel(playback, record, driftPpm, seed), frameCount)
+                        << "playback " << playback << " record " << record
+                        << " drift " << driftPpm << " seed " << seed;
+            }
+        }
+    }
+}
+
+}  // namespace
@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "outputfanout_tests"
+
+#include "OutputFanOut.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace android {
+namespace {
+
+constexpr size_t kPeriod = 64;  // frames written by the DuplicatingThread on each cycle
+constexpr uint32_t kWaitTimeMs = 10;
+
+using Sample = int32_t;  // one channel, each frame holds its index in the stream
+
+/* A destination thread playing an OutputTrack of the fan out, driven by the test.
+ *
+ * The buffer of the track is the ring, with the same positions as a control block.
+ */
+class TestDestination : public OutputFanOut::Destination {
+public:
+    TestDestination(int id, const OutputFanOut& fanOut)
+        : mId(id), mRing(static_cast<const Sample*>(fanOut.buffer())),
+          mRingFrames(fanOut.frameCount()) {}
+
+    int id() const override { return mId; }
+    int32_t front() const override { return mFront; }
+    int32_t rear() const override { return mRear; }
+    bool isActive() const override { return mActive; }
+    status_t start() override {
+        mActive = true;
+        mPlaying = true;
+        return NO_ERROR;
+    }
+    void stop() override { mActive = false; }
+    void flush() override { mFlushPending = true; }
+    bool isReading() const override { return mPlaying; }
+    bool resync(int32_t rear) override {
+        if (mPlaying) {
+            return false;
+        }
+        mFlushPending = false;
+        mFront = rear;
+        mRear = rear;
+        return true;
+    }
+    bool inStandby() const override { return false; }
+    bool waitForStart() override { return true; }
+    size_t bufferSizeInFrames() const override { return mBufferSize; }
+    void setBufferSizeInFrames(size_t frameCount) override { mBufferSize = frameCount; }
+    uint32_t startThresholdInFrames() const override { return kPeriod; }
+    status_t obtainBuffer(size_t* frameCount, void** raw, uint32_t /* waitTimeMs */) override {
+        const size_t filled = (uint32_t)(mRear - mFront);
+        const size_t offset = mRear & (mRingFrames - 1);
+        *frameCount = std::min({*frameCount, mBufferSize - std::min(filled, mBufferSize),
+                mRingFrames - offset});
+        *raw = const_cast<Sample*>(mRing) + offset;
+        return *frameCount != 0 ? NO_ERROR : WOULD_BLOCK;
+    }
+    void releaseBuffer(size_t frameCount) override { mRear += frameCount; }
+    // the test reads between the writes
+    void waitForRead(uint32_t /* waitTimeMs */) override {}
+
+    // Mixes up to frameCount frames, as the thread of the destination.
+    void read(size_t frameCount) {
+        if (mFlushPending) {
+            mFlushPending = false;
+            mFront = mRear;
+        }
+        const size_t count = std::min<size_t>(frameCount, (uint32_t)(mRear - mFront));
+        for (size_t i = 0; i < count; i++) {
+            mReceived.push_back(mRing[(mFront + i) & (mRingFrames - 1)]);
+        }
+        mFront += count;
+        if (!mActive && mFront == mRear) {
+            mPlaying = false;  // drained, removed from the active tracks
+        }
+    }
+
+    const std::vector<Sample>& received() const { return mReceived; }
+
+private:
+    const int mId;
+    const Sample* const mRing;
+    const size_t mRingFrames;
+    int32_t mFront = 0;
+    int32_t mRear = 0;
+    size_t mBufferSize = 0;
+    bool mActive = false;
+    bool mPlaying = false;
+    bool mFlushPending = false;
+    std::vector<Sample> mReceived;
+};
+
+class OutputFanOutTest : public ::testing::Test {
+protected:
+    OutputFanOutTest() {
+        mFanOut->addDestination(kPeriod);
+    }
+
+    // One cycle of the DuplicatingThread.
+    ssize_t write() {
+        std::vector<Sample> data(kPeriod);
+        std::iota(data.begin(), data.end(), mNextSample);
+        mNextSample += kPeriod;
+        return mFanOut->write(mDestinations, data.data(), kPeriod, kWaitTimeMs);
+    }
+
+    const sp<OutputFanOut> mFanOut = sp<OutputFanOut>::make(2 * kPeriod, sizeof(Sample));
+    std::vector<OutputFanOut::Destination*> mDestinations;
+    Sample mNextSample = 0;
+};
+
+void expectContiguous(const std::vector<Sample>& received, Sample first) {
+    for (size_t i = 0; i < received.size(); i++) {
+        ASSERT_EQ(first + (Sample)i, received[i]) << "at frame " << i;
+    }
+}
+
+void expectIncreasing(const std::vector<Sample>& received) {
+    for (size_t i = 1; i < received.size(); i++) {
+        ASSERT_LT(received[i - 1], received[i]) << "at frame " << i;
+    }
+}
+
+TEST_F(OutputFanOutTest, LaggingDestinationIsNotOverwritten) {
+    TestDestination fast(1, *mFanOut);
+    TestDestination lagging(2, *mFanOut);
+    mDestinations = {&fast, &lagging};
+
+    constexpr int kCycles = 16;
+    constexpr int kLagCycles = 3;  // fewer than the writes before a destination is dropped
+    for (int cycle = 0; cycle < kCycles; cycle++) {
+        EXPECT_EQ((ssize_t)kPeriod, write());
+        fast.read(kPeriod);
+        if (cycle == 0 || cycle > kLagCycles) {
+            lagging.read(2 * kPeriod);  // reads faster to catch up
+        }
+    }
+
+    // the writes waited for the lagging destination, the data was queued, not overwritten
+    expectContiguous(fast.received(), 0);
+    expectContiguous(lagging.received(), 0);
+    EXPECT_TRUE(lagging.isActive());
+    EXPECT_GE(lagging.received().size(), fast.received().size() - 2 * kPeriod);
+    EXPECT_EQ(mFanOut->framesWritten() + (int64_t)mFanOut->framesQueued(), mNextSample);
+}
+
+TEST_F(OutputFanOutTest, QueueWrapsAround) {
+    // buffer two periods, so that a write can drain the queue
+    mFanOut->addDestination(2 * kPeriod);
+    TestDestination fast(1, *mFanOut);
+    TestDestination lagging(2, *mFanOut);
+    mDestinations = {&fast, &lagging};
+
+    // Each round queues data while a destination lags and drains it once it catches up.
+    // The data going through the queue is several times its size.
+    constexpr int kRounds = 12;
+    constexpr int kLagCycles = 3;  // fewer than the writes before a destination is dropped
+    constexpr int kCatchUpCycles = 6;
+    size_t maxQueued = 0;
+    for (int round = 0; round < kRounds; round++) {
+        for (int cycle = 0; cycle < kLagCycles + kCatchUpCycles; cycle++) {
+            EXPECT_EQ((ssize_t)kPeriod, write());
+            maxQueued = std::max(maxQueued, mFanOut->framesQueued());
+            // both read faster to drain the queue once the lagging one catches up
+            const bool catchingUp = cycle >= kLagCycles;
+            fast.read(catchingUp ? 2 * kPeriod : kPeriod);
+            if ((round == 0 && cycle == 0) || catchingUp) {
+                lagging.read(2 * kPeriod);
+            }
+        }
+        EXPECT_EQ(0u, mFanOut->framesQueued()) << "round " << round;
+    }
+
+    EXPECT_NE(0u, maxQueued);
+    expectContiguous(fast.received(), 0);
+    expectContiguous(lagging.received(), 0);
+    EXPECT_TRUE(lagging.isActive());
+    EXPECT_EQ(mFanOut->framesWritten(), mNextSample);
+}
+
+TEST_F(OutputFanOutTest, StalledDestinationIsDropped) {
+    TestDestination fast(1, *mFanOut);
+    TestDestination stalled(2, *mFanOut);
+    mDestinations = {&fast, &stalled};
+
+    constexpr int kCycles = 24;
+    for (int cycle = 0; cycle < kCycles; cycle++) {
+        write();
+        fast.read(kPeriod);
+    }
+    // flushed and stopped: the frames it did not play are not handed out after the ring
+    // moved on without it.
+    EXPECT_FALSE(stalled.isActive());
+    EXPECT_TRUE(stalled.received().empty());
+    const size_t receivedWhileStalled = fast.received().size();
+    EXPECT_GT(receivedWhileStalled, 4 * kPeriod);
+    expectIncreasing(fast.received());
+
+    // the thread of the destination recovers and discards its buffer, the destination
+    // rejoins at the rear of the ring.
+    stalled.read(kPeriod);
+    EXPECT_TRUE(stalled.received().empty());
+    for (int cycle = 0; cycle < kCycles; cycle++) {
+        EXPECT_EQ((ssize_t)kPeriod, write());
+        fast.read(kPeriod);
+        stalled.read(kPeriod);
+    }
+    EXPECT_TRUE(stalled.isActive());
+    ASSERT_FALSE(stalled.received().empty());
+    const Sample first = stalled.received().front();
+    expectIncreasing(stalled.received());
+    // the same data as the destination which kept up
+    const auto& fastReceived = fast.received();
+    const auto it = std::find(fastReceived.begin(), fastReceived.end(), first);
+    ASSERT_NE(fastReceived.end(), it);
+    EXPECT_TRUE(std::equal(stalled.received().begin(), stalled.received().end(), it));
+    expectIncreasing(fast.received());
+}
+
+TEST_F(OutputFanOutTest, StoppingDestinationKeepsQueueOfOthers) {
+    TestDestination fast(1, *mFanOut);
+    TestDestination stopping(2, *mFanOut);
+    TestDestination lagging(3, *mFanOut);
+    mDestinations = {&fast, &stopping, &lagging};
+
+    constexpr int kCycles = 16;
+    constexpr int kStopCycle = 4;
+    for (int cycle = 0; cycle < kCycles; cycle++) {
+        if (cycle == kStopCycle) {
+            // data is queued for the lagging destination
+            ASSERT_NE(0u, mFanOut->framesQueued());
+            stopping.stop();
+        }
+        EXPECT_EQ((ssize_t)kPeriod, write());
+        fast.read(kPeriod);
+        stopping.read(kPeriod);
+        if (cycle == 0 || cycle > kStopCycle) {
+            lagging.read(2 * kPeriod);
+        }
+    }
+
+    // the queue was not dropped for the other destinations
+    expectContiguous(fast.received(), 0);
+    expectContiguous(lagging.received(), 0);
+    // restarted at the rear of the ring, after playing the frames released before stop()
+    EXPECT_TRUE(stopping.isActive());
+    expectIncreasing(stopping.received());
+    EXPECT_GT(stopping.received().size(), fast.received().size() / 2);
+}
+
+} // namespace
+} // namespace android
@@ -27,7 +27,9 @@
 #include <cutils/config_utils.h>
 #include <string>
 #include <map>
+#include <mutex>
 #include <utility>
+#include <vector>
 
 namespace android {
 
@@ -53,8 +55,13 @@ class VolumeCurve : public RefBase
 public:
     VolumeCurve(device_category device) : mDeviceCategory(device) {}
 
-    void add(const CurvePoint &point) { mCurvePoints.add(point); }
+    void add(const CurvePoint &point);
 
+    /**
+     * Returns the attenuation in dB for the given UI index. The result is served from a
+     * table precomputed for the [volIndexMin, volIndexMax] range, which is (re)built on first
+     * use after the range or the curve points changed.
+     */
     float volIndexToDb(int indexInUi, int volIndexMin, int volIndexMax) const;
 
     void dump(String8 *dst, int spaces = 0, bool curvePoints = false) const;
@@ -62,8 +69,20 @@ public:
     device_category getDeviceCategory() const { return mDeviceCategory; }
 
 private:
+    // Largest index range for which a lookup table is built. Wider ranges fall back to the
+    // interpolation on each query.
+    static constexpr int kMaxTableIndex = 1000;
+
+    float interpolateDb(int indexInUi, int volIndexMin, int volIndexMax) const;
+
     const device_category mDeviceCategory;
     SortedVector<CurvePoint> mCurvePoints;
+
+    mutable std::mutex mTableLock;
+    // Index range the table was built for, -1 if it needs to be rebuilt.
+    mutable int mTableIndexMin = -1;
+    mutable int mTableIndexMax = -1;
+    mutable std::vector<float> mDbTable; /**< attenuation in dB for UI index 0..max. */
 };
 
 // Volume Curves for a given use case indexed by device category
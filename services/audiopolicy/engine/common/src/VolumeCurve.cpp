@@ -23,7 +23,36 @@
 
 namespace android {
 
+void VolumeCurve::add(const CurvePoint &point)
+{
+    mCurvePoints.add(point);
+    std::lock_guard _l(mTableLock);
+    mTableIndexMin = -1;
+    mTableIndexMax = -1;
+    mDbTable.clear();
+}
+
 float VolumeCurve::volIndexToDb(int indexInUi, int volIndexMin, int volIndexMax) const
+{
+    if (volIndexMin < 0 || volIndexMax < 0 || volIndexMax > kMaxTableIndex ||
+            indexInUi < 0 || indexInUi > volIndexMax) {
+        return interpolateDb(indexInUi, volIndexMin, volIndexMax);
+    }
+    std::lock_guard _l(mTableLock);
+    if (volIndexMin != mTableIndexMin || volIndexMax != mTableIndexMax) {
+        ALOGV("%s: building table for device category %d, index range [%d %d]",
+              __func__, mDeviceCategory, volIndexMin, volIndexMax);
+        mDbTable.resize(volIndexMax + 1);
+        for (int index = 0; index <= volIndexMax; index++) {
+            mDbTable[index] = interpolateDb(index, volIndexMin, volIndexMax);
+        }
+        mTableIndexMin = volIndexMin;
+        mTableIndexMax = volIndexMax;
+    }
+    return mDbTable[indexInUi];
+}
+
+float VolumeCurve::interpolateDb(int indexInUi, int volIndexMin, int volIndexMax) const
 {
     ALOG_ASSERT(!mCurvePoints.isEmpty(), "Invalid volume curve");
     if (volIndexMin < 0 || volIndexMax < 0) {
@@ -102,6 +131,11 @@ void VolumeCurve::dump(String8 *dst, int spaces, bool curvePoints) const
                           mCurvePoints[i].mAttenuationInMb);
         dst->appendFormat(i == (mCurvePoints.size() - 1) ? " }\n" : ", ");
     }
+    std::lock_guard _l(mTableLock);
+    if (mTableIndexMax >= 0) {
+        dst->appendFormat("%*s  table for index range [%d %d], %zu entries\n", spaces, "",
+                          mTableIndexMin, mTableIndexMax, mDbTable.size());
+    }
 }
 
 void VolumeCurves::dump(String8 *dst, int spaces, bool curvePoints) const
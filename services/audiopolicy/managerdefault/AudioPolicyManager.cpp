@@ -221,6 +221,22 @@ status_t AudioPolicyManager::setDeviceConnectionStateInt(audio_devices_t deviceT
 
 status_t AudioPolicyManager::setDeviceConnectionStateInt(const sp<DeviceDescriptor> &device,
                                                          audio_policy_dev_state_t state)
+{
+    const nsecs_t startTimeNs = systemTime();
+    const status_t status = handleDeviceConnectionState(device, state);
+    const double timeMs = (systemTime() - startTimeNs) * 1e-6;
+    if (audio_is_output_device(device->type())) {
+        mOutputDeviceConnectionTimeMs.add(timeMs);
+    } else {
+        mInputDeviceConnectionTimeMs.add(timeMs);
+    }
+    ALOGV("%s() device %s state %d handled in %.3f ms, status %d", __func__,
+          device->toString().c_str(), state, timeMs, status);
+    return status;
+}
+
+status_t AudioPolicyManager::handleDeviceConnectionState(const sp<DeviceDescriptor> &device,
+                                                         audio_policy_dev_state_t state)
 {
     // handle output devices
     if (audio_is_output_device(device->type())) {
@@ -301,6 +317,8 @@ status_t AudioPolicyManager::setDeviceConnectionStateInt(const sp<DeviceDescript
             // remove device from mReportedFormatsMap cache
             mReportedFormatsMap.erase(device);
 
+            onDynamicProfileDeviceDisconnected(device);
+
             // remove preferred mixer configurations
             mPreferredMixerAttrInfos.erase(device->getId());
 
@@ -4254,6 +4272,11 @@ status_t AudioPolicyManager::unregisterPolicyMixes(Vector<AudioMix> mixes)
             }
             rSubmixModule->removeOutputProfile(address.c_str());
             rSubmixModule->removeInputProfile(address.c_str());
+            pruneDynamicProfileQueries([&](const sp<IOProfile>& profile,
+                                           const AudioDeviceTypeAddr&) {
+                return profile->getModule() == rSubmixModule
+                        && profile->getName() == address.c_str();
+            });
 
         } else if ((mix.mRouteFlags & MIX_ROUTE_FLAG_RENDER) == MIX_ROUTE_FLAG_RENDER) {
             if (mPolicyMixes.unregisterMix(mix) != NO_ERROR) {
@@ -4709,6 +4732,12 @@ void AudioPolicyManager::dump(String8 *dst) const
     dst->appendFormat(" Master mono: %s\n", mMasterMono ? "on" : "off");
     dst->appendFormat(" Communication Strategy id: %d\n", mCommunnicationStrategy);
     dst->appendFormat(" Config source: %s\n", mConfig->getSource().c_str());
+    dst->appendFormat(" Output device connection time (ms): %s\n",
+                      mOutputDeviceConnectionTimeMs.toString().c_str());
+    dst->appendFormat(" Input device connection time (ms): %s\n",
+                      mInputDeviceConnectionTimeMs.toString().c_str());
+    dst->appendFormat(" Dynamic profile queries cached: %zu, reused: %u\n",
+                      mDynamicProfileQueries.size(), mDynamicProfileQueryHits);
 
     dst->append("\n");
     mAvailableOutputDevices.dump(dst, String8("Available output"), 1);
@@ -9031,6 +9060,98 @@ void AudioPolicyManager::updateAudioProfiles(const sp<DeviceDescriptor>& devDesc
         mixPort.num_audio_profiles = modifiedNumProfiles;
     }
     profile->importAudioPort(mixPort);
+
+    // Only remember the query if the device reports its capabilities, so that a different
+    // device later connected with the same address is not given stale attributes. The queries
+    // are only reused when opening outputs.
+    if (devicePort.num_audio_profiles > 0 && audio_is_output_device(devDesc->type())) {
+        mDynamicProfileQueries[std::make_pair(profile, devDesc->getDeviceTypeAddr())] = {
+            .deviceProfiles = std::vector<audio_profile>(
+                    devicePort.audio_profiles,
+                    devicePort.audio_profiles + devicePort.num_audio_profiles),
+            .mixPort = mixPort,
+            .reportedFormats = mReportedFormatsMap[devDesc],
+        };
+    }
+}
+
+namespace {
+
+bool isSameAudioProfile(const audio_profile& profile1, const audio_profile& profile2) {
+    return profile1.format == profile2.format
+            && profile1.encapsulation_type == profile2.encapsulation_type
+            && std::equal(profile1.sample_rates,
+                          profile1.sample_rates + profile1.num_sample_rates,
+                          profile2.sample_rates,
+                          profile2.sample_rates + profile2.num_sample_rates)
+            && std::equal(profile1.channel_masks,
+                          profile1.channel_masks + profile1.num_channel_masks,
+                          profile2.channel_masks,
+                          profile2.channel_masks + profile2.num_channel_masks);
+}
+
+} // namespace
+
+bool AudioPolicyManager::applyCachedAudioProfiles(const sp<DeviceDescriptor>& devDesc,
+                                                  const sp<IOProfile>& profile) {
+    auto it = mDynamicProfileQueries.find(
+            std::make_pair(profile, devDesc->getDeviceTypeAddr()));
+    if (it == mDynamicProfileQueries.end()) {
+        return false;
+    }
+    audio_port_v7 devicePort;
+    devDesc->toAudioPort(&devicePort);
+    const std::vector<audio_profile>& deviceProfiles = it->second.deviceProfiles;
+    if (!std::equal(devicePort.audio_profiles,
+                    devicePort.audio_profiles + devicePort.num_audio_profiles,
+                    deviceProfiles.begin(), deviceProfiles.end(), isSameAudioProfile)) {
+        ALOGV("%s device %s capabilities changed, query profile %s again", __func__,
+              devDesc->toString().c_str(), profile->getTagName().c_str());
+        mDynamicProfileQueries.erase(it);
+        return false;
+    }
+    mReportedFormatsMap[devDesc] = it->second.reportedFormats;
+    profile->importAudioPort(it->second.mixPort);
+    mDynamicProfileQueryHits++;
+    ALOGV("%s reusing attributes of profile %s for device %s", __func__,
+          profile->getTagName().c_str(), devDesc->toString().c_str());
+    return true;
+}
+
+void AudioPolicyManager::pruneDynamicProfileQueries(
+        const std::function<bool(const sp<IOProfile>&, const AudioDeviceTypeAddr&)>& evict) {
+    for (auto it = mDynamicProfileQueries.begin(); it != mDynamicProfileQueries.end();) {
+        const sp<IOProfile> profile = it->first.first.promote();
+        if (profile == nullptr || evict(profile, it->first.second)) {
+            it = mDynamicProfileQueries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void AudioPolicyManager::onDynamicProfileDeviceDisconnected(const sp<DeviceDescriptor>& device) {
+    const AudioDeviceTypeAddr deviceTypeAddr = device->getDeviceTypeAddr();
+    auto it = std::find(mDynamicProfileQueryDevices.begin(), mDynamicProfileQueryDevices.end(),
+                        deviceTypeAddr);
+    if (it != mDynamicProfileQueryDevices.end()) {
+        mDynamicProfileQueryDevices.erase(it);
+    }
+    mDynamicProfileQueryDevices.push_front(deviceTypeAddr);
+    if (mDynamicProfileQueryDevices.size() <= kMaxDynamicProfileQueryDevices) {
+        pruneDynamicProfileQueries([](const sp<IOProfile>&, const AudioDeviceTypeAddr&) {
+            return false;
+        });
+        return;
+    }
+    const AudioDeviceTypeAddr evicted = mDynamicProfileQueryDevices.back();
+    mDynamicProfileQueryDevices.pop_back();
+    ALOGV("%s forgetting the profile queries of device %s", __func__,
+          evicted.toString().c_str());
+    pruneDynamicProfileQueries([&evicted](const sp<IOProfile>&,
+                                          const AudioDeviceTypeAddr& deviceTypeAddr) {
+        return deviceTypeAddr == evicted;
+    });
 }
 
 status_t AudioPolicyManager::installPatch(const char *caller,
@@ -9139,6 +9260,21 @@ sp<SwAudioOutputDescriptor> AudioPolicyManager::openOutputWithProfileAndDevice(
             return nullptr;
         }
     }
+    sp<DeviceDescriptor> device = devices.getDeviceForOpening();
+    // If the attributes of a dynamic profile were already queried for this device, open the
+    // output directly with the best configuration instead of opening it first to query them.
+    audio_config_t queriedConfig = AUDIO_CONFIG_INITIALIZER;
+    bool useQueriedProfiles = false;
+    if (halConfig == nullptr && profile->hasDynamicAudioProfile()
+            && applyCachedAudioProfiles(device, profile)) {
+        profile->pickAudioProfile(
+                queriedConfig.sample_rate, queriedConfig.channel_mask, queriedConfig.format);
+        queriedConfig.offload_info.sample_rate = queriedConfig.sample_rate;
+        queriedConfig.offload_info.channel_mask = queriedConfig.channel_mask;
+        queriedConfig.offload_info.format = queriedConfig.format;
+        halConfig = &queriedConfig;
+        useQueriedProfiles = true;
+    }
     sp<SwAudioOutputDescriptor> desc = new SwAudioOutputDescriptor(profile, mpClientInterface);
     audio_io_handle_t output = AUDIO_IO_HANDLE_NONE;
     status_t status = desc->open(halConfig, mixerConfig, devices,
@@ -9155,7 +9291,6 @@ sp<SwAudioOutputDescriptor> AudioPolicyManager::openOutputWithProfileAndDevice(
     }
 
     // Here is where the out_set_parameters() for card & device gets called
-    sp<DeviceDescriptor> device = devices.getDeviceForOpening();
     const audio_devices_t deviceType = device->type();
     const String8 &address = String8(device->address().c_str());
     if (!address.empty()) {
@@ -9163,7 +9298,9 @@ sp<SwAudioOutputDescriptor> AudioPolicyManager::openOutputWithProfileAndDevice(
         mpClientInterface->setParameters(output, String8(param));
         free(param);
     }
-    updateAudioProfiles(device, output, profile);
+    if (!useQueriedProfiles) {
+        updateAudioProfiles(device, output, profile);
+    }
     if (!profile->hasValidAudioProfile()) {
         ALOGW("%s() missing param", __func__);
         desc->close();
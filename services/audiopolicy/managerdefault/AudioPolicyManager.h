@@ -17,6 +17,7 @@
 #pragma once
 
 #include <atomic>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <unordered_set>
@@ -29,6 +30,7 @@
 #include <utils/Errors.h>
 #include <utils/KeyedVector.h>
 #include <utils/SortedVector.h>
+#include <audio_utils/Statistics.h>
 #include <media/AudioParameter.h>
 #include <media/AudioPolicy.h>
 #include <media/AudioProfile.h>
@@ -1044,6 +1046,26 @@ protected:
         // The map of device descriptor and formats reported by the device.
         std::map<wp<DeviceDescriptor>, FormatVector> mReportedFormatsMap;
 
+        // Attributes of the mix port queried for an IOProfile with dynamic audio profiles routed
+        // to a given device. Kept across connections of the device so that the output does not
+        // need to be opened first only to query them.
+        struct DynamicProfileQuery {
+            std::vector<audio_profile> deviceProfiles; // device capabilities at query time
+            audio_port_v7 mixPort;
+            FormatVector reportedFormats;
+        };
+        std::map<std::pair<wp<IOProfile>, AudioDeviceTypeAddr>, DynamicProfileQuery>
+                mDynamicProfileQueries;
+        uint32_t mDynamicProfileQueryHits = 0;
+        // The queries are kept for the most recently disconnected output devices only, so that
+        // devices connected with a new address each time do not grow the cache.
+        static constexpr size_t kMaxDynamicProfileQueryDevices = 4;
+        std::deque<AudioDeviceTypeAddr> mDynamicProfileQueryDevices; // most recent first
+
+        // Time spent handling device connection state changes.
+        audio_utils::Statistics<double> mOutputDeviceConnectionTimeMs{0.9 /* alpha */};
+        audio_utils::Statistics<double> mInputDeviceConnectionTimeMs{0.9 /* alpha */};
+
         // Cached product strategy ID corresponding to legacy strategy STRATEGY_PHONE
         product_strategy_t mCommunnicationStrategy;
 
@@ -1106,6 +1128,21 @@ protected:
         void updateAudioProfiles(const sp<DeviceDescriptor>& devDesc, audio_io_handle_t ioHandle,
                 const sp<IOProfile> &profiles);
 
+        // Resolve the "dynamic" fields of the IOProfile from the attributes previously queried
+        // for the same device, if the device still reports the same capabilities.
+        // Returns true if the IOProfile was updated.
+        bool applyCachedAudioProfiles(const sp<DeviceDescriptor>& devDesc,
+                const sp<IOProfile> &profile);
+
+        // Forgets the dynamic profile queries for which evict() returns true, and those of the
+        // IOProfiles which no longer exist.
+        void pruneDynamicProfileQueries(
+                const std::function<bool(const sp<IOProfile>&, const AudioDeviceTypeAddr&)>& evict);
+
+        // Keeps the dynamic profile queries of an output device being disconnected, and forgets
+        // those of the least recently disconnected devices.
+        void onDynamicProfileDeviceDisconnected(const sp<DeviceDescriptor>& device);
+
         // Notify the policy client to prepare for disconnecting external device.
         void prepareToDisconnectExternalDevice(const sp<DeviceDescriptor> &device);
 
@@ -1254,6 +1291,9 @@ protected:
                                              audio_format_t encodedFormat);
         status_t setDeviceConnectionStateInt(const sp<DeviceDescriptor> &device,
                                              audio_policy_dev_state_t state);
+        // Called by setDeviceConnectionStateInt(), which records the time spent.
+        status_t handleDeviceConnectionState(const sp<DeviceDescriptor> &device,
+                                             audio_policy_dev_state_t state);
 
         void setEngineDeviceConnectionState(const sp<DeviceDescriptor> device,
                                       audio_policy_dev_state_t state);
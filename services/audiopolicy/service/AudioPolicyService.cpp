@@ -21,6 +21,7 @@
 #include <stdint.h>
 #include <sys/time.h>
 #include <dlfcn.h>
+#include <map>
 
 #include <audio_utils/clock.h>
 #include <binder/IServiceManager.h>
@@ -1806,14 +1807,33 @@ bool AudioPolicyService::AudioCommandThread::threadLoop()
 
                 switch (command->mCommand) {
                 case SET_VOLUME: {
-                    VolumeData *data = (VolumeData *)command->mParam.get();
-                    ALOGV("AudioCommandThread() processing set volume stream %d, \
-                            volume %f, output %d", data->mStream, data->mVolume, data->mIO);
+                    // Volume commands already due were most likely issued for the same routing
+                    // decision: send them to audio flinger in a single transaction.
+                    std::vector<sp<AudioCommand>> volumeCommands{command};
+                    while (!mAudioCommands.isEmpty() &&
+                            mAudioCommands[0]->mCommand == SET_VOLUME &&
+                            mAudioCommands[0]->mTime <= curTime) {
+                        volumeCommands.push_back(mAudioCommands[0]);
+                        mAudioCommands.removeAt(0);
+                        if (mAudioCommands.isEmpty()) {
+                            ++numTimesBecameEmpty;
+                        }
+                    }
                     ul.unlock();
-                    command->mStatus = AudioSystem::setStreamVolume(data->mStream,
-                                                                    data->mVolume,
-                                                                    data->mIO);
+                    std::vector<status_t> statuses;
+                    sendVolumeCommands(volumeCommands, &statuses);
                     ul.lock();
+                    for (size_t i = 0; i < volumeCommands.size(); ++i) {
+                        const sp<AudioCommand>& volumeCommand = volumeCommands[i];
+                        volumeCommand->mStatus = statuses[i];
+                        if (volumeCommand == command) continue;
+                        // the status of the current command is reported below
+                        audio_utils::lock_guard _l(volumeCommand->mMutex);
+                        if (volumeCommand->mWaitStatus) {
+                            volumeCommand->mWaitStatus = false;
+                            volumeCommand->mCond.notify_one();
+                        }
+                    }
                     }break;
                 case SET_PARAMETERS: {
                     ParametersData *data = (ParametersData *)command->mParam.get();
@@ -2140,6 +2160,55 @@ status_t AudioPolicyService::AudioCommandThread::volumeCommand(audio_stream_type
     return sendCommand(command, delayMs);
 }
 
+void AudioPolicyService::AudioCommandThread::sendVolumeCommands(
+        const std::vector<sp<AudioCommand>>& commands, std::vector<status_t> *statuses)
+{
+    // An invalid command fails on its own, the others are still sent.
+    statuses->assign(commands.size(), NO_ERROR);
+    std::vector<size_t> sent;
+    sent.reserve(commands.size());
+    // Only keep the last volume requested for a given stream and output: intermediate values
+    // would be overwritten before audio flinger mixes a single buffer.
+    std::vector<media::StreamVolumeInfo> volumes;
+    std::map<std::pair<audio_stream_type_t, audio_io_handle_t>, size_t> volumeIndexes;
+    for (size_t i = 0; i < commands.size(); ++i) {
+        VolumeData *data = (VolumeData *)commands[i]->mParam.get();
+        ALOGV("AudioCommandThread() processing set volume stream %d, volume %f, output %d",
+                data->mStream, data->mVolume, data->mIO);
+        const ConversionResult<media::audio::common::AudioStreamType> stream =
+                legacy2aidl_audio_stream_type_t_AudioStreamType(data->mStream);
+        const ConversionResult<int32_t> output = legacy2aidl_audio_io_handle_t_int32_t(data->mIO);
+        if (uint32_t(data->mStream) >= AUDIO_STREAM_CNT || data->mIO == AUDIO_IO_HANDLE_NONE
+                || !stream.ok() || !output.ok()) {
+            ALOGW("%s: invalid stream %d or output %d", __func__, data->mStream, data->mIO);
+            (*statuses)[i] = BAD_VALUE;
+            continue;
+        }
+        sent.push_back(i);
+        media::StreamVolumeInfo volume;
+        volume.stream = stream.value();
+        volume.volume = data->mVolume;
+        volume.output = output.value();
+        const auto [it, inserted] =
+                volumeIndexes.emplace(std::make_pair(data->mStream, data->mIO), volumes.size());
+        if (inserted) {
+            volumes.push_back(volume);
+        } else {
+            ALOGV("Coalescing volume command on output %d for stream %d", data->mIO,
+                    data->mStream);
+            volumes[it->second] = volume;
+        }
+    }
+    if (volumes.empty()) {
+        return;
+    }
+    const sp<IAudioFlinger> af = AudioSystem::get_audio_flinger();
+    const status_t status = af != nullptr ? af->setStreamVolumes(volumes) : PERMISSION_DENIED;
+    for (size_t i : sent) {
+        (*statuses)[i] = status;
+    }
+}
+
 status_t AudioPolicyService::AudioCommandThread::parametersCommand(audio_io_handle_t ioHandle,
                                                                    const char *keyValuePairs,
                                                                    int delayMs)
@@ -655,6 +655,11 @@ private:
     private:
         class AudioCommandData;
 
+        // sends the volumes of one or more SET_VOLUME commands in one audio flinger transaction
+        // and returns the status of each command
+        static      void        sendVolumeCommands(const std::vector<sp<AudioCommand>>& commands,
+                                                   std::vector<status_t> *statuses);
+
         // descriptor for requested tone playback event
         class AudioCommand: public RefBase {
 
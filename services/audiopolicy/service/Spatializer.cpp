@@ -40,6 +40,7 @@
 #include <media/ShmemCompat.h>
 #include <mediautils/SchedulingPolicyService.h>
 #include <mediautils/ServiceUtilities.h>
+#include <utils/SystemClock.h>
 #include <utils/Thread.h>
 
 #include "Spatializer.h"
@@ -123,13 +124,8 @@ public:
         kWhatOnLatencyModesChanged, // Spatializer::onSupportedLatencyModesChanged
     };
     static constexpr const char *kNumFramesKey = "numFrames";
+    static constexpr const char *kTimeKey = "time";
     static constexpr const char *kModeKey = "mode";
-    static constexpr const char *kTranslation0Key = "translation0";
-    static constexpr const char *kTranslation1Key = "translation1";
-    static constexpr const char *kTranslation2Key = "translation2";
-    static constexpr const char *kRotation0Key = "rotation0";
-    static constexpr const char *kRotation1Key = "rotation1";
-    static constexpr const char *kRotation2Key = "rotation2";
     static constexpr const char *kLatencyModesKey = "latencyModes";
 
     class LatencyModes : public RefBase {
@@ -164,19 +160,17 @@ public:
                     ALOGE("%s: Cannot find num frames!", __func__);
                     return;
                 }
+                int64_t timeNs;
+                if (!msg->findInt64(kTimeKey, &timeNs)) {
+                    ALOGE("%s: Cannot find time!", __func__);
+                    return;
+                }
                 if (numFrames > 0) {
-                    spatializer->calculateHeadPose();
+                    spatializer->calculateHeadPose(timeNs);
                 }
                 } break;
             case kWhatOnHeadToStagePose: {
-                std::vector<float> headToStage(sHeadPoseKeys.size());
-                for (size_t i = 0 ; i < sHeadPoseKeys.size(); i++) {
-                    if (!msg->findFloat(sHeadPoseKeys[i], &headToStage[i])) {
-                        ALOGE("%s: Cannot find kTranslation0Key!", __func__);
-                        return;
-                    }
-                }
-                spatializer->onHeadToStagePoseMsg(headToStage);
+                spatializer->onHeadToStagePoseMsg(spatializer->mHeadPoseSlot.read());
                 } break;
             case kWhatOnActualModeChange: {
                 int mode;
@@ -207,15 +201,6 @@ private:
     std::once_flag mPrioritySetFlag;
 };
 
-const std::vector<const char *> Spatializer::sHeadPoseKeys = {
-    Spatializer::EngineCallbackHandler::kTranslation0Key,
-    Spatializer::EngineCallbackHandler::kTranslation1Key,
-    Spatializer::EngineCallbackHandler::kTranslation2Key,
-    Spatializer::EngineCallbackHandler::kRotation0Key,
-    Spatializer::EngineCallbackHandler::kRotation1Key,
-    Spatializer::EngineCallbackHandler::kRotation2Key,
-};
-
 // Mapping table between strings read form property bluetooth.core.le.dsa_transport_preference
 // and low latency modes emums.
 //TODO b/273373363: use AIDL enum when available
@@ -821,14 +806,42 @@ void Spatializer::onHeadToStagePose(const Pose3f& headToStage) {
             "onHeadToStagePose() called with no head tracking support!");
 
     auto vec = headToStage.toVector();
-    LOG_ALWAYS_FATAL_IF(vec.size() != sHeadPoseKeys.size(),
+    LOG_ALWAYS_FATAL_IF(vec.size() != HeadPoseSlot::kSize,
             "%s invalid head to stage vector size %zu", __func__, vec.size());
-    sp<AMessage> msg =
-            new AMessage(EngineCallbackHandler::kWhatOnHeadToStagePose, mHandler);
-    for (size_t i = 0 ; i < sHeadPoseKeys.size(); i++) {
-        msg->setFloat(sHeadPoseKeys[i], vec[i]);
+    // Only the latest pose is delivered: poses calculated while a message is pending
+    // replace the one in the slot.
+    if (mHeadPoseSlot.write(vec)) {
+        sp<AMessage> msg =
+                new AMessage(EngineCallbackHandler::kWhatOnHeadToStagePose, mHandler);
+        msg->post();
     }
-    msg->post();
+}
+
+bool Spatializer::HeadPoseSlot::write(const std::vector<float>& pose) {
+    const uint32_t sequence = mSequence.load(std::memory_order_relaxed);
+    mSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kSize; ++i) {
+        mPose[i].store(pose[i], std::memory_order_relaxed);
+    }
+    mSequence.store(sequence + 2, std::memory_order_release);
+    return !mPending.exchange(true, std::memory_order_acq_rel);
+}
+
+std::vector<float> Spatializer::HeadPoseSlot::read() {
+    // Clear first so that a pose written from now on posts another message.
+    mPending.store(false, std::memory_order_release);
+    std::vector<float> pose(kSize);
+    uint32_t before, after;
+    do {
+        before = mSequence.load(std::memory_order_acquire);
+        for (size_t i = 0; i < kSize; ++i) {
+            pose[i] = mPose[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = mSequence.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+    return pose;
 }
 
 void Spatializer::resetEngineHeadPose_l() {
@@ -970,6 +983,7 @@ status_t Spatializer::attachOutput(audio_io_handle_t output, size_t numActiveTra
         outputChanged = mOutput != output;
         mOutput = output;
         mNumActiveTracks = numActiveTracks;
+        updateOutputTiming_l();
         AudioSystem::addSupportedLatencyModesCallback(this);
 
         std::vector<audio_latency_mode_t> latencyModes;
@@ -1171,6 +1185,7 @@ void Spatializer::checkPoseController_l() {
         LOG_ALWAYS_FATAL_IF(mPoseController == nullptr,
                             "%s could not allocate pose controller", __func__);
         mPoseController->setDisplayOrientation(mDisplayOrientation);
+        mPoseController->setOutputTiming(mOutputPeriodNs, mOutputLatencyNs);
     } else if (!isControllerNeeded && mPoseController != nullptr) {
         mPoseController.reset();
         resetEngineHeadPose_l();
@@ -1180,11 +1195,11 @@ void Spatializer::checkPoseController_l() {
     }
 }
 
-void Spatializer::calculateHeadPose() {
+void Spatializer::calculateHeadPose(int64_t timeNs) {
     ALOGV("%s", __func__);
     audio_utils::lock_guard lock(mMutex);
     if (mPoseController != nullptr) {
-        mPoseController->calculateAsync();
+        mPoseController->onFramesProcessed(timeNs);
     }
 }
 
@@ -1192,9 +1207,30 @@ void Spatializer::onFramesProcessed(int32_t framesProcessed) {
     sp<AMessage> msg =
             new AMessage(EngineCallbackHandler::kWhatOnFramesProcessed, mHandler);
     msg->setInt32(EngineCallbackHandler::kNumFramesKey, framesProcessed);
+    msg->setInt64(EngineCallbackHandler::kTimeKey, elapsedRealtimeNano());
     msg->post();
 }
 
+void Spatializer::updateOutputTiming_l() {
+    uint32_t latencyMs = 0;
+    size_t frameCount = 0;
+    uint32_t sampleRate = 0;
+    if (AudioSystem::getLatency(mOutput, &latencyMs) != NO_ERROR
+            || AudioSystem::getFrameCount(mOutput, &frameCount) != NO_ERROR
+            || AudioSystem::getSamplingRate(mOutput, &sampleRate) != NO_ERROR
+            || sampleRate == 0) {
+        ALOGW("%s cannot get timing of output %d", __func__, (int)mOutput);
+        mOutputPeriodNs = 0;
+        mOutputLatencyNs = 0;
+    } else {
+        mOutputPeriodNs = static_cast<int64_t>(frameCount) * 1'000'000'000LL / sampleRate;
+        mOutputLatencyNs = static_cast<int64_t>(latencyMs) * 1'000'000LL;
+    }
+    if (mPoseController != nullptr) {
+        mPoseController->setOutputTiming(mOutputPeriodNs, mOutputLatencyNs);
+    }
+}
+
 std::string Spatializer::toString(unsigned level) const {
     std::string prefixSpace(level, ' ');
     std::string ss = prefixSpace + "Spatializer:\n";
@@ -25,6 +25,8 @@
 #include <android/media/audio/common/Spatialization.h>
 #include <audio_utils/mutex.h>
 #include <audio_utils/SimpleLog.h>
+#include <array>
+#include <atomic>
 #include <math.h>
 #include <media/AudioEffect.h>
 #include <media/MediaMetricsItem.h>
@@ -204,7 +206,8 @@ class Spatializer : public media::BnSpatializer,
     /** Gets the channel mask, sampling rate and format set for the spatializer input. */
     audio_config_base_t getAudioInConfig() const;
 
-    void calculateHeadPose();
+    /** Calculates the head pose for the buffer following the one processed at timeNs. */
+    void calculateHeadPose(int64_t timeNs);
 
     /** Convert fields in Spatializer and sub-modules to a string. Disable thread-safety-analysis
      * here because we want to dump mutex guarded members even try_lock failed to provide as much
@@ -421,6 +424,12 @@ private:
      */
     void checkPoseController_l() REQUIRES(mMutex);
 
+    /**
+     * Gets the mixer period and latency of the output, used by the pose controller to
+     * predict the head pose for the time the audio is heard.
+     */
+    void updateOutputTiming_l() REQUIRES(mMutex);
+
     /**
      * Checks if the spatializer effect should be enabled based on
      * playback activity and requested level.
@@ -540,6 +549,9 @@ private:
     sp<EngineCallbackHandler> mHandler;
 
     size_t mNumActiveTracks GUARDED_BY(mMutex) = 0;
+    /** Mixer period and latency of mOutput, 0 if unknown */
+    int64_t mOutputPeriodNs GUARDED_BY(mMutex) = 0;
+    int64_t mOutputLatencyNs GUARDED_BY(mMutex) = 0;
     std::vector<audio_latency_mode_t> mSupportedLatencyModes GUARDED_BY(mMutex);
     /** preference order for low latency modes according to persist.bluetooth.hid.transport */
     std::vector<audio_latency_mode_t> mOrderedLowLatencyModes;
@@ -548,7 +560,25 @@ private:
 
     /** string to latency mode map used to parse bluetooth.core.le.dsa_transport_preference */
     static const std::map<std::string, audio_latency_mode_t> sStringToLatencyModeMap;
-    static const std::vector<const char*> sHeadPoseKeys;
+
+    /**
+     * Latest head to stage pose calculated by the pose controller, handed to the looper
+     * thread without lock. Single writer: the pose controller thread.
+     */
+    class HeadPoseSlot {
+      public:
+        static constexpr size_t kSize = 6;  // translation and rotation vectors
+
+        // Returns true if no message is pending for a previous pose.
+        bool write(const std::vector<float>& pose);
+        std::vector<float> read();
+
+      private:
+        std::atomic<uint32_t> mSequence = 0;  // odd while writing
+        std::array<std::atomic<float>, kSize> mPose{};
+        std::atomic<bool> mPending = false;
+    };
+    HeadPoseSlot mHeadPoseSlot;
 
     // Local log for command messages.
     static constexpr int mMaxLocalLogLine = 10;
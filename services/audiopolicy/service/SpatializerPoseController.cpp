@@ -16,6 +16,7 @@
 
 #include "SpatializerPoseController.h"
 #include <android-base/stringprintf.h>
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <string>
@@ -60,6 +61,10 @@ constexpr float kMaxRotationalVelocity = 0.8f;
 // is achievable with reasonable confidence as the "best prediction".
 constexpr auto kPredictionDuration = 120ms;
 
+// When the output timing is known, the prediction duration is the time from a head sample to
+// the presentation of the audio rendered with it, limited to this.
+constexpr auto kMaxPredictionDuration = 250ms;
+
 // After not getting a pose sample for this long, we would treat the measurement as stale.
 // The max connection interval is 50ms, and HT sensor event interval can differ depending on the
 // sampling rate, scheduling, sensor eventQ FIFO etc. 120 (2 * 50 + 20) ms seems reasonable for now.
@@ -169,6 +174,12 @@ SpatializerPoseController::SpatializerPoseController(Listener* listener,
           if (isValidPosePredictorType(posePredictorType)) {
               mProcessor->setPosePredictorType(posePredictorType);
           }
+          const int durationMs =
+                  property_get_int32("audio.spatializer.prediction_duration_ms", -1);
+          std::lock_guard lock(mMutex);
+          mFixedPredictionDuration = durationMs >= 0;
+          mPredictionDurationNs = mFixedPredictionDuration
+                  ? durationMs * 1'000'000LL : Ticks(kPredictionDuration).count();
       }
 
 SpatializerPoseController::~SpatializerPoseController() {
@@ -282,14 +293,48 @@ void SpatializerPoseController::waitUntilCalculated() {
     mCondVar.wait(lock, [this] { return mCalculated; });
 }
 
+void SpatializerPoseController::setOutputTiming(int64_t periodNs, int64_t latencyNs) {
+    ALOGV("%s: period %lld ns latency %lld ns", __func__, (long long)periodNs,
+            (long long)latencyNs);
+    mOutputPeriodNs = std::max(periodNs, int64_t{0});
+    mOutputLatencyNs = std::max(latencyNs, int64_t{0});
+}
+
+void SpatializerPoseController::onFramesProcessed(int64_t timeNs) {
+    mLastProcessedNs = timeNs;
+    calculateAsync();
+}
+
+std::optional<int64_t> SpatializerPoseController::presentationTimeNs(int64_t timeNs) const {
+    const int64_t periodNs = mOutputPeriodNs;
+    const int64_t lastProcessedNs = mLastProcessedNs;
+    if (periodNs == 0 || lastProcessedNs == 0) {
+        return std::nullopt;
+    }
+    // next buffer processed after timeNs, assuming a steady mixer period
+    int64_t nextProcessedNs = lastProcessedNs + periodNs;
+    if (timeNs >= nextProcessedNs) {
+        nextProcessedNs += (timeNs - lastProcessedNs) / periodNs * periodNs;
+    }
+    return nextProcessedNs + mOutputLatencyNs;
+}
+
 std::tuple<media::Pose3f, std::optional<media::HeadTrackingMode>>
 SpatializerPoseController::calculate_l() {
     Pose3f headToStage;
     HeadTrackingMode mode;
     std::optional<media::HeadTrackingMode> modeIfChanged;
 
-    mProcessor->calculate(elapsedRealtimeNano());
+    const int64_t now = elapsedRealtimeNano();
+    mProcessor->calculate(now);
     headToStage = mProcessor->getHeadToStagePose();
+    if (const auto presentationNs = presentationTimeNs(now);
+            presentationNs.has_value() && mLastHeadTimestamp.has_value()) {
+        constexpr float NANOS_TO_MILLIS = 1e-6;
+        const float latencyMs = (presentationNs.value() - mLastHeadTimestamp.value())
+                * NANOS_TO_MILLIS;
+        mLatencyHistogram.add(latencyMs, latencyMs - mPredictionDurationNs * NANOS_TO_MILLIS);
+    }
     mode = mProcessor->getActualMode();
     if (!mActualMode.has_value() || mActualMode.value() != mode) {
         mActualMode = mode;
@@ -305,57 +350,95 @@ void SpatializerPoseController::recenter() {
 
 void SpatializerPoseController::onPose(int64_t timestamp, int32_t sensor, const Pose3f& pose,
                                        const std::optional<Twist3f>& twist, bool isNewReference) {
+    const SensorPoseProvider::Listener::PoseSample sample{
+            timestamp, sensor, pose, twist, isNewReference};
+    onPoses(&sample, 1);
+}
+
+void SpatializerPoseController::onPoses(const SensorPoseProvider::Listener::PoseSample* samples,
+                                        size_t count) {
     std::lock_guard lock(mMutex);
     constexpr float NANOS_TO_MILLIS = 1e-6;
     constexpr float RAD_TO_DEGREE = 180.f / M_PI;
 
-    const float delayMs = (elapsedRealtimeNano() - timestamp) * NANOS_TO_MILLIS; // CLOCK_BOOTTIME
-
-    if (sensor == mHeadSensor) {
-        std::vector<float> pryprydt(8);  // pitch, roll, yaw, d_pitch, d_roll, d_yaw,
-                                         // discontinuity, timestamp_delay
-        media::quaternionToAngles(pose.rotation(), &pryprydt[0], &pryprydt[1], &pryprydt[2]);
-        if (twist) {
-            const auto rotationalVelocity = twist->rotationalVelocity();
-            // The rotational velocity is an intrinsic transform (i.e. based on the head
-            // coordinate system, not the world coordinate system).  It is a 3 element vector:
-            // axis (d theta / dt).
-            //
-            // We leave rotational velocity relative to the head coordinate system,
-            // as the initial head tracking sensor's world frame is arbitrary.
-            media::quaternionToAngles(media::rotationVectorToQuaternion(rotationalVelocity),
-                    &pryprydt[3], &pryprydt[4], &pryprydt[5]);
-        }
-        pryprydt[6] = isNewReference;
-        pryprydt[7] = delayMs;
-        for (size_t i = 0; i < 6; ++i) {
-            // pitch, roll, yaw in degrees, referenced in degrees on the world frame.
-            // d_pitch, d_roll, d_yaw rotational velocity in degrees/s, based on the world frame.
-            pryprydt[i] *= RAD_TO_DEGREE;
+    const int64_t nowNs = elapsedRealtimeNano();  // CLOCK_BOOTTIME
+    for (size_t i = 0; i < count; ++i) {
+        const auto& [timestamp, sensor, pose, twist, isNewReference] = samples[i];
+        const float delayMs = (nowNs - timestamp) * NANOS_TO_MILLIS;
+
+        if (sensor == mHeadSensor) {
+            std::vector<float> pryprydt(8);  // pitch, roll, yaw, d_pitch, d_roll, d_yaw,
+                                             // discontinuity, timestamp_delay
+            media::quaternionToAngles(pose.rotation(), &pryprydt[0], &pryprydt[1], &pryprydt[2]);
+            if (twist) {
+                const auto rotationalVelocity = twist->rotationalVelocity();
+                // The rotational velocity is an intrinsic transform (i.e. based on the head
+                // coordinate system, not the world coordinate system).  It is a 3 element vector:
+                // axis (d theta / dt).
+                //
+                // We leave rotational velocity relative to the head coordinate system,
+                // as the initial head tracking sensor's world frame is arbitrary.
+                media::quaternionToAngles(media::rotationVectorToQuaternion(rotationalVelocity),
+                        &pryprydt[3], &pryprydt[4], &pryprydt[5]);
+            }
+            pryprydt[6] = isNewReference;
+            pryprydt[7] = delayMs;
+            for (size_t j = 0; j < 6; ++j) {
+                // pitch, roll, yaw in degrees, referenced in degrees on the world frame.
+                // d_pitch, d_roll, d_yaw rotational velocity in degrees/s, based on the world
+                // frame.
+                pryprydt[j] *= RAD_TO_DEGREE;
+            }
+            mHeadSensorRecorder.record(pryprydt);
+            mHeadSensorDurableRecorder.record(pryprydt);
+
+            // The samples read together from the sensor FIFO are given to the processor at once.
+            mHeadSamples.push_back(HeadTrackingProcessor::HeadSample{
+                    timestamp, pose, twist.value_or(Twist3f()) / kTicksPerSecond});
+            if (isNewReference) {
+                setWorldToHeadPoses_l();
+                mProcessor->recenter(true, false, __func__);
+            }
         }
-        mHeadSensorRecorder.record(pryprydt);
-        mHeadSensorDurableRecorder.record(pryprydt);
+        if (sensor == mScreenSensor) {
+            std::vector<float> pryt{ 0.f, 0.f, 0.f, delayMs}; // pitch, roll, yaw, timestamp_delay
+            media::quaternionToAngles(pose.rotation(), &pryt[0], &pryt[1], &pryt[2]);
+            for (size_t j = 0; j < 3; ++j) {
+                pryt[j] *= RAD_TO_DEGREE;
+            }
+            mScreenSensorRecorder.record(pryt);
+            mScreenSensorDurableRecorder.record(pryt);
 
-        mProcessor->setWorldToHeadPose(timestamp, pose,
-                                       twist.value_or(Twist3f()) / kTicksPerSecond);
-        if (isNewReference) {
-            mProcessor->recenter(true, false, __func__);
+            setWorldToHeadPoses_l();  // in the order of the events
+            mProcessor->setWorldToScreenPose(timestamp, pose);
+            if (isNewReference) {
+                mProcessor->recenter(false, true, __func__);
+            }
         }
     }
-    if (sensor == mScreenSensor) {
-        std::vector<float> pryt{ 0.f, 0.f, 0.f, delayMs}; // pitch, roll, yaw, timestamp_delay
-        media::quaternionToAngles(pose.rotation(), &pryt[0], &pryt[1], &pryt[2]);
-        for (size_t i = 0; i < 3; ++i) {
-            pryt[i] *= RAD_TO_DEGREE;
-        }
-        mScreenSensorRecorder.record(pryt);
-        mScreenSensorDurableRecorder.record(pryt);
+    setWorldToHeadPoses_l();
+}
 
-        mProcessor->setWorldToScreenPose(timestamp, pose);
-        if (isNewReference) {
-            mProcessor->recenter(false, true, __func__);
+void SpatializerPoseController::setWorldToHeadPoses_l() {
+    if (mHeadSamples.empty()) {
+        return;
+    }
+    const int64_t timestamp = mHeadSamples.back().timestamp;
+    // Predict the pose at the time the audio rendered with it is heard: the last sample is
+    // used by the first calculation after it, itself applied to the next buffer processed.
+    if (!mFixedPredictionDuration) {
+        if (const auto presentationNs = presentationTimeNs(timestamp);
+                presentationNs.has_value()) {
+            const int64_t calculationNs = presentationNs.value() - mOutputLatencyNs;
+            const auto appliedNs = presentationTimeNs(calculationNs);
+            mPredictionDurationNs = std::clamp(appliedNs.value() - timestamp,
+                    int64_t{0}, Ticks(kMaxPredictionDuration).count());
+            mProcessor->setPredictionDuration(mPredictionDurationNs);
         }
     }
+    mProcessor->setWorldToHeadPoses(mHeadSamples.data(), mHeadSamples.size());
+    mLastHeadTimestamp = timestamp;
+    mHeadSamples.clear();
 }
 
 std::string SpatializerPoseController::toString(unsigned level) const {
@@ -409,6 +492,13 @@ std::string SpatializerPoseController::toString(unsigned level) const {
         ss += "ActualMode NOTEXIST\n";
     }
 
+    base::StringAppendF(&ss, "%sPredictionDuration: %0.1f ms (%s)\n", prefixSpace.c_str(),
+            mPredictionDurationNs * 1e-6,
+            mFixedPredictionDuration ? "fixed" : mOutputPeriodNs != 0 ? "adaptive" : "default");
+    base::StringAppendF(&ss, "%sOutputTiming: period %0.1f ms latency %0.1f ms\n",
+            prefixSpace.c_str(), mOutputPeriodNs * 1e-6, mOutputLatencyNs * 1e-6);
+    ss += mLatencyHistogram.toString(level + 1);
+
     if (mProcessor) {
         ss += mProcessor->toString_l(level + 1);
     } else {
@@ -428,4 +518,40 @@ std::string SpatializerPoseController::toString(unsigned level) const {
     return ss;
 }
 
+void SpatializerPoseController::LatencyHistogram::add(float latencyMs, float predictionErrorMs) {
+    const size_t bin = latencyMs <= 0 ? 0 : std::min(static_cast<size_t>(latencyMs / kBinWidthMs),
+                                                     kBinCount - 1);
+    ++mBins[bin];
+    mLatencyStats.add(latencyMs);
+    mPredictionErrorStats.add(predictionErrorMs);
+}
+
+std::string SpatializerPoseController::LatencyHistogram::toString(unsigned level) const {
+    std::string prefixSpace(level, ' ');
+    std::string ss = prefixSpace + "MotionToAudioLatency:\n";
+    if (mLatencyStats.getN() == 0) {
+        return ss.append(prefixSpace).append(" no data\n");
+    }
+    base::StringAppendF(&ss, "%s latency: mean %0.1f ms stddev %0.1f min %0.1f max %0.1f "
+            "(%lld poses)\n", prefixSpace.c_str(), mLatencyStats.getMean(),
+            mLatencyStats.getStdDev(), mLatencyStats.getMin(), mLatencyStats.getMax(),
+            (long long)mLatencyStats.getN());
+    base::StringAppendF(&ss, "%s prediction error: mean %0.1f ms stddev %0.1f\n",
+            prefixSpace.c_str(), mPredictionErrorStats.getMean(),
+            mPredictionErrorStats.getStdDev());
+    ss.append(prefixSpace).append(" histogram (ms: count):");
+    for (size_t i = 0; i < kBinCount; ++i) {
+        if (mBins[i] == 0) continue;
+        if (i == kBinCount - 1) {
+            base::StringAppendF(&ss, " >=%0.f: %llu", i * kBinWidthMs,
+                    (unsigned long long)mBins[i]);
+        } else {
+            base::StringAppendF(&ss, " %0.f-%0.f: %llu", i * kBinWidthMs, (i + 1) * kBinWidthMs,
+                    (unsigned long long)mBins[i]);
+        }
+    }
+    ss += "\n";
+    return ss;
+}
+
 }  // namespace android
@@ -15,13 +15,17 @@
  */
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <limits>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
+#include <audio_utils/Statistics.h>
 #include <media/HeadTrackingProcessor.h>
 #include <media/SensorPoseProvider.h>
 #include <media/VectorRecorder.h>
@@ -114,6 +118,20 @@ class SpatializerPoseController : private media::SensorPoseProvider::Listener {
      */
     void waitUntilCalculated();
 
+    /**
+     * Sets the timing of the output rendering the poses: the mixer period and the latency from
+     * processing a buffer to its presentation, in ns. Once buffers are processed, the head pose
+     * is predicted for the presentation time of the audio it is applied to instead of a fixed
+     * duration. A zero periodNs disables this.
+     */
+    void setOutputTiming(int64_t periodNs, int64_t latencyNs);
+
+    /**
+     * Notifies that the spatializer processed a buffer at timeNs (CLOCK_BOOTTIME), and triggers
+     * a calculation as calculateAsync(). The pose calculated is applied to the next buffer.
+     */
+    void onFramesProcessed(int64_t timeNs);
+
     // convert fields to a printable string
     std::string toString(unsigned level) const;
 
@@ -144,6 +162,37 @@ class SpatializerPoseController : private media::SensorPoseProvider::Listener {
         4 /* vectorSize */, std::chrono::minutes(1), 10 /* maxLogLine */,
         { 3 } /* delimiterIdx */};
 
+    // Output timing, see setOutputTiming().
+    std::atomic<int64_t> mOutputPeriodNs = 0;
+    std::atomic<int64_t> mOutputLatencyNs = 0;
+    std::atomic<int64_t> mLastProcessedNs = 0;
+    // true if the prediction duration is set by property and never adapted.
+    bool mFixedPredictionDuration = false;
+    float mPredictionDurationNs = 0;            // used for the last head sample
+    std::optional<int64_t> mLastHeadTimestamp;  // last head sample
+    // onPoses() scratch, the head samples not given to the processor yet
+    std::vector<media::HeadTrackingProcessor::HeadSample> mHeadSamples;
+
+    /**
+     * Motion to audio latency: from a head sensor sample to the presentation of the first
+     * buffer rendered with the pose calculated from it, in ms. The prediction error is this
+     * latency minus the prediction duration used for the sample.
+     */
+    class LatencyHistogram {
+      public:
+        static constexpr float kBinWidthMs = 10.f;
+        static constexpr size_t kBinCount = 20;   // last bin is for anything above
+
+        void add(float latencyMs, float predictionErrorMs);
+        std::string toString(unsigned level) const;
+
+      private:
+        std::array<uint64_t, kBinCount> mBins{};
+        audio_utils::Statistics<double> mLatencyStats;
+        audio_utils::Statistics<double> mPredictionErrorStats;
+    };
+    LatencyHistogram mLatencyHistogram;
+
     // Next to last variable as releasing this stops the callbacks
     std::unique_ptr<media::SensorPoseProvider> mPoseProvider;
 
@@ -153,12 +202,27 @@ class SpatializerPoseController : private media::SensorPoseProvider::Listener {
 
     void onPose(int64_t timestamp, int32_t sensor, const media::Pose3f& pose,
                 const std::optional<media::Twist3f>& twist, bool isNewReference) override;
+    void onPoses(const media::SensorPoseProvider::Listener::PoseSample* samples,
+                 size_t count) override;
+
+    /**
+     * Gives the head samples batched by onPoses() to the processor. Must be called with the
+     * lock held.
+     */
+    void setWorldToHeadPoses_l();
 
     /**
      * Calculates the new outputs and updates internal state. Must be called with the lock held.
      * Returns values that should be passed to the respective callbacks.
      */
     std::tuple<media::Pose3f, std::optional<media::HeadTrackingMode>> calculate_l();
+
+    /**
+     * Returns the presentation time of the audio rendered with a pose calculated at timeNs:
+     * it is applied to the first buffer processed after timeNs. nullopt if the output timing
+     * is not known yet.
+     */
+    std::optional<int64_t> presentationTimeNs(int64_t timeNs) const;
 };
 
 }  // namespace android
@@ -219,23 +219,18 @@ public:
         return mAudioParameters.toString();
     }
 
+    status_t getAudioPort(struct audio_port_v7 *port) override {
+        if (!mReportDevicePortProfiles || port->type != AUDIO_PORT_TYPE_DEVICE) {
+            return AudioPolicyTestClient::getAudioPort(port);
+        }
+        fillAudioProfiles(port);
+        return NO_ERROR;
+    }
+
     status_t getAudioMixPort(const struct audio_port_v7 *devicePort __unused,
                              struct audio_port_v7 *mixPort) override {
-        mixPort->num_audio_profiles = 0;
-        for (auto format : mSupportedFormats) {
-            const int i = mixPort->num_audio_profiles;
-            mixPort->audio_profiles[i].format = format;
-            mixPort->audio_profiles[i].num_sample_rates = 1;
-            mixPort->audio_profiles[i].sample_rates[0] = 48000;
-            mixPort->audio_profiles[i].num_channel_masks = 0;
-            for (const auto& cm : mSupportedChannelMasks) {
-                if (audio_channel_mask_is_valid(cm)) {
-                    mixPort->audio_profiles[i].channel_masks[
-                            mixPort->audio_profiles[i].num_channel_masks++] = cm;
-                }
-            }
-            mixPort->num_audio_profiles++;
-        }
+        ++mAudioMixPortQueryCount;
+        fillAudioProfiles(mixPort);
         return NO_ERROR;
     }
 
@@ -256,12 +251,35 @@ public:
         mSupportedChannelMasks.insert(channelMask);
     }
 
+    // When set, getAudioPort() reports the supported formats as device port capabilities.
+    void setReportDevicePortProfiles(bool report) { mReportDevicePortProfiles = report; }
+
+    size_t getAudioMixPortQueryCount() const { return mAudioMixPortQueryCount; }
+
     bool getTrackInternalMute(audio_port_handle_t portId) {
         auto it = mTracksInternalMute.find(portId);
         return it == mTracksInternalMute.end() ? false : it->second;
     }
 
 private:
+    void fillAudioProfiles(struct audio_port_v7 *port) const {
+        port->num_audio_profiles = 0;
+        for (auto format : mSupportedFormats) {
+            const int i = port->num_audio_profiles;
+            port->audio_profiles[i].format = format;
+            port->audio_profiles[i].num_sample_rates = 1;
+            port->audio_profiles[i].sample_rates[0] = 48000;
+            port->audio_profiles[i].num_channel_masks = 0;
+            for (const auto& cm : mSupportedChannelMasks) {
+                if (audio_channel_mask_is_valid(cm)) {
+                    port->audio_profiles[i].channel_masks[
+                            port->audio_profiles[i].num_channel_masks++] = cm;
+                }
+            }
+            port->num_audio_profiles++;
+        }
+    }
+
     audio_module_handle_t mNextModuleHandle = AUDIO_MODULE_HANDLE_NONE + 1;
     audio_io_handle_t mNextIoHandle = AUDIO_IO_HANDLE_NONE + 1;
     audio_patch_handle_t mNextPatchHandle = AUDIO_PATCH_HANDLE_NONE + 1;
@@ -275,6 +293,8 @@ private:
     std::set<audio_channel_mask_t> mSupportedChannelMasks;
     std::map<audio_port_handle_t, bool> mTracksInternalMute;
     std::set<audio_io_handle_t> mOpenedInputs;
+    bool mReportDevicePortProfiles = false;
+    size_t mAudioMixPortQueryCount = 0;
 };
 
 } // namespace android
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+#include "AudioPolicyManagerTestClient.h"
+#include "AudioPolicyTestManager.h"
+
+using namespace android;
+
+// Applies the volume of every volume group on every opened output, as done on each
+// routing change, with the default configuration.
+static void BM_ApplyStreamVolumes(benchmark::State& state) {
+    std::unique_ptr<AudioPolicyManagerTestClient> client(new AudioPolicyManagerTestClient);
+    sp<AudioPolicyConfig> config = AudioPolicyConfig::createWritableForTests();
+    config->setDefault();
+    std::unique_ptr<AudioPolicyTestManager> manager(
+            new AudioPolicyTestManager(config, client.get()));
+    if (manager->initialize() != NO_ERROR || manager->initCheck() != NO_ERROR) {
+        state.SkipWithError("failed to initialize the audio policy manager");
+        return;
+    }
+    const SwAudioOutputCollection& outputs = manager->getOutputs();
+
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < outputs.size(); i++) {
+            const sp<SwAudioOutputDescriptor>& desc = outputs.valueAt(i);
+            manager->applyStreamVolumes(desc, desc->devices().types(), 0 /*delayMs*/,
+                                        true /*force*/);
+        }
+        benchmark::ClobberMemory();
+    }
+}
+
+BENCHMARK(BM_ApplyStreamVolumes);
+
+BENCHMARK_MAIN();
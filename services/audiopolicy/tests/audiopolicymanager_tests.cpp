@@ -1156,6 +1156,69 @@ TEST_F(AudioPolicyManagerTestWithConfigurationFile, RoutingChangedWithPreferredM
                                                            "", "", AUDIO_FORMAT_LDAC));
 }
 
+TEST_F(AudioPolicyManagerTestWithConfigurationFile, ReconnectionReusesDynamicProfileQuery) {
+    mClient->addSupportedFormat(AUDIO_FORMAT_PCM_16_BIT);
+    mClient->addSupportedChannelMask(AUDIO_CHANNEL_OUT_STEREO);
+    mClient->setReportDevicePortProfiles(true);
+    ASSERT_EQ(NO_ERROR, mManager->setDeviceConnectionState(AUDIO_DEVICE_OUT_USB_DEVICE,
+                                                           AUDIO_POLICY_DEVICE_STATE_AVAILABLE,
+                                                           "", "", AUDIO_FORMAT_DEFAULT));
+    const size_t queryCount = mClient->getAudioMixPortQueryCount();
+    EXPECT_GT(queryCount, 0);
+    ASSERT_EQ(NO_ERROR, mManager->setDeviceConnectionState(AUDIO_DEVICE_OUT_USB_DEVICE,
+                                                           AUDIO_POLICY_DEVICE_STATE_UNAVAILABLE,
+                                                           "", "", AUDIO_FORMAT_DEFAULT));
+
+    // The device reports the same capabilities, the dynamic profiles are not queried again.
+    ASSERT_EQ(NO_ERROR, mManager->setDeviceConnectionState(AUDIO_DEVICE_OUT_USB_DEVICE,
+                                                           AUDIO_POLICY_DEVICE_STATE_AVAILABLE,
+                                                           "", "", AUDIO_FORMAT_DEFAULT));
+    EXPECT_EQ(queryCount, mClient->getAudioMixPortQueryCount());
+    ASSERT_EQ(NO_ERROR, mManager->setDeviceConnectionState(AUDIO_DEVICE_OUT_USB_DEVICE,
+                                                           AUDIO_POLICY_DEVICE_STATE_UNAVAILABLE,
+                                                           "", "", AUDIO_FORMAT_DEFAULT));
+
+    // The device capabilities changed, the dynamic profiles are queried again.
+    mClient->addSupportedFormat(AUDIO_FORMAT_PCM_24_BIT_PACKED);
+    ASSERT_EQ(NO_ERROR, mManager->setDeviceConnectionState(AUDIO_DEVICE_OUT_USB_DEVICE,
+                                                           AUDIO_POLICY_DEVICE_STATE_AVAILABLE,
+                                                           "", "", AUDIO_FORMAT_DEFAULT));
+    EXPECT_GT(mClient->getAudioMixPortQueryCount(), queryCount);
+    ASSERT_EQ(NO_ERROR, mManager->setDeviceConnectionState(AUDIO_DEVICE_OUT_USB_DEVICE,
+                                                           AUDIO_POLICY_DEVICE_STATE_UNAVAILABLE,
+                                                           "", "", AUDIO_FORMAT_DEFAULT));
+}
+
+TEST_F(AudioPolicyManagerTestWithConfigurationFile, DynamicProfileQueriesOfOldDevicesEvicted) {
+    mClient->addSupportedFormat(AUDIO_FORMAT_PCM_16_BIT);
+    mClient->addSupportedChannelMask(AUDIO_CHANNEL_OUT_STEREO);
+    mClient->setReportDevicePortProfiles(true);
+    auto connectAndDisconnect = [this](const std::string& address) {
+        ASSERT_EQ(NO_ERROR, mManager->setDeviceConnectionState(AUDIO_DEVICE_OUT_USB_DEVICE,
+                                                               AUDIO_POLICY_DEVICE_STATE_AVAILABLE,
+                                                               address.c_str(), "",
+                                                               AUDIO_FORMAT_DEFAULT));
+        ASSERT_EQ(NO_ERROR, mManager->setDeviceConnectionState(
+                AUDIO_DEVICE_OUT_USB_DEVICE, AUDIO_POLICY_DEVICE_STATE_UNAVAILABLE,
+                address.c_str(), "", AUDIO_FORMAT_DEFAULT));
+    };
+    // A device connected with a new address each time, as a BT device with random addresses.
+    constexpr int kAddressCount = 16;
+    for (int i = 0; i < kAddressCount; ++i) {
+        ASSERT_NO_FATAL_FAILURE(connectAndDisconnect("card=" + std::to_string(i) + ";device=0"));
+    }
+
+    // The most recently disconnected device is not queried again.
+    size_t queryCount = mClient->getAudioMixPortQueryCount();
+    ASSERT_NO_FATAL_FAILURE(
+            connectAndDisconnect("card=" + std::to_string(kAddressCount - 1) + ";device=0"));
+    EXPECT_EQ(queryCount, mClient->getAudioMixPortQueryCount());
+
+    // The queries of the first device were evicted.
+    ASSERT_NO_FATAL_FAILURE(connectAndDisconnect("card=0;device=0"));
+    EXPECT_GT(mClient->getAudioMixPortQueryCount(), queryCount);
+}
+
 TEST_F(AudioPolicyManagerTestWithConfigurationFile, PreferExactConfigForInput) {
     const audio_channel_mask_t deviceChannelMask = AUDIO_CHANNEL_IN_3POINT1;
     mClient->addSupportedFormat(AUDIO_FORMAT_PCM_16_BIT);